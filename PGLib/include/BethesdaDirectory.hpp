@@ -11,16 +11,22 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <filesystem>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 constexpr unsigned ASCII_UPPER_BOUND = 127;
 
 class BethesdaDirectory {
+public:
+    static constexpr uint32_t NO_MOD = 0; /** < Mod ID of files that do not belong to a mod (empty label) */
+
 private:
     /**
      * @struct BSAFile
@@ -28,12 +34,15 @@ private:
      *
      * path stores the path to the BSA archive, preserving case from the original
      * path version stores the version of the BSA archive archive stores the BSA
-     * archive object, which is where files can be accessed
+     * archive object, which is where files can be accessed. fileSize and
+     * lastWriteTime are read when the archive is loaded and used for file fingerprints
      */
     struct BSAFile {
         std::filesystem::path path;
         bsa::tes4::version version;
         bsa::tes4::archive archive;
+        uintmax_t fileSize = 0;
+        int64_t lastWriteTime = 0;
     };
 
     /**
@@ -48,10 +57,11 @@ private:
     struct BethesdaFile {
         std::filesystem::path path;
         std::shared_ptr<BSAFile> bsaFile;
-        std::wstring mod;
+        uint32_t modID = NO_MOD; /** < interned mod label, see getModName */
         bool generated;
+        uintmax_t fileSize = 0; /** < uncompressed size in bytes, 0 for generated files */
 
-        [[nodiscard]] auto getDiagJSON() const -> nlohmann::json
+        [[nodiscard]] auto getDiagJSON(const std::wstring& mod) const -> nlohmann::json
         {
             auto j = nlohmann::json::object();
             j["mod"] = ParallaxGenUtil::utf16toUTF8(mod);
@@ -84,6 +94,9 @@ private:
     std::map<std::filesystem::path, BethesdaFile> m_fileMap; /** < Stores the file map for every file found in the load
                                                               order. Key is a lowercase path, value is a BethesdaFile*/
     std::mutex m_fileMapMutex; /** < Mutex for the file map */
+    std::deque<std::wstring> m_modNames { L"" }; /** < Interned mod labels indexed by mod ID (references stay valid) */
+    std::unordered_map<std::wstring, uint32_t> m_modIDs { { L"", NO_MOD } }; /** < Mod label to mod ID */
+    std::mutex m_modTableMutex; /** < Mutex for the mod table */
     std::vector<ModFile> m_modFiles; /** < Stores files in mod staging directory */
 
     std::unordered_map<std::filesystem::path, std::vector<std::byte>> m_fileCache; /** < Stores a cache of file bytes */
@@ -111,6 +124,21 @@ private:
     static auto getExtensionBlocklist() -> std::vector<std::wstring>;
 
 public:
+    /**
+     * @struct FileFingerprint
+     * @brief Identifies the version of a file in the load order without reading it
+     *
+     * source is the absolute path of the loose file or of the BSA containing the file, size and lastWriteTime belong to
+     * that source. Any change to the winning file (or its BSA) changes the fingerprint
+     */
+    struct FileFingerprint {
+        std::wstring source;
+        uintmax_t size = 0;
+        int64_t lastWriteTime = 0;
+
+        auto operator==(const FileFingerprint& other) const -> bool = default;
+    };
+
     /**
      * @brief Construct a new Bethesda Directory object
      *
@@ -167,6 +195,33 @@ public:
     [[nodiscard]] auto getFile(const std::filesystem::path& relPath, const bool& cacheFile = false)
         -> std::vector<std::byte>;
 
+    /**
+     * @brief Get the first bytes of a file in the load order without reading the whole file. For compressed BSA
+     * entries only the data needed to produce the requested bytes is decompressed
+     *
+     * @param relPath path to the file relative to the data directory
+     * @param numBytes number of bytes to read from the start of the file
+     * @return std::vector<std::byte> up to numBytes bytes, empty if the file could not be read
+     */
+    [[nodiscard]] auto getFileHeader(const std::filesystem::path& relPath, const size_t& numBytes)
+        -> std::vector<std::byte>;
+
+    /**
+     * @brief Get the fingerprint of the winning version of a file
+     *
+     * @param relPath path to the file relative to the data directory
+     * @return FileFingerprint fingerprint, source is empty if the file does not exist
+     */
+    [[nodiscard]] auto getFileFingerprint(const std::filesystem::path& relPath) -> FileFingerprint;
+
+    /**
+     * @brief Get the size of the winning version of a file as recorded when the file map was built
+     *
+     * @param relPath path to the file relative to the data directory
+     * @return uintmax_t uncompressed size in bytes, 0 if the file does not exist or was generated
+     */
+    [[nodiscard]] auto getFileSize(const std::filesystem::path& relPath) -> uintmax_t;
+
     /**
      * @brief Get the Mod that has the winning version of the file
      *
@@ -175,6 +230,37 @@ public:
      */
     [[nodiscard]] auto getMod(const std::filesystem::path& relPath) -> std::wstring;
 
+    /**
+     * @brief Get the interned ID of the mod that has the winning version of the file
+     *
+     * @param relPath path to the file relative to the data directory
+     * @return uint32_t mod ID (NO_MOD for files without a mod)
+     */
+    [[nodiscard]] auto getModID(const std::filesystem::path& relPath) -> uint32_t;
+
+    /**
+     * @brief Get the label of an interned mod ID
+     *
+     * @param modID mod ID
+     * @return const std::wstring& mod label, valid for the lifetime of the directory
+     */
+    [[nodiscard]] auto getModName(const uint32_t& modID) -> const std::wstring&;
+
+    /**
+     * @brief Get the number of interned mods (mod IDs are 0 to getNumMods() - 1)
+     *
+     * @return size_t number of mods
+     */
+    [[nodiscard]] auto getNumMods() -> size_t;
+
+    /**
+     * @brief Build a rank table from a mod priority map
+     *
+     * @param modPriority mod label to priority
+     * @return std::vector<int> priority indexed by mod ID, -1 for mods without priority
+     */
+    [[nodiscard]] auto getModRanks(const std::unordered_map<std::wstring, int>& modPriority) -> std::vector<int>;
+
     /**
      * @brief Create a Generated file in the file map
      *
@@ -370,14 +456,35 @@ private:
      */
     [[nodiscard]] auto getFileFromMap(const std::filesystem::path& filePath) -> BethesdaFile;
 
+    /**
+     * @brief Get the ID of a mod label, adding it to the mod table if it is new
+     *
+     * @param mod mod label
+     * @return uint32_t mod ID
+     */
+    auto internMod(const std::wstring& mod) -> uint32_t;
+
     /**
      * @brief Update the file map with
      *
      * @param filePath path to update or add
      * @param bsaFile BSA file or nullptr if it doesn't exist
+     * @param fileSize uncompressed size of the file in bytes
      */
     void updateFileMap(const std::filesystem::path& filePath, std::shared_ptr<BSAFile> bsaFile,
-        const std::wstring& mod = L"", const bool& generated = false);
+        const std::wstring& mod = L"", const bool& generated = false, const uintmax_t& fileSize = 0);
+
+    /**
+     * @brief Decompress the start of a compressed BSA file entry
+     *
+     * @param data compressed file data
+     * @param version version of the BSA the data is from (selects zlib or lz4)
+     * @param numBytes number of decompressed bytes to produce
+     * @return std::vector<std::byte> up to numBytes decompressed bytes
+     */
+    [[nodiscard]] static auto decompressBSAFilePrefix(
+        std::span<const std::byte> data, const bsa::tes4::version& version, const size_t& numBytes)
+        -> std::vector<std::byte>;
 
     /**
      * @brief Convert a list of wstrings to a LPCWSTRs
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ParallaxGenPluginIndex.hpp"
+
+/**
+ * @class BethesdaPluginReader
+ * @brief Native reader for the TXST records and model alternate textures of a load order
+ * @details Plugins are memory mapped and only the top level groups of TXST and model record types are walked, every
+ * other group is skipped by its size. Each group is parsed as its own job in parallel and only records of those types
+ * are decompressed. The result is the winning override view of the load order in the same order PGMutagen
+ * PopulateObjs enumerates it, so buildIndex hands out the same TXST, alternate texture and model record handles.
+ * The reader only depends on boost and miniz and does not log, problems found while reading are kept for getWarnings.
+ */
+class BethesdaPluginReader {
+public:
+    /**
+     * @struct TXSTRecord
+     * @brief Winning override of a TXST record
+     */
+    struct TXSTRecord {
+        uint64_t formKey {}; /** < see getFormKey */
+        ParallaxGenPluginIndex::TXSTSlots slots; /** < lowercase textures\ paths in NIF slot order */
+    };
+
+    /**
+     * @struct AltTex
+     * @brief Alternate texture of a model
+     */
+    struct AltTex {
+        std::string name3D;
+        int index3D {};
+        uint64_t txstFormKey {}; /** < new texture, see getFormKey */
+    };
+
+    /**
+     * @struct Model
+     * @brief Model of a record that has an alternate texture list (possibly empty)
+     */
+    struct Model {
+        std::wstring nifName; /** < lowercase meshes\ path */
+        std::string matchType; /** < MODL, MALE, FEMALE, 1STMALE or 1STFEMALE */
+        std::vector<AltTex> altTexs;
+    };
+
+    /**
+     * @struct ModelRecord
+     * @brief Winning override of a record with at least one model that has an alternate texture list
+     */
+    struct ModelRecord {
+        uint64_t formKey {}; /** < see getFormKey */
+        std::string recordType;
+        std::vector<Model> models;
+    };
+
+private:
+    /**
+     * @struct PluginFile
+     * @brief Memory mapped plugin of the load order
+     */
+    struct PluginFile {
+        std::wstring name;
+        boost::interprocess::file_mapping file;
+        boost::interprocess::mapped_region region;
+        std::vector<uint32_t> masters; /** < plugin IDs of the masters, the plugin itself is last */
+    };
+
+    /**
+     * @struct GroupJob
+     * @brief Top level group to parse, results are merged in job order
+     */
+    struct GroupJob {
+        size_t plugin {}; /** < index into m_plugins */
+        uint32_t type {};
+        std::span<const std::byte> data; /** < records of the group without the group header */
+
+        std::vector<TXSTRecord> txsts;
+        std::vector<ModelRecord> modelRecords;
+        std::vector<uint64_t> hidden; /** < deleted records and records without alternate textures still win */
+    };
+
+    std::filesystem::path m_dataPath;
+
+    std::vector<std::wstring> m_pluginNames; /** < lowercase plugin names indexed by plugin ID */
+    std::unordered_map<std::wstring, uint32_t> m_pluginIDs;
+    std::vector<PluginFile> m_plugins; /** < mapped plugins in load order */
+
+    std::vector<TXSTRecord> m_txsts;
+    std::vector<ModelRecord> m_modelRecords;
+
+    std::vector<std::wstring> m_warnings;
+
+public:
+    /**
+     * @brief Construct a new Bethesda Plugin Reader object
+     *
+     * @param dataPath game data folder containing the plugins
+     */
+    explicit BethesdaPluginReader(std::filesystem::path dataPath);
+
+    /**
+     * @brief Read the winning overrides of a load order, plugins that do not exist are skipped
+     *
+     * @param loadOrder plugin file names in load order (for example from BethesdaGame::getActivePlugins)
+     * @param numThreads threads used to parse groups, 0 uses all hardware threads
+     */
+    void load(const std::vector<std::wstring>& loadOrder, const size_t& numThreads = 0);
+
+    /**
+     * @brief Get the winning TXST records, in the order PGMutagen indexes them
+     *
+     * @return const std::vector<TXSTRecord>& TXST records
+     */
+    [[nodiscard]] auto getTXSTs() const -> const std::vector<TXSTRecord>&;
+
+    /**
+     * @brief Get the winning records that have alternate texture lists, in the order PGMutagen enumerates them
+     *
+     * @return const std::vector<ModelRecord>& model records
+     */
+    [[nodiscard]] auto getModelRecords() const -> const std::vector<ModelRecord>&;
+
+    /**
+     * @brief Get the problems found by the last load, for example skipped plugins and references to missing TXSTs
+     *
+     * @return const std::vector<std::wstring>& warnings in the order they were found
+     */
+    [[nodiscard]] auto getWarnings() const -> const std::vector<std::wstring>&;
+
+    /**
+     * @brief Get the form key of a form ID of a plugin
+     *
+     * @param plugin plugin name that owns the form (case insensitive)
+     * @param formID form ID without the master index
+     * @return uint64_t form key, unique for every plugin and form ID pair
+     */
+    [[nodiscard]] auto getFormKey(const std::wstring& plugin, const uint32_t& formID) -> uint64_t;
+
+    /**
+     * @brief Get a readable description of a form key
+     *
+     * @param formKey form key
+     * @return std::wstring form ID and owning plugin
+     */
+    [[nodiscard]] auto getFormKeyDesc(const uint64_t& formKey) const -> std::wstring;
+
+    /**
+     * @brief Fill a plugin index the same way the PGMutagen snapshot does
+     *
+     * @param[out] index index to fill (cleared first)
+     */
+    void buildIndex(ParallaxGenPluginIndex& index) const;
+
+private:
+    void mapPlugins(const std::vector<std::wstring>& loadOrder);
+    auto getGroupJobs() const -> std::vector<GroupJob>;
+    void parseGroup(GroupJob& job) const;
+    void mergeGroups(std::vector<GroupJob>& jobs);
+
+    void findMissingTXSTs();
+
+    static auto parseTXST(std::span<const std::byte> data) -> ParallaxGenPluginIndex::TXSTSlots;
+    static auto parseModels(const uint32_t& type, std::span<const std::byte> data, const PluginFile& plugin)
+        -> std::vector<Model>;
+    static auto parseAltTexs(std::span<const std::byte> data, const PluginFile& plugin) -> std::vector<AltTex>;
+
+    static auto decompressRecord(std::span<const std::byte> data) -> std::vector<std::byte>;
+    static auto resolveFormID(const uint32_t& formID, const PluginFile& plugin) -> uint64_t;
+    auto internPlugin(const std::wstring& plugin) -> uint32_t;
+};
@@ -55,6 +55,9 @@ public:
         auto operator=(Prefix&&) -> Prefix& = delete;
     };
 
+    // Prefix of the calling thread as it is put in front of debug and trace messages
+    static auto getPrefix() -> std::wstring { return buildPrefixWString(); }
+
     // WString Log functions
     template <typename... Args> static void critical(const std::wstring& fmt, Args&&... moreArgs)
     {
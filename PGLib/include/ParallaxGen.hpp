@@ -44,8 +44,8 @@ private:
 
     // Runner vars
     PatcherUtil::PatcherTextureSet m_texPatchers;
-    PatcherUtil::PatcherMeshSet m_meshPatchers;
-    std::unordered_map<std::wstring, int>* m_modPriority;
+    PatcherUtil::PatcherMeshObjectPool m_meshPatcherPool;
+    std::vector<int> m_modRanks; /** < Mod priority indexed by mod ID */
 
     // Define a hash function for ShapeKey
     struct ShapeKeyHash {
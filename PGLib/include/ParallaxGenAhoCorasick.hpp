@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ParallaxGenCharTrie.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class ParallaxGenAhoCorasick
+ * @brief Case insensitive multi-pattern substring matcher (Aho-Corasick automaton)
+ * @details Patterns are added with an id and compiled once with build(). After that the automaton is immutable, so
+ * findAll can be called from any number of threads without locking. One pass over the text finds every pattern it
+ * contains.
+ */
+class ParallaxGenAhoCorasick {
+private:
+    static constexpr uint32_t ROOT = ParallaxGenCharTrie::ROOT;
+
+    ParallaxGenCharTrie m_trie;
+
+    // Pattern ids ending at each node before failure links are added
+    std::vector<std::vector<size_t>> m_trieOutputs;
+
+    std::vector<uint32_t> m_fail;
+
+    // Outputs of node n (including those reachable by failure links) are m_outputs[m_outputStart[n]..[n + 1])
+    std::vector<uint32_t> m_outputStart;
+    std::vector<size_t> m_outputs;
+
+    size_t m_numPatterns = 0;
+    bool m_built = false;
+
+public:
+    ParallaxGenAhoCorasick();
+
+    /**
+     * @brief Add a pattern, only valid before build()
+     *
+     * @param pattern pattern to search for (case insensitive, an empty pattern matches every text)
+     * @param id id reported by findAll when the pattern matches
+     */
+    void addPattern(const std::wstring& pattern, const size_t& id);
+
+    /**
+     * @brief Compile the added patterns into the automaton
+     */
+    void build();
+
+    /**
+     * @brief Find all patterns contained in a text
+     *
+     * @param text text to search
+     * @param[out] ids ids of the matching patterns, sorted ascending without duplicates (cleared first)
+     */
+    void findAll(const std::wstring& text, std::vector<size_t>& ids) const;
+
+    /**
+     * @brief Get the number of added patterns
+     *
+     * @return size_t number of patterns
+     */
+    [[nodiscard]] auto getNumPatterns() const -> size_t;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cwctype>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * @class ParallaxGenCharTrie
+ * @brief Case insensitive character trie shared by ParallaxGenAhoCorasick and ParallaxGenSuffixTrie
+ * @details Strings are inserted into a build time trie and compiled once with build() into one flat edge array sorted
+ * by character per node. Nodes are plain indices, so owners keep their per node data (pattern ids, failure links) in
+ * their own arrays indexed by node.
+ */
+class ParallaxGenCharTrie {
+public:
+    static constexpr uint32_t ROOT = 0;
+
+    struct Edge {
+        wchar_t c;
+        uint32_t target;
+    };
+
+private:
+    // Build time trie (edges per node, unsorted)
+    std::vector<std::vector<Edge>> m_trieEdges;
+
+    // Compiled trie, edges of node n are m_edges[m_edgeStart[n]..m_edgeStart[n + 1]) sorted by character
+    std::vector<uint32_t> m_edgeStart;
+    std::vector<Edge> m_edges;
+
+public:
+    ParallaxGenCharTrie();
+
+    /**
+     * @brief Insert a string, only valid before build()
+     *
+     * @param str string to insert (lowercased)
+     * @param reversed insert the string from its last character to its first
+     * @return uint32_t node the string ends at
+     */
+    auto insert(const std::wstring& str, const bool& reversed = false) -> uint32_t;
+
+    /**
+     * @brief Compile the inserted strings into the flat edge array
+     */
+    void build();
+
+    /**
+     * @brief Get the number of nodes including the root
+     *
+     * @return size_t number of nodes
+     */
+    [[nodiscard]] auto getNumNodes() const -> size_t { return m_trieEdges.size(); }
+
+    /**
+     * @brief Get the edges of a node in the compiled trie
+     *
+     * @param node node to look in
+     * @return std::span<const Edge> edges sorted by character
+     */
+    [[nodiscard]] auto getEdges(const uint32_t& node) const -> std::span<const Edge>
+    {
+        return { m_edges.data() + m_edgeStart[node], m_edges.data() + m_edgeStart[node + 1] };
+    }
+
+    /**
+     * @brief Get the child of a node in the compiled trie
+     *
+     * @param node node to look in
+     * @param c lowercase character of the edge
+     * @return uint32_t child node or ROOT if there is no edge (ROOT is never a child)
+     */
+    [[nodiscard]] auto findEdge(const uint32_t& node, const wchar_t& c) const -> uint32_t
+    {
+        const auto edges = getEdges(node);
+        const auto it = std::lower_bound(
+            edges.begin(), edges.end(), c, [](const Edge& edge, const wchar_t& value) { return edge.c < value; });
+        if (it != edges.end() && it->c == c) {
+            return it->target;
+        }
+
+        return ROOT;
+    }
+
+    /**
+     * @brief Lowercase a character the same way for inserted strings and texts
+     *
+     * @param c character
+     * @return wchar_t lowercase character
+     */
+    static auto toLower(const wchar_t& c) -> wchar_t { return static_cast<wchar_t>(towlower(static_cast<wint_t>(c))); }
+};
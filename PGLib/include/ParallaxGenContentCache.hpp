@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * @class ParallaxGenContentCache
+ * @brief Content addressed on-disk cache for generated files
+ * @details Files are stored as <key><extension> in the cache directory, where the key is a SHA-256 hash of everything
+ * the file was generated from. Cached files are copied to the output location.
+ * Eviction removes the least recently used files once the cache is larger than its size limit. Thread safe.
+ */
+class ParallaxGenContentCache {
+private:
+    static constexpr uintmax_t BYTES_PER_MB = 1024ULL * 1024ULL;
+
+    std::filesystem::path m_cacheDir; /** Directory holding the cached files */
+    std::wstring m_extension; /** Extension of cached files, including the dot */
+    uintmax_t m_maxSize; /** Size limit in bytes enforced by evict() */
+
+    std::atomic<size_t> m_numHits = 0;
+    std::atomic<size_t> m_numMisses = 0;
+    std::atomic<size_t> m_numStored = 0;
+
+public:
+    static constexpr uintmax_t DEFAULT_MAX_SIZE = 2048ULL * BYTES_PER_MB;
+
+    /**
+     * @brief Construct a new content cache
+     *
+     * @param cacheDir directory holding the cached files (created on first store)
+     * @param extension extension of cached files, including the dot
+     * @param maxSize size limit in bytes, enforced by evict()
+     */
+    ParallaxGenContentCache(std::filesystem::path cacheDir, std::wstring extension, const uintmax_t& maxSize);
+
+    /**
+     * @brief Get the cache key for a set of inputs
+     *
+     * @param inputs contents the output is generated from, in a fixed order (empty inputs are allowed)
+     * @param generatorVersion version of the generator, bump to invalidate outputs of older generators
+     * @return std::string hex SHA-256 of the inputs, empty on failure
+     */
+    [[nodiscard]] static auto getKey(const std::vector<std::vector<std::byte>>& inputs,
+        const std::string& generatorVersion) -> std::string;
+
+    /**
+     * @brief Place the cached file for a key at a destination
+     *
+     * @param key cache key from getKey
+     * @param destPath destination path, parent directories are created
+     * @return true cached file was copied to destPath
+     * @return false key is not cached or the file could not be placed
+     */
+    auto fetch(const std::string& key, const std::filesystem::path& destPath) -> bool;
+
+    /**
+     * @brief Store a generated file in the cache
+     *
+     * @param key cache key from getKey
+     * @param srcPath generated file to copy into the cache
+     * @return true file was stored
+     * @return false file could not be stored
+     */
+    auto store(const std::string& key, const std::filesystem::path& srcPath) -> bool;
+
+    /**
+     * @brief Remove least recently used files until the cache is within its size limit
+     */
+    void evict();
+
+    /**
+     * @brief Get the total size of the cached files
+     *
+     * @return uintmax_t size in bytes
+     */
+    [[nodiscard]] auto getSize() const -> uintmax_t;
+
+    /**
+     * @brief Log hit, miss and size statistics
+     */
+    void logStats() const;
+
+private:
+    /**
+     * @brief Get the path of the cached file for a key
+     *
+     * @param key cache key
+     * @return std::filesystem::path path in the cache directory
+     */
+    [[nodiscard]] auto getCachePath(const std::string& key) const -> std::filesystem::path;
+};
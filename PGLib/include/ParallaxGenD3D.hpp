@@ -5,21 +5,32 @@
 #include <dxgiformat.h>
 #include <wrl/client.h>
 
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <filesystem>
+#include <functional>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "ParallaxGenDirectory.hpp"
+#include "ParallaxGenGPUPool.hpp"
 #include "ParallaxGenTask.hpp"
+#include "ParallaxGenTextureCache.hpp"
 
 constexpr unsigned NUM_GPU_THREADS = 16;
 constexpr unsigned GPU_BUFFER_SIZE_MULTIPLE = 16;
 constexpr unsigned MAX_CHANNEL_VALUE = 255;
+constexpr unsigned NUM_GPU_JOBS_IN_FLIGHT = 4;
+constexpr unsigned DDS_HEADER_READ_SIZE = 148; // magic + DDS_HEADER + DDS_HEADER_DXT10
+constexpr unsigned DDS_HEADER_INDEX_CHUNK_SIZE = 256;
 
-class ParallaxGenD3D {
+class ParallaxGenD3D : public ParallaxGenGPUDevice {
 private:
     ParallaxGenDirectory* m_pgd;
 
@@ -49,15 +60,36 @@ private:
     };
     Microsoft::WRL::ComPtr<ID3D11ComputeShader> m_shaderCountAlphaValues;
 
-    struct ShaderConvertToHDRParams {
-        float luminanceMult;
-    };
-    Microsoft::WRL::ComPtr<ID3D11ComputeShader> m_shaderConvertToHDR;
+    // DDS header index, filled once by buildDDSHeaderIndex and only read afterwards so lookups take no lock
+    std::unordered_map<std::filesystem::path, DirectX::TexMetadata> m_ddsHeaderIndex;
+    std::atomic<bool> m_ddsHeaderIndexReady = false;
+
+    ParallaxGenTextureCache* m_textureCache = nullptr; // persistent analysis cache, optional
 
+    // Fallback cache for textures that are not in the header index (generated files)
     std::unordered_map<std::filesystem::path, DirectX::TexMetadata> m_ddsMetaDataCache;
     std::mutex m_ddsMetaDataMutex;
 
-    std::mutex m_gpuOperationMutex;
+    std::recursive_mutex m_gpuOperationMutex; // guards the immediate context, recursive for fence calls
+
+    // Pooled GPU resources
+    struct GPUTexture {
+        Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav;
+    };
+    struct GPUBuffer {
+        Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav;
+    };
+    ParallaxGenGPUResourcePool<GPUTexture> m_texturePool;
+    ParallaxGenGPUResourcePool<GPUBuffer> m_bufferPool;
+
+    // Fences (D3D11.0 has no fence objects, so pooled event queries are used instead)
+    std::deque<std::pair<FenceValue, Microsoft::WRL::ComPtr<ID3D11Query>>> m_pendingFences;
+    std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> m_freeFenceQueries;
+    FenceValue m_lastSignaledFence = 0;
+    FenceValue m_lastCompletedFence = 0;
 
 public:
     /// @brief Constructor
@@ -69,6 +101,16 @@ public:
     /// @brief Initialize GPU (also compiles shaders)
     void initGPU();
 
+    /// @brief Use a persistent texture analysis cache for DDS metadata and complex material detection
+    /// @param textureCache loaded cache, must outlive this object (nullptr disables the cache)
+    void loadTextureCache(ParallaxGenTextureCache* textureCache);
+
+    /// @brief Read the headers of every mapped DDS file in parallel into an immutable lookup table
+    /// @details Call once after mapFiles and before patching. Only the first DDS_HEADER_READ_SIZE bytes of each file
+    /// are read, for compressed BSA entries only the first chunk is decompressed
+    /// @param multithreading read headers on the thread pool
+    void buildDDSHeaderIndex(const bool& multithreading = true);
+
     /// @brief Find complex material maps and re-assign the type in the used ParallaxGenDirectory
     /// @param[in] bsaExcludes never assume files found in these BSAs are complex material maps
     /// @return result of the operation
@@ -81,7 +123,14 @@ public:
     [[nodiscard]] auto upgradeToComplexMaterial(
         const std::filesystem::path& parallaxMap, const std::filesystem::path& envMap) -> DirectX::ScratchImage;
 
-    void convertToHDR(DirectX::ScratchImage* dds, bool& ddsModified, const float& luminanceMult,
+    /// @brief Convert a texture to HDR on the CPU (luminance multiply + float conversion for every mip)
+    /// @details Does not touch the GPU, so textures can be converted in parallel without any global lock. The source is
+    /// expanded to float a strip of rows at a time, so only the destination is held in full
+    /// @param[in,out] dds texture to convert, replaced with the converted texture on success
+    /// @param[out] ddsModified set to true if the texture was converted
+    /// @param luminanceMult multiplier applied to the rgb channels (alpha is left untouched)
+    /// @param outputFormat DXGI_FORMAT_R16G16B16A16_FLOAT or DXGI_FORMAT_R32G32B32A32_FLOAT
+    static void convertToHDR(DirectX::ScratchImage* dds, bool& ddsModified, const float& luminanceMult,
         const DXGI_FORMAT& outputFormat = DXGI_FORMAT_R16G16B16A16_FLOAT);
 
     /// @brief Checks if the aspect ratio of two DDS files match
@@ -98,13 +147,47 @@ public:
 
     static auto getDXGIFormatFromString(const std::string& format) -> DXGI_FORMAT;
 
+    // Fences (ParallaxGenGPUDevice)
+    auto signalFence() -> FenceValue override;
+    auto getCompletedFence() -> FenceValue override;
+    void waitForFence(FenceValue fence) override;
+
+    /// @brief Count channel values of many textures with up to NUM_GPU_JOBS_IN_FLIGHT dispatches in flight
+    /// @details loadImage runs on the calling thread while earlier textures are processed by the GPU
+    /// @param numImages number of images to process
+    /// @param loadImage callback that decodes image i, returns false if the image should be skipped
+    /// @return per image counts of non-zero r, g, b values and opaque alpha values, nullopt if the image failed
+    auto countValuesGPUBatch(const size_t& numImages,
+        const std::function<bool(const size_t&, DirectX::ScratchImage&)>& loadImage)
+        -> std::vector<std::optional<std::array<int, 4>>>;
+
     // Texture helpers
     auto getDDS(const std::filesystem::path& ddsPath, DirectX::ScratchImage& dds) const -> ParallaxGenTask::PGResult;
 
 private:
-    auto checkIfCM(const std::filesystem::path& ddsPath, bool& result, bool& hasEnvMask, bool& hasGlosiness,
-        bool& hasMetalness) -> ParallaxGenTask::PGResult;
-    auto countValuesGPU(const DirectX::ScratchImage& image) -> std::array<int, 4>;
+    auto checkIfCMCandidate(const std::filesystem::path& ddsPath, bool& result) -> ParallaxGenTask::PGResult;
+    static auto checkIfCM(const std::array<int, 4>& values, const DirectX::TexMetadata& ddsImageMeta, bool& hasEnvMask,
+        bool& hasGlosiness, bool& hasMetalness) -> bool;
+
+    /**
+     * @struct CountValuesJob
+     * @brief Resources of one in-flight countValuesGPUBatch dispatch, returned to the pools when it retires
+     */
+    struct CountValuesJob {
+        size_t index = 0;
+        ParallaxGenGPUResourceKey inputKey;
+        GPUTexture input;
+        ParallaxGenGPUResourceKey outputKey;
+        GPUBuffer output;
+        ParallaxGenGPUResourceKey stagingKey;
+        GPUBuffer staging;
+    };
+
+    /// @brief Upload, dispatch and copy to staging for one image (does not wait for the GPU)
+    auto recordCountValues(const DirectX::ScratchImage& image, CountValuesJob& job) -> bool;
+
+    /// @brief Return the resources of a count values job to the pools
+    void releaseCountValuesJob(CountValuesJob& job);
 
     // GPU functions
     void initShaders();
@@ -116,11 +199,20 @@ private:
         -> ParallaxGenTask::PGResult;
 
     // GPU Helpers
-    auto createTexture2D(const DirectX::ScratchImage& texture, Microsoft::WRL::ComPtr<ID3D11Texture2D>& dest) const
+    auto createPooledTexture(const ParallaxGenGPUResourceKey& key, GPUTexture& dest) const -> bool;
+    auto createPooledBuffer(const ParallaxGenGPUResourceKey& key, GPUBuffer& dest) const -> bool;
+
+    /// @brief Get a pooled texture matching the image and upload the image to it (caller holds the GPU lock)
+    auto acquireTexture2D(const DirectX::ScratchImage& texture, ParallaxGenGPUResourceKey& key, GPUTexture& dest)
         -> ParallaxGenTask::PGResult;
 
-    auto createTexture2D(Microsoft::WRL::ComPtr<ID3D11Texture2D>& existingTexture,
-        Microsoft::WRL::ComPtr<ID3D11Texture2D>& dest) const -> ParallaxGenTask::PGResult;
+    /// @brief Get a pooled structured buffer with a UAV and fill it with initial data (caller holds the GPU lock)
+    auto acquireStructuredBuffer(const void* data, const UINT& size, const UINT& stride,
+        ParallaxGenGPUResourceKey& key, GPUBuffer& dest) -> ParallaxGenTask::PGResult;
+
+    /// @brief Get a pooled constant buffer and write data to it (caller holds the GPU lock)
+    auto acquireConstantBuffer(const void* data, const UINT& size, ParallaxGenGPUResourceKey& key, GPUBuffer& dest)
+        -> ParallaxGenTask::PGResult;
 
     auto createTexture2D(D3D11_TEXTURE2D_DESC& desc, Microsoft::WRL::ComPtr<ID3D11Texture2D>& dest) const
         -> ParallaxGenTask::PGResult;
@@ -135,21 +227,12 @@ private:
         const D3D11_UNORDERED_ACCESS_VIEW_DESC& desc, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView>& dest) const
         -> ParallaxGenTask::PGResult;
 
-    auto createBuffer(const void* data, D3D11_BUFFER_DESC& desc, Microsoft::WRL::ComPtr<ID3D11Buffer>& dest) const
-        -> ParallaxGenTask::PGResult;
+    /// @brief Dispatch the bound compute shader without waiting, completion is tracked with fences
+    void dispatch(UINT threadGroupCountX, UINT threadGroupCountY, UINT threadGroupCountZ) const;
 
-    auto createConstantBuffer(const void* data, const UINT& size, Microsoft::WRL::ComPtr<ID3D11Buffer>& dest) const
-        -> ParallaxGenTask::PGResult;
-
-    [[nodiscard]] auto blockingDispatch(UINT threadGroupCountX, UINT threadGroupCountY, UINT threadGroupCountZ) const
-        -> ParallaxGenTask::PGResult;
-
-    [[nodiscard]] auto readBack(const Microsoft::WRL::ComPtr<ID3D11Texture2D>& gpuResource) const
+    [[nodiscard]] auto readBack(const Microsoft::WRL::ComPtr<ID3D11Texture2D>& gpuResource)
         -> std::vector<unsigned char>;
 
-    template <typename T>
-    [[nodiscard]] auto readBack(const Microsoft::WRL::ComPtr<ID3D11Buffer>& gpuResource) const -> std::vector<T>;
-
     // Texture Helpers
     auto getDDSMetadata(const std::filesystem::path& ddsPath, DirectX::TexMetadata& ddsMeta)
         -> ParallaxGenTask::PGResult;
@@ -158,4 +241,23 @@ private:
         const size_t& height, const size_t& mips, DXGI_FORMAT format) -> DirectX::ScratchImage;
 
     static auto isPowerOfTwo(unsigned int x) -> bool;
+
+    // CPU Helpers
+
+    /// @brief Convert one scanline of RGBA32F pixels to the HDR output format
+    /// @param src source pixels (4 floats per pixel)
+    /// @param dst destination scanline
+    /// @param numPixels number of pixels in the scanline
+    /// @param luminanceMult multiplier applied to the rgb channels
+    /// @param outputFormat DXGI_FORMAT_R16G16B16A16_FLOAT or DXGI_FORMAT_R32G32B32A32_FLOAT
+    static void convertScanlineToHDR(const float* src, uint8_t* dst, const size_t& numPixels,
+        const float& luminanceMult, const DXGI_FORMAT& outputFormat);
+
+    /// @brief Convert RGBA32F pixels to RGBA16F with F16C, two pixels per iteration
+    /// @return number of pixels converted (the remainder is left for the scalar path)
+    static auto convertScanlineToHalfF16C(
+        const float* src, uint16_t* dst, const size_t& numPixels, const float& luminanceMult) -> size_t;
+
+    /// @brief Checks if the CPU and OS support AVX and F16C
+    static auto cpuSupportsF16C() -> bool;
 };
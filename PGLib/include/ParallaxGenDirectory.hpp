@@ -119,6 +119,13 @@ public:
     [[nodiscard]] auto getTextureMapConst(const NIFUtil::TextureSlots& slot) const
         -> const std::map<std::wstring, std::unordered_set<NIFUtil::PGTexture, NIFUtil::PGTextureHasher>>&;
 
+    /// @brief Get a copy of the texture map for a given texture slot, safe while textures are being generated
+    /// @see getTextureMap
+    /// @param Slot texture slot of BSShaderTextureSet in the shapes
+    /// @return Copy of the map
+    [[nodiscard]] auto getTextureMapCopy(const NIFUtil::TextureSlots& slot)
+        -> std::map<std::wstring, std::unordered_set<NIFUtil::PGTexture, NIFUtil::PGTextureHasher>>;
+
     [[nodiscard]] auto getMeshes() const -> const std::unordered_set<std::filesystem::path>&;
 
     [[nodiscard]] auto getTextures() const -> const std::unordered_set<std::filesystem::path>&;
@@ -137,5 +144,12 @@ public:
 
     void setTextureType(const std::filesystem::path& path, const NIFUtil::TextureType& type);
 
+    /// @brief Add a texture generated while patching to the texture maps and texture types (thread safe)
+    /// @param path relative path of the generated texture
+    /// @param slot texture slot map to add it to
+    /// @param type texture type
+    void addGeneratedTexture(
+        const std::filesystem::path& path, const NIFUtil::TextureSlots& slot, const NIFUtil::TextureType& type);
+
     auto getTextureType(const std::filesystem::path& path) -> NIFUtil::TextureType;
 };
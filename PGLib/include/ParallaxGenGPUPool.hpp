@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+/**
+ * @class ParallaxGenGPUDevice
+ * @brief Minimal fence interface used by the GPU resource pool and dispatch batches
+ * @details Implemented by ParallaxGenD3D for D3D11. Has no dependency on D3D so a CPU stand-in device can be used to
+ * test pooling and batching on any platform.
+ */
+class ParallaxGenGPUDevice {
+public:
+    using FenceValue = uint64_t;
+
+    ParallaxGenGPUDevice() = default;
+    virtual ~ParallaxGenGPUDevice() = default;
+    ParallaxGenGPUDevice(const ParallaxGenGPUDevice& other) = delete;
+    auto operator=(const ParallaxGenGPUDevice& other) -> ParallaxGenGPUDevice& = delete;
+    ParallaxGenGPUDevice(ParallaxGenGPUDevice&& other) noexcept = delete;
+    auto operator=(ParallaxGenGPUDevice&& other) noexcept -> ParallaxGenGPUDevice& = delete;
+
+    /**
+     * @brief Insert a fence after all work submitted so far
+     *
+     * @return FenceValue value that is reached once that work has completed (monotonically increasing)
+     */
+    virtual auto signalFence() -> FenceValue = 0;
+
+    /**
+     * @brief Get the highest fence value that has completed (does not block)
+     *
+     * @return FenceValue completed fence value
+     */
+    virtual auto getCompletedFence() -> FenceValue = 0;
+
+    /**
+     * @brief Block until a fence value has completed
+     *
+     * @param fence fence value to wait for
+     */
+    virtual void waitForFence(FenceValue fence) = 0;
+};
+
+/**
+ * @struct ParallaxGenGPUResourceKey
+ * @brief Bucket key for pooled GPU resources (formats and flags are stored as raw integers to stay API agnostic)
+ */
+struct ParallaxGenGPUResourceKey {
+    uint32_t width = 0; /** Width for textures, bucketed byte width for buffers */
+    uint32_t height = 0;
+    uint32_t mipLevels = 0;
+    uint32_t format = 0;
+    uint32_t bindFlags = 0;
+    uint32_t miscFlags = 0;
+    uint32_t usage = 0;
+
+    auto operator==(const ParallaxGenGPUResourceKey& other) const -> bool = default;
+
+    /**
+     * @brief Round a buffer size up to its bucket so similar sized buffers share resources
+     *
+     * @param size requested size in bytes
+     * @return uint32_t bucket size (next power of two, at least MIN_BUFFER_BUCKET)
+     */
+    static auto getBufferBucket(const uint32_t& size) -> uint32_t
+    {
+        static constexpr uint32_t MIN_BUFFER_BUCKET = 16;
+        return std::bit_ceil(std::max(size, MIN_BUFFER_BUCKET));
+    }
+};
+
+/**
+ * @struct ParallaxGenGPUResourceKeyHash
+ * @brief Hash for ParallaxGenGPUResourceKey
+ */
+struct ParallaxGenGPUResourceKeyHash {
+    auto operator()(const ParallaxGenGPUResourceKey& key) const -> size_t
+    {
+        size_t hash = 0;
+        boost::hash_combine(hash, key.width);
+        boost::hash_combine(hash, key.height);
+        boost::hash_combine(hash, key.mipLevels);
+        boost::hash_combine(hash, key.format);
+        boost::hash_combine(hash, key.bindFlags);
+        boost::hash_combine(hash, key.miscFlags);
+        boost::hash_combine(hash, key.usage);
+        return hash;
+    }
+};
+
+/**
+ * @class ParallaxGenGPUResourcePool
+ * @brief Thread-safe pool of reusable GPU resources bucketed by ParallaxGenGPUResourceKey
+ *
+ * @tparam Resource resource handle type (ComPtr, struct of ComPtrs, or anything copyable/movable)
+ */
+template <typename Resource> class ParallaxGenGPUResourcePool {
+public:
+    using CreateFunc = std::function<bool(const ParallaxGenGPUResourceKey&, Resource&)>;
+
+    /**
+     * @brief Construct a new resource pool
+     *
+     * @param createFunc called to create a resource when the bucket has no idle resource
+     * @param maxIdlePerBucket idle resources kept per bucket, extra released resources are destroyed
+     */
+    explicit ParallaxGenGPUResourcePool(CreateFunc createFunc, const size_t& maxIdlePerBucket = DEFAULT_MAX_IDLE)
+        : m_createFunc(std::move(createFunc))
+        , m_maxIdlePerBucket(maxIdlePerBucket)
+    {
+    }
+
+    /**
+     * @brief Get a resource from the pool, creating one if none is idle
+     *
+     * @param key bucket key
+     * @param[out] resource acquired resource
+     * @return true resource was acquired
+     * @return false resource creation failed
+     */
+    auto acquire(const ParallaxGenGPUResourceKey& key, Resource& resource) -> bool
+    {
+        {
+            const std::lock_guard<std::mutex> lock(m_poolMutex);
+            auto it = m_idle.find(key);
+            if (it != m_idle.end() && !it->second.empty()) {
+                resource = std::move(it->second.back());
+                it->second.pop_back();
+                m_numReused++;
+                return true;
+            }
+        }
+
+        // create outside of the lock, creation may be slow
+        if (!m_createFunc(key, resource)) {
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> lock(m_poolMutex);
+        m_numCreated++;
+        return true;
+    }
+
+    /**
+     * @brief Return a resource to the pool
+     *
+     * @param key bucket key the resource was acquired with
+     * @param resource resource to return
+     */
+    void release(const ParallaxGenGPUResourceKey& key, Resource resource)
+    {
+        const std::lock_guard<std::mutex> lock(m_poolMutex);
+        auto& bucket = m_idle[key];
+        if (bucket.size() < m_maxIdlePerBucket) {
+            bucket.push_back(std::move(resource));
+        }
+    }
+
+    /// @brief Destroy all idle resources
+    void clear()
+    {
+        const std::lock_guard<std::mutex> lock(m_poolMutex);
+        m_idle.clear();
+    }
+
+    /// @brief Number of resources created by the pool
+    [[nodiscard]] auto getNumCreated() -> size_t
+    {
+        const std::lock_guard<std::mutex> lock(m_poolMutex);
+        return m_numCreated;
+    }
+
+    /// @brief Number of acquires served from idle resources
+    [[nodiscard]] auto getNumReused() -> size_t
+    {
+        const std::lock_guard<std::mutex> lock(m_poolMutex);
+        return m_numReused;
+    }
+
+private:
+    static constexpr size_t DEFAULT_MAX_IDLE = 4;
+
+    CreateFunc m_createFunc;
+    size_t m_maxIdlePerBucket;
+
+    std::unordered_map<ParallaxGenGPUResourceKey, std::vector<Resource>, ParallaxGenGPUResourceKeyHash> m_idle;
+    std::mutex m_poolMutex;
+
+    size_t m_numCreated = 0;
+    size_t m_numReused = 0;
+};
+
+/**
+ * @class ParallaxGenGPUBatch
+ * @brief Keeps up to N fenced GPU jobs in flight and retires them in submission order
+ * @details Callers record GPU work (upload, dispatch, copy to a pooled staging resource), then push the job. The batch
+ * fences it and only blocks once the in-flight window is full, so the CPU can decode the next texture while the GPU
+ * works. The in-flight window bounds how many staging resources are checked out, which makes the staging pool a ring.
+ *
+ * @tparam Job per job state needed to read back results (staging resource, output slot, ...)
+ */
+template <typename Job> class ParallaxGenGPUBatch {
+public:
+    using RetireFunc = std::function<void(Job&)>;
+
+    /**
+     * @brief Construct a new batch
+     *
+     * @param device device used for fencing
+     * @param maxInFlight maximum number of jobs that can be in flight
+     * @param retireFunc called for every job once its fence completed (read back and release resources here)
+     */
+    ParallaxGenGPUBatch(ParallaxGenGPUDevice* device, const size_t& maxInFlight, RetireFunc retireFunc)
+        : m_device(device)
+        , m_maxInFlight(std::max<size_t>(1, maxInFlight))
+        , m_retireFunc(std::move(retireFunc))
+    {
+    }
+
+    ~ParallaxGenGPUBatch() { flush(); }
+    ParallaxGenGPUBatch(const ParallaxGenGPUBatch& other) = delete;
+    auto operator=(const ParallaxGenGPUBatch& other) -> ParallaxGenGPUBatch& = delete;
+    ParallaxGenGPUBatch(ParallaxGenGPUBatch&& other) noexcept = delete;
+    auto operator=(ParallaxGenGPUBatch&& other) noexcept -> ParallaxGenGPUBatch& = delete;
+
+    /**
+     * @brief Fence a job whose GPU work was already submitted
+     * @details Retires completed jobs first, then blocks on the oldest job if the in-flight window is full
+     *
+     * @param job job to track
+     */
+    void push(Job job)
+    {
+        const auto fence = m_device->signalFence();
+        m_inFlight.emplace_back(fence, std::move(job));
+
+        retireCompleted();
+        while (m_inFlight.size() > m_maxInFlight) {
+            retireOldest();
+        }
+    }
+
+    /// @brief Retire all jobs whose fence has completed without blocking
+    void retireCompleted()
+    {
+        if (m_inFlight.empty()) {
+            return;
+        }
+
+        const auto completed = m_device->getCompletedFence();
+        while (!m_inFlight.empty() && m_inFlight.front().first <= completed) {
+            retireFront();
+        }
+    }
+
+    /// @brief Block until every job in flight is retired
+    void flush()
+    {
+        while (!m_inFlight.empty()) {
+            retireOldest();
+        }
+    }
+
+    /// @brief Number of jobs currently in flight
+    [[nodiscard]] auto getNumInFlight() const -> size_t { return m_inFlight.size(); }
+
+private:
+    ParallaxGenGPUDevice* m_device;
+    size_t m_maxInFlight;
+    RetireFunc m_retireFunc;
+
+    std::deque<std::pair<ParallaxGenGPUDevice::FenceValue, Job>> m_inFlight;
+
+    void retireOldest()
+    {
+        m_device->waitForFence(m_inFlight.front().first);
+        retireFront();
+    }
+
+    void retireFront()
+    {
+        auto job = std::move(m_inFlight.front().second);
+        m_inFlight.pop_front();
+        m_retireFunc(job);
+    }
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Mesh math kernels that work on raw vertex arrays (no nifly dependency)
+ */
+namespace ParallaxGenMeshMath {
+
+struct UVScale {
+    float u;
+    float v;
+};
+
+/**
+ * @brief Calculate the automatic UV scale of a mesh from its UV density (SSE2, 4 triangles per iteration)
+ * @details Per triangle terms are computed with the same operations as the scalar version and accumulated in
+ * triangle order, so the result is bit identical to autoUVScaleScalar.
+ *
+ * @param uvs interleaved u, v per vertex
+ * @param verts interleaved x, y, z per vertex
+ * @param tris 3 vertex indices per triangle
+ * @param numTris number of triangles
+ * @return UVScale UV scale (both components are the smaller of the two)
+ */
+auto autoUVScale(const float* uvs, const float* verts, const uint16_t* tris, const size_t& numTris) -> UVScale;
+
+/**
+ * @brief Scalar reference for autoUVScale
+ *
+ * @param uvs interleaved u, v per vertex
+ * @param verts interleaved x, y, z per vertex
+ * @param tris 3 vertex indices per triangle
+ * @param numTris number of triangles
+ * @return UVScale UV scale (both components are the smaller of the two)
+ */
+auto autoUVScaleScalar(const float* uvs, const float* verts, const uint16_t* tris, const size_t& numTris) -> UVScale;
+
+/**
+ * @brief Recalculate vertex normals, smoothing across vertices that share a position (SSE2, 4 triangles per iteration)
+ * @details Area weighted face normals are summed per vertex in triangle order and normalized. Vertices at the same
+ * position (UV seams, split edges) then take the sum of each other's normals that are less than smoothAngle apart.
+ * Bit identical to calcNormalsScalar.
+ *
+ * @param verts interleaved x, y, z per vertex
+ * @param numVerts number of vertices
+ * @param tris 3 vertex indices per triangle
+ * @param numTris number of triangles
+ * @param smoothAngle largest angle in degrees between normals that are smoothed together
+ * @param[out] normals interleaved x, y, z per vertex (numVerts * 3 floats)
+ */
+void calcNormals(const float* verts, const size_t& numVerts, const uint16_t* tris, const size_t& numTris,
+    const float& smoothAngle, float* normals);
+
+/**
+ * @brief Scalar reference for calcNormals
+ */
+void calcNormalsScalar(const float* verts, const size_t& numVerts, const uint16_t* tris, const size_t& numTris,
+    const float& smoothAngle, float* normals);
+
+/**
+ * @brief Recalculate vertex tangents from UV gradients (SSE2, 4 triangles per iteration)
+ * @details Uses the game's convention: the tangent follows the V direction and the bitangent the U direction. Both are
+ * orthogonalized against the normal, vertices without UV gradient get a tangent frame built from the normal alone.
+ * Bit identical to calcTangentsScalar.
+ *
+ * @param verts interleaved x, y, z per vertex
+ * @param uvs interleaved u, v per vertex
+ * @param normals interleaved x, y, z per vertex (normalized)
+ * @param numVerts number of vertices
+ * @param tris 3 vertex indices per triangle
+ * @param numTris number of triangles
+ * @param[out] tangents interleaved x, y, z per vertex (numVerts * 3 floats)
+ * @param[out] bitangents interleaved x, y, z per vertex (numVerts * 3 floats)
+ */
+void calcTangents(const float* verts, const float* uvs, const float* normals, const size_t& numVerts,
+    const uint16_t* tris, const size_t& numTris, float* tangents, float* bitangents);
+
+/**
+ * @brief Scalar reference for calcTangents
+ */
+void calcTangentsScalar(const float* verts, const float* uvs, const float* normals, const size_t& numVerts,
+    const uint16_t* tris, const size_t& numTris, float* tangents, float* bitangents);
+
+}
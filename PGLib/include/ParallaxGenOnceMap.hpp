@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @class ParallaxGenOnceMap
+ * @brief Concurrent map that computes the value of each key exactly once
+ * @details The first caller for a key runs the compute function without holding the map lock. Concurrent callers for
+ * the same key wait on a shared future for that result, callers for other keys are not blocked. A compute function that
+ * throws rethrows the exception to every caller of that key.
+ *
+ * @tparam Key key type
+ * @tparam Value value type (copied to every caller)
+ * @tparam Hash hash for Key
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>> class ParallaxGenOnceMap {
+private:
+    std::unordered_map<Key, std::shared_future<Value>, Hash> m_results;
+    std::mutex m_mutex;
+
+public:
+    /**
+     * @brief Get the value of a key, computing it if this is the first call for the key
+     *
+     * @param key key to look up
+     * @param compute function returning the value, only called by the first caller of a key
+     * @return Value computed value
+     */
+    template <typename Func> auto getOrCompute(const Key& key, Func&& compute) -> Value
+    {
+        std::promise<Value> promise;
+        std::shared_future<Value> future;
+
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+
+            const auto [it, inserted] = m_results.try_emplace(key);
+            if (inserted) {
+                it->second = promise.get_future().share();
+            } else {
+                future = it->second;
+            }
+        }
+
+        if (future.valid()) {
+            // another caller owns this key
+            return future.get();
+        }
+
+        try {
+            Value result = std::forward<Func>(compute)();
+            promise.set_value(result);
+            return result;
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    /**
+     * @brief Check if a key has been requested before (its value might still be computing)
+     *
+     * @param key key to check
+     * @return true key is in the map
+     */
+    [[nodiscard]] auto contains(const Key& key) -> bool
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_results.contains(key);
+    }
+
+    /**
+     * @brief Get the number of keys in the map
+     *
+     * @return size_t number of keys
+     */
+    [[nodiscard]] auto size() -> size_t
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_results.size();
+    }
+
+    /**
+     * @brief Remove all keys, no value may be computing
+     */
+    void clear()
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_results.clear();
+    }
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @class ParallaxGenPipeline
+ * @brief Runs stages as soon as the stages whose output they need are done
+ * @details Every stage names the stages it reads from. Stages without a path between them run at the same time on
+ * their own threads, so for example plugin loading does not wait for the file map. Stages that must run on the calling
+ * thread (like anything that shows UI) are marked as such and run there when they are ready. Running single threaded
+ * runs every stage on the calling thread in the order the stages were added, which is the plain barrier pipeline.
+ */
+class ParallaxGenPipeline {
+public:
+    /**
+     * @struct StageTime
+     * @brief When a stage ran, relative to the start of run
+     */
+    struct StageTime {
+        std::string name;
+        double startMS {};
+        double endMS {};
+    };
+
+private:
+    struct Stage {
+        std::string name;
+        std::vector<size_t> inputs; /** < indices of the stages this stage reads from */
+        std::function<void()> func;
+        bool mainThread {};
+    };
+
+    std::vector<Stage> m_stages;
+    std::vector<StageTime> m_stageTimes; /** < indexed like m_stages, filled by run */
+    double m_wallMS {};
+
+public:
+    /**
+     * @brief Add a stage, stages it reads from must be added first
+     *
+     * @param name name of the stage, other stages use it to name their inputs
+     * @param inputs names of the stages whose output this stage reads
+     * @param func stage function
+     * @param mainThread if true, the stage runs on the thread that calls run
+     */
+    void addStage(const std::string& name, const std::vector<std::string>& inputs, std::function<void()> func,
+        const bool& mainThread = false);
+
+    /**
+     * @brief Run all stages, blocks until every stage is done. If a stage throws, no further stages are started and
+     * the first exception is rethrown once the running stages are done
+     *
+     * @param multithread if false, stages run one after another in the order they were added
+     */
+    void run(const bool& multithread = true);
+
+    /**
+     * @brief Get when each stage ran during the last run
+     *
+     * @return const std::vector<StageTime>& stage times in the order the stages were added
+     */
+    [[nodiscard]] auto getStageTimes() const -> const std::vector<StageTime>&;
+
+    /**
+     * @brief Get how much time the last run saved over running the stages one after another
+     *
+     * @return double sum of all stage durations minus the wall time of the run in milliseconds
+     */
+    [[nodiscard]] auto getOverlapMS() const -> double;
+
+private:
+    auto getStageIndex(const std::string& name) const -> size_t;
+};
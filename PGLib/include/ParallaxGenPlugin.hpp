@@ -1,11 +1,18 @@
 #pragma once
 
 #include <Geometry.hpp>
+#include <atomic>
 #include <boost/algorithm/string/predicate.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <mutex>
 #include <nlohmann/json_fwd.hpp>
+#include <span>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 #include <windows.h>
 
 #include <boost/functional/hash.hpp>
@@ -13,27 +20,102 @@
 #include "BethesdaGame.hpp"
 #include "NIFUtil.hpp"
 #include "ParallaxGenDirectory.hpp"
+#include "ParallaxGenPluginIndex.hpp"
+#include "ParallaxGenRingBuffer.hpp"
 #include "patchers/base/PatcherUtil.hpp"
 
 class ParallaxGenPlugin {
-private:
-    static constexpr int LOG_POLL_INTERVAL = 1000;
+public:
+    /**
+     * @struct NewTXSTKey
+     * @brief Slots of a new TXST record, lowercased and hashed once when the record is requested
+     */
+    struct NewTXSTKey {
+        NIFUtil::TextureSet slots;
+        size_t hash {};
+
+        auto operator==(const NewTXSTKey& other) const -> bool { return hash == other.hash && slots == other.slots; }
+    };
+
+    struct NewTXSTKeyHash {
+        auto operator()(const NewTXSTKey& key) const -> size_t { return key.hash; }
+    };
+
+    /**
+     * @struct NewTXSTRequest
+     * @brief Shape that needs a new TXST record, the request with the lowest alternate texture index wins
+     */
+    struct NewTXSTRequest {
+        int altTexIndex {}; /** < the new record is a copy of the TXST of this alternate texture */
+        NIFUtil::TextureSet slots; /** < slots as returned by the patcher */
+        PatcherMeshShader::PatcherMatch match;
+        PatcherMeshShader::NewTXSTRecordWriter writeRecord {}; /** < patcher output for the record, may be null */
+    };
+
+    using NewTXSTRequests = std::unordered_map<NewTXSTKey, NewTXSTRequest, NewTXSTKeyHash>;
+
+    /**
+     * @struct NewTXST
+     * @brief TXST record to create in savePlugin
+     */
+    struct NewTXST {
+        const NewTXSTRequest* request {};
+        std::string edid;
+    };
+
+    /**
+     * @brief Create the key of new TXST slots
+     *
+     * @param slots slots of the new record
+     * @return NewTXSTKey lowercase slots and their hash
+     */
+    static auto makeNewTXSTKey(const NIFUtil::TextureSet& slots) -> NewTXSTKey;
+
+    /**
+     * @brief Add a request for a new TXST record to a request set
+     *
+     * @param requests request set of the calling thread
+     * @param key key of the slots
+     * @param request request, replaces an existing request for the same slots if its alternate texture index is lower
+     * @return const NewTXSTKey* key stored in the set, stays valid until the set is cleared
+     */
+    static auto addNewTXSTRequest(NewTXSTRequests& requests, NewTXSTKey key, NewTXSTRequest request)
+        -> const NewTXSTKey*;
+
+    /**
+     * @brief Merge request sets and name the new records in slot order, so the result does not depend on which thread
+     * requested which record or in what order
+     *
+     * @param requests request sets to merge
+     * @param[out] newTXSTs records to create in EDID order
+     * @param[out] keyIndices index into newTXSTs of every key in the request sets
+     */
+    static void assignNewTXSTs(const std::vector<const NewTXSTRequests*>& requests, std::vector<NewTXST>& newTXSTs,
+        std::unordered_map<const NewTXSTKey*, size_t>& keyIndices);
 
+private:
     static std::mutex s_libMutex;
-    static void libLogMessageIfExists();
     static void libThrowExceptionIfExists();
     static void libInitialize(const int& gameType, const std::wstring& exePath, const std::wstring& dataPath,
         const std::vector<std::wstring>& loadOrder = {});
     static void libPopulateObjs();
     static void libFinalize(const std::filesystem::path& outputPath, const bool& esmify);
 
-    /// @brief get the TXST objects that are used by a shape
+    /// @brief get every alternate texture that references an existing texture set
+    /// @return alternate texture entries, entries of the same NIF and 3D index in plugin order
+    static auto libGetTXSTRefs() -> std::vector<ParallaxGenPluginIndex::AltTexRef>;
+
+    /// @brief get the TXST objects that are used by a shape, only used to check the native index against the library
     /// @param[in] nifName filename of the nif
-    /// @param[in] name3D "3D name" - name of the shape
     /// @param[in] index3D "3D index" - index of the shape in the nif
-    /// @return TXST objects, pairs of (texture set index,alternate textures ids)
+    /// @return matching alternate textures in library order
     static auto libGetMatchingTXSTObjs(const std::wstring& nifName, const int& index3D)
-        -> std::vector<std::tuple<int, int, std::wstring, std::string>>;
+        -> std::vector<ParallaxGenPluginIndex::Match>;
+
+    /// @brief get the model record handle from the alternate texture handle
+    /// @param[in] altTexIndex global index of the alternate texture
+    /// @return model record handle
+    static auto libGetModelRecHandleFromAltTexHandle(const int& altTexIndex) -> int;
 
     /// @brief get the assigned textures of all slots in a texture set
     /// @param[in] txstIndex index of the texture set
@@ -64,86 +146,213 @@ private:
 
     static auto libGetAltTexFormID(const int& altTexIndex) -> std::tuple<unsigned int, std::wstring, std::wstring>;
 
-    /// @brief get the model record handle from the alternate texture handle
-    /// @param[in] altTexIndex global index of the alternate texture
-    /// @return model record handle
-    static auto libGetModelRecHandleFromAltTexHandle(const int& altTexIndex) -> int;
-
     static void libSetModelRecNIF(const int& modelRecHandle, const std::wstring& nifPath);
 
-    static bool s_loggingEnabled;
-    static void logMessages();
+    /// @brief log messages from the managed side through the registered log callback
+    /// @param[in] numMessages number of messages
+    /// @param[in] level library log level of the messages
+    static void libLogTestMessages(const int& numMessages, const int& level);
+
+    /**
+     * @struct LibLogMessage
+     * @brief Message logged by the plugin library
+     */
+    struct LibLogMessage {
+        int level {};
+        std::wstring prefix; /** < Logger prefix of the thread that logged the message, trace and debug only */
+        std::wstring message;
+    };
+
+    static constexpr size_t LOG_BUFFER_SIZE = 8192;
+    static ParallaxGenRingBuffer<LibLogMessage> s_logBuffer; /** < filled by the library, drained by logConsumer */
+    static std::atomic<uint32_t> s_logSignal; /** < bumped on every push and on stop, logConsumer waits on it */
+    static std::atomic<uint64_t> s_logPushed;
+    static std::atomic<uint64_t> s_logWritten;
+    static std::atomic<bool> s_logConsumerRunning;
+    static std::atomic<bool> s_logCritical; /** < set when the library logs a critical message */
+
+    /**
+     * @class LogConsumer
+     * @brief Owns the thread that drains s_logBuffer into the log, stops and joins it when destroyed. The thread never
+     * exits the process, critical messages are raised by the thread that called into the library
+     */
+    class LogConsumer {
+    private:
+        std::jthread m_thread;
+
+    public:
+        LogConsumer();
+        ~LogConsumer();
+        LogConsumer(const LogConsumer& other) = delete;
+        auto operator=(const LogConsumer& other) -> LogConsumer& = delete;
+        LogConsumer(LogConsumer&& other) noexcept = delete;
+        auto operator=(LogConsumer&& other) noexcept -> LogConsumer& = delete;
+
+    private:
+        /**
+         * @brief Drain the log buffer into the log until a stop is requested
+         */
+        static void run(const std::stop_token& stopToken);
+    };
+
+    /**
+     * @brief Get the owner of the running log consumer
+     * @details Created on first use, which is after the logger, so a consumer that is still running at exit is
+     * joined while the logger still exists
+     *
+     * @return std::unique_ptr<LogConsumer>& consumer, null if not running
+     */
+    static auto getLogConsumer() -> std::unique_ptr<LogConsumer>&;
+
+    /**
+     * @brief Log callback registered with the library, called on the thread that is in the library
+     *
+     * @param level library log level
+     * @param message message, not null terminated
+     * @param length message length
+     */
+    static void libLogCallback(int level, const wchar_t* message, int length);
+
+    /**
+     * @brief Write a library message to the log
+     *
+     * @param level library log level
+     * @param prefix Logger prefix to log trace and debug messages with, in addition to the prefix of this thread
+     * @param message message
+     */
+    static void logLibMessage(const int& level, const std::wstring& prefix, const std::wstring& message);
+
+    static void startLogConsumer();
+
+    /**
+     * @brief Stop the log consumer after it drained the buffer, no library call may be running
+     */
+    static void stopLogConsumer();
+
+    /**
+     * @brief Write every message in the log buffer to the log, safe to call from any thread
+     */
+    static void drainLog();
+
+    /**
+     * @brief Wait until every message pushed so far is written to the log
+     */
+    static void flushLog();
 
     static ParallaxGenDirectory* s_pgd;
 
-    static std::mutex s_processShapeMutex;
-
-    // Custom hash function for std::array<std::string, 9>
-    struct ArrayHash {
-        auto operator()(const std::array<std::wstring, NUM_TEXTURE_SLOTS>& arr) const -> std::size_t
-        {
-            std::size_t hash = 0;
-            for (const auto& str : arr) {
-                // Convert string to lowercase and hash
-                const std::wstring lowerStr = boost::to_lower_copy(str);
-                boost::hash_combine(hash, boost::hash<std::wstring>()(lowerStr));
-            }
-            return hash;
-        }
-    };
+    static ParallaxGenPluginIndex s_index; /** < Snapshot of the plugin records, read only after populateObjs */
+
+    static std::filesystem::path s_dataPath;
+    static std::vector<std::wstring> s_loadOrder;
+
+    /**
+     * @brief Read the load order with BethesdaPluginReader and log where it differs from the plugin library snapshot
+     */
+    static void verifyNativeReader();
+
+    /**
+     * @struct PluginOp
+     * @brief Plugin change logged by a worker thread, applied in savePlugin
+     */
+    struct PluginOp {
+        enum class Type : uint8_t { SET_MODEL_REC_NIF, SET_MODEL_ALT_TEX, SET_3D_INDEX };
 
-    struct ArrayEqual {
-        auto operator()(const std::array<std::wstring, NUM_TEXTURE_SLOTS>& lhs,
-            const std::array<std::wstring, NUM_TEXTURE_SLOTS>& rhs) const -> bool
-        {
-            for (size_t i = 0; i < NUM_TEXTURE_SLOTS; ++i) {
-                if (!boost::iequals(lhs.at(i), rhs.at(i))) {
-                    return false;
-                }
-            }
-            return true;
-        }
+        std::wstring baseNIF; /** < NIF being processed when the op was logged, ops are applied in mesh order */
+        size_t sequence {}; /** < order of the op within its thread */
+        Type type {};
+        int altTexIndex {};
+        int value {}; /** < TXST index, new TXST index or 3D index */
+        const NewTXSTKey* newTXST {}; /** < new TXST to assign instead of value */
+        std::wstring nifPath; /** < model path for SET_MODEL_REC_NIF */
     };
-    static std::unordered_map<std::array<std::wstring, NUM_TEXTURE_SLOTS>, std::pair<int, std::string>, ArrayHash,
-        ArrayEqual>
-        s_createdTXSTs;
-    static std::mutex s_createdTXSTMutex;
 
-    static int s_edidCounter;
-    static std::mutex s_edidCounterMutex;
+    /**
+     * @brief Get the op log of the calling thread, every thread gets its own log so logging needs no lock
+     *
+     * @return std::vector<PluginOp>& op log
+     */
+    static auto getThreadOpLog() -> std::vector<PluginOp>&;
+    static std::vector<std::shared_ptr<std::vector<PluginOp>>> s_opLogs; /** < logs of all threads */
+    static std::mutex s_opLogsMutex;
+
+    /**
+     * @brief Create the new TXST records and apply all logged ops in a deterministic order
+     */
+    static void applyPluginOps();
+
+    /**
+     * @brief Get the new TXST requests of the calling thread, every thread gets its own set so requesting needs no lock
+     *
+     * @return NewTXSTRequests& requests
+     */
+    static auto getThreadTXSTRequests() -> NewTXSTRequests&;
+    static std::vector<std::shared_ptr<NewTXSTRequests>> s_txstRequests; /** < requests of all threads */
+    static std::mutex s_txstRequestsMutex;
 
     // Runner vars
-    static std::unordered_map<std::wstring, int>* s_modPriority;
+    static std::vector<int> s_modRanks; /** < Mod priority indexed by mod ID */
 
 public:
     static void loadStatics(ParallaxGenDirectory* pgd);
-    static void loadModPriorityMap(std::unordered_map<std::wstring, int>* modPriority);
+    static void loadModRanks(const std::vector<int>& modRanks);
 
     static void initialize(const BethesdaGame& game, const std::filesystem::path& exePath);
 
     static void populateObjs();
 
+    /**
+     * @brief Compare the native index with GetMatchingTXSTObjs of the plugin library, call after populateObjs
+     * @details Checks every indexed NIF shape, the other weight of weighted NIFs and the shape after the last indexed
+     * one, plus the model record handle of every alternate texture
+     *
+     * @param maxDifferences stop after this many differences
+     * @return std::vector<std::wstring> descriptions of the differences, empty if both resolve the same matches
+     */
+    static auto getLibraryDifferences(const size_t& maxDifferences = 10) -> std::vector<std::wstring>;
+
     struct TXSTResult {
         std::wstring matchedNIF;
         int modelRecHandle {};
         int altTexIndex {};
         int txstIndex {};
+        const NewTXSTKey* newTXST {}; /** < new TXST created in savePlugin, replaces txstIndex */
         std::string matchType;
         NIFUtil::ShapeShader shader {};
     };
 
+    /**
+     * @brief Get the plugin matches of every shape of a NIF, call once per NIF and pass the result to processShape
+     *
+     * @param nifPath NIF path
+     * @param numShapes number of shapes in the NIF
+     * @param[out] nifMatches matches keyed by 3D index
+     */
+    static void getNIFMatches(
+        const std::wstring& nifPath, const size_t& numShapes, ParallaxGenPluginIndex::NIFMatches& nifMatches);
+
     static void processShape(const std::wstring& nifPath, nifly::NiShape* nifShape, const int& index3D,
-        PatcherUtil::PatcherMeshObjectSet& patchers, std::vector<TXSTResult>& results, const std::string& shapeKey,
+        std::span<const ParallaxGenPluginIndex::Match> pluginMatches, PatcherUtil::PatcherMeshObjectSet& patchers,
+        std::vector<TXSTResult>& results, const std::string& shapeKey,
         PatcherUtil::ConflictModResults* conflictMods = nullptr);
 
     static void assignMesh(
         const std::wstring& nifPath, const std::wstring& baseNIFPath, const std::vector<TXSTResult>& result);
 
-    static void set3DIndices(const std::wstring& nifPath,
+    static void set3DIndices(const std::wstring& nifPath, const ParallaxGenPluginIndex::NIFMatches& nifMatches,
         const std::vector<std::tuple<nifly::NiShape*, int, int, std::string>>& shapeTracker);
 
     static void savePlugin(const std::filesystem::path& outputDir, bool esmify);
 
+    /**
+     * @brief Log messages from the plugin library, used to measure the log channel
+     *
+     * @param numMessages number of messages the managed side logs
+     * @param level library log level of the messages
+     * @param wait wait until the messages are written to the log
+     */
+    static void logTestMessages(const int& numMessages, const int& level, const bool& wait = true);
+
 private:
     static auto getKeyFromFormID(const std::tuple<unsigned int, std::wstring, std::wstring>& formID) -> std::string;
 };
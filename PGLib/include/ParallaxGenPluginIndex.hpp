@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class ParallaxGenPluginIndex
+ * @brief Native snapshot of the plugin TXST records and model alternate textures
+ * @details Filled once after the plugin objects are populated, after that it is read only so any number of threads
+ * can resolve matches without going through the plugin library. Lookups mirror GetMatchingTXSTObjs of the library.
+ */
+class ParallaxGenPluginIndex {
+public:
+    static constexpr size_t NUM_SLOTS = 9;
+    using TXSTSlots = std::array<std::wstring, NUM_SLOTS>; /** < same type as NIFUtil::TextureSet */
+
+    /**
+     * @struct AltTexRef
+     * @brief Alternate texture entry of a model record that references an existing TXST
+     */
+    struct AltTexRef {
+        std::wstring nifName; /** < lowercase NIF path of the model */
+        int index3D {};
+        int txstIndex {};
+        int altTexIndex {};
+        int modelRecHandle {};
+        std::string matchType; /** < model subrecord type (MODL, MOD2, ...) */
+    };
+
+    /**
+     * @struct Match
+     * @brief Alternate texture that applies to a NIF shape
+     */
+    struct Match {
+        int txstIndex {};
+        int altTexIndex {};
+        std::wstring matchedNIF;
+        std::string matchType;
+    };
+
+    /**
+     * @struct NIFMatches
+     * @brief Matches of every shape of a NIF in one flat array
+     */
+    struct NIFMatches {
+        std::vector<uint32_t> shapeStart; /** < matches of shape i are matches[shapeStart[i]..shapeStart[i + 1]) */
+        std::vector<Match> matches;
+
+        /**
+         * @brief Get the matches of one shape
+         *
+         * @param index3D 3D index of the shape
+         * @return std::span<const Match> matches, empty if the shape is out of range
+         */
+        [[nodiscard]] auto getShapeMatches(const int& index3D) const -> std::span<const Match>;
+    };
+
+private:
+    std::vector<AltTexRef> m_altTexRefs;
+    std::unordered_map<std::wstring, std::vector<size_t>> m_refsByNIF; /** < indices into m_altTexRefs */
+    std::unordered_map<int, size_t> m_refsByAltTex; /** < alternate texture index to m_altTexRefs index */
+    std::unordered_map<int, TXSTSlots> m_txstSlots;
+
+public:
+    /**
+     * @brief Add an alternate texture entry, refs of the same NIF and 3D index keep the order they are added in
+     *
+     * @param ref alternate texture entry
+     */
+    void addAltTexRef(AltTexRef ref);
+
+    /**
+     * @brief Set the texture slots of a TXST record
+     *
+     * @param txstIndex TXST index
+     * @param slots lowercase texture slots
+     */
+    void setTXSTSlots(const int& txstIndex, TXSTSlots slots);
+
+    /**
+     * @brief Get the TXST indices referenced by the added alternate textures
+     *
+     * @return std::vector<int> TXST indices, sorted without duplicates
+     */
+    [[nodiscard]] auto getReferencedTXSTs() const -> std::vector<int>;
+
+    /**
+     * @brief Get the alternate textures that apply to a shape of a NIF (including _0/_1 weight variants)
+     *
+     * @param nifName NIF path
+     * @param index3D 3D index of the shape
+     * @param[out] matches matching alternate textures (cleared first)
+     */
+    void getMatches(const std::wstring& nifName, const int& index3D, std::vector<Match>& matches) const;
+
+    /**
+     * @brief Get the alternate textures of every shape of a NIF at once, the NIF name is normalized and looked up once
+     *
+     * @param nifName NIF path
+     * @param numShapes number of shapes in the NIF, 3D indices at or above this are ignored
+     * @param[out] nifMatches matches keyed by 3D index, each shape matches the same entries as getMatches
+     */
+    void getNIFMatches(const std::wstring& nifName, const size_t& numShapes, NIFMatches& nifMatches) const;
+
+    /**
+     * @brief Get the texture slots of a TXST record
+     *
+     * @param txstIndex TXST index
+     * @return const TXSTSlots& texture slots, empty slots if the TXST is unknown
+     */
+    [[nodiscard]] auto getTXSTSlots(const int& txstIndex) const -> const TXSTSlots&;
+
+    /**
+     * @brief Get the model record handle of an alternate texture
+     *
+     * @param altTexIndex alternate texture index
+     * @return int model record handle
+     */
+    [[nodiscard]] auto getModelRecHandle(const int& altTexIndex) const -> int;
+
+    /**
+     * @brief Get all alternate texture entries
+     *
+     * @return const std::vector<AltTexRef>& entries in the order they were added
+     */
+    [[nodiscard]] auto getAltTexRefs() const -> const std::vector<AltTexRef>&;
+
+    /**
+     * @brief Get the name of the other weight of a weighted NIF (_0.nif and _1.nif)
+     *
+     * @param nifNameLower lowercase NIF path
+     * @return std::wstring other weight, empty if the NIF is not weighted
+     */
+    static auto getOtherWeightNIF(const std::wstring& nifNameLower) -> std::wstring;
+
+    /**
+     * @brief Get the number of alternate texture entries
+     *
+     * @return size_t number of entries
+     */
+    [[nodiscard]] auto getNumAltTexRefs() const -> size_t;
+
+    /**
+     * @brief Compare the entries and referenced TXST slots with another index, for example one built by a different
+     * plugin reader
+     *
+     * @param other index to compare with
+     * @param maxDifferences stop after this many differences
+     * @return std::vector<std::wstring> descriptions of the differences, empty if both indices match
+     */
+    [[nodiscard]] auto getDifferences(const ParallaxGenPluginIndex& other, const size_t& maxDifferences = 10) const
+        -> std::vector<std::wstring>;
+
+    /**
+     * @brief Remove all entries
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Get the refs of a NIF
+     *
+     * @param nifNameLower lowercase NIF path
+     * @return const std::vector<size_t>* indices into m_altTexRefs, null if the NIF has none
+     */
+    [[nodiscard]] auto getNIFRefs(const std::wstring& nifNameLower) const -> const std::vector<size_t>*;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * @class ParallaxGenRingBuffer
+ * @brief Bounded lock-free queue for any number of producers and consumers
+ * @details Every slot carries a sequence number that tells producers and consumers whose turn it is, so a push or pop
+ * is one compare exchange on the head or tail plus a move of the value. Neither call blocks, a full or empty buffer
+ * returns false and the caller decides whether to retry.
+ *
+ * @tparam T value type, must be default constructible and move assignable
+ */
+template <typename T> class ParallaxGenRingBuffer {
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> m_slots; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+    size_t m_mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head = 0; /** < next position to push */
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail = 0; /** < next position to pop */
+
+public:
+    /**
+     * @brief Construct a new ring buffer
+     *
+     * @param capacity number of slots, rounded up to a power of two
+     */
+    explicit ParallaxGenRingBuffer(const size_t& capacity)
+        : m_mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+    {
+        m_slots = std::make_unique<Slot[]>(m_mask + 1); // NOLINT(cppcoreguidelines-avoid-c-arrays)
+        for (size_t i = 0; i <= m_mask; i++) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Push a value
+     *
+     * @param value value to push, only moved from if the push succeeds
+     * @return true value was pushed
+     * @return false buffer is full
+     */
+    auto tryPush(T&& value) -> bool
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = m_slots[pos & m_mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                // slot is free for this position, claim it
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // slot still holds a value from the previous lap
+                return false;
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Pop the oldest value
+     *
+     * @param[out] value popped value
+     * @return true a value was popped
+     * @return false buffer is empty
+     */
+    auto tryPop(T& value) -> bool
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = m_slots[pos & m_mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(slot.value);
+                    // free the slot for the push one lap ahead
+                    slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Get the number of slots
+     *
+     * @return size_t capacity
+     */
+    [[nodiscard]] auto capacity() const -> size_t { return m_mask + 1; }
+};
@@ -1,36 +1,107 @@
 #pragma once
 
-#include <boost/asio.hpp>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+class ParallaxGenScheduler;
+
+/**
+ * @class ParallaxGenRunner
+ * @brief Group of tasks run on the process wide ParallaxGenScheduler
+ */
 class ParallaxGenRunner {
-private:
-    boost::asio::thread_pool m_threadPool; /** Thread pool responsible for queueing tasks for multithreaded */
+public:
+    /**
+     * @class Task
+     * @brief Move only callable, so tasks can own what they capture without being copied
+     */
+    class Task {
+    private:
+        struct Base {
+            Base() = default;
+            virtual ~Base() = default;
+            Base(const Base& other) = delete;
+            auto operator=(const Base& other) -> Base& = delete;
+            Base(Base&& other) noexcept = delete;
+            auto operator=(Base&& other) noexcept -> Base& = delete;
+
+            virtual void run() = 0;
+        };
+
+        template <typename Func> struct Impl : Base {
+            Func func;
+
+            template <typename Arg>
+            explicit Impl(Arg&& func)
+                : func(std::forward<Arg>(func))
+            {
+            }
+
+            void run() override { func(); }
+        };
+
+        std::unique_ptr<Base> m_impl;
 
+    public:
+        Task() = default;
+
+        template <typename Func, typename Stored = std::remove_cvref_t<Func>>
+            requires(!std::same_as<Stored, Task> && std::invocable<Stored&>)
+        Task(Func&& func) // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+            : m_impl(std::make_unique<Impl<Stored>>(std::forward<Func>(func)))
+        {
+        }
+
+        void operator()() { m_impl->run(); }
+    };
+
+private:
     const bool m_multithread; /** If true, run multithreaded */
+    ParallaxGenScheduler* m_scheduler; /** Scheduler the tasks run on, nullptr for the scheduler of the process */
 
-    std::vector<std::function<void()>> m_tasks; /** Task list to run */
+    std::vector<Task> m_tasks; /** Task list to run */
+    std::vector<uint64_t> m_costs; /** Cost hint of every task, the most expensive tasks are started first */
+    std::vector<size_t> m_order; /** Task index for every submitted index while runTasks runs */
     std::atomic<size_t> m_completedTasks; /** Counter of completed tasks */
 
-    static constexpr int LOOP_INTERVAL = 10; /** Task loop interval */
+    std::unique_ptr<std::latch> m_done; /** Counted down once per task while runTasks runs */
+
+    std::atomic<bool> m_exceptionThrown = false; /** Set by the first task that throws, later tasks are skipped */
+    std::exception m_exception;
+    std::string m_exceptionStackTrace;
+    std::mutex m_exceptionMutex;
 
 public:
     /**
      * @brief Construct a new Parallax Gen Runner object
      *
      * @param multithread if true, use multithreading
+     * @param scheduler scheduler to run on, nullptr uses the scheduler of the process
      */
-    ParallaxGenRunner(const bool& multithread = true);
+    ParallaxGenRunner(const bool& multithread = true, ParallaxGenScheduler* scheduler = nullptr);
 
     /**
      * @brief Add a task to the task list
      *
-     * @param task Task to add (function<void()>)
+     * @param task Task to add, any callable without arguments
+     * @param cost Estimated cost in any unit shared by the tasks of this runner (for example file size). Tasks are
+     * started most expensive first so a large file picked up last does not stretch the run, 0 keeps the added order
      */
-    void addTask(const std::function<void()>& task);
+    void addTask(Task task, const uint64_t& cost = 0);
 
     /**
-     * @brief Blocking function that runs all tasks in the task list. Intended to be run from the main thread
+     * @brief Blocking function that runs all tasks in the task list. The calling thread runs queued work of the
+     * scheduler while it waits, so runners can also be used from within tasks
      */
     void runTasks();
 
@@ -44,6 +115,14 @@ public:
     static void processException(const std::exception& e, const std::string& stacktrace);
 
 private:
+    /**
+     * @brief Run one task, called by the scheduler
+     *
+     * @param runner runner that owns the task
+     * @param index index of the task
+     */
+    static void runTask(void* runner, const size_t& index);
+
     /**
      * @brief Process an exception - prints stack trace and exception message, and throws a main thread exception
      *
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ParallaxGenScheduler
+ * @brief Work stealing thread pool shared by every ParallaxGenRunner of the process
+ * @details Workers are started once and sleep while there is no work. Every worker owns a queue of index ranges, it
+ * takes work from the back of its own queue and steals from the front of the others when it runs dry. A range is
+ * split in half until one index is left, the halves stay on the queue of the worker so idle workers can steal them.
+ * Jobs are a function pointer, a context pointer and an index range, so submitting does not allocate per task.
+ */
+class ParallaxGenScheduler {
+public:
+    using JobFunc = void (*)(void* context, const size_t& index);
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr int SPIN_COUNT = 64; /** < failed steal rounds before a worker goes to sleep */
+
+    /**
+     * @struct Job
+     * @brief Range of indices to run a job function on
+     */
+    struct Job {
+        JobFunc func = nullptr;
+        void* context = nullptr;
+        size_t begin {};
+        size_t end {};
+    };
+
+    struct alignas(CACHE_LINE_SIZE) WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues; /** < one queue per worker */
+    std::vector<std::thread> m_workers;
+
+    std::atomic<uint32_t> m_signal = 0; /** < bumped when work is queued for sleeping workers, they wait on it */
+    std::atomic<size_t> m_numSleeping = 0;
+    std::atomic<size_t> m_nextQueue = 0; /** < round robin queue for submits from outside the pool */
+    std::atomic<bool> m_stop = false;
+
+public:
+    /**
+     * @brief Get the scheduler of the process, started on first use with one worker per hardware thread. It is never
+     * destroyed, so exiting during a run does not wait for queued jobs
+     *
+     * @return ParallaxGenScheduler& scheduler
+     */
+    static auto get() -> ParallaxGenScheduler&;
+
+    /**
+     * @brief Construct a new scheduler and start its workers
+     *
+     * @param numThreads number of workers, 0 uses all hardware threads
+     */
+    explicit ParallaxGenScheduler(const size_t& numThreads = 0);
+
+    /**
+     * @brief Stop the workers. Jobs that are running finish, queued jobs that have not started are dropped
+     */
+    ~ParallaxGenScheduler();
+    ParallaxGenScheduler(const ParallaxGenScheduler& other) = delete;
+    auto operator=(const ParallaxGenScheduler& other) -> ParallaxGenScheduler& = delete;
+    ParallaxGenScheduler(ParallaxGenScheduler&& other) noexcept = delete;
+    auto operator=(ParallaxGenScheduler&& other) noexcept -> ParallaxGenScheduler& = delete;
+
+    /**
+     * @brief Queue func(context, i) for every i in [0, count), returns right away
+     *
+     * @param func job function, must not throw
+     * @param context passed to every call, must stay valid until all calls returned
+     * @param count number of indices
+     */
+    void submit(JobFunc func, void* context, const size_t& count);
+
+    /**
+     * @brief Get the order in which the indices of a submit are started. Every worker runs its chunk front to back, so
+     * the first index of every chunk starts first, then the second and so on
+     *
+     * @param count number of indices of the submit
+     * @return std::vector<size_t> indices in start order
+     */
+    [[nodiscard]] auto getStartOrder(const size_t& count) const -> std::vector<size_t>;
+
+    /**
+     * @brief Run one queued index on the calling thread, used by threads that wait for their jobs to help out
+     *
+     * @return true an index was run
+     * @return false no work was queued
+     */
+    auto runPending() -> bool;
+
+    /**
+     * @brief Get the number of workers
+     *
+     * @return size_t number of workers
+     */
+    [[nodiscard]] auto getNumThreads() const -> size_t;
+
+private:
+    void workerLoop(const size_t& workerIndex);
+
+    /**
+     * @brief Take a job from the own queue (back) or steal one from another queue (front)
+     *
+     * @param workerIndex queue of the calling worker, or SIZE_MAX for threads outside the pool
+     * @param[out] job job taken
+     * @return true a job was taken
+     */
+    auto takeJob(const size_t& workerIndex, Job& job) -> bool;
+
+    /**
+     * @brief Split a job down to one index, queue the split off halves and run the index
+     *
+     * @param workerIndex queue the halves go to, or SIZE_MAX to split onto round robin queues
+     * @param job job to run
+     */
+    void runJob(const size_t& workerIndex, Job job);
+
+    void pushJob(const size_t& queueIndex, const Job& job);
+    void wakeWorkers();
+};
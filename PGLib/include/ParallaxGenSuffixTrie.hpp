@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ParallaxGenCharTrie.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class ParallaxGenSuffixTrie
+ * @brief Case insensitive lookup of all stored suffixes of a string (trie over reversed strings)
+ * @details Suffixes are added with an id and compiled once with build() into flat sorted edge arrays. After that the
+ * trie is immutable, so findSuffixes can be called from any number of threads without locking. A lookup walks the text
+ * backwards once and does not allocate beyond the output vector.
+ */
+class ParallaxGenSuffixTrie {
+private:
+    static constexpr uint32_t ROOT = ParallaxGenCharTrie::ROOT;
+
+    // Trie over the reversed suffixes
+    ParallaxGenCharTrie m_trie;
+
+    // Ids of suffixes ending at each node before build
+    std::vector<std::vector<size_t>> m_trieIds;
+
+    // Ids of suffixes ending at node n are m_ids[m_idStart[n]..m_idStart[n + 1])
+    std::vector<uint32_t> m_idStart;
+    std::vector<size_t> m_ids;
+
+    size_t m_numSuffixes = 0;
+    bool m_built = false;
+
+public:
+    ParallaxGenSuffixTrie();
+
+    /**
+     * @brief Add a suffix, only valid before build()
+     *
+     * @param suffix suffix to store (case insensitive)
+     * @param id id reported by findSuffixes when the suffix matches
+     */
+    void addSuffix(const std::wstring& suffix, const size_t& id);
+
+    /**
+     * @brief Compile the added suffixes
+     */
+    void build();
+
+    /**
+     * @brief Find all stored suffixes of a text
+     *
+     * @param text text to look up
+     * @param minLength only report suffixes at least this long
+     * @param[out] ids ids of the matching suffixes, sorted ascending without duplicates (cleared first)
+     */
+    void findSuffixes(const std::wstring& text, const size_t& minLength, std::vector<size_t>& ids) const;
+
+    /**
+     * @brief Get the number of added suffixes
+     *
+     * @return size_t number of suffixes
+     */
+    [[nodiscard]] auto getNumSuffixes() const -> size_t;
+};
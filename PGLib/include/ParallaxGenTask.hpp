@@ -1,8 +1,14 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <mutex>
 #include <string>
-#include <unordered_map>
+#include <thread>
 
 class ParallaxGenTask {
 public:
@@ -10,31 +16,86 @@ public:
 
 private:
     static constexpr int FULL_PERCENTAGE = 100;
+    static constexpr size_t NUM_RESULTS = 3;
+    static constexpr size_t NUM_SHARDS = 16;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr std::chrono::milliseconds REPORT_INTERVAL { 500 };
+    static constexpr double RATE_SMOOTHING = 0.3; /** < weight of the newest sample in the jobs/s and bytes/s average */
+
+    /**
+     * @struct CounterShard
+     * @brief Completed job counters of the threads mapped to this shard, on their own cache line so threads completing
+     * jobs at the same time do not write to the same line
+     */
+    struct alignas(CACHE_LINE_SIZE) CounterShard {
+        std::array<std::atomic<size_t>, NUM_RESULTS> numJobsCompleted {};
+        std::atomic<uint64_t> numBytesCompleted {};
+    };
+
+    static inline std::atomic<int> s_progressFD = -1; /** < file descriptor for JSON lines progress, -1 to disable */
+    static inline std::mutex s_progressFDMutex;
 
     int m_progressPrintModulo;
 
     std::string m_taskName;
     size_t m_totalJobs;
-    size_t m_lastPerc = 0;
-    std::mutex m_numJobsCompletedMutex;
 
-    std::unordered_map<PGResult, size_t> m_numJobsCompleted;
+    std::array<CounterShard, NUM_SHARDS> m_shards;
+
+    // reporter state, only used by the reporter thread
+    std::chrono::steady_clock::time_point m_startTime;
+    std::chrono::steady_clock::time_point m_lastSampleTime;
+    size_t m_lastSampleJobs = 0;
+    uint64_t m_lastSampleBytes = 0;
+    double m_jobsPerSec = 0.0;
+    double m_bytesPerSec = 0.0;
+    size_t m_lastPrintedStep = 0;
+    bool m_summaryPrinted = false;
 
-    std::unordered_map<PGResult, std::string> m_pgResultStr = { { PGResult::SUCCESS, "COMPLETED" },
-        { PGResult::SUCCESS_WITH_WARNINGS, "COMPLETED WITH WARNINGS" }, { PGResult::FAILURE, "FAILED" } };
+    std::mutex m_reporterMutex;
+    std::condition_variable m_reporterCV;
+    bool m_stopReporter = false;
+    std::thread m_reporter;
 
 public:
     ParallaxGenTask(std::string taskName, const size_t& totalJobs, const int& progressPrintModulo = 1);
+    ~ParallaxGenTask();
+    ParallaxGenTask(const ParallaxGenTask& other) = delete;
+    auto operator=(const ParallaxGenTask& other) -> ParallaxGenTask& = delete;
+    ParallaxGenTask(ParallaxGenTask&& other) noexcept = delete;
+    auto operator=(ParallaxGenTask&& other) noexcept -> ParallaxGenTask& = delete;
 
-    void completeJob(const PGResult& result);
-    [[nodiscard]] auto isCompleted() -> bool;
+    /**
+     * @brief Count a completed job, lock free so it can be called from any number of threads. Progress is printed by a
+     * reporter thread that samples the counters
+     *
+     * @param result result of the job
+     * @param numBytes size of the input of the job, used for the bytes/s rate
+     */
+    void completeJob(const PGResult& result, const uint64_t& numBytes = 0);
+    [[nodiscard]] auto isCompleted() const -> bool;
+
+    /**
+     * @brief Write every progress sample of every task as one JSON object per line to a file descriptor
+     *
+     * @param fd file descriptor that is already open for writing, -1 to disable
+     */
+    static void setProgressFD(const int& fd);
 
     static void updatePGResult(
         PGResult& result, const PGResult& currentResult, const PGResult& threshold = PGResult::FAILURE);
 
 private:
     void initJobStatus();
-    void printJobStatus(bool force = false);
-    void printJobSummary();
-    [[nodiscard]] auto getCompletedJobs() -> size_t;
+    void reporterLoop();
+
+    /**
+     * @brief Sum the counters, update the rates, print progress if it moved on and write a progress line if enabled
+     */
+    void sampleJobStatus();
+    void printJobSummary(const std::array<size_t, NUM_RESULTS>& numJobsCompleted);
+    static void writeProgressLine(const std::string& line);
+
+    [[nodiscard]] auto getCompletedJobs() const -> std::array<size_t, NUM_RESULTS>;
+    [[nodiscard]] auto getShard() -> CounterShard&;
 };
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <DirectXTex.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+#include "BethesdaDirectory.hpp"
+
+/**
+ * @class ParallaxGenTextureCache
+ * @brief Persistent cache of texture analysis results (DDS metadata and complex material detection)
+ * @details Entries are keyed by the lowercase relative path and only valid while the fingerprint of the winning file
+ * (source, size, last write time) is unchanged. Thread safe.
+ */
+class ParallaxGenTextureCache {
+public:
+    /**
+     * @struct Entry
+     * @brief Cached analysis of one texture
+     */
+    struct Entry {
+        BethesdaDirectory::FileFingerprint fingerprint;
+
+        bool hasMetadata = false; /** metadata holds the DDS header of the file */
+        DirectX::TexMetadata metadata {};
+
+        bool cmChecked = false; /** complex material detection ran, the CM fields are valid */
+        bool isCM = false;
+        bool hasEnvMask = false;
+        bool hasGlossiness = false;
+        bool hasMetalness = false;
+    };
+
+private:
+    static constexpr int CACHE_VERSION = 1; /** Bump when the stored format or analysis logic changes */
+    static constexpr double PERCENT = 100.0;
+
+    std::filesystem::path m_cacheFile; /** Path of the JSON cache file */
+
+    struct CacheEntry {
+        Entry entry;
+        bool used = false; /** Looked up or updated this run, unused entries are dropped on save */
+    };
+    std::unordered_map<std::filesystem::path, CacheEntry> m_entries;
+    std::mutex m_entriesMutex;
+
+    size_t m_numHits = 0;
+    size_t m_numMisses = 0;
+
+public:
+    /**
+     * @brief Construct a new texture cache
+     *
+     * @param cacheFile path of the JSON file the cache is loaded from and saved to
+     */
+    explicit ParallaxGenTextureCache(std::filesystem::path cacheFile);
+
+    /**
+     * @brief Load the cache file, a missing, outdated or corrupt file results in an empty cache
+     *
+     * @return true cache was loaded
+     * @return false cache file could not be used
+     */
+    auto load() -> bool;
+
+    /**
+     * @brief Save all entries that were used this run to the cache file
+     *
+     * @return true cache was saved
+     * @return false cache file could not be written
+     */
+    auto save() -> bool;
+
+    /**
+     * @brief Get the cached entry for a texture if its fingerprint still matches
+     *
+     * @param relPath path of the texture relative to the data directory
+     * @param fingerprint current fingerprint of the texture
+     * @param[out] entry cached entry
+     * @return true entry is valid
+     * @return false no entry or the file changed
+     */
+    auto lookup(const std::filesystem::path& relPath, const BethesdaDirectory::FileFingerprint& fingerprint,
+        Entry& entry) -> bool;
+
+    /**
+     * @brief Store the DDS metadata of a texture (resets the entry if the fingerprint changed)
+     *
+     * @param relPath path of the texture relative to the data directory
+     * @param fingerprint current fingerprint of the texture
+     * @param metadata DDS metadata
+     */
+    void updateMetadata(const std::filesystem::path& relPath, const BethesdaDirectory::FileFingerprint& fingerprint,
+        const DirectX::TexMetadata& metadata);
+
+    /**
+     * @brief Store the complex material detection result of a texture (resets the entry if the fingerprint changed)
+     *
+     * @param relPath path of the texture relative to the data directory
+     * @param fingerprint current fingerprint of the texture
+     * @param isCM texture is a complex material map
+     * @param hasEnvMask CM_ENVMASK attribute
+     * @param hasGlossiness CM_GLOSSINESS attribute
+     * @param hasMetalness CM_METALNESS attribute
+     */
+    void updateCM(const std::filesystem::path& relPath, const BethesdaDirectory::FileFingerprint& fingerprint,
+        const bool& isCM, const bool& hasEnvMask, const bool& hasGlossiness, const bool& hasMetalness);
+
+    /**
+     * @brief Log hit and miss counts
+     */
+    void logStats();
+
+private:
+    /**
+     * @brief Get the entry for a path, resetting it if the fingerprint changed (caller holds the lock)
+     *
+     * @param relPath path of the texture relative to the data directory
+     * @param fingerprint current fingerprint of the texture
+     * @return Entry& entry to update
+     */
+    auto getEntryForUpdate(const std::filesystem::path& relPath, const BethesdaDirectory::FileFingerprint& fingerprint)
+        -> Entry&;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+/**
+ * @class ParallaxGenTrace
+ * @brief Records timed spans of every thread and saves them as a Chrome trace event file
+ * @details Every thread appends its spans to its own buffer, recording never takes a lock. The buffers live until the
+ * process exits so they can be saved after their threads are gone. While tracing is disabled a span is a relaxed load
+ * and a branch. Open the saved file with chrome://tracing or https://ui.perfetto.dev
+ */
+class ParallaxGenTrace {
+private:
+    static inline std::atomic<bool> s_enabled = false;
+
+public:
+    /**
+     * @class Span
+     * @brief Records the time from construction to destruction on the calling thread
+     */
+    class Span {
+    private:
+        const char* m_name;
+        std::string m_detail;
+        int64_t m_startNS = -1; /** < -1 if tracing was disabled when the span started */
+
+    public:
+        /**
+         * @brief Start a span
+         *
+         * @param name name of the span, must be a string literal because it is saved after the span is gone
+         */
+        explicit Span(const char* name)
+            : m_name(name)
+        {
+            if (isEnabled()) {
+                m_startNS = getNowNS();
+            }
+        }
+
+        /**
+         * @brief Start a span with a file the span works on, the path is only converted while tracing
+         */
+        Span(const char* name, const std::filesystem::path& detail);
+
+        /**
+         * @brief Start a span with a detail that is only built while tracing
+         *
+         * @param getDetail returns a std::string or std::wstring
+         */
+        template <typename DetailFunc>
+            requires std::invocable<DetailFunc>
+        Span(const char* name, DetailFunc&& getDetail)
+            : Span(name)
+        {
+            if (m_startNS >= 0) {
+                setDetail(std::forward<DetailFunc>(getDetail)());
+            }
+        }
+
+        ~Span()
+        {
+            if (m_startNS >= 0) {
+                record(m_name, std::move(m_detail), m_startNS, getNowNS());
+            }
+        }
+
+        Span(const Span& other) = delete;
+        auto operator=(const Span& other) -> Span& = delete;
+        Span(Span&& other) noexcept = delete;
+        auto operator=(Span&& other) noexcept -> Span& = delete;
+
+    private:
+        void setDetail(const std::string& detail);
+        void setDetail(const std::wstring& detail);
+    };
+
+    /**
+     * @brief Start recording spans, spans started before are not recorded
+     */
+    static void enable();
+
+    /**
+     * @brief Stop recording spans, spans recorded so far are kept for save
+     */
+    static void disable();
+
+    /**
+     * @brief Check if spans are recorded
+     *
+     * @return true tracing is enabled
+     */
+    [[nodiscard]] static auto isEnabled() -> bool { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Save all spans recorded so far as Chrome trace event JSON. Spans still recording are not included
+     *
+     * @param tracePath file to write
+     */
+    static void save(const std::filesystem::path& tracePath);
+
+private:
+    [[nodiscard]] static auto getNowNS() -> int64_t
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /**
+     * @brief Append a span to the buffer of the calling thread
+     */
+    static void record(const char* name, std::string&& detail, const int64_t& startNS, const int64_t& endNS);
+};
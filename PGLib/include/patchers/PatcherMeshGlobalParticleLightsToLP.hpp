@@ -4,7 +4,15 @@
 #include <BasicTypes.hpp>
 #include <Geometry.hpp>
 #include <Nodes.hpp>
+#include <nlohmann/json.hpp>
+
+#include <array>
+#include <cstddef>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include "patchers/base/PatcherMeshGlobal.hpp"
 #include <Shaders.hpp>
@@ -15,13 +23,105 @@
  */
 class PatcherMeshGlobalParticleLightsToLP : public PatcherMeshGlobal {
 private:
-    static nlohmann::json s_lpJsonData; /** < LP JSON data */
-    static std::mutex s_lpJsonDataMutex; /** < Mutex for LP JSON data */
-
     static constexpr int PARTICLE_LIGHT_FLAGS = 4109; /** < Particle light flags */
     static constexpr int WHITE_COLOR = 255; /** < White color */
     static constexpr double MIN_VALUE = 1e-5; /** < Minimum value */
     static constexpr float ROUNDING_VALUE = 1000000.0; /** < Rounding value */
+    static constexpr const char* PLACEHOLDER_LIGHT = "MagicLightWhite01"; /** < Light overridden by the LP data */
+
+    /**
+     * @struct LPFadeKey
+     * @brief Key of an emissive multiple controller (values are rounded)
+     */
+    struct LPFadeKey {
+        float time = 0.0F;
+        float value = 0.0F;
+        float forward = 0.0F;
+        float backward = 0.0F;
+
+        auto operator==(const LPFadeKey& other) const -> bool = default;
+    };
+
+    /**
+     * @struct LPColorKey
+     * @brief Key of an emissive color controller
+     */
+    struct LPColorKey {
+        float time = 0.0F;
+        std::array<int, 3> color {};
+        std::array<int, 3> forward {};
+        std::array<int, 3> backward {};
+
+        auto operator==(const LPColorKey& other) const -> bool = default;
+    };
+
+    /**
+     * @struct LPController
+     * @brief Fade or color controller of a light, only the keys matching the controller type are set
+     */
+    struct LPController {
+        std::string interpolation;
+        std::vector<LPFadeKey> fadeKeys;
+        std::vector<LPColorKey> colorKeys;
+
+        auto operator==(const LPController& other) const -> bool = default;
+
+        [[nodiscard]] auto getJSON() const -> nlohmann::json;
+    };
+
+    /**
+     * @struct LPLightData
+     * @brief "data" object of a LightPlacer light, lights with equal data in the same model share one entry
+     */
+    struct LPLightData {
+        std::array<int, 3> color {};
+        int radius = 0;
+        double fade = 0.0;
+        std::optional<LPController> fadeController;
+        std::optional<LPController> colorController;
+
+        auto operator==(const LPLightData& other) const -> bool = default;
+
+        [[nodiscard]] auto getJSON() const -> nlohmann::json;
+    };
+
+    struct LPLightDataHash {
+        auto operator()(const LPLightData& data) const -> size_t;
+    };
+
+    /**
+     * @struct LPLight
+     * @brief One particle light found in a model
+     */
+    struct LPLight {
+        std::string model; /** < Model path without "meshes\\" */
+        std::array<double, 3> point {}; /** < Global position of the light (rounded) */
+        LPLightData data;
+    };
+
+    /**
+     * @struct LPLightBuffer
+     * @brief Lights found by one thread, only locked by that thread and finalize
+     */
+    struct LPLightBuffer {
+        std::vector<LPLight> lights;
+        std::mutex mutex;
+    };
+
+    /**
+     * @brief Get the light buffers of all threads that found lights
+     *
+     * @return std::vector<std::shared_ptr<LPLightBuffer>>& buffers (guarded by getLightBuffersMutex)
+     */
+    static auto getLightBuffers() -> std::vector<std::shared_ptr<LPLightBuffer>>&;
+    static auto getLightBuffersMutex() -> std::mutex&;
+
+    /**
+     * @brief Get the light buffer of the calling thread (registered on first use)
+     *
+     * @return LPLightBuffer& buffer of this thread
+     */
+    static auto getThreadLightBuffer() -> LPLightBuffer&;
 
 public:
     /**
@@ -49,7 +149,7 @@ public:
     auto applyPatch() -> bool override;
 
     /**
-     * @brief Save output JSON
+     * @brief Group all found lights by model and light data and stream the LightPlacer JSON to the output
      */
     static void finalize();
 
@@ -67,11 +167,11 @@ private:
         nifly::NiBillboardNode* node, nifly::NiShape* shape, nifly::BSEffectShaderProperty* effectShader) -> bool;
 
     /**
-     * @brief Get LP JSON for a specific NIF controller
+     * @brief Get the LP controller for a specific NIF controller
      *
-     * @param controller Controller to get JSON for
-     * @param jsonField JSON field to store controller JSON in LP
-     * @return nlohmann::json JSON for controller
+     * @param controller Controller to convert
+     * @param[out] isColorController true if the result is a color controller, false if it is a fade controller
+     * @return std::optional<LPController> controller, empty if the NIF controller is not relevant for LP
      */
-    auto getControllerJSON(nifly::NiTimeController* controller, std::string& jsonField) -> nlohmann::json;
+    auto getController(nifly::NiTimeController* controller, bool& isColorController) -> std::optional<LPController>;
 };
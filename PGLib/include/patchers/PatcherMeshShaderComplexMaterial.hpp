@@ -98,8 +98,6 @@ public:
     auto applyPatchSlots(const NIFUtil::TextureSet& oldSlots, const PatcherMatch& match, NIFUtil::TextureSet& newSlots)
         -> bool override;
 
-    void processNewTXSTRecord(const PatcherMatch& match, const std::string& edid = {}) override;
-
     /**
      * @brief Apply CM shader to a shape
      *
@@ -1,8 +1,12 @@
 #pragma once
 
 #include "NIFUtil.hpp"
+#include "ParallaxGenContentCache.hpp"
+#include "ParallaxGenOnceMap.hpp"
 #include "patchers/base/PatcherMeshShaderTransform.hpp"
-#include <mutex>
+
+#include <filesystem>
+#include <string>
 
 /**
  * @class PatcherMeshShaderTransformParallaxToCM
@@ -10,9 +14,24 @@
  */
 class PatcherMeshShaderTransformParallaxToCM : public PatcherMeshShaderTransform {
 private:
-    static std::mutex s_upgradeCMMutex; /** < Mutex for the upgrade to CM */
+    static ParallaxGenContentCache* s_cmCache; /** < Cache of generated complex material maps, optional */
+    static constexpr const char* CM_GENERATOR_VERSION = "MergeToCM-1"; /** < Bump to invalidate cached maps */
+
+    /**
+     * @brief Get the upgrade result of every complex material map requested this run
+     *
+     * @return ParallaxGenOnceMap<std::wstring, bool>& lowercase complex map path -> upgrade succeeded
+     */
+    static auto getUpgradeResults() -> ParallaxGenOnceMap<std::wstring, bool>&;
 
 public:
+    /**
+     * @brief Set the cache used to reuse complex material maps generated in previous runs
+     *
+     * @param cmCache cache to use, must outlive patching (nullptr disables the cache)
+     */
+    static void loadCMCache(ParallaxGenContentCache* cmCache);
+
     /**
      * @brief Get the Factory object for Parallax > CM transform
      *
@@ -50,4 +69,25 @@ public:
      */
     auto transform(const PatcherMeshShader::PatcherMatch& fromMatch, PatcherMeshShader::PatcherMatch& result)
         -> bool override;
+
+private:
+    /**
+     * @brief Generate (or fetch from the cache) the complex material map for a height map, called once per map
+     *
+     * @param heightMap height map to upgrade
+     * @param texBase texture base of the height map
+     * @param complexMap relative path of the complex material map to create
+     * @return true map exists in the output
+     * @return false map could not be generated
+     */
+    static auto upgradeToCM(
+        const std::wstring& heightMap, const std::wstring& texBase, const std::filesystem::path& complexMap) -> bool;
+
+    /**
+     * @brief Register a complex material map written to the output directory with the directory and texture maps
+     *
+     * @param complexMap relative path of the generated map
+     * @param heightMap height map the map was generated from (used for the mod)
+     */
+    static void addGeneratedComplexMap(const std::filesystem::path& complexMap, const std::filesystem::path& heightMap);
 };
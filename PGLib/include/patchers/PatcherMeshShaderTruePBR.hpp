@@ -2,14 +2,19 @@
 
 #include <Geometry.hpp>
 #include <NifFile.hpp>
+#include <array>
+#include <cstdint>
 #include <filesystem>
 #include <map>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "NIFUtil.hpp"
+#include "ParallaxGenAhoCorasick.hpp"
+#include "ParallaxGenSuffixTrie.hpp"
 #include "patchers/base/PatcherMeshShader.hpp"
 
 constexpr unsigned TEXTURE_STR_LENGTH = 9;
@@ -19,64 +24,182 @@ constexpr unsigned TEXTURE_STR_LENGTH = 9;
  * @brief Patcher for True PBR
  */
 class PatcherMeshShaderTruePBR : public PatcherMeshShader {
-private:
-    // Static caches
-
+public:
     /**
-     * @struct TupleStrHash
-     * @brief Key hash for storing a tuple of two strings
+     * @struct TruePBRRule
+     * @brief One TruePBR config entry compiled from JSON at load time
+     * @details Optional attributes are tracked in the fields bitmask and boolean attribute values in the flags bitmask,
+     * so the patching hot path never touches JSON. Match paths are stored lowercase and without texture suffixes.
      */
-    struct TupleStrHash {
-        auto operator()(const std::tuple<std::wstring, std::wstring>& t) const -> std::size_t
-        {
-            const std::size_t hash1 = std::hash<std::wstring> {}(std::get<0>(t));
-            const std::size_t hash2 = std::hash<std::wstring> {}(std::get<1>(t));
-
-            // Combine the two hash values
-            return hash1 ^ (hash2 << 1);
-        }
+    struct TruePBRRule {
+        enum Field : uint64_t {
+            FIELD_MATCH_NORMAL = 1ULL << 0U,
+            FIELD_MATCH_DIFFUSE = 1ULL << 1U,
+            FIELD_PATH_CONTAINS = 1ULL << 2U,
+            FIELD_NIF_FILTER = 1ULL << 3U,
+            FIELD_RENAME = 1ULL << 4U,
+            FIELD_PBR = 1ULL << 5U,
+            FIELD_DELETE = 1ULL << 6U,
+            FIELD_ENV_MAPPING = 1ULL << 7U,
+            FIELD_SMOOTH_ANGLE = 1ULL << 8U,
+            FIELD_AUTO_UV = 1ULL << 9U,
+            FIELD_VERTEX_COLORS = 1ULL << 10U,
+            FIELD_SPECULAR_LEVEL = 1ULL << 11U,
+            FIELD_SUBSURFACE_COLOR = 1ULL << 12U,
+            FIELD_ROUGHNESS_SCALE = 1ULL << 13U,
+            FIELD_SUBSURFACE_OPACITY = 1ULL << 14U,
+            FIELD_DISPLACEMENT_SCALE = 1ULL << 15U,
+            FIELD_ENV_MAP_SCALE = 1ULL << 16U,
+            FIELD_ENV_MAP_SCALE_MULT = 1ULL << 17U,
+            FIELD_EMISSIVE_SCALE = 1ULL << 18U,
+            FIELD_EMISSIVE_COLOR = 1ULL << 19U,
+            FIELD_UV_SCALE = 1ULL << 20U,
+            FIELD_LOCK_DIFFUSE = 1ULL << 21U,
+            FIELD_LOCK_NORMAL = 1ULL << 22U,
+            FIELD_EMISSIVE = 1ULL << 23U,
+            FIELD_LOCK_EMISSIVE = 1ULL << 24U,
+            FIELD_PARALLAX = 1ULL << 25U,
+            FIELD_LOCK_PARALLAX = 1ULL << 26U,
+            FIELD_CUBEMAP = 1ULL << 27U,
+            FIELD_LOCK_CUBEMAP = 1ULL << 28U,
+            FIELD_LOCK_RMAOS = 1ULL << 29U,
+            FIELD_LOCK_CNR = 1ULL << 30U,
+            FIELD_COAT_NORMAL = 1ULL << 31U,
+            FIELD_LOCK_SUBSURFACE = 1ULL << 32U,
+            FIELD_SUBSURFACE_FOLIAGE = 1ULL << 33U,
+            FIELD_SUBSURFACE = 1ULL << 34U,
+            FIELD_COAT_DIFFUSE = 1ULL << 35U,
+            FIELD_HAIR = 1ULL << 36U,
+            FIELD_MULTILAYER = 1ULL << 37U,
+            FIELD_COAT_COLOR = 1ULL << 38U,
+            FIELD_COAT_SPECULAR_LEVEL = 1ULL << 39U,
+            FIELD_COAT_ROUGHNESS = 1ULL << 40U,
+            FIELD_COAT_STRENGTH = 1ULL << 41U,
+            FIELD_COAT_PARALLAX = 1ULL << 42U,
+            FIELD_INNER_UV_SCALE = 1ULL << 43U,
+            FIELD_GLINT = 1ULL << 44U,
+            FIELD_GLINT_SCREEN_SPACE_SCALE = 1ULL << 45U,
+            FIELD_GLINT_LOG_MICROFACET_DENSITY = 1ULL << 46U,
+            FIELD_GLINT_MICROFACET_DENSITY = 1ULL << 47U,
+            FIELD_GLINT_MICROFACET_ROUGHNESS = 1ULL << 48U,
+            FIELD_GLINT_DENSITY_RANDOMIZATION = 1ULL << 49U,
+            FIELD_FUZZ = 1ULL << 50U,
+            FIELD_FUZZ_COLOR = 1ULL << 51U,
+            FIELD_FUZZ_WEIGHT = 1ULL << 52U,
+            FIELD_FUZZ_TEXTURE = 1ULL << 53U
+        };
+
+        uint64_t fields = 0; /** < Attributes present in the config */
+        uint64_t flags = 0; /** < Values of boolean attributes (only set if present) */
+        uint8_t slotFields = 0; /** < "slotX" attributes present in the config, bit X-1 */
+
+        std::wstring json; /** < Config file the entry was loaded from */
+        std::wstring matchNormal; /** < "match_normal" with leading backslash */
+        std::wstring matchDiffuse; /** < "match_diffuse" (or "texture") with leading backslash */
+        size_t matchFieldBaseLength = 0; /** < Length of the matched field without texture suffix */
+        std::wstring pbrSuffix; /** < Lowercase "rename" or matched field, appended to the PBR prefix */
+        std::wstring pathContains; /** < Lowercase "path_contains" */
+        std::wstring nifFilter; /** < Lowercase "nif_filter" */
+        std::wstring cubemap;
+        std::array<std::wstring, NUM_TEXTURE_SLOTS - 1> slots; /** < "slotX" paths with "textures\\" prefix */
+
+        float smoothAngle = 0.0F;
+        float autoUV = 0.0F;
+        float specularLevel = 0.0F;
+        std::array<float, 3> subsurfaceColor {};
+        float roughnessScale = 0.0F;
+        float subsurfaceOpacity = 0.0F;
+        float displacementScale = 0.0F;
+        float envMapScale = 0.0F;
+        float envMapScaleMult = 0.0F;
+        float emissiveScale = 0.0F;
+        std::array<float, 4> emissiveColor {};
+        float uvScale = 0.0F;
+        std::array<float, 3> coatColor {};
+        float coatSpecularLevel = 0.0F;
+        float coatRoughness = 0.0F;
+        float coatStrength = 0.0F;
+        float innerUVScale = 0.0F;
+        float glintScreenSpaceScale = 0.0F;
+        float glintLogMicrofacetDensity = 0.0F;
+        float glintMicrofacetDensity = 0.0F;
+        float glintMicrofacetRoughness = 0.0F;
+        float glintDensityRandomization = 0.0F;
+        std::array<float, 3> fuzzColor {};
+        float fuzzWeight = 1.0F;
+
+        /**
+         * @brief Check if an attribute is present
+         *
+         * @param field attribute to check
+         * @return true attribute is present
+         */
+        [[nodiscard]] auto has(const Field& field) const -> bool { return (fields & field) != 0; }
+
+        /**
+         * @brief Check if a boolean attribute is present and true
+         *
+         * @param field attribute to check
+         * @return true attribute is present and true
+         */
+        [[nodiscard]] auto flag(const Field& field) const -> bool { return (flags & field) != 0; }
+
+        /**
+         * @brief Check if a "slotX" attribute is present
+         *
+         * @param slot zero based slot index
+         * @return true attribute is present
+         */
+        [[nodiscard]] auto hasSlot(const size_t& slot) const -> bool { return (slotFields & (1U << slot)) != 0; }
+
+        /**
+         * @brief Rebuild the JSON form of the rule (for diagnostics)
+         *
+         * @return nlohmann::json config JSON
+         */
+        [[nodiscard]] auto getJSON() const -> nlohmann::json;
     };
 
+    /**
+     * @brief Rules matched for one PatcherMatch, rule index to PBR texture prefix (empty if PBR is not enabled)
+     */
+    using TruePBRMatchData = std::map<size_t, std::wstring>;
+
+private:
+    inline static std::vector<TruePBRRule> s_truePBRRules;
+
     // Options
     inline static bool s_checkPaths;
     inline static bool s_printNonExistentPaths;
 
 public:
     /**
-     * @brief Get the True PBR Configs
+     * @brief Get the compiled True PBR rules, indexed by config order (immutable after loadStatics)
      *
-     * @return std::map<size_t, nlohmann::json>& JSON objects
+     * @return const std::vector<TruePBRRule>& Rules
      */
-    static auto getTruePBRConfigs() -> std::map<size_t, nlohmann::json>&;
+    static auto getTruePBRRules() -> const std::vector<TruePBRRule>&;
 
     /**
-     * @brief Get the Path Lookup JSONs objects
+     * @brief Get the matcher for "path_contains" rules (pattern ids are rule indices, immutable after loadStatics)
      *
-     * @return std::map<size_t, nlohmann::json>& JSON objects
+     * @return ParallaxGenAhoCorasick& Matcher
      */
-    static auto getPathLookupJSONs() -> std::map<size_t, nlohmann::json>&;
+    static auto getPathContainsMatcher() -> ParallaxGenAhoCorasick&;
 
     /**
-     * @brief Get the Path Lookup Cache object
+     * @brief Get the lookup for "match_diffuse" rules (suffix ids are rule indices, immutable after loadStatics)
      *
-     * @return std::unordered_map<std::tuple<std::wstring, std::wstring>, bool, TupleStrHash>& Cache results for path
-     * lookups
+     * @return ParallaxGenSuffixTrie& Lookup
      */
-    static auto getPathLookupCache() -> std::unordered_map<std::tuple<std::wstring, std::wstring>, bool, TupleStrHash>&;
+    static auto getTruePBRDiffuseLookup() -> ParallaxGenSuffixTrie&;
 
     /**
-     * @brief Get the True PBR Diffuse Inverse lookup table
+     * @brief Get the lookup for "match_normal" rules (suffix ids are rule indices, immutable after loadStatics)
      *
-     * @return std::map<std::wstring, std::vector<size_t>>& Lookup
+     * @return ParallaxGenSuffixTrie& Lookup
      */
-    static auto getTruePBRDiffuseInverse() -> std::map<std::wstring, std::vector<size_t>>&;
-
-    /**
-     * @brief Get the True PBR Normal Inverse lookup table
-     *
-     * @return std::map<std::wstring, std::vector<size_t>>& Lookup
-     */
-    static auto getTruePBRNormalInverse() -> std::map<std::wstring, std::vector<size_t>>&;
+    static auto getTruePBRNormalLookup() -> ParallaxGenSuffixTrie&;
 
     /**
      * @brief Get the True PBR Config Filename Fields (fields that have paths)
@@ -170,7 +293,15 @@ public:
      */
     auto applyShader(nifly::NiShape& nifShape) -> bool override;
 
-    void processNewTXSTRecord(const PatcherMatch& match, const std::string& edid = {}) override;
+    /**
+     * @brief Write the PBR texture swap JSON of a new TXST record
+     *
+     * @param match match the new record was made from
+     * @param edid EDID of the new record
+     */
+    static void processNewTXSTRecord(const PatcherMatch& match, const std::string& edid);
+
+    [[nodiscard]] auto getNewTXSTRecordWriter() const -> NewTXSTRecordWriter override;
 
     /**
      * @brief Load PBR options string
@@ -181,30 +312,53 @@ public:
 
     static void loadOptions(const bool& checkPaths, const bool& printNonExistentPaths);
 
+    /**
+     * @brief Get the "smooth_angle" to apply for a match, the last rule in config order that sets it wins
+     *
+     * @param truePBRData Rules that matched
+     * @return std::optional<float> Smooth angle, empty if no applied rule sets it
+     */
+    static auto getSmoothAngle(const TruePBRMatchData& truePBRData) -> std::optional<float>;
+
 private:
     /**
-     * @brief Applies a single JSON config to a shape
+     * @brief Compile one JSON config entry into a rule
+     *
+     * @param element JSON config entry (after preprocessing)
+     * @return TruePBRRule Compiled rule
+     */
+    static auto compileRule(const nlohmann::json& element) -> TruePBRRule;
+
+    /**
+     * @brief Applies a single rule to a shape ("smooth_angle" is applied by applyPatch once all rules ran)
      *
      * @param nifShape Shape to patch
-     * @param truePBRData Data to patch
+     * @param rule Rule to apply
      * @param matchedPath Matched path (PBR prefix)
      * @param[out] newSlots New slots of shape
      */
-    auto applyOnePatch(nifly::NiShape* nifShape, nlohmann::json& truePBRData, const std::wstring& matchedPath,
+    auto applyOnePatch(nifly::NiShape* nifShape, const TruePBRRule& rule, const std::wstring& matchedPath,
         NIFUtil::TextureSet& newSlots) -> bool;
 
-    static void applyOnePatchSwapJSON(const nlohmann::json& truePBRData, nlohmann::json& output);
+    static void applyOnePatchSwapJSON(const TruePBRRule& rule, nlohmann::json& output);
 
     /**
-     * @brief Applies a single JSON config to slots
+     * @brief Recalculate smoothed normals and tangents of a shape (SIMD kernels in ParallaxGenMeshMath)
      *
-     * @param oldSlots Slots to patch
-     * @param truePBRData Data to patch
+     * @param nifShape Shape to recalculate
+     * @param smoothAngle Largest angle in degrees between normals that are smoothed together
+     */
+    void recalcNormalsAndTangents(nifly::NiShape& nifShape, const float& smoothAngle);
+
+    /**
+     * @brief Applies a single rule to slots
+     *
+     * @param slots Slots to patch
+     * @param rule Rule to apply
      * @param matchedPath Matched path (PBR prefix)
-     * @return NIFUtil::TextureSet New slots after patch
      */
     static void applyOnePatchSlots(
-        NIFUtil::TextureSet& slots, const nlohmann::json& truePBRData, const std::wstring& matchedPath);
+        NIFUtil::TextureSet& slots, const TruePBRRule& rule, const std::wstring& matchedPath);
 
     /**
      * @brief Enables truepbr on a shape (pbr: true in JSON)
@@ -212,26 +366,18 @@ private:
      * @param nifShape Shape to enable truepbr on
      * @param nifShader Shader of shape
      * @param nifShaderBSLSP Properties of shader
-     * @param truePBRData Data to enable truepbr with
+     * @param rule Rule to enable truepbr with
      * @param matchedPath Matched path (PBR prefix)
      * @param[out] newSlots New slots of shape
      */
     auto enableTruePBROnShape(nifly::NiShape* nifShape, nifly::NiShader* nifShader,
-        nifly::BSLightingShaderProperty* nifShaderBSLSP, nlohmann::json& truePBRData, const std::wstring& matchedPath,
+        nifly::BSLightingShaderProperty* nifShaderBSLSP, const TruePBRRule& rule, const std::wstring& matchedPath,
         NIFUtil::TextureSet& newSlots) -> bool;
 
     // TruePBR Helpers
 
     /**
-     * @brief Calculate ABS of 2-element vector
-     *
-     * @param v vector to calculate abs of
-     * @return nifly::Vector2 ABS of vector
-     */
-    static auto abs2(nifly::Vector2 v) -> nifly::Vector2;
-
-    /**
-     * @brief Math that calculates auto UV scale for a shape
+     * @brief Math that calculates auto UV scale for a shape (SIMD kernel in ParallaxGenMeshMath)
      *
      * @param uvs UVs of shape
      * @param verts Vertices of shape
@@ -239,49 +385,38 @@ private:
      * @return nifly::Vector2
      */
     static auto autoUVScale(const std::vector<nifly::Vector2>* uvs, const std::vector<nifly::Vector3>* verts,
-        std::vector<nifly::Triangle>& tris) -> nifly::Vector2;
-
-    /**
-     * @brief Checks if a JSON field has a key and that key is true
-     *
-     * @param json JSON to check
-     * @param key Key to check
-     * @return true has key and is true
-     * @return false does not have key or is not true
-     */
-    static auto flag(const nlohmann::json& json, const char* key) -> bool;
+        const std::vector<nifly::Triangle>& tris) -> nifly::Vector2;
 
     /**
      * @brief Get the Slot Match for a given lookup (diffuse or normal)
      *
-     * @param[out] truePBRData Data that matched
+     * @param[out] truePBRData Rules that matched
      * @param texName Texture name to match
      * @param lookup Lookup table to use
      * @param slotLabel Slot label to use
-     * @param nifPath NIF path to use
+     * @param nifPath Lowercase NIF path to use
      */
-    static void getSlotMatch(std::map<size_t, std::tuple<nlohmann::json, std::wstring>>& truePBRData,
-        const std::wstring& texName, const std::map<std::wstring, std::vector<size_t>>& lookup,
-        const std::wstring& slotLabel, const std::wstring& nifPath);
+    static void getSlotMatch(TruePBRMatchData& truePBRData, const std::wstring& texName,
+        const ParallaxGenSuffixTrie& lookup, const std::wstring& slotLabel, const std::wstring& nifPath);
 
     /**
      * @brief Get path contains match for diffuse
      *
-     * @param[out] truePBRData Data that matched
+     * @param[out] truePBRData Rules that matched
      * @param[out] diffuse Texture name to patch
-     * @param nifPath NIF path to use
+     * @param nifPath Lowercase NIF path to use
      */
-    static void getPathContainsMatch(std::map<size_t, std::tuple<nlohmann::json, std::wstring>>& truePBRData,
-        const std::wstring& diffuse, const std::wstring& nifPath);
+    static void getPathContainsMatch(
+        TruePBRMatchData& truePBRData, const std::wstring& diffuse, const std::wstring& nifPath);
 
     /**
      * @brief Inserts truepbr data if criteria is met
      *
-     * @param[out] truePBRData Data to update
+     * @param[out] truePBRData Rules to update
      * @param texName Texture name to insert
-     * @param cfg Config ID
-     * @param nifPath NIF path to use
+     * @param cfg Rule index
+     * @param nifPath Lowercase NIF path to use
      */
-    static void insertTruePBRData(std::map<size_t, std::tuple<nlohmann::json, std::wstring>>& truePBRData,
-        const std::wstring& texName, size_t cfg, const std::wstring& nifPath);
+    static void insertTruePBRData(
+        TruePBRMatchData& truePBRData, const std::wstring& texName, size_t cfg, const std::wstring& nifPath);
 };
@@ -12,10 +12,6 @@
  * @brief Patcher for vanilla parallax
  */
 class PatcherMeshShaderVanillaParallax : public PatcherMeshShader {
-private:
-    bool m_hasAttachedHavok
-        = false; /** Stores at the NIF level whether the NIF has attached havok (incompatible with parallax) */
-
 public:
     /**
      * @brief Get the Factory object for parallax patcher
@@ -90,8 +86,6 @@ public:
     auto applyPatchSlots(const NIFUtil::TextureSet& oldSlots, const PatcherMatch& match, NIFUtil::TextureSet& newSlots)
         -> bool override;
 
-    void processNewTXSTRecord(const PatcherMatch& match, const std::string& edid = {}) override;
-
     /**
      * @brief Apply parallax shader to a shape
      *
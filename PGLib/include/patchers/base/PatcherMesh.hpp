@@ -1,6 +1,10 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "NifFile.hpp"
 
@@ -11,10 +15,79 @@
  * @brief Base class for all patchers
  */
 class PatcherMesh : public Patcher {
+public:
+    /**
+     * @class NIFIndex
+     * @brief Typed index of a NIF built with one pass over its block tree, shared by all patchers of that NIF
+     * @details Blocks are stored as pointers instead of block ids because ids shift when blocks are deleted. The index
+     * describes the NIF as loaded: blocks added by patchers are not in it and blocks deleted by patchers dangle.
+     */
+    class NIFIndex {
+    public:
+        /**
+         * @struct ShapeInfo
+         * @brief Shape to shader to texture set links and flags of a shape
+         */
+        struct ShapeInfo {
+            nifly::NiShader* shader = nullptr; /** < Shader block, null if the shape has none */
+            nifly::BSShaderTextureSet* textureSet = nullptr; /** < Texture set block of the shader, null if none */
+            bool isPatchableType = false; /** < NiTriShape, BSTriShape, BSLODTriShape or BSMeshLODTriShape */
+            bool hasLightingShader = false; /** < Shader is a BSLightingShaderProperty */
+            bool isSkinned = false; /** < Shape has a skin instance or skinned vertices */
+        };
+
+    private:
+        std::unordered_map<std::string, std::vector<nifly::NiObject*>> m_blocksByType; /** < Block name -> blocks */
+        std::unordered_map<nifly::NiShape*, ShapeInfo> m_shapes; /** < Shapes in the block tree */
+        bool m_hasAttachedHavok = false; /** < NIF has BSBehaviorGraphExtraData (attached havok animations) */
+        bool m_hasSkinnedShapes = false; /** < Any shape in the NIF is skinned */
+
+    public:
+        NIFIndex() = default;
+
+        /**
+         * @brief Build the index of a NIF
+         *
+         * @param nif NIF to index
+         */
+        explicit NIFIndex(nifly::NifFile& nif);
+
+        /**
+         * @brief Get all blocks of a type in block tree order
+         *
+         * @param blockName block type name (ie. "NiBillboardNode")
+         * @return const std::vector<nifly::NiObject*>& blocks of that type, empty if there are none
+         */
+        [[nodiscard]] auto getBlocks(const std::string& blockName) const -> const std::vector<nifly::NiObject*>&;
+
+        /**
+         * @brief Get the links and flags of a shape
+         *
+         * @param nif NIF the shape belongs to, used for shapes outside of the block tree
+         * @param nifShape shape to look up
+         * @return ShapeInfo links and flags of the shape
+         */
+        [[nodiscard]] auto getShapeInfo(nifly::NifFile& nif, nifly::NiShape* nifShape) const -> ShapeInfo;
+
+        [[nodiscard]] auto hasAttachedHavok() const -> bool;
+        [[nodiscard]] auto hasSkinnedShapes() const -> bool;
+
+        /**
+         * @brief Build the links and flags of a single shape
+         *
+         * @param nif NIF the shape belongs to
+         * @param nifShape shape to inspect
+         * @return ShapeInfo links and flags of the shape
+         */
+        static auto buildShapeInfo(nifly::NifFile& nif, nifly::NiShape* nifShape) -> ShapeInfo;
+    };
+
 private:
     // Instance vars
     std::filesystem::path m_nifPath; /** Stores the path to the NIF file currently being patched */
     nifly::NifFile* m_nif; /** Stores the NIF object itself */
+    const NIFIndex* m_nifIndex = nullptr; /** Shared index of the NIF (not owned) */
+    std::shared_ptr<NIFIndex> m_ownNIFIndex; /** Index built on demand if no shared index was set */
 
 protected:
     /**
@@ -31,6 +104,13 @@ protected:
      */
     [[nodiscard]] auto getNIF() const -> nifly::NifFile*;
 
+    /**
+     * @brief Get the block index of the NIF (built on first use if no shared index was set)
+     *
+     * @return const NIFIndex& index of the NIF
+     */
+    [[nodiscard]] auto getNIFIndex() -> const NIFIndex&;
+
 public:
     /**
      * @brief Construct a new Patcher object
@@ -41,4 +121,20 @@ public:
      */
     PatcherMesh(
         std::filesystem::path nifPath, nifly::NifFile* nif, std::string patcherName, const bool& triggerSave = true);
+
+    /**
+     * @brief Bind the patcher to another NIF so the same object can be reused, resets all per NIF state
+     * @details Shared per NIF objects (ie. the NIF index) have to be set again after binding.
+     *
+     * @param nifPath Path to NIF being patched
+     * @param nif NIF object
+     */
+    virtual void bind(std::filesystem::path nifPath, nifly::NifFile* nif);
+
+    /**
+     * @brief Set the shared block index of the NIF this patcher works on
+     *
+     * @param nifIndex index built from the same NIF object, must outlive the patcher
+     */
+    void setNIFIndex(const NIFIndex* nifIndex);
 };
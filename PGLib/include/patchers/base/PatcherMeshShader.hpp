@@ -3,6 +3,8 @@
 #include <Geometry.hpp>
 #include <NifFile.hpp>
 
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 #include "NIFUtil.hpp"
@@ -13,22 +15,21 @@
  * @brief Base class for shader patchers
  */
 class PatcherMeshShader : public PatcherMesh {
-private:
-    struct PatchedTextureSetsHash {
-        auto operator()(const std::tuple<std::filesystem::path, uint32_t>& key) const -> std::size_t
-        {
-            return std::hash<std::filesystem::path>()(std::get<0>(key)) ^ std::hash<uint32_t>()(std::get<1>(key));
-        }
-    };
-
+public:
+    /**
+     * @struct PatchedTextureSet
+     * @brief Original slots of a texture set block and every slot combination it has been patched to
+     */
     struct PatchedTextureSet {
         NIFUtil::TextureSet original;
-        std::unordered_map<uint32_t, NIFUtil::TextureSet> patchResults;
+        std::unordered_map<uint32_t, NIFUtil::TextureSet> patchResults; /** < new block id -> slots */
     };
 
-    static std::mutex s_patchedTextureSetsMutex;
-    static std::unordered_map<std::tuple<std::filesystem::path, uint32_t>, PatchedTextureSet, PatchedTextureSetsHash>
-        s_patchedTextureSets;
+    /// @brief Texture sets patched in one NIF keyed by original block id, shared by all shader patchers of that NIF
+    using PatchedTextureSets = std::unordered_map<uint32_t, PatchedTextureSet>;
+
+private:
+    PatchedTextureSets* m_patchedTextureSets = nullptr; /** Patched texture sets of the current NIF (not owned) */
 
 protected:
     auto getTextureSet(nifly::NiShape& nifShape) -> NIFUtil::TextureSet;
@@ -58,6 +59,17 @@ public:
     PatcherMeshShader(PatcherMeshShader&& other) noexcept = default;
     auto operator=(PatcherMeshShader&& other) noexcept -> PatcherMeshShader& = default;
 
+    void bind(std::filesystem::path nifPath, nifly::NifFile* nif) override;
+
+    /**
+     * @brief Set the patched texture sets of the NIF this patcher works on
+     * @details Every shader patcher of a NIF must share the same object, which must outlive the patchers. Without it
+     * texture sets are overwritten in place and never split between shapes.
+     *
+     * @param patchedTextureSets per NIF patched texture sets
+     */
+    void setPatchedTextureSets(PatchedTextureSets* patchedTextureSets);
+
     /**
      * @brief Checks if a shape can be patched by this patcher (without looking at slots)
      *
@@ -91,7 +103,12 @@ public:
         const NIFUtil::TextureSet& oldSlots, const PatcherMatch& match, NIFUtil::TextureSet& newSlots) -> bool
         = 0;
 
-    virtual void processNewTXSTRecord(const PatcherMatch& match, const std::string& edid = {}) = 0;
+    /// @brief writes patcher output for a new TXST record once it has an EDID, needs no patcher object
+    using NewTXSTRecordWriter = void (*)(const PatcherMatch& match, const std::string& edid);
+
+    /// @brief get the writer for new TXST records made from the matches of this patcher
+    /// @return static writer, null if the patcher writes nothing for new records
+    [[nodiscard]] virtual auto getNewTXSTRecordWriter() const -> NewTXSTRecordWriter { return nullptr; }
 
     /// @brief apply the shader to the shape
     /// @param[in] nifShape shape to apply the shader to
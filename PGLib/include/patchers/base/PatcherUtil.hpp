@@ -1,7 +1,15 @@
 #pragma once
 
 #include <nlohmann/json_fwd.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "patchers/base/PatcherMeshGlobal.hpp"
 #include "patchers/base/PatcherMeshPre.hpp"
@@ -29,6 +37,21 @@ public:
         std::unordered_map<NIFUtil::ShapeShader,
             std::map<NIFUtil::ShapeShader, PatcherMeshShaderTransform::PatcherMeshShaderTransformObject>>
             shaderTransformPatchers;
+        PatcherMesh::NIFIndex nifIndex; /** < block index of the NIF, shared by all patchers */
+        PatcherMeshShader::PatchedTextureSets patchedTextureSets; /** < shared by shaderPatchers, freed with the set */
+
+        /**
+         * @brief Bind every patcher to a NIF, rebuilds the NIF index and clears the patched texture sets
+         *
+         * @param nifPath Path to NIF being patched
+         * @param nif NIF object (null leaves the index empty)
+         */
+        void bind(const std::filesystem::path& nifPath, nifly::NifFile* nif);
+
+        /**
+         * @brief Drop all per NIF state, the patchers stay allocated for the next bind
+         */
+        void unbind();
     };
 
     /**
@@ -44,6 +67,81 @@ public:
             shaderTransformPatchers;
     };
 
+    /**
+     * @class PatcherMeshObjectPool
+     * @brief Reusable patcher object sets so patchers are constructed once per concurrently processed NIF
+     * @details Sets are created from the factories on demand and handed out bound to a NIF. A set goes back to the pool
+     * when its handle is destroyed. Duplicate NIFs processed while their parent NIF is still being patched on the same
+     * thread take a second set. Thread safe.
+     */
+    class PatcherMeshObjectPool {
+    public:
+        /**
+         * @class Handle
+         * @brief Owns a set taken from the pool and returns it unbound on destruction
+         */
+        class Handle {
+        private:
+            PatcherMeshObjectPool* m_pool;
+            std::unique_ptr<PatcherMeshObjectSet> m_set;
+
+        public:
+            Handle(PatcherMeshObjectPool* pool, std::unique_ptr<PatcherMeshObjectSet> set);
+            ~Handle();
+            Handle(const Handle& other) = delete;
+            auto operator=(const Handle& other) -> Handle& = delete;
+            Handle(Handle&& other) noexcept = default;
+            auto operator=(Handle&& other) noexcept -> Handle& = delete;
+
+            auto operator*() const -> PatcherMeshObjectSet&;
+            auto operator->() const -> PatcherMeshObjectSet*;
+        };
+
+    private:
+        PatcherMeshSet m_factories; /** < Factories used to create new sets */
+        std::vector<std::unique_ptr<PatcherMeshObjectSet>> m_freeSets; /** < Sets not in use */
+        size_t m_numCreated = 0; /** < Number of sets created since the factories were loaded */
+        std::mutex m_mutex;
+
+    public:
+        /**
+         * @brief Set the factories for new sets, drops all pooled sets (no handles may be alive)
+         *
+         * @param factories patcher factories
+         */
+        void loadFactories(const PatcherMeshSet& factories);
+
+        /**
+         * @brief Take a set from the pool (or create one) and bind it to a NIF
+         *
+         * @param nifPath Path to NIF being patched
+         * @param nif NIF object
+         * @return Handle set bound to the NIF
+         */
+        auto acquire(const std::filesystem::path& nifPath, nifly::NifFile* nif) -> Handle;
+
+        /**
+         * @brief Get the number of sets created since the factories were loaded
+         *
+         * @return size_t number of created sets
+         */
+        [[nodiscard]] auto getNumCreated() -> size_t;
+
+        /**
+         * @brief Create a patcher object set by calling every factory
+         *
+         * @param factories patcher factories
+         * @param nifPath Path to NIF being patched
+         * @param nif NIF object
+         * @return std::unique_ptr<PatcherMeshObjectSet> new set, not bound
+         */
+        static auto createSet(const PatcherMeshSet& factories, const std::filesystem::path& nifPath,
+            nifly::NifFile* nif) -> std::unique_ptr<PatcherMeshObjectSet>;
+
+    private:
+        void release(std::unique_ptr<PatcherMeshObjectSet> set);
+    };
+
     struct PatcherTextureObjectSet {
         std::vector<PatcherTextureGlobal::PatcherGlobalObject> globalPatchers;
     };
@@ -57,12 +155,12 @@ public:
      * @brief Describes a match with transform properties
      */
     struct ShaderPatcherMatch {
-        std::wstring mod;
+        uint32_t modID = 0; /** < interned mod ID of the matched file (see BethesdaDirectory::getModID) */
         NIFUtil::ShapeShader shader;
         PatcherMeshShader::PatcherMatch match;
         NIFUtil::ShapeShader shaderTransformTo;
 
-        [[nodiscard]] auto getJSON() const -> nlohmann::json
+        [[nodiscard]] auto getJSON(const std::wstring& mod) const -> nlohmann::json
         {
             nlohmann::json json = nlohmann::json::object();
             json["mod"] = ParallaxGenUtil::utf16toUTF8(mod);
@@ -78,22 +176,83 @@ public:
         }
     };
 
+    /**
+     * @class ModSet
+     * @brief Set of mod IDs stored as a bitset
+     */
+    class ModSet {
+    private:
+        static constexpr uint32_t WORD_BITS = 64;
+
+        std::vector<uint64_t> m_words;
+
+    public:
+        /**
+         * @brief Add a mod ID to the set
+         *
+         * @param modID mod ID to add
+         */
+        void insert(const uint32_t& modID);
+
+        /**
+         * @brief Check if a mod ID is in the set
+         *
+         * @param modID mod ID to check
+         * @return true mod ID is in the set
+         */
+        [[nodiscard]] auto contains(const uint32_t& modID) const -> bool;
+
+        /**
+         * @brief Call a function for every mod ID in the set in ascending order
+         *
+         * @param func function taking a uint32_t mod ID
+         */
+        template <typename Func> void forEach(Func&& func) const
+        {
+            for (size_t word = 0; word < m_words.size(); word++) {
+                uint64_t bits = m_words[word];
+                while (bits != 0) {
+                    func(static_cast<uint32_t>((word * WORD_BITS) + std::countr_zero(bits)));
+                    bits &= bits - 1;
+                }
+            }
+        }
+    };
+
+    /**
+     * @struct ConflictMod
+     * @brief Conflict results of one mod
+     */
+    struct ConflictMod {
+        uint32_t shaders = 0; /** < one bit per NIFUtil::ShapeShader the mod matched with */
+        ModSet mods; /** < mods matching the same shapes as this mod (including itself) */
+    };
+
+    /**
+     * @struct ConflictModResults
+     * @brief Conflict results of all mods, indexed by mod ID
+     */
     struct ConflictModResults {
-        std::unordered_map<std::wstring, std::tuple<std::set<NIFUtil::ShapeShader>, std::unordered_set<std::wstring>>>
-            mods;
+        std::vector<ConflictMod> mods;
         std::mutex mutex;
+
+        /**
+         * @brief Record the matches of one shape if they come from more than one mod
+         *
+         * @param matches matches of the shape
+         */
+        void addMatches(const std::vector<ShaderPatcherMatch>& matches);
     };
 
     /**
      * @brief Get the Winning Match object (checks mod priority)
      *
      * @param Matches Matches to check
-     * @param NIFPath NIF path to check
-     * @param ModPriority Mod priority map
+     * @param ModRanks Mod priority indexed by mod ID (see BethesdaDirectory::getModRanks), missing mods rank -1
      * @return ShaderPatcherMatch Winning match
      */
-    static auto getWinningMatch(const std::vector<ShaderPatcherMatch>& matches,
-        const std::unordered_map<std::wstring, int>* modPriority = nullptr) -> ShaderPatcherMatch;
+    static auto getWinningMatch(const std::vector<ShaderPatcherMatch>& matches, const std::vector<int>& modRanks = {})
+        -> ShaderPatcherMatch;
 
     /**
      * @brief Helper method to run a transform if needed on a match
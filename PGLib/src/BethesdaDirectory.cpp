@@ -3,6 +3,7 @@
 #include "BethesdaGame.hpp"
 #include "ModManagerDirectory.hpp"
 #include "PGDiag.hpp"
+#include "ParallaxGenTrace.hpp"
 #include "ParallaxGenUtil.hpp"
 
 #include <bsa/tes4.hpp>
@@ -20,10 +21,14 @@
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/crc.hpp>
 
+#include <lz4frame.h>
+#include <miniz.h>
+
 #include <shlwapi.h>
 #include <winnt.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <exception>
 #include <filesystem>
 #include <fstream>
@@ -31,8 +36,11 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <system_error>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -136,6 +144,8 @@ auto BethesdaDirectory::getFileMap() const -> const map<filesystem::path, Bethes
 
 auto BethesdaDirectory::getFile(const filesystem::path& relPath, const bool& cacheFile) -> vector<std::byte>
 {
+    const ParallaxGenTrace::Span traceSpan("getFile", relPath);
+
     // find bsa/loose file to open
     const BethesdaFile file = getFileFromMap(relPath);
     if (file.path.empty()) {
@@ -219,14 +229,204 @@ auto BethesdaDirectory::getFile(const filesystem::path& relPath, const bool& cac
     return outFileBytes;
 }
 
+auto BethesdaDirectory::getFileHeader(const filesystem::path& relPath, const size_t& numBytes) -> vector<std::byte>
+{
+    const BethesdaFile file = getFileFromMap(relPath);
+    if (file.path.empty()) {
+        return {};
+    }
+
+    const shared_ptr<BSAFile> bsaStruct = file.bsaFile;
+    if (bsaStruct == nullptr) {
+        // loose file, read only the requested prefix
+        const filesystem::path filePath = file.generated ? m_generatedDir / relPath : m_dataDir / relPath;
+
+        ifstream inputFile(filePath, ios::binary);
+        if (!inputFile.is_open()) {
+            return {};
+        }
+
+        vector<std::byte> buffer(numBytes);
+        inputFile.read(
+            reinterpret_cast<char*>(buffer.data()), // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            static_cast<streamsize>(numBytes));
+        buffer.resize(static_cast<size_t>(inputFile.gcount()));
+        return buffer;
+    }
+
+    // BSA file, only the start of the entry is copied or decompressed
+    const string parentPath = utf16toASCII(relPath.parent_path().wstring());
+    const string filename = utf16toASCII(relPath.filename().wstring());
+
+    const bsa::tes4::archive& bsaObj = bsaStruct->archive;
+    const auto bsaFile = bsaObj[parentPath][filename];
+    if (!bsaFile) {
+        return {};
+    }
+
+    try {
+        const auto data = bsaFile->as_bytes();
+        if (!bsaFile->compressed()) {
+            const size_t prefixSize = min(numBytes, data.size());
+            return { data.begin(), data.begin() + static_cast<ptrdiff_t>(prefixSize) };
+        }
+
+        return decompressBSAFilePrefix(data, bsaStruct->version, min(numBytes, bsaFile->decompressed_size()));
+    } catch (const std::exception& e) {
+        if (m_logging) {
+            spdlog::debug(L"Failed to read header of {}: {}", relPath.wstring(), asciitoUTF16(e.what()));
+        }
+    }
+
+    return {};
+}
+
+auto BethesdaDirectory::decompressBSAFilePrefix(
+    span<const std::byte> data, const bsa::tes4::version& version, const size_t& numBytes) -> vector<std::byte>
+{
+    vector<std::byte> outBytes(numBytes);
+    size_t outSize = 0;
+
+    if (version == bsa::tes4::version::sse) {
+        // lz4 frame, decompresses block by block so this stops after the first block
+        LZ4F_dctx* dctx = nullptr;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION)) != 0U) {
+            return {};
+        }
+
+        size_t inPos = 0;
+        while (outSize < numBytes && inPos < data.size()) {
+            const span<std::byte> dst = span(outBytes).subspan(outSize);
+            const span<const std::byte> src = data.subspan(inPos);
+            size_t dstSize = dst.size();
+            size_t srcSize = src.size();
+            const size_t ret = LZ4F_decompress(dctx, dst.data(), &dstSize, src.data(), &srcSize, nullptr);
+            if (LZ4F_isError(ret) != 0U) {
+                outSize = 0;
+                break;
+            }
+
+            outSize += dstSize;
+            inPos += srcSize;
+            if (ret == 0 || (dstSize == 0 && srcSize == 0)) {
+                // frame finished or no progress
+                break;
+            }
+        }
+
+        LZ4F_freeDecompressionContext(dctx);
+    } else {
+        // zlib stream, inflate stops once the output buffer is full
+        mz_stream stream = {};
+        if (mz_inflateInit(&stream) != MZ_OK) {
+            return {};
+        }
+
+        stream.next_in = reinterpret_cast<const unsigned char*>( // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            data.data());
+        stream.avail_in = static_cast<unsigned int>(data.size());
+        stream.next_out = reinterpret_cast<unsigned char*>( // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            outBytes.data());
+        stream.avail_out = static_cast<unsigned int>(numBytes);
+
+        const int ret = mz_inflate(&stream, MZ_NO_FLUSH);
+        if (ret == MZ_OK || ret == MZ_STREAM_END || ret == MZ_BUF_ERROR) {
+            outSize = static_cast<size_t>(stream.total_out);
+        }
+
+        mz_inflateEnd(&stream);
+    }
+
+    outBytes.resize(outSize);
+    return outBytes;
+}
+
+auto BethesdaDirectory::getFileFingerprint(const filesystem::path& relPath) -> FileFingerprint
+{
+    const BethesdaFile file = getFileFromMap(relPath);
+    if (file.path.empty()) {
+        return {};
+    }
+
+    if (file.bsaFile != nullptr) {
+        // BSA stats are read once when the archive is loaded
+        return { .source = file.bsaFile->path.wstring(),
+            .size = file.bsaFile->fileSize,
+            .lastWriteTime = file.bsaFile->lastWriteTime };
+    }
+
+    const filesystem::path filePath = file.generated ? m_generatedDir / relPath : m_dataDir / relPath;
+
+    error_code ec;
+    const uintmax_t fileSize = filesystem::file_size(filePath, ec);
+    if (ec) {
+        return {};
+    }
+    const auto lastWriteTime = filesystem::last_write_time(filePath, ec);
+    if (ec) {
+        return {};
+    }
+
+    return { .source = filePath.wstring(),
+        .size = fileSize,
+        .lastWriteTime = lastWriteTime.time_since_epoch().count() };
+}
+
+auto BethesdaDirectory::getFileSize(const filesystem::path& relPath) -> uintmax_t
+{
+    return getFileFromMap(relPath).fileSize;
+}
+
 auto BethesdaDirectory::getMod(const filesystem::path& relPath) -> wstring
 {
     if (m_fileMap.empty()) {
         throw runtime_error("File map was not populated");
     }
 
-    const BethesdaFile file = getFileFromMap(relPath);
-    return file.mod;
+    return getModName(getModID(relPath));
+}
+
+auto BethesdaDirectory::getModID(const filesystem::path& relPath) -> uint32_t
+{
+    if (m_fileMap.empty()) {
+        throw runtime_error("File map was not populated");
+    }
+
+    const lock_guard<mutex> lock(m_fileMapMutex);
+
+    const auto it = m_fileMap.find(getAsciiPathLower(relPath));
+    if (it == m_fileMap.end()) {
+        return NO_MOD;
+    }
+
+    return it->second.modID;
+}
+
+auto BethesdaDirectory::getModName(const uint32_t& modID) -> const wstring&
+{
+    const lock_guard<mutex> lock(m_modTableMutex);
+    return m_modNames.at(modID);
+}
+
+auto BethesdaDirectory::getNumMods() -> size_t
+{
+    const lock_guard<mutex> lock(m_modTableMutex);
+    return m_modNames.size();
+}
+
+auto BethesdaDirectory::getModRanks(const unordered_map<wstring, int>& modPriority) -> vector<int>
+{
+    const lock_guard<mutex> lock(m_modTableMutex);
+
+    vector<int> ranks(m_modNames.size(), -1);
+    for (size_t modID = 0; modID < m_modNames.size(); modID++) {
+        const auto it = modPriority.find(m_modNames[modID]);
+        if (it != modPriority.end()) {
+            ranks[modID] = it->second;
+        }
+    }
+
+    return ranks;
 }
 
 void BethesdaDirectory::addGeneratedFile(const filesystem::path& relPath, const wstring& mod)
@@ -366,7 +566,7 @@ void BethesdaDirectory::addLooseFilesToMap()
                 if (m_mmd != nullptr) {
                     curMod = m_mmd->getMod(relativePath);
                 }
-                updateFileMap(relativePath, nullptr, curMod);
+                updateFileMap(relativePath, nullptr, curMod, false, entry.file_size());
             }
         } catch (const std::exception& e) {
             if (m_logging) {
@@ -397,7 +597,11 @@ void BethesdaDirectory::addBSAToFileMap(const wstring& bsaName)
     }
 
     const bsa::tes4::version bsaVersion = bsaObj.read(bsaPath);
-    const BSAFile bsaStruct = { .path = bsaPath, .version = bsaVersion, .archive = bsaObj };
+    const BSAFile bsaStruct = { .path = bsaPath,
+        .version = bsaVersion,
+        .archive = bsaObj,
+        .fileSize = filesystem::file_size(bsaPath),
+        .lastWriteTime = filesystem::last_write_time(bsaPath).time_since_epoch().count() };
 
     const shared_ptr<BSAFile> bsaStructPtr = make_shared<BSAFile>(bsaStruct);
 
@@ -442,7 +646,9 @@ void BethesdaDirectory::addBSAToFileMap(const wstring& bsaName)
                 if (m_mmd != nullptr) {
                     bsaMod = m_mmd->getMod(bsaName);
                 }
-                updateFileMap(curPath, bsaStructPtr, bsaMod);
+                const auto& bsaEntry = entry.second;
+                updateFileMap(curPath, bsaStructPtr, bsaMod, false,
+                    bsaEntry.compressed() ? bsaEntry.decompressed_size() : bsaEntry.size());
             }
         } catch (const std::exception& e) {
             if (m_logging) {
@@ -665,18 +871,33 @@ auto BethesdaDirectory::getFileFromMap(const filesystem::path& filePath) -> Beth
 }
 
 void BethesdaDirectory::updateFileMap(const filesystem::path& filePath, shared_ptr<BethesdaDirectory::BSAFile> bsaFile,
-    const wstring& mod, const bool& generated)
+    const wstring& mod, const bool& generated, const uintmax_t& fileSize)
 {
     const lock_guard<mutex> lock(m_fileMapMutex);
 
     const filesystem::path lowerPath = getAsciiPathLower(filePath);
 
-    const BethesdaFile newBFile
-        = { .path = filePath, .bsaFile = std::move(bsaFile), .mod = mod, .generated = generated };
+    const BethesdaFile newBFile = { .path = filePath,
+        .bsaFile = std::move(bsaFile),
+        .modID = internMod(mod),
+        .generated = generated,
+        .fileSize = fileSize };
 
     m_fileMap[lowerPath] = newBFile;
 
-    PGDiag::insert(lowerPath.wstring(), newBFile.getDiagJSON());
+    PGDiag::insert(lowerPath.wstring(), newBFile.getDiagJSON(mod));
+}
+
+auto BethesdaDirectory::internMod(const wstring& mod) -> uint32_t
+{
+    const lock_guard<mutex> lock(m_modTableMutex);
+
+    const auto [it, inserted] = m_modIDs.try_emplace(mod, static_cast<uint32_t>(m_modNames.size()));
+    if (inserted) {
+        m_modNames.push_back(mod);
+    }
+
+    return it->second;
 }
 
 auto BethesdaDirectory::isFileInBSA(const filesystem::path& file, const std::vector<std::wstring>& bsaFiles) -> bool
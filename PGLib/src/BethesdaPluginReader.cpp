@@ -0,0 +1,614 @@
+#include "BethesdaPluginReader.hpp"
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/asio.hpp>
+
+#include <miniz.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t RECORD_HEADER_SIZE = 24;
+constexpr size_t SUBRECORD_HEADER_SIZE = 6;
+constexpr size_t COMPRESSED_SIZE_FIELD = 4;
+constexpr uint32_t FLAG_DELETED = 0x20;
+constexpr uint32_t FLAG_COMPRESSED = 0x40000;
+constexpr uint32_t FORM_ID_MASK = 0xFFFFFF;
+constexpr unsigned MASTER_INDEX_SHIFT = 24;
+constexpr unsigned PLUGIN_ID_SHIFT = 32;
+constexpr int TOP_LEVEL_GROUP = 0;
+
+constexpr auto makeType(const char (&type)[5]) -> uint32_t // NOLINT(cppcoreguidelines-avoid-c-arrays)
+{
+    // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+    return static_cast<uint32_t>(static_cast<unsigned char>(type[0]))
+        | (static_cast<uint32_t>(static_cast<unsigned char>(type[1])) << 8U)
+        | (static_cast<uint32_t>(static_cast<unsigned char>(type[2])) << 16U)
+        | (static_cast<uint32_t>(static_cast<unsigned char>(type[3])) << 24U);
+    // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+}
+
+auto typeToString(const uint32_t& type) -> string
+{
+    string typeStr(sizeof(type), '\0');
+    memcpy(typeStr.data(), &type, sizeof(type));
+    return typeStr;
+}
+
+constexpr uint32_t TYPE_TES4 = makeType("TES4");
+constexpr uint32_t TYPE_GRUP = makeType("GRUP");
+constexpr uint32_t TYPE_MAST = makeType("MAST");
+constexpr uint32_t TYPE_XXXX = makeType("XXXX");
+constexpr uint32_t TYPE_TXST = makeType("TXST");
+constexpr uint32_t TYPE_ARMO = makeType("ARMO");
+constexpr uint32_t TYPE_ARMA = makeType("ARMA");
+
+// Record types PGMutagen enumerates for models, in its enumeration order
+constexpr array<uint32_t, 36> MODEL_RECORD_TYPES = { makeType("ACTI"), makeType("ADDN"), makeType("AMMO"),
+    makeType("ANIO"), TYPE_ARMO, TYPE_ARMA, makeType("ARTO"), makeType("BPTD"), makeType("BOOK"), makeType("CAMS"),
+    makeType("CLMT"), makeType("CONT"), makeType("DOOR"), makeType("EXPL"), makeType("FLOR"), makeType("FURN"),
+    makeType("GRAS"), makeType("HAZD"), makeType("HDPT"), makeType("IDLM"), makeType("IPCT"), makeType("ALCH"),
+    makeType("INGR"), makeType("KEYM"), makeType("LVLN"), makeType("LIGH"), makeType("MATO"), makeType("MISC"),
+    makeType("MSTT"), makeType("PROJ"), makeType("SCRL"), makeType("SLGM"), makeType("STAT"), makeType("TACT"),
+    makeType("TREE"), makeType("WEAP") };
+
+// TXST subrecords in NIF slot order
+constexpr array<uint32_t, ParallaxGenPluginIndex::NUM_SLOTS - 1> TXST_SLOT_TYPES = { makeType("TX00"), makeType("TX01"),
+    makeType("TX03"), makeType("TX04"), makeType("TX05"), makeType("TX02"), makeType("TX06"), makeType("TX07") };
+
+/**
+ * @struct ModelSlot
+ * @brief Model path and alternate texture subrecords of one model of a record type
+ */
+struct ModelSlot {
+    uint32_t pathType;
+    uint32_t altTexType;
+    const char* matchType;
+};
+
+constexpr array<ModelSlot, 1> MODELED_SLOTS = { { { makeType("MODL"), makeType("MODS"), "MODL" } } };
+constexpr array<ModelSlot, 2> ARMO_SLOTS
+    = { { { makeType("MOD2"), makeType("MO2S"), "MALE" }, { makeType("MOD4"), makeType("MO4S"), "FEMALE" } } };
+constexpr array<ModelSlot, 4> ARMA_SLOTS = { { { makeType("MOD2"), makeType("MO2S"), "MALE" },
+    { makeType("MOD3"), makeType("MO3S"), "FEMALE" }, { makeType("MOD4"), makeType("MO4S"), "1STMALE" },
+    { makeType("MOD5"), makeType("MO5S"), "1STFEMALE" } } };
+
+auto isNeededType(const uint32_t& type) -> bool
+{
+    return type == TYPE_TXST || ranges::find(MODEL_RECORD_TYPES, type) != MODEL_RECORD_TYPES.end();
+}
+
+template <typename T> auto readValue(span<const std::byte> data, const size_t& offset) -> T
+{
+    if (offset + sizeof(T) > data.size()) {
+        throw runtime_error("Unexpected end of plugin data");
+    }
+
+    T value {};
+    memcpy(&value, data.subspan(offset, sizeof(T)).data(), sizeof(T));
+    return value;
+}
+
+auto readZString(span<const std::byte> data) -> string
+{
+    string str(reinterpret_cast<const char*>(data.data()), // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        data.size());
+    if (const auto nullPos = str.find('\0'); nullPos != string::npos) {
+        str.resize(nullPos);
+    }
+
+    return str;
+}
+
+template <typename Func> void forEachSubrecord(span<const std::byte> data, const Func& func)
+{
+    size_t offset = 0;
+    uint32_t nextSize = 0;
+    while (offset + SUBRECORD_HEADER_SIZE <= data.size()) {
+        const auto type = readValue<uint32_t>(data, offset);
+        size_t size = readValue<uint16_t>(data, offset + sizeof(type));
+        offset += SUBRECORD_HEADER_SIZE;
+
+        if (nextSize != 0) {
+            // size of this subrecord is stored in the preceding XXXX subrecord
+            size = nextSize;
+            nextSize = 0;
+        }
+
+        if (offset + size > data.size()) {
+            throw runtime_error("Subrecord exceeds record size");
+        }
+
+        const auto subData = data.subspan(offset, size);
+        offset += size;
+
+        if (type == TYPE_XXXX) {
+            nextSize = readValue<uint32_t>(subData, 0);
+            continue;
+        }
+
+        func(type, subData);
+    }
+}
+
+// Unicode code points of windows-1252 0x80 to 0x9F, unassigned bytes keep their value like MultiByteToWideChar does
+constexpr array<wchar_t, 32> WINDOWS_1252_80_9F = { 0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F, 0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022,
+    0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178 };
+
+// plugin strings are windows-1252, decoded here so the reader does not need the Windows code page functions
+auto windows1252ToWString(const string& str) -> wstring
+{
+    static constexpr unsigned char FIRST_MAPPED = 0x80;
+    static constexpr unsigned char LAST_MAPPED = 0x9F;
+
+    wstring out;
+    out.reserve(str.size());
+    for (const char c : str) {
+        const auto byte = static_cast<unsigned char>(c);
+        out.push_back(byte >= FIRST_MAPPED && byte <= LAST_MAPPED ? WINDOWS_1252_80_9F.at(byte - FIRST_MAPPED)
+                                                                  : static_cast<wchar_t>(byte));
+    }
+
+    return out;
+}
+
+// plugin name for exception messages, characters outside of ASCII are replaced
+auto getMessageName(const wstring& name) -> string
+{
+    static constexpr wchar_t LAST_ASCII = 0x7F;
+
+    string out;
+    out.reserve(name.size());
+    for (const wchar_t c : name) {
+        out.push_back(c <= LAST_ASCII ? static_cast<char>(c) : '?');
+    }
+
+    return out;
+}
+
+auto normalizePath(const string& path, const wstring& prefix) -> wstring
+{
+    wstring pathW = boost::to_lower_copy(windows1252ToWString(path));
+    if (!boost::starts_with(pathW, prefix)) {
+        pathW = prefix + pathW;
+    }
+
+    return pathW;
+}
+
+} // namespace
+
+BethesdaPluginReader::BethesdaPluginReader(filesystem::path dataPath)
+    : m_dataPath(std::move(dataPath))
+{
+}
+
+void BethesdaPluginReader::load(const vector<wstring>& loadOrder, const size_t& numThreads)
+{
+    m_txsts.clear();
+    m_modelRecords.clear();
+    m_warnings.clear();
+
+    mapPlugins(loadOrder);
+    auto jobs = getGroupJobs();
+
+    // Parse groups in parallel, each job only writes to itself
+    {
+        const size_t poolSize = numThreads == 0 ? max(1U, thread::hardware_concurrency()) : numThreads;
+        boost::asio::thread_pool pool(poolSize);
+
+        exception_ptr jobException;
+        mutex jobExceptionMutex;
+        for (auto& job : jobs) {
+            boost::asio::post(pool, [this, &job, &jobException, &jobExceptionMutex] {
+                try {
+                    parseGroup(job);
+                } catch (...) {
+                    const lock_guard<mutex> lock(jobExceptionMutex);
+                    if (jobException == nullptr) {
+                        jobException = current_exception();
+                    }
+                }
+            });
+        }
+        pool.join();
+
+        if (jobException != nullptr) {
+            m_plugins.clear();
+            rethrow_exception(jobException);
+        }
+    }
+
+    mergeGroups(jobs);
+    findMissingTXSTs();
+
+    // results do not point into the plugins
+    m_plugins.clear();
+}
+
+auto BethesdaPluginReader::getTXSTs() const -> const vector<TXSTRecord>& { return m_txsts; }
+
+auto BethesdaPluginReader::getModelRecords() const -> const vector<ModelRecord>& { return m_modelRecords; }
+
+auto BethesdaPluginReader::getWarnings() const -> const vector<wstring>& { return m_warnings; }
+
+auto BethesdaPluginReader::getFormKey(const wstring& plugin, const uint32_t& formID) -> uint64_t
+{
+    return (static_cast<uint64_t>(internPlugin(plugin)) << PLUGIN_ID_SHIFT) | (formID & FORM_ID_MASK);
+}
+
+auto BethesdaPluginReader::getFormKeyDesc(const uint64_t& formKey) const -> wstring
+{
+    const auto pluginID = static_cast<size_t>(formKey >> PLUGIN_ID_SHIFT);
+    const wstring plugin = pluginID < m_pluginNames.size() ? m_pluginNames[pluginID] : L"unknown";
+    return format(L"{:06X} ({})", formKey & FORM_ID_MASK, plugin);
+}
+
+void BethesdaPluginReader::buildIndex(ParallaxGenPluginIndex& index) const
+{
+    index.clear();
+
+    unordered_map<uint64_t, int> txstIndices;
+    for (size_t i = 0; i < m_txsts.size(); i++) {
+        txstIndices.emplace(m_txsts[i].formKey, static_cast<int>(i));
+    }
+
+    // handles count every alternate texture and model, also the ones that reference a missing TXST
+    int altTexIndex = 0;
+    int modelRecHandle = 0;
+    for (const auto& modelRecord : m_modelRecords) {
+        for (const auto& model : modelRecord.models) {
+            for (const auto& altTex : model.altTexs) {
+                // missing TXSTs were added to the warnings by load
+                if (const auto txstIt = txstIndices.find(altTex.txstFormKey); txstIt != txstIndices.end()) {
+                    index.addAltTexRef({ .nifName = model.nifName,
+                        .index3D = altTex.index3D,
+                        .txstIndex = txstIt->second,
+                        .altTexIndex = altTexIndex,
+                        .modelRecHandle = modelRecHandle,
+                        .matchType = model.matchType });
+                }
+
+                altTexIndex++;
+            }
+
+            modelRecHandle++;
+        }
+    }
+
+    for (const auto& txstIndex : index.getReferencedTXSTs()) {
+        index.setTXSTSlots(txstIndex, m_txsts[txstIndex].slots);
+    }
+}
+
+void BethesdaPluginReader::findMissingTXSTs()
+{
+    unordered_set<uint64_t> txstFormKeys;
+    for (const auto& txst : m_txsts) {
+        txstFormKeys.insert(txst.formKey);
+    }
+
+    for (const auto& modelRecord : m_modelRecords) {
+        for (const auto& model : modelRecord.models) {
+            for (const auto& altTex : model.altTexs) {
+                if (!txstFormKeys.contains(altTex.txstFormKey)) {
+                    m_warnings.push_back(format(L"Referenced TXST record {} in {} does not exist",
+                        getFormKeyDesc(altTex.txstFormKey), getFormKeyDesc(modelRecord.formKey)));
+                }
+            }
+        }
+    }
+}
+
+void BethesdaPluginReader::mapPlugins(const vector<wstring>& loadOrder)
+{
+    m_plugins.clear();
+
+    for (const auto& pluginName : loadOrder) {
+        const filesystem::path pluginPath = m_dataPath / pluginName;
+        error_code ec;
+        if (filesystem::file_size(pluginPath, ec) < RECORD_HEADER_SIZE || ec) {
+            m_warnings.push_back(format(L"Plugin {} does not exist or is empty, skipping", pluginName));
+            continue;
+        }
+
+        PluginFile plugin { .name = pluginName,
+            .file = boost::interprocess::file_mapping(pluginPath.c_str(), boost::interprocess::read_only),
+            .region = {},
+            .masters = {} };
+        plugin.region = boost::interprocess::mapped_region(plugin.file, boost::interprocess::read_only);
+
+        const span<const std::byte> data(static_cast<const std::byte*>(plugin.region.get_address()),
+            plugin.region.get_size());
+        if (readValue<uint32_t>(data, 0) != TYPE_TES4) {
+            throw runtime_error("Plugin " + getMessageName(pluginName) + " has no TES4 header");
+        }
+
+        // masters resolve the first byte of form IDs, the plugin itself comes after its masters
+        const auto headerSize = readValue<uint32_t>(data, sizeof(uint32_t));
+        if (RECORD_HEADER_SIZE + headerSize > data.size()) {
+            throw runtime_error("Plugin " + getMessageName(pluginName) + " has a truncated header");
+        }
+
+        forEachSubrecord(data.subspan(RECORD_HEADER_SIZE, headerSize), [&](const uint32_t& type, const auto& subData) {
+            if (type == TYPE_MAST) {
+                plugin.masters.push_back(internPlugin(windows1252ToWString(readZString(subData))));
+            }
+        });
+        plugin.masters.push_back(internPlugin(pluginName));
+
+        m_plugins.push_back(std::move(plugin));
+    }
+}
+
+auto BethesdaPluginReader::getGroupJobs() const -> vector<GroupJob>
+{
+    vector<GroupJob> jobs;
+
+    for (size_t pluginIndex = 0; pluginIndex < m_plugins.size(); pluginIndex++) {
+        const auto& plugin = m_plugins[pluginIndex];
+        const span<const std::byte> data(static_cast<const std::byte*>(plugin.region.get_address()),
+            plugin.region.get_size());
+
+        size_t offset = RECORD_HEADER_SIZE + readValue<uint32_t>(data, sizeof(uint32_t));
+        while (offset + RECORD_HEADER_SIZE <= data.size()) {
+            const auto type = readValue<uint32_t>(data, offset);
+            const auto groupSize = readValue<uint32_t>(data, offset + sizeof(uint32_t));
+            const auto label = readValue<uint32_t>(data, offset + (2 * sizeof(uint32_t)));
+            const auto groupType = readValue<int32_t>(data, offset + (3 * sizeof(uint32_t)));
+            if (type != TYPE_GRUP || groupSize < RECORD_HEADER_SIZE || offset + groupSize > data.size()) {
+                throw runtime_error("Plugin " + getMessageName(plugin.name) + " has an invalid group");
+            }
+
+            // everything else is skipped without being read
+            if (groupType == TOP_LEVEL_GROUP && isNeededType(label)) {
+                jobs.push_back({ .plugin = pluginIndex,
+                    .type = label,
+                    .data = data.subspan(offset + RECORD_HEADER_SIZE, groupSize - RECORD_HEADER_SIZE),
+                    .txsts = {},
+                    .modelRecords = {},
+                    .hidden = {} });
+            }
+
+            offset += groupSize;
+        }
+    }
+
+    return jobs;
+}
+
+void BethesdaPluginReader::parseGroup(GroupJob& job) const
+{
+    const auto& plugin = m_plugins[job.plugin];
+
+    size_t offset = 0;
+    while (offset + RECORD_HEADER_SIZE <= job.data.size()) {
+        const auto type = readValue<uint32_t>(job.data, offset);
+        const auto dataSize = readValue<uint32_t>(job.data, offset + sizeof(uint32_t));
+
+        if (type == TYPE_GRUP) {
+            // nested groups do not hold records of the top level type, their size includes the header
+            offset += max(static_cast<size_t>(dataSize), RECORD_HEADER_SIZE);
+            continue;
+        }
+
+        const auto flags = readValue<uint32_t>(job.data, offset + (2 * sizeof(uint32_t)));
+        const auto formID = readValue<uint32_t>(job.data, offset + (3 * sizeof(uint32_t)));
+        if (offset + RECORD_HEADER_SIZE + dataSize > job.data.size()) {
+            throw runtime_error("Record " + to_string(formID) + " of plugin "
+                + getMessageName(plugin.name) + " exceeds its group");
+        }
+
+        span<const std::byte> recordData = job.data.subspan(offset + RECORD_HEADER_SIZE, dataSize);
+        offset += RECORD_HEADER_SIZE + dataSize;
+
+        if (type != job.type) {
+            continue;
+        }
+
+        const uint64_t formKey = resolveFormID(formID, plugin);
+        if ((flags & FLAG_DELETED) != 0U) {
+            job.hidden.push_back(formKey);
+            continue;
+        }
+
+        vector<std::byte> decompressed;
+        if ((flags & FLAG_COMPRESSED) != 0U) {
+            decompressed = decompressRecord(recordData);
+            recordData = decompressed;
+        }
+
+        if (type == TYPE_TXST) {
+            job.txsts.push_back({ .formKey = formKey, .slots = parseTXST(recordData) });
+            continue;
+        }
+
+        auto models = parseModels(type, recordData, plugin);
+        if (models.empty()) {
+            // still the winning override, so older overrides with alternate textures do not apply
+            job.hidden.push_back(formKey);
+            continue;
+        }
+
+        job.modelRecords.push_back(
+            { .formKey = formKey, .recordType = typeToString(type), .models = std::move(models) });
+    }
+}
+
+void BethesdaPluginReader::mergeGroups(vector<GroupJob>& jobs)
+{
+    // winning overrides come from the highest priority plugin, records of one plugin keep their file order
+    vector<size_t> jobOrder(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        jobOrder[i] = i;
+    }
+    ranges::stable_sort(
+        jobOrder, [&jobs](const size_t& a, const size_t& b) { return jobs[a].plugin > jobs[b].plugin; });
+
+    const auto mergeType = [&](const uint32_t& type) {
+        unordered_set<uint64_t> seen;
+        for (const auto& jobIndex : jobOrder) {
+            auto& job = jobs[jobIndex];
+            if (job.type != type) {
+                continue;
+            }
+
+            seen.insert(job.hidden.begin(), job.hidden.end());
+            for (auto& txst : job.txsts) {
+                if (seen.insert(txst.formKey).second) {
+                    m_txsts.push_back(std::move(txst));
+                }
+            }
+            for (auto& modelRecord : job.modelRecords) {
+                if (seen.insert(modelRecord.formKey).second) {
+                    m_modelRecords.push_back(std::move(modelRecord));
+                }
+            }
+        }
+    };
+
+    mergeType(TYPE_TXST);
+    for (const auto& type : MODEL_RECORD_TYPES) {
+        mergeType(type);
+    }
+}
+
+auto BethesdaPluginReader::parseTXST(span<const std::byte> data) -> ParallaxGenPluginIndex::TXSTSlots
+{
+    ParallaxGenPluginIndex::TXSTSlots slots;
+    forEachSubrecord(data, [&slots](const uint32_t& type, const auto& subData) {
+        const auto slotIt = ranges::find(TXST_SLOT_TYPES, type);
+        if (slotIt == TXST_SLOT_TYPES.end()) {
+            return;
+        }
+
+        const string texture = readZString(subData);
+        if (!texture.empty()) {
+            slots.at(static_cast<size_t>(slotIt - TXST_SLOT_TYPES.begin())) = normalizePath(texture, L"textures\\");
+        }
+    });
+
+    return slots;
+}
+
+auto BethesdaPluginReader::parseModels(const uint32_t& type, span<const std::byte> data, const PluginFile& plugin)
+    -> vector<Model>
+{
+    span<const ModelSlot> modelSlots = MODELED_SLOTS;
+    if (type == TYPE_ARMO) {
+        modelSlots = ARMO_SLOTS;
+    } else if (type == TYPE_ARMA) {
+        modelSlots = ARMA_SLOTS;
+    }
+
+    // only the first model of each slot counts, alternate textures belong to the model before them
+    vector<Model> models(modelSlots.size());
+    vector<bool> hasPath(modelSlots.size(), false);
+    vector<bool> hasAltTexs(modelSlots.size(), false);
+    forEachSubrecord(data, [&](const uint32_t& subType, const auto& subData) {
+        for (size_t slot = 0; slot < modelSlots.size(); slot++) {
+            if (subType == modelSlots[slot].pathType && !hasPath[slot]) {
+                string path = readZString(subData);
+                if (boost::starts_with(path, "\\")) {
+                    path.erase(0, 1);
+                }
+
+                models[slot].nifName = normalizePath(path, L"meshes\\");
+                models[slot].matchType = modelSlots[slot].matchType;
+                hasPath[slot] = true;
+            } else if (subType == modelSlots[slot].altTexType && hasPath[slot] && !hasAltTexs[slot]) {
+                models[slot].altTexs = parseAltTexs(subData, plugin);
+                hasAltTexs[slot] = true;
+            }
+        }
+    });
+
+    vector<Model> outModels;
+    for (size_t slot = 0; slot < modelSlots.size(); slot++) {
+        if (hasAltTexs[slot]) {
+            outModels.push_back(std::move(models[slot]));
+        }
+    }
+
+    return outModels;
+}
+
+auto BethesdaPluginReader::parseAltTexs(span<const std::byte> data, const PluginFile& plugin) -> vector<AltTex>
+{
+    const auto count = readValue<uint32_t>(data, 0);
+
+    vector<AltTex> altTexs;
+    altTexs.reserve(min(static_cast<size_t>(count), data.size()));
+
+    size_t offset = sizeof(uint32_t);
+    for (uint32_t i = 0; i < count; i++) {
+        const auto nameLength = readValue<uint32_t>(data, offset);
+        offset += sizeof(uint32_t);
+        if (offset + nameLength > data.size()) {
+            throw runtime_error("Alternate texture name exceeds subrecord size");
+        }
+
+        AltTex altTex;
+        altTex.name3D = readZString(data.subspan(offset, nameLength));
+        offset += nameLength;
+        altTex.txstFormKey = resolveFormID(readValue<uint32_t>(data, offset), plugin);
+        offset += sizeof(uint32_t);
+        altTex.index3D = readValue<int32_t>(data, offset);
+        offset += sizeof(int32_t);
+
+        altTexs.push_back(std::move(altTex));
+    }
+
+    return altTexs;
+}
+
+auto BethesdaPluginReader::decompressRecord(span<const std::byte> data) -> vector<std::byte>
+{
+    const auto decompressedSize = readValue<uint32_t>(data, 0);
+    const auto compressed = data.subspan(COMPRESSED_SIZE_FIELD);
+
+    vector<std::byte> outBytes(decompressedSize);
+    mz_ulong outSize = decompressedSize;
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+    const int ret = mz_uncompress(reinterpret_cast<unsigned char*>(outBytes.data()), &outSize,
+        reinterpret_cast<const unsigned char*>(compressed.data()), static_cast<mz_ulong>(compressed.size()));
+    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (ret != MZ_OK || outSize != decompressedSize) {
+        throw runtime_error("Unable to decompress plugin record");
+    }
+
+    return outBytes;
+}
+
+auto BethesdaPluginReader::resolveFormID(const uint32_t& formID, const PluginFile& plugin) -> uint64_t
+{
+    // form IDs with a master index past the masters belong to the plugin itself
+    const size_t masterIndex = min(static_cast<size_t>(formID >> MASTER_INDEX_SHIFT), plugin.masters.size() - 1);
+    return (static_cast<uint64_t>(plugin.masters[masterIndex]) << PLUGIN_ID_SHIFT) | (formID & FORM_ID_MASK);
+}
+
+auto BethesdaPluginReader::internPlugin(const wstring& plugin) -> uint32_t
+{
+    const wstring pluginLower = boost::to_lower_copy(plugin);
+
+    const auto [it, inserted] = m_pluginIDs.try_emplace(pluginLower, static_cast<uint32_t>(m_pluginNames.size()));
+    if (inserted) {
+        m_pluginNames.push_back(pluginLower);
+    }
+
+    return it->second;
+}
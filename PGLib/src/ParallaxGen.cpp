@@ -4,6 +4,7 @@
 #include <Geometry.hpp>
 #include <NifFile.hpp>
 #include <algorithm>
+#include <bit>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/asio.hpp>
@@ -11,6 +12,8 @@
 #include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/stream.hpp>
 #include <boost/thread.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <memory>
@@ -32,8 +35,10 @@
 #include "PGDiag.hpp"
 #include "ParallaxGenDirectory.hpp"
 #include "ParallaxGenPlugin.hpp"
+#include "ParallaxGenPluginIndex.hpp"
 #include "ParallaxGenRunner.hpp"
 #include "ParallaxGenTask.hpp"
+#include "ParallaxGenTrace.hpp"
 #include "ParallaxGenUtil.hpp"
 #include "ParallaxGenWarnings.hpp"
 
@@ -46,7 +51,6 @@ ParallaxGen::ParallaxGen(
     : m_outputDir(std::move(outputDir))
     , m_pgd(pgd)
     , m_pgd3D(pgd3D)
-    , m_modPriority(nullptr)
 {
     // constructor
 
@@ -57,14 +61,14 @@ ParallaxGen::ParallaxGen(
 void ParallaxGen::loadPatchers(
     const PatcherUtil::PatcherMeshSet& meshPatchers, const PatcherUtil::PatcherTextureSet& texPatchers)
 {
-    this->m_meshPatchers = meshPatchers;
+    m_meshPatcherPool.loadFactories(meshPatchers);
     this->m_texPatchers = texPatchers;
 }
 
 void ParallaxGen::loadModPriorityMap(unordered_map<wstring, int>* modPriority)
 {
-    this->m_modPriority = modPriority;
-    ParallaxGenPlugin::loadModPriorityMap(modPriority);
+    m_modRanks = modPriority != nullptr ? m_pgd->getModRanks(*modPriority) : vector<int>();
+    ParallaxGenPlugin::loadModRanks(m_modRanks);
 }
 
 void ParallaxGen::patch(const bool& multiThread, const bool& patchPlugin)
@@ -81,11 +85,14 @@ void ParallaxGen::patch(const bool& multiThread, const bool& patchPlugin)
     // Create runner
     ParallaxGenRunner meshRunner(multiThread);
 
-    // Add tasks
+    // Add tasks, larger files are started first
     for (const auto& mesh : meshes) {
-        meshRunner.addTask([this, &taskTracker, &diffJSONMutex, &diffJSON, &mesh, &patchPlugin] {
-            taskTracker.completeJob(processNIF(mesh, &diffJSON, &diffJSONMutex, patchPlugin));
-        });
+        const auto meshSize = m_pgd->getFileSize(mesh);
+        meshRunner.addTask(
+            [this, &taskTracker, &diffJSONMutex, &diffJSON, &mesh, &patchPlugin, meshSize] {
+                taskTracker.completeJob(processNIF(mesh, &diffJSON, &diffJSONMutex, patchPlugin), meshSize);
+            },
+            meshSize);
     }
 
     // Blocks until all tasks are done
@@ -106,8 +113,12 @@ void ParallaxGen::patch(const bool& multiThread, const bool& patchPlugin)
 
         // Add tasks
         for (const auto& texture : textures) {
+            const auto textureSize = m_pgd->getFileSize(texture);
             textureRunner.addTask(
-                [this, &textureTaskTracker, &texture] { textureTaskTracker.completeJob(processDDS(texture)); });
+                [this, &textureTaskTracker, &texture, textureSize] {
+                    textureTaskTracker.completeJob(processDDS(texture), textureSize);
+                },
+                textureSize);
         }
 
         // Blocks until all tasks are done
@@ -138,15 +149,34 @@ auto ParallaxGen::findModConflicts(const bool& multiThread, const bool& patchPlu
 
     // Add tasks
     for (const auto& mesh : meshes) {
-        runner.addTask([this, &taskTracker, &mesh, &patchPlugin, &conflictMods] {
-            taskTracker.completeJob(processNIF(mesh, nullptr, nullptr, patchPlugin, &conflictMods));
-        });
+        const auto meshSize = m_pgd->getFileSize(mesh);
+        runner.addTask(
+            [this, &taskTracker, &mesh, &patchPlugin, &conflictMods, meshSize] {
+                taskTracker.completeJob(processNIF(mesh, nullptr, nullptr, patchPlugin, &conflictMods), meshSize);
+            },
+            meshSize);
     }
 
     // Blocks until all tasks are done
     runner.runTasks();
 
-    return conflictMods.mods;
+    // Resolve mod IDs to labels
+    unordered_map<wstring, tuple<set<NIFUtil::ShapeShader>, unordered_set<wstring>>> modConflicts;
+    for (size_t modID = 0; modID < conflictMods.mods.size(); modID++) {
+        const auto& conflictMod = conflictMods.mods[modID];
+        if (conflictMod.shaders == 0) {
+            // mod was never part of a conflict
+            continue;
+        }
+
+        auto& [shaders, mods] = modConflicts[m_pgd->getModName(static_cast<uint32_t>(modID))];
+        for (uint32_t shaderBits = conflictMod.shaders; shaderBits != 0; shaderBits &= shaderBits - 1) {
+            shaders.insert(static_cast<NIFUtil::ShapeShader>(countr_zero(shaderBits)));
+        }
+        conflictMod.mods.forEach([&](const uint32_t& otherModID) { mods.insert(m_pgd->getModName(otherModID)); });
+    }
+
+    return modConflicts;
 }
 
 void ParallaxGen::zipMeshes() const
@@ -236,6 +266,8 @@ auto ParallaxGen::getDiffJSONName() -> filesystem::path { return "ParallaxGen_Di
 auto ParallaxGen::processNIF(const filesystem::path& nifFile, nlohmann::json* diffJSON, mutex* diffJSONMutex,
     const bool& patchPlugin, PatcherUtil::ConflictModResults* conflictMods) -> ParallaxGenTask::PGResult
 {
+    const ParallaxGenTrace::Span traceSpan("processNIF", nifFile);
+
     if (diffJSON != nullptr && diffJSONMutex == nullptr) {
         throw runtime_error("Diff JSON mutex must be set if diff JSON is set");
     }
@@ -348,30 +380,19 @@ auto ParallaxGen::processNIF(const std::filesystem::path& nifFile, const vector<
 
     nifModified = false;
 
-    // Create patcher objects
-    auto patcherObjects = PatcherUtil::PatcherMeshObjectSet();
-    for (const auto& factory : m_meshPatchers.prePatchers) {
-        auto patcher = factory(nifFile, &nif);
-        patcherObjects.prePatchers.emplace_back(std::move(patcher));
-    }
-    for (const auto& [shader, factory] : m_meshPatchers.shaderPatchers) {
-        auto patcher = factory(nifFile, &nif);
-        patcherObjects.shaderPatchers.emplace(shader, std::move(patcher));
-    }
-    for (const auto& [shader, factory] : m_meshPatchers.shaderTransformPatchers) {
-        for (const auto& [transformShader, transformFactory] : factory) {
-            auto transform = transformFactory(nifFile, &nif);
-            patcherObjects.shaderTransformPatchers[shader].emplace(transformShader, std::move(transform));
-        }
-    }
-    for (const auto& factory : m_meshPatchers.globalPatchers) {
-        auto patcher = factory(nifFile, &nif);
-        patcherObjects.globalPatchers.emplace_back(std::move(patcher));
-    }
+    // Get patcher objects bound to this NIF (returned to the pool when processing is done)
+    const auto patcherObjectsHandle = m_meshPatcherPool.acquire(nifFile, &nif);
+    auto& patcherObjects = *patcherObjectsHandle;
 
     // Get shapes
     auto shapes = nif.GetShapes();
 
+    // Get plugin matches of all shapes at once
+    ParallaxGenPluginIndex::NIFMatches pluginMatches;
+    if (patchPlugin && forceShaders == nullptr) {
+        ParallaxGenPlugin::getNIFMatches(nifFile.wstring(), shapes.size(), pluginMatches);
+    }
+
     // shadersAppliedMesh stores the shaders that were applied on the current mesh by shape for comparison later
     vector<NIFUtil::ShapeShader> shadersAppliedMesh(shapes.size(), NIFUtil::ShapeShader::UNKNOWN);
 
@@ -441,8 +462,8 @@ auto ParallaxGen::processNIF(const std::filesystem::path& nifFile, const vector<
 
             {
                 const PGDiag::Prefix diagPluginPrefix("plugins", nlohmann::json::value_t::object);
-                ParallaxGenPlugin::processShape(
-                    nifFile.wstring(), nifShape, oldShapeIndex, patcherObjects, results, shapeIDStr, conflictMods);
+                ParallaxGenPlugin::processShape(nifFile.wstring(), nifShape, oldShapeIndex,
+                    pluginMatches.getShapeMatches(oldShapeIndex), patcherObjects, results, shapeIDStr, conflictMods);
             }
 
             // Loop through results
@@ -534,6 +555,8 @@ auto ParallaxGen::processNIF(const std::filesystem::path& nifFile, const vector<
         for (const auto& globalPatcher : patcherObjects.globalPatchers) {
             const Logger::Prefix prefixPatches(utf8toUTF16(globalPatcher->getPatcherName()));
             bool globalPatcherChanged = false;
+            const ParallaxGenTrace::Span traceSpan(
+                "applyPatch", [&globalPatcher] { return globalPatcher->getPatcherName(); });
             globalPatcherChanged = globalPatcher->applyPatch();
 
             PGDiag::insert(globalPatcher->getPatcherName(), globalPatcherChanged);
@@ -571,7 +594,7 @@ auto ParallaxGen::processNIF(const std::filesystem::path& nifFile, const vector<
 
         {
             const PGDiag::Prefix diagPluginPrefix("plugins", nlohmann::json::value_t::object);
-            ParallaxGenPlugin::set3DIndices(nifFile.wstring(), shapeTracker);
+            ParallaxGenPlugin::set3DIndices(nifFile.wstring(), pluginMatches, shapeTracker);
         }
     }
 
@@ -589,36 +612,27 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
 
     // Check for exclusions
     // only allow BSLightingShaderProperty blocks
-    const string nifShapeName = nifShape->GetBlockName();
-    if (nifShapeName != "NiTriShape" && nifShapeName != "BSTriShape" && nifShapeName != "BSLODTriShape"
-        && nifShapeName != "BSMeshLODTriShape") {
-
-        PGDiag::insert("rejectReason", "Incorrect shape block type: " + nifShapeName);
-        return false;
-    }
-
-    // get NIFShader type
-    if (!nifShape->HasShaderProperty()) {
-        PGDiag::insert("rejectReason", "No NIFShader property");
+    const auto shapeInfo = patchers.nifIndex.getShapeInfo(nif, nifShape);
+    if (!shapeInfo.isPatchableType) {
+        PGDiag::insert("rejectReason", "Incorrect shape block type: " + string(nifShape->GetBlockName()));
         return false;
     }
 
     // get NIFShader from shape
-    NiShader* nifShader = nif.GetShader(nifShape);
-    if (nifShader == nullptr) {
-        PGDiag::insert("rejectReason", "No NIFShader block");
+    if (shapeInfo.shader == nullptr) {
+        PGDiag::insert("rejectReason", nifShape->HasShaderProperty() ? "No NIFShader block" : "No NIFShader property");
         return false;
     }
 
     // check that NIFShader is a BSLightingShaderProperty
-    const string nifShaderName = nifShader->GetBlockName();
-    if (nifShaderName != "BSLightingShaderProperty") {
-        PGDiag::insert("rejectReason", "Incorrect NIFShader block type: " + nifShaderName);
+    if (!shapeInfo.hasLightingShader) {
+        PGDiag::insert(
+            "rejectReason", "Incorrect NIFShader block type: " + string(shapeInfo.shader->GetBlockName()));
         return false;
     }
 
     // check that NIFShader has a texture set
-    if (!nifShader->HasTextureSet()) {
+    if (shapeInfo.textureSet == nullptr) {
         PGDiag::insert("rejectReason", "No texture set");
         return false;
     }
@@ -630,6 +644,8 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
         const PGDiag::Prefix diagPrePatcherPrefix("prePatchers", nlohmann::json::value_t::object);
         for (const auto& prePatcher : patchers.prePatchers) {
             const Logger::Prefix prefixPatches(prePatcher->getPatcherName());
+            const ParallaxGenTrace::Span traceSpan(
+                "applyPatch", [&prePatcher] { return prePatcher->getPatcherName(); });
             const bool prePatcherChanged = prePatcher->applyPatch(*nifShape);
 
             PGDiag::insert(prePatcher->getPatcherName(), prePatcherChanged);
@@ -659,7 +675,6 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
     }
 
     // Loop through each shader patcher if cache does not exist
-    unordered_set<wstring> modSet;
     if (!cacheExists) {
         for (const auto& [shader, patcher] : patchers.shaderPatchers) {
             if (shader == NIFUtil::ShapeShader::NONE) {
@@ -671,14 +686,18 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
 
             // Check if shader should be applied
             vector<PatcherMeshShader::PatcherMatch> curMatches;
-            if (!patcher->shouldApply(*nifShape, curMatches)) {
+            const bool shouldApply = [&] {
+                const ParallaxGenTrace::Span traceSpan("shouldApply", [&patcher] { return patcher->getPatcherName(); });
+                return patcher->shouldApply(*nifShape, curMatches);
+            }();
+            if (!shouldApply) {
                 Logger::trace(L"Rejecting: Shader not applicable");
                 continue;
             }
 
             for (const auto& match : curMatches) {
                 PatcherUtil::ShaderPatcherMatch curMatch;
-                curMatch.mod = m_pgd->getMod(match.matchedPath);
+                curMatch.modID = m_pgd->getModID(match.matchedPath);
                 curMatch.shader = shader;
                 curMatch.match = match;
                 curMatch.shaderTransformTo = NIFUtil::ShapeShader::UNKNOWN;
@@ -699,7 +718,6 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
                 // Add to matches if shader can apply (or if transform shader exists and can apply)
                 if (patcher->canApply(*nifShape) || curMatch.shaderTransformTo != NIFUtil::ShapeShader::UNKNOWN) {
                     matches.push_back(curMatch);
-                    modSet.insert(curMatch.mod);
                 }
             }
         }
@@ -713,20 +731,7 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
 
     // Populate conflict mods if set
     if (conflictMods != nullptr && !matches.empty()) {
-        if (modSet.size() > 1) {
-            const lock_guard<mutex> lock(conflictMods->mutex);
-
-            // add mods to conflict set
-            for (const auto& match : matches) {
-                if (conflictMods->mods.find(match.mod) == conflictMods->mods.end()) {
-                    conflictMods->mods.insert({ match.mod, { set<NIFUtil::ShapeShader>(), unordered_set<wstring>() } });
-                }
-
-                get<0>(conflictMods->mods[match.mod]).insert(match.shader);
-                get<1>(conflictMods->mods[match.mod]).insert(modSet.begin(), modSet.end());
-            }
-        }
-
+        conflictMods->addMatches(matches);
         return false;
     }
 
@@ -745,7 +750,7 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
     {
         const PGDiag::Prefix diagShaderPatcherPrefix("shaderPatcherMatches", nlohmann::json::value_t::array);
         for (const auto& match : matches) {
-            PGDiag::pushBack(match.getJSON());
+            PGDiag::pushBack(match.getJSON(m_pgd->getModName(match.modID)));
         }
     }
 
@@ -761,16 +766,18 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
         shaderApplied = *forceShader;
         // Find correct patcher
         const auto& patcher = patchers.shaderPatchers.at(*forceShader);
+        const ParallaxGenTrace::Span traceSpan("applyShader", [&patcher] { return patcher->getPatcherName(); });
         return patcher->applyShader(*nifShape);
     }
 
     // Get winning match
-    auto winningShaderMatch = PatcherUtil::getWinningMatch(matches, m_modPriority);
-    PGDiag::insert("winningShaderMatch", winningShaderMatch.getJSON());
+    auto winningShaderMatch = PatcherUtil::getWinningMatch(matches, m_modRanks);
+    const auto& winningMod = m_pgd->getModName(winningShaderMatch.modID);
+    PGDiag::insert("winningShaderMatch", winningShaderMatch.getJSON(winningMod));
 
     // Apply transforms
     if (PatcherUtil::applyTransformIfNeeded(winningShaderMatch, patchers)) {
-        PGDiag::insert("shaderTransformResult", winningShaderMatch.getJSON());
+        PGDiag::insert("shaderTransformResult", winningShaderMatch.getJSON(winningMod));
     }
 
     shaderApplied = winningShaderMatch.shader;
@@ -783,8 +790,11 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
 
     // loop through patchers
     NIFUtil::TextureSet newSlots;
-    changed |= patchers.shaderPatchers.at(winningShaderMatch.shader)
-                   ->applyPatch(*nifShape, winningShaderMatch.match, newSlots);
+    {
+        const auto& patcher = patchers.shaderPatchers.at(winningShaderMatch.shader);
+        const ParallaxGenTrace::Span traceSpan("applyPatch", [&patcher] { return patcher->getPatcherName(); });
+        changed |= patcher->applyPatch(*nifShape, winningShaderMatch.match, newSlots);
+    }
 
     PGDiag::insert("newTextures", NIFUtil::textureSetToStr(newSlots));
 
@@ -801,6 +811,8 @@ auto ParallaxGen::processShape(const filesystem::path& nifPath, NifFile& nif, Ni
 
 auto ParallaxGen::processDDS(const filesystem::path& ddsFile) -> ParallaxGenTask::PGResult
 {
+    const ParallaxGenTrace::Span traceSpan("processDDS", ddsFile);
+
     auto result = ParallaxGenTask::PGResult::SUCCESS;
 
     const PGDiag::Prefix nifPrefix("textures", nlohmann::json::value_t::object);
@@ -824,6 +836,7 @@ auto ParallaxGen::processDDS(const filesystem::path& ddsFile) -> ParallaxGenTask
 
     for (const auto& factory : m_texPatchers.globalPatchers) {
         auto patcher = factory(ddsFile, &ddsImage);
+        const ParallaxGenTrace::Span traceSpan("applyPatch", [&patcher] { return patcher->getPatcherName(); });
         patcher->applyPatch(ddsModified);
     }
 
@@ -0,0 +1,110 @@
+#include "ParallaxGenAhoCorasick.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+ParallaxGenAhoCorasick::ParallaxGenAhoCorasick()
+    : m_trieOutputs(1)
+{
+}
+
+void ParallaxGenAhoCorasick::addPattern(const wstring& pattern, const size_t& id)
+{
+    const uint32_t node = m_trie.insert(pattern);
+    m_trieOutputs.resize(m_trie.getNumNodes());
+
+    m_trieOutputs[node].push_back(id);
+    m_numPatterns++;
+    m_built = false;
+}
+
+void ParallaxGenAhoCorasick::build()
+{
+    m_trie.build();
+    const size_t numNodes = m_trie.getNumNodes();
+
+    // Failure links in BFS order, a node's fail target is always closer to the root so its outputs are final
+    m_fail.assign(numNodes, ROOT);
+    vector<vector<size_t>> outputs = m_trieOutputs;
+
+    queue<uint32_t> pending;
+    pending.push(ROOT);
+    while (!pending.empty()) {
+        const uint32_t node = pending.front();
+        pending.pop();
+
+        for (const auto& [c, child] : m_trie.getEdges(node)) {
+            if (node != ROOT) {
+                uint32_t fail = m_fail[node];
+                while (fail != ROOT && m_trie.findEdge(fail, c) == ROOT) {
+                    fail = m_fail[fail];
+                }
+                m_fail[child] = m_trie.findEdge(fail, c);
+            }
+
+            // inherit outputs of the longest proper suffix that is also a pattern prefix (root outputs are added by
+            // findAll once per text)
+            if (m_fail[child] != ROOT) {
+                const auto& failOutputs = outputs[m_fail[child]];
+                outputs[child].insert(outputs[child].end(), failOutputs.begin(), failOutputs.end());
+            }
+
+            pending.push(child);
+        }
+    }
+
+    // Flatten outputs
+    m_outputStart.assign(numNodes + 1, 0);
+    m_outputs.clear();
+    for (size_t node = 0; node < numNodes; node++) {
+        m_outputStart[node] = static_cast<uint32_t>(m_outputs.size());
+        m_outputs.insert(m_outputs.end(), outputs[node].begin(), outputs[node].end());
+    }
+    m_outputStart[numNodes] = static_cast<uint32_t>(m_outputs.size());
+
+    m_built = true;
+}
+
+void ParallaxGenAhoCorasick::findAll(const wstring& text, vector<size_t>& ids) const
+{
+    ids.clear();
+
+    if (!m_built) {
+        return;
+    }
+
+    const auto addOutputs = [&](const uint32_t& node) {
+        ids.insert(ids.end(), m_outputs.begin() + m_outputStart[node], m_outputs.begin() + m_outputStart[node + 1]);
+    };
+
+    // empty patterns match every text
+    addOutputs(ROOT);
+
+    uint32_t node = ROOT;
+    for (const auto& textC : text) {
+        const wchar_t c = ParallaxGenCharTrie::toLower(textC);
+
+        uint32_t next = m_trie.findEdge(node, c);
+        while (next == ROOT && node != ROOT) {
+            node = m_fail[node];
+            next = m_trie.findEdge(node, c);
+        }
+        node = next;
+
+        if (node != ROOT) {
+            addOutputs(node);
+        }
+    }
+
+    ranges::sort(ids);
+    const auto [first, last] = ranges::unique(ids);
+    ids.erase(first, last);
+}
+
+auto ParallaxGenAhoCorasick::getNumPatterns() const -> size_t { return m_numPatterns; }
@@ -0,0 +1,52 @@
+#include "ParallaxGenCharTrie.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+ParallaxGenCharTrie::ParallaxGenCharTrie()
+    : m_trieEdges(1)
+{
+}
+
+auto ParallaxGenCharTrie::insert(const wstring& str, const bool& reversed) -> uint32_t
+{
+    uint32_t node = ROOT;
+    for (size_t i = 0; i < str.length(); i++) {
+        const wchar_t c = toLower(reversed ? str[str.length() - 1 - i] : str[i]);
+
+        const auto& edges = m_trieEdges[node];
+        const auto it = ranges::find_if(edges, [&c](const Edge& edge) { return edge.c == c; });
+        if (it != edges.end()) {
+            node = it->target;
+            continue;
+        }
+
+        const auto newNode = static_cast<uint32_t>(m_trieEdges.size());
+        m_trieEdges[node].push_back({ .c = c, .target = newNode });
+        m_trieEdges.emplace_back();
+        node = newNode;
+    }
+
+    return node;
+}
+
+void ParallaxGenCharTrie::build()
+{
+    const size_t numNodes = m_trieEdges.size();
+
+    m_edgeStart.assign(numNodes + 1, 0);
+    m_edges.clear();
+    m_edges.reserve(numNodes - 1);
+    for (size_t node = 0; node < numNodes; node++) {
+        m_edgeStart[node] = static_cast<uint32_t>(m_edges.size());
+        auto edges = m_trieEdges[node];
+        ranges::sort(edges, [](const Edge& a, const Edge& b) { return a.c < b.c; });
+        m_edges.insert(m_edges.end(), edges.begin(), edges.end());
+    }
+    m_edgeStart[numNodes] = static_cast<uint32_t>(m_edges.size());
+}
@@ -0,0 +1,235 @@
+#include "ParallaxGenContentCache.hpp"
+
+#include "Logger.hpp"
+#include "ParallaxGenUtil.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <windows.h>
+
+#include <bcrypt.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+using namespace ParallaxGenUtil;
+
+ParallaxGenContentCache::ParallaxGenContentCache(filesystem::path cacheDir, wstring extension, const uintmax_t& maxSize)
+    : m_cacheDir(std::move(cacheDir))
+    , m_extension(std::move(extension))
+    , m_maxSize(maxSize)
+{
+}
+
+auto ParallaxGenContentCache::getKey(const vector<vector<std::byte>>& inputs, const string& generatorVersion) -> string
+{
+    static constexpr size_t SHA256_SIZE = 32;
+
+    BCRYPT_ALG_HANDLE algHandle = nullptr;
+    if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&algHandle, BCRYPT_SHA256_ALGORITHM, nullptr, 0))) {
+        return {};
+    }
+
+    BCRYPT_HASH_HANDLE hashHandle = nullptr;
+    if (!BCRYPT_SUCCESS(BCryptCreateHash(algHandle, &hashHandle, nullptr, 0, nullptr, 0, 0))) {
+        BCryptCloseAlgorithmProvider(algHandle, 0);
+        return {};
+    }
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-type-const-cast)
+    const auto hashData = [&hashHandle](const void* data, const size_t& size) -> bool {
+        return BCRYPT_SUCCESS(BCryptHashData(
+            hashHandle, const_cast<PUCHAR>(reinterpret_cast<const UCHAR*>(data)), static_cast<ULONG>(size), 0));
+    };
+
+    // every field is length prefixed so different splits of the same bytes hash differently
+    bool success = true;
+    const uint64_t versionSize = generatorVersion.size();
+    success &= hashData(&versionSize, sizeof(versionSize));
+    success &= hashData(generatorVersion.data(), generatorVersion.size());
+    for (const auto& input : inputs) {
+        const uint64_t inputSize = input.size();
+        success &= hashData(&inputSize, sizeof(inputSize));
+        if (!input.empty()) {
+            success &= hashData(input.data(), input.size());
+        }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-type-const-cast)
+
+    array<UCHAR, SHA256_SIZE> digest {};
+    success &= BCRYPT_SUCCESS(BCryptFinishHash(hashHandle, digest.data(), static_cast<ULONG>(digest.size()), 0));
+
+    BCryptDestroyHash(hashHandle);
+    BCryptCloseAlgorithmProvider(algHandle, 0);
+
+    if (!success) {
+        return {};
+    }
+
+    static constexpr array<char, 16> HEX_DIGITS
+        = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+    static constexpr unsigned HEX_SHIFT = 4;
+    static constexpr unsigned HEX_MASK = 0xF;
+
+    string key;
+    key.reserve(digest.size() * 2);
+    for (const auto& byte : digest) {
+        key.push_back(HEX_DIGITS.at(byte >> HEX_SHIFT));
+        key.push_back(HEX_DIGITS.at(byte & HEX_MASK));
+    }
+
+    return key;
+}
+
+auto ParallaxGenContentCache::fetch(const string& key, const filesystem::path& destPath) -> bool
+{
+    const filesystem::path cachePath = getCachePath(key);
+
+    error_code ec;
+    if (key.empty() || !filesystem::exists(cachePath, ec)) {
+        m_numMisses++;
+        return false;
+    }
+
+    filesystem::create_directories(destPath.parent_path(), ec);
+    filesystem::remove(destPath, ec);
+
+    // copy, a hard link would share the file so anything writing the output in place would corrupt the cache
+    filesystem::copy_file(cachePath, destPath, filesystem::copy_options::overwrite_existing, ec);
+    if (ec) {
+        spdlog::debug(L"Failed to place cached file {} at {}: {}", cachePath.wstring(), destPath.wstring(),
+            asciitoUTF16(ec.message()));
+        m_numMisses++;
+        return false;
+    }
+
+    // mark as recently used for eviction
+    filesystem::last_write_time(cachePath, filesystem::file_time_type::clock::now(), ec);
+
+    m_numHits++;
+    return true;
+}
+
+auto ParallaxGenContentCache::store(const string& key, const filesystem::path& srcPath) -> bool
+{
+    if (key.empty()) {
+        return false;
+    }
+
+    const filesystem::path cachePath = getCachePath(key);
+
+    error_code ec;
+    if (filesystem::exists(cachePath, ec)) {
+        return true;
+    }
+
+    filesystem::create_directories(m_cacheDir, ec);
+
+    // copy to a temporary file first so a partially written file is never picked up, every writer gets its own so
+    // two threads storing the same key do not write into each other
+    filesystem::path tempPath = cachePath;
+    tempPath += L"." + to_wstring(GetCurrentProcessId()) + L"." + to_wstring(GetCurrentThreadId()) + L".tmp";
+    filesystem::copy_file(srcPath, tempPath, filesystem::copy_options::overwrite_existing, ec);
+    if (ec) {
+        spdlog::debug(L"Failed to store {} in cache: {}", srcPath.wstring(), asciitoUTF16(ec.message()));
+        filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    filesystem::rename(tempPath, cachePath, ec);
+    if (ec) {
+        error_code removeEC;
+        filesystem::remove(tempPath, removeEC);
+
+        // another writer stored the same content first
+        if (filesystem::exists(cachePath, removeEC)) {
+            return true;
+        }
+
+        spdlog::debug(L"Failed to store {} in cache: {}", srcPath.wstring(), asciitoUTF16(ec.message()));
+        return false;
+    }
+
+    m_numStored++;
+    return true;
+}
+
+void ParallaxGenContentCache::evict()
+{
+    error_code ec;
+    if (!filesystem::exists(m_cacheDir, ec)) {
+        return;
+    }
+
+    vector<tuple<filesystem::file_time_type, uintmax_t, filesystem::path>> cachedFiles;
+    uintmax_t totalSize = 0;
+    for (const auto& entry : filesystem::directory_iterator(m_cacheDir, ec)) {
+        if (!entry.is_regular_file(ec) || entry.path().extension() != m_extension) {
+            continue;
+        }
+
+        const uintmax_t fileSize = entry.file_size(ec);
+        const auto lastWriteTime = entry.last_write_time(ec);
+        cachedFiles.emplace_back(lastWriteTime, fileSize, entry.path());
+        totalSize += fileSize;
+    }
+
+    if (totalSize <= m_maxSize) {
+        return;
+    }
+
+    // oldest first
+    ranges::sort(cachedFiles, [](const auto& a, const auto& b) { return get<0>(a) < get<0>(b); });
+
+    size_t numEvicted = 0;
+    for (const auto& [lastWriteTime, fileSize, filePath] : cachedFiles) {
+        if (totalSize <= m_maxSize) {
+            break;
+        }
+
+        if (filesystem::remove(filePath, ec)) {
+            totalSize -= fileSize;
+            numEvicted++;
+        }
+    }
+
+    spdlog::debug(L"Evicted {} files from cache {}", numEvicted, m_cacheDir.wstring());
+}
+
+auto ParallaxGenContentCache::getSize() const -> uintmax_t
+{
+    error_code ec;
+    if (!filesystem::exists(m_cacheDir, ec)) {
+        return 0;
+    }
+
+    uintmax_t totalSize = 0;
+    for (const auto& entry : filesystem::directory_iterator(m_cacheDir, ec)) {
+        if (entry.is_regular_file(ec) && entry.path().extension() == m_extension) {
+            totalSize += entry.file_size(ec);
+        }
+    }
+
+    return totalSize;
+}
+
+void ParallaxGenContentCache::logStats() const
+{
+    Logger::info(L"Generated file cache {}: {} hits, {} misses, {} stored, {} MB / {} MB", m_cacheDir.wstring(),
+        m_numHits.load(), m_numMisses.load(), m_numStored.load(), getSize() / BYTES_PER_MB, m_maxSize / BYTES_PER_MB);
+}
+
+auto ParallaxGenContentCache::getCachePath(const string& key) const -> filesystem::path
+{
+    return m_cacheDir / (asciitoUTF16(key) + m_extension);
+}
@@ -2,13 +2,17 @@
 
 #include "NIFUtil.hpp"
 #include "ParallaxGenDirectory.hpp"
+#include "ParallaxGenRunner.hpp"
 #include "ParallaxGenTask.hpp"
+#include "ParallaxGenTextureCache.hpp"
+#include "ParallaxGenTrace.hpp"
 #include "ParallaxGenUtil.hpp"
 
 #include <dxgiformat.h>
 #include <spdlog/spdlog.h>
 
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
 #include <DirectXTex.h>
 
 // windows
@@ -23,14 +27,23 @@
 // DXGI
 #include <dxgi.h>
 
+// SIMD
+#include <immintrin.h>
+#include <intrin.h>
+
 // HLSL
 #include <d3dcompiler.h>
 #include <dxcapi.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 
 #include <climits>
 #include <cstdlib>
@@ -50,11 +63,93 @@ ParallaxGenD3D::ParallaxGenD3D(ParallaxGenDirectory* pgd, filesystem::path outpu
     : m_pgd(pgd)
     , m_outputDir(std::move(outputDir))
     , m_exePath(std::move(exePath))
+    , m_texturePool(
+          [this](const ParallaxGenGPUResourceKey& key, GPUTexture& dest) { return createPooledTexture(key, dest); })
+    , m_bufferPool(
+          [this](const ParallaxGenGPUResourceKey& key, GPUBuffer& dest) { return createPooledBuffer(key, dest); })
+{
+}
+
+void ParallaxGenD3D::loadTextureCache(ParallaxGenTextureCache* textureCache) { m_textureCache = textureCache; }
+
+void ParallaxGenD3D::buildDDSHeaderIndex(const bool& multithreading)
 {
+    const ParallaxGenTrace::Span traceSpan("buildDDSHeaderIndex");
+
+    if (m_ddsHeaderIndexReady.load(memory_order_acquire)) {
+        return;
+    }
+
+    // Collect every mapped texture, file map keys are already lowercase
+    vector<filesystem::path> ddsFiles;
+    for (const auto& [filePath, file] : m_pgd->getFileMap()) {
+        if (filePath.extension() == L".dds") {
+            ddsFiles.push_back(filePath);
+        }
+    }
+
+    spdlog::info("Reading {} DDS headers", ddsFiles.size());
+
+    // Every task writes only its own slots, so no locking is needed
+    vector<DirectX::TexMetadata> ddsMetas(ddsFiles.size());
+    vector<char> ddsMetasValid(ddsFiles.size(), 0);
+
+    ParallaxGenRunner runner(multithreading);
+    for (size_t chunkStart = 0; chunkStart < ddsFiles.size(); chunkStart += DDS_HEADER_INDEX_CHUNK_SIZE) {
+        const size_t chunkEnd = min(chunkStart + DDS_HEADER_INDEX_CHUNK_SIZE, ddsFiles.size());
+        runner.addTask([this, &ddsFiles, &ddsMetas, &ddsMetasValid, chunkStart, chunkEnd] {
+            for (size_t i = chunkStart; i < chunkEnd; i++) {
+                BethesdaDirectory::FileFingerprint fingerprint;
+                if (m_textureCache != nullptr) {
+                    fingerprint = m_pgd->getFileFingerprint(ddsFiles[i]);
+                    ParallaxGenTextureCache::Entry cacheEntry;
+                    if (!fingerprint.source.empty() && m_textureCache->lookup(ddsFiles[i], fingerprint, cacheEntry)
+                        && cacheEntry.hasMetadata) {
+                        ddsMetas[i] = cacheEntry.metadata;
+                        ddsMetasValid[i] = 1;
+                        continue;
+                    }
+                }
+
+                const vector<std::byte> header = m_pgd->getFileHeader(ddsFiles[i], DDS_HEADER_READ_SIZE);
+                if (header.empty()) {
+                    continue;
+                }
+
+                const HRESULT hr = DirectX::GetMetadataFromDDSMemory(
+                    header.data(), header.size(), DirectX::DDS_FLAGS_NONE, ddsMetas[i]);
+                if (FAILED(hr)) {
+                    spdlog::trace(L"Failed to read DDS header of {}: {}", ddsFiles[i].wstring(),
+                        asciitoUTF16(getHRESULTErrorMessage(hr)));
+                    continue;
+                }
+
+                ddsMetasValid[i] = 1;
+
+                if (m_textureCache != nullptr && !fingerprint.source.empty()) {
+                    m_textureCache->updateMetadata(ddsFiles[i], fingerprint, ddsMetas[i]);
+                }
+            }
+        });
+    }
+    runner.runTasks();
+
+    // Publish the table, it is never modified after this point
+    m_ddsHeaderIndex.reserve(ddsFiles.size());
+    for (size_t i = 0; i < ddsFiles.size(); i++) {
+        if (ddsMetasValid[i] != 0) {
+            m_ddsHeaderIndex.emplace(std::move(ddsFiles[i]), ddsMetas[i]);
+        }
+    }
+    m_ddsHeaderIndexReady.store(true, memory_order_release);
+
+    spdlog::info("Indexed {} of {} DDS headers", m_ddsHeaderIndex.size(), ddsFiles.size());
 }
 
 auto ParallaxGenD3D::findCMMaps(const std::vector<std::wstring>& bsaExcludes) -> ParallaxGenTask::PGResult
 {
+    const ParallaxGenTrace::Span traceSpan("findCMMaps");
+
     Logger::info("Finding complex material maps");
 
     if (m_ptrDevice == nullptr || m_ptrContext == nullptr) {
@@ -65,72 +160,137 @@ auto ParallaxGenD3D::findCMMaps(const std::vector<std::wstring>& bsaExcludes) ->
 
     ParallaxGenTask::PGResult pgResult = ParallaxGenTask::PGResult::SUCCESS;
 
-    // loop through maps
-    for (auto& envSlot : envMasks) {
-        vector<tuple<NIFUtil::PGTexture, bool, bool, bool>> cmMaps;
-
-        for (const auto& envMask : envSlot.second) {
+    // find candidates from the texture cache and the DDS headers only
+    vector<tuple<wstring, NIFUtil::PGTexture, BethesdaDirectory::FileFingerprint>> candidates;
+    vector<tuple<wstring, NIFUtil::PGTexture, ParallaxGenTextureCache::Entry>> cachedCMs;
+    for (const auto& [envSlotKey, envSlotTextures] : envMasks) {
+        for (const auto& envMask : envSlotTextures) {
             if (envMask.type != NIFUtil::TextureType::ENVIRONMENTMASK) {
                 continue;
             }
 
-            const bool bFileInVanillaBSA = m_pgd->isFileInBSA(envMask.path, bsaExcludes);
-
-            bool result = false;
-            bool hasMetalness = false;
-            bool hasGlosiness = false;
-            bool hasEnvMask = false;
-            if (!bFileInVanillaBSA) {
-                try {
-                    ParallaxGenTask::updatePGResult(pgResult,
-                        checkIfCM(envMask.path, result, hasEnvMask, hasGlosiness, hasMetalness),
-                        ParallaxGenTask::PGResult::SUCCESS_WITH_WARNINGS);
-                } catch (const exception& e) {
-                    spdlog::error(L"Failed to check if {} is a complex material: {}", envMask.path.wstring(),
-                        asciitoUTF16(e.what()));
-                    pgResult = ParallaxGenTask::PGResult::SUCCESS_WITH_WARNINGS;
-                    continue;
-                }
-            } else {
+            if (m_pgd->isFileInBSA(envMask.path, bsaExcludes)) {
                 spdlog::trace(L"Envmask {} is contained in excluded BSA - skipping complex material check",
                     envMask.path.wstring());
+                continue;
             }
 
-            if (result) {
-                // remove old env mask
-                cmMaps.emplace_back(envMask, hasEnvMask, hasGlosiness, hasMetalness);
-                spdlog::trace(L"Found complex material env mask: {}", envMask.path.wstring());
+            BethesdaDirectory::FileFingerprint fingerprint;
+            if (m_textureCache != nullptr) {
+                fingerprint = m_pgd->getFileFingerprint(envMask.path);
+                ParallaxGenTextureCache::Entry cacheEntry;
+                if (!fingerprint.source.empty() && m_textureCache->lookup(envMask.path, fingerprint, cacheEntry)
+                    && cacheEntry.cmChecked) {
+                    if (cacheEntry.isCM) {
+                        cachedCMs.emplace_back(envSlotKey, envMask, cacheEntry);
+                    }
+                    continue;
+                }
             }
-        }
-
-        // update map
-        for (const auto& [cmMap, hasEnvMask, hasGlosiness, hasMetalness] : cmMaps) {
-            envSlot.second.erase(cmMap);
-            envSlot.second.insert({ cmMap.path, NIFUtil::TextureType::COMPLEXMATERIAL });
-            m_pgd->setTextureType(cmMap.path, NIFUtil::TextureType::COMPLEXMATERIAL);
 
-            if (hasEnvMask) {
-                m_pgd->addTextureAttribute(cmMap.path, NIFUtil::TextureAttribute::CM_ENVMASK);
+            bool isCandidate = false;
+            try {
+                ParallaxGenTask::updatePGResult(pgResult, checkIfCMCandidate(envMask.path, isCandidate),
+                    ParallaxGenTask::PGResult::SUCCESS_WITH_WARNINGS);
+            } catch (const exception& e) {
+                spdlog::error(L"Failed to check if {} is a complex material: {}", envMask.path.wstring(),
+                    asciitoUTF16(e.what()));
+                pgResult = ParallaxGenTask::PGResult::SUCCESS_WITH_WARNINGS;
+                continue;
             }
 
-            if (hasGlosiness) {
-                m_pgd->addTextureAttribute(cmMap.path, NIFUtil::TextureAttribute::CM_GLOSSINESS);
+            if (isCandidate) {
+                candidates.emplace_back(envSlotKey, envMask, fingerprint);
+            } else if (m_textureCache != nullptr && !fingerprint.source.empty()) {
+                m_textureCache->updateCM(envMask.path, fingerprint, false, false, false, false);
             }
+        }
+    }
 
-            if (hasMetalness) {
-                m_pgd->addTextureAttribute(cmMap.path, NIFUtil::TextureAttribute::CM_METALNESS);
-            }
+    // count values on the GPU, the next candidates are decoded while earlier ones are in flight
+    vector<DirectX::TexMetadata> candidateMeta(candidates.size());
+    const auto candidateValues
+        = countValuesGPUBatch(candidates.size(), [&](const size_t& index, DirectX::ScratchImage& image) -> bool {
+              const auto& ddsPath = get<1>(candidates[index]).path;
+              try {
+                  if (getDDS(ddsPath, image) != ParallaxGenTask::PGResult::SUCCESS) {
+                      spdlog::error(L"Failed to load DDS file (Skipping): {}", ddsPath.wstring());
+                      pgResult = ParallaxGenTask::PGResult::SUCCESS_WITH_WARNINGS;
+                      return false;
+                  }
+              } catch (const exception& e) {
+                  spdlog::error(L"Failed to check if {} is a complex material: {}", ddsPath.wstring(),
+                      asciitoUTF16(e.what()));
+                  pgResult = ParallaxGenTask::PGResult::SUCCESS_WITH_WARNINGS;
+                  return false;
+              }
+
+              candidateMeta[index] = image.GetMetadata();
+              return true;
+          });
+
+    // update map
+    const auto markCM = [&](const wstring& envSlotKey, const NIFUtil::PGTexture& cmMap, const bool& hasEnvMask,
+                            const bool& hasGlosiness, const bool& hasMetalness) {
+        spdlog::trace(L"Found complex material env mask: {}", cmMap.path.wstring());
+
+        auto& envSlot = envMasks[envSlotKey];
+        envSlot.erase(cmMap);
+        envSlot.insert({ cmMap.path, NIFUtil::TextureType::COMPLEXMATERIAL });
+        m_pgd->setTextureType(cmMap.path, NIFUtil::TextureType::COMPLEXMATERIAL);
+
+        if (hasEnvMask) {
+            m_pgd->addTextureAttribute(cmMap.path, NIFUtil::TextureAttribute::CM_ENVMASK);
+        }
+
+        if (hasGlosiness) {
+            m_pgd->addTextureAttribute(cmMap.path, NIFUtil::TextureAttribute::CM_GLOSSINESS);
+        }
+
+        if (hasMetalness) {
+            m_pgd->addTextureAttribute(cmMap.path, NIFUtil::TextureAttribute::CM_METALNESS);
+        }
+    };
+
+    for (const auto& [envSlotKey, cmMap, cacheEntry] : cachedCMs) {
+        markCM(envSlotKey, cmMap, cacheEntry.hasEnvMask, cacheEntry.hasGlossiness, cacheEntry.hasMetalness);
+    }
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (!candidateValues[i].has_value()) {
+            continue;
+        }
+
+        const auto& [envSlotKey, cmMap, fingerprint] = candidates[i];
+
+        bool hasMetalness = false;
+        bool hasGlosiness = false;
+        bool hasEnvMask = false;
+        const bool isCM
+            = checkIfCM(candidateValues[i].value(), candidateMeta[i], hasEnvMask, hasGlosiness, hasMetalness);
+
+        if (m_textureCache != nullptr && !fingerprint.source.empty()) {
+            m_textureCache->updateCM(cmMap.path, fingerprint, isCM, hasEnvMask, hasGlosiness, hasMetalness);
+        }
+
+        if (isCM) {
+            markCM(envSlotKey, cmMap, hasEnvMask, hasGlosiness, hasMetalness);
         }
     }
 
+    spdlog::debug("GPU resource pool: {} textures created, {} reused, {} buffers created, {} reused",
+        m_texturePool.getNumCreated(), m_texturePool.getNumReused(), m_bufferPool.getNumCreated(),
+        m_bufferPool.getNumReused());
+
     Logger::info("Done finding complex material env maps");
 
     return ParallaxGenTask::PGResult::SUCCESS;
 }
 
-auto ParallaxGenD3D::checkIfCM(const filesystem::path& ddsPath, bool& result, bool& hasEnvMask, bool& hasGlosiness,
-    bool& hasMetalness) -> ParallaxGenTask::PGResult
+auto ParallaxGenD3D::checkIfCMCandidate(const filesystem::path& ddsPath, bool& result) -> ParallaxGenTask::PGResult
 {
+    const ParallaxGenTrace::Span traceSpan("checkIfCMCandidate", ddsPath);
+
     // get metadata (should only pull headers, which is much faster)
     DirectX::TexMetadata ddsImageMeta {};
     auto pgResult = getDDSMetadata(ddsPath, ddsImageMeta);
@@ -186,22 +346,17 @@ auto ParallaxGenD3D::checkIfCM(const filesystem::path& ddsPath, bool& result, bo
         return ParallaxGenTask::PGResult::SUCCESS;
     }
 
-    // Read image
-    DirectX::ScratchImage image;
-    pgResult = getDDS(ddsPath, image);
-    if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
-        spdlog::error(L"Failed to load DDS file (Skipping): {}", ddsPath.wstring());
-        return pgResult;
-    }
-
-    array<int, 4> values {};
-    values = countValuesGPU(image);
+    result = true;
+    return ParallaxGenTask::PGResult::SUCCESS;
+}
 
+auto ParallaxGenD3D::checkIfCM(const array<int, 4>& values, const DirectX::TexMetadata& ddsImageMeta,
+    bool& hasEnvMask, bool& hasGlosiness, bool& hasMetalness) -> bool
+{
     const size_t numPixels = ddsImageMeta.width * ddsImageMeta.height;
     if (values[3] > numPixels / 2) {
         // check alpha
-        result = false;
-        return ParallaxGenTask::PGResult::SUCCESS;
+        return false;
     }
 
     if (values[0] > 0) {
@@ -217,87 +372,117 @@ auto ParallaxGenD3D::checkIfCM(const filesystem::path& ddsPath, bool& result, bo
         hasMetalness = true;
     }
 
-    result = true;
-    return ParallaxGenTask::PGResult::SUCCESS;
+    return true;
 }
 
-auto ParallaxGenD3D::countValuesGPU(const DirectX::ScratchImage& image) -> array<int, 4>
+auto ParallaxGenD3D::countValuesGPUBatch(const size_t& numImages,
+    const function<bool(const size_t&, DirectX::ScratchImage&)>& loadImage) -> vector<optional<array<int, 4>>>
 {
+    const ParallaxGenTrace::Span traceSpan("countValuesGPUBatch");
+
     if ((m_ptrContext == nullptr) || (m_ptrDevice == nullptr) || (m_shaderCountAlphaValues == nullptr)) {
         throw runtime_error("GPU not initialized");
     }
 
-    // Create GPU texture
-    ComPtr<ID3D11Texture2D> inputTex;
-    if (createTexture2D(image, inputTex) != ParallaxGenTask::PGResult::SUCCESS) {
-        return {};
-    }
+    vector<optional<array<int, 4>>> results(numImages);
 
-    // Create SRV
-    ComPtr<ID3D11ShaderResourceView> inputSRV;
-    if (createShaderResourceView(inputTex, inputSRV) != ParallaxGenTask::PGResult::SUCCESS) {
-        return {};
+    ParallaxGenGPUBatch<CountValuesJob> batch(this, NUM_GPU_JOBS_IN_FLIGHT, [&](CountValuesJob& job) {
+        const lock_guard<recursive_mutex> lock(m_gpuOperationMutex);
+
+        // fence completed, so mapping the staging buffer does not stall
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        const HRESULT hr = m_ptrContext->Map(job.staging.buffer.Get(), 0, D3D11_MAP_READ, 0, &mappedResource);
+        if (SUCCEEDED(hr)) {
+            array<int, 4> values {};
+            memcpy(values.data(), mappedResource.pData, sizeof(values));
+            m_ptrContext->Unmap(job.staging.buffer.Get(), 0);
+            results[job.index] = values;
+        } else {
+            spdlog::debug("[GPU] Failed to map resource to CPU during read back: {}", getHRESULTErrorMessage(hr));
+        }
+
+        releaseCountValuesJob(job);
+    });
+
+    for (size_t i = 0; i < numImages; i++) {
+        // decode on the CPU while earlier dispatches run
+        DirectX::ScratchImage image;
+        if (!loadImage(i, image)) {
+            continue;
+        }
+
+        CountValuesJob job;
+        job.index = i;
+        if (!recordCountValues(image, job)) {
+            continue;
+        }
+
+        batch.push(std::move(job));
     }
 
-    // Create buffer for output
-    D3D11_BUFFER_DESC bufferDesc = {};
-    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    bufferDesc.ByteWidth = sizeof(UINT) * 4;
-    bufferDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
-    bufferDesc.CPUAccessFlags = 0;
-    bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-    bufferDesc.StructureByteStride = sizeof(UINT);
-
-    array<unsigned int, 4> outputData = { 0, 0, 0, 0 };
-    ComPtr<ID3D11Buffer> outputBuffer;
-    if (createBuffer(outputData.data(), bufferDesc, outputBuffer) != ParallaxGenTask::PGResult::SUCCESS) {
-        return {};
+    batch.flush();
+
+    return results;
+}
+
+auto ParallaxGenD3D::recordCountValues(const DirectX::ScratchImage& image, CountValuesJob& job) -> bool
+{
+    const lock_guard<recursive_mutex> lock(m_gpuOperationMutex);
+
+    // Upload input texture
+    if (acquireTexture2D(image, job.inputKey, job.input) != ParallaxGenTask::PGResult::SUCCESS) {
+        return false;
     }
 
-    // Create UAV for output buffer
-    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-    uavDesc.Format = DXGI_FORMAT_UNKNOWN;
-    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
-    uavDesc.Buffer.FirstElement = 0;
-    uavDesc.Buffer.NumElements = 4;
+    // Output buffer, reset to 0
+    const array<unsigned int, 4> outputInitData = { 0, 0, 0, 0 };
+    if (acquireStructuredBuffer(outputInitData.data(), sizeof(outputInitData), sizeof(UINT), job.outputKey, job.output)
+        != ParallaxGenTask::PGResult::SUCCESS) {
+        releaseCountValuesJob(job);
+        return false;
+    }
 
-    ComPtr<ID3D11UnorderedAccessView> outputBufferUAV;
-    if (createUnorderedAccessView(outputBuffer, uavDesc, outputBufferUAV) != ParallaxGenTask::PGResult::SUCCESS) {
-        return {};
+    // Staging buffer for read back, stays checked out until the job retires
+    job.stagingKey = { .width = job.outputKey.width, .usage = D3D11_USAGE_STAGING };
+    if (!m_bufferPool.acquire(job.stagingKey, job.staging)) {
+        releaseCountValuesJob(job);
+        return false;
     }
 
     // Dispatch shader
     m_ptrContext->CSSetShader(m_shaderCountAlphaValues.Get(), nullptr, 0);
-    m_ptrContext->CSSetShaderResources(0, 1, inputSRV.GetAddressOf());
-    m_ptrContext->CSSetUnorderedAccessViews(0, 1, outputBufferUAV.GetAddressOf(), nullptr);
+    m_ptrContext->CSSetShaderResources(0, 1, job.input.srv.GetAddressOf());
+    m_ptrContext->CSSetUnorderedAccessViews(0, 1, job.output.uav.GetAddressOf(), nullptr);
 
     const DirectX::TexMetadata imageMeta = image.GetMetadata();
-    if (blockingDispatch(static_cast<UINT>(imageMeta.width), static_cast<UINT>(imageMeta.height), 1)
-        != ParallaxGenTask::PGResult::SUCCESS) {
-        return {};
-    }
-
-    // Clean Up Objects
-    inputTex.Reset();
-    inputSRV.Reset();
+    dispatch(static_cast<UINT>(imageMeta.width), static_cast<UINT>(imageMeta.height), 1);
 
     // Clean up shader resources
-    array<ID3D11ShaderResourceView*, 2> nullSRV = { nullptr, nullptr };
+    array<ID3D11ShaderResourceView*, 1> nullSRV = { nullptr };
     m_ptrContext->CSSetShaderResources(0, 1, nullSRV.data());
-    array<ID3D11UnorderedAccessView*, 2> nullUAV = { nullptr, nullptr };
+    array<ID3D11UnorderedAccessView*, 1> nullUAV = { nullptr };
     m_ptrContext->CSSetUnorderedAccessViews(0, 1, nullUAV.data(), nullptr);
     m_ptrContext->CSSetShader(nullptr, nullptr, 0);
 
-    // Read back data
-    vector<array<int, 4>> data = readBack<array<int, 4>>(outputBuffer);
+    // Queue copy to staging, it is read once the fence for this job completes
+    m_ptrContext->CopyResource(job.staging.buffer.Get(), job.output.buffer.Get());
 
-    // Cleanup
-    outputBuffer.Reset();
-    outputBufferUAV.Reset();
+    return true;
+}
 
-    m_ptrContext->Flush(); // Flush GPU to avoid leaks
+void ParallaxGenD3D::releaseCountValuesJob(CountValuesJob& job)
+{
+    if (job.input.texture != nullptr) {
+        m_texturePool.release(job.inputKey, std::move(job.input));
+    }
 
-    return data[0];
+    if (job.output.buffer != nullptr) {
+        m_bufferPool.release(job.outputKey, std::move(job.output));
+    }
+
+    if (job.staging.buffer != nullptr) {
+        m_bufferPool.release(job.stagingKey, std::move(job.staging));
+    }
 }
 
 auto ParallaxGenD3D::checkIfAspectRatioMatches(
@@ -333,6 +518,8 @@ auto ParallaxGenD3D::checkIfAspectRatioMatches(
 
 void ParallaxGenD3D::initGPU()
 {
+    const ParallaxGenTrace::Span traceSpan("initGPU");
+
 // initialize GPU device and context
 #ifdef _DEBUG
     UINT deviceFlags = D3D11_CREATE_DEVICE_DEBUG;
@@ -370,13 +557,6 @@ void ParallaxGenD3D::initShaders()
     ParallaxGenTask::PGResult pgResult {};
 
     // TODO don't repeat error handling code
-    // ConvertToHDR.hlsl
-    pgResult = createComputeShader(L"ConvertToHDR.hlsl", m_shaderConvertToHDR);
-    if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
-        spdlog::critical("Failed to create compute shader. Exiting.");
-        exit(1);
-    }
-
     // MergeToComplexMaterial.hlsl
     pgResult = createComputeShader(L"MergeToComplexMaterial.hlsl", m_shaderMergeToComplexMaterial);
     if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
@@ -447,12 +627,12 @@ auto ParallaxGenD3D::createComputeShader(const wstring& shaderPath, ComPtr<ID3D1
 auto ParallaxGenD3D::upgradeToComplexMaterial(
     const std::filesystem::path& parallaxMap, const std::filesystem::path& envMap) -> DirectX::ScratchImage
 {
+    const ParallaxGenTrace::Span traceSpan("upgradeToComplexMaterial", parallaxMap);
+
     if ((m_ptrContext == nullptr) || (m_ptrDevice == nullptr) || (m_shaderMergeToComplexMaterial == nullptr)) {
         throw runtime_error("GPU was not initialized");
     }
 
-    const lock_guard<mutex> lock(m_gpuOperationMutex);
-
     ParallaxGenTask::PGResult pgResult {};
 
     const bool parallaxExists = !parallaxMap.empty();
@@ -510,29 +690,23 @@ auto ParallaxGenD3D::upgradeToComplexMaterial(
         return {};
     }
 
-    // Create GPU Textures objects
-    ComPtr<ID3D11Texture2D> parallaxMapGPU;
-    ComPtr<ID3D11ShaderResourceView> parallaxMapSRV;
+    // Only upload, dispatch and read back use the immediate context, loading and compression run without the lock
+    unique_lock<recursive_mutex> gpuLock(m_gpuOperationMutex);
+
+    // Upload textures to pooled GPU textures
+    ParallaxGenGPUResourceKey parallaxMapKey;
+    GPUTexture parallaxMapGPU;
     if (parallaxExists) {
-        pgResult = createTexture2D(parallaxMapDDS, parallaxMapGPU);
+        pgResult = acquireTexture2D(parallaxMapDDS, parallaxMapKey, parallaxMapGPU);
         if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
             spdlog::debug(L"Failed to create GPU texture for {}", parallaxMap.wstring());
             return {};
         }
-        pgResult = createShaderResourceView(parallaxMapGPU, parallaxMapSRV);
-        if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
-            spdlog::debug(L"Failed to create GPU SRV for {}", parallaxMap.wstring());
-            return {};
-        }
     }
-    ComPtr<ID3D11Texture2D> envMapGPU;
-    ComPtr<ID3D11ShaderResourceView> envMapSRV;
+    ParallaxGenGPUResourceKey envMapKey;
+    GPUTexture envMapGPU;
     if (envExists) {
-        pgResult = createTexture2D(envMapDDS, envMapGPU);
-        if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
-            return {};
-        }
-        pgResult = createShaderResourceView(envMapGPU, envMapSRV);
+        pgResult = acquireTexture2D(envMapDDS, envMapKey, envMapGPU);
         if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
             return {};
         }
@@ -562,84 +736,51 @@ auto ParallaxGenD3D::upgradeToComplexMaterial(
     shaderParams.parallaxMapAvailable = static_cast<BOOL>(parallaxExists);
     shaderParams.intScalingFactor = MAX_CHANNEL_VALUE;
 
-    ComPtr<ID3D11Buffer> constantBuffer;
-    pgResult = createConstantBuffer(&shaderParams, sizeof(ShaderMergeToComplexMaterialParams), constantBuffer);
+    ParallaxGenGPUResourceKey constantBufferKey;
+    GPUBuffer constantBuffer;
+    pgResult = acquireConstantBuffer(
+        &shaderParams, sizeof(ShaderMergeToComplexMaterialParams), constantBufferKey, constantBuffer);
     if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
         return {};
     }
 
-    // Create output texture
-    D3D11_TEXTURE2D_DESC outputTextureDesc = {};
-    if (parallaxExists) {
-        parallaxMapGPU->GetDesc(&outputTextureDesc);
-    } else {
-        envMapGPU->GetDesc(&outputTextureDesc);
-    }
-    outputTextureDesc.Width = resultWidth;
-    outputTextureDesc.Height = resultHeight;
-    outputTextureDesc.MipLevels = 0;
-    outputTextureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    outputTextureDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
-
-    ComPtr<ID3D11Texture2D> outputTexture;
-    pgResult = createTexture2D(outputTextureDesc, outputTexture);
-    if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
+    // Create output texture (0 mip levels creates the full mip chain)
+    const ParallaxGenGPUResourceKey outputTextureKey = { .width = resultWidth,
+        .height = resultHeight,
+        .mipLevels = 0,
+        .format = DXGI_FORMAT_R8G8B8A8_UNORM,
+        .bindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE,
+        .usage = D3D11_USAGE_DEFAULT };
+    GPUTexture outputTexture;
+    if (!m_texturePool.acquire(outputTextureKey, outputTexture)) {
         return {};
     }
     // Query the texture's description to get the actual number of mip levels
     D3D11_TEXTURE2D_DESC createdOutputTextureDesc = {};
-    outputTexture->GetDesc(&createdOutputTextureDesc);
+    outputTexture.texture->GetDesc(&createdOutputTextureDesc);
     const UINT resultMips = createdOutputTextureDesc.MipLevels;
 
-    ComPtr<ID3D11UnorderedAccessView> outputUAV;
-    pgResult = createUnorderedAccessView(outputTexture, outputUAV);
-    if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
-        return {};
-    }
-
     // Create buffer for output
     ShaderMergeToComplexMaterialOutputBuffer minMaxInitData
         = { .minEnvValue = UINT_MAX, .maxEnvValue = 0, .minParallaxValue = UINT_MAX, .maxParallaxValue = 0 };
 
-    D3D11_BUFFER_DESC bufferDesc = {};
-    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    bufferDesc.ByteWidth = sizeof(ShaderMergeToComplexMaterialOutputBuffer);
-    bufferDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
-    bufferDesc.CPUAccessFlags = 0;
-    bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-    bufferDesc.StructureByteStride = sizeof(UINT);
-
-    ComPtr<ID3D11Buffer> outputBuffer;
-    pgResult = createBuffer(&minMaxInitData, bufferDesc, outputBuffer);
-    if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
-        return {};
-    }
-
-    // Create UAV for output buffer
-    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-    uavDesc.Format = DXGI_FORMAT_UNKNOWN;
-    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
-    uavDesc.Buffer.FirstElement = 0;
-    uavDesc.Buffer.NumElements = 4;
-
-    ComPtr<ID3D11UnorderedAccessView> outputBufferUAV;
-    pgResult = createUnorderedAccessView(outputBuffer, uavDesc, outputBufferUAV);
+    ParallaxGenGPUResourceKey outputBufferKey;
+    GPUBuffer outputBuffer;
+    pgResult = acquireStructuredBuffer(
+        &minMaxInitData, sizeof(ShaderMergeToComplexMaterialOutputBuffer), sizeof(UINT), outputBufferKey, outputBuffer);
     if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
         return {};
     }
 
     // Dispatch shader
     m_ptrContext->CSSetShader(m_shaderMergeToComplexMaterial.Get(), nullptr, 0);
-    m_ptrContext->CSSetConstantBuffers(0, 1, constantBuffer.GetAddressOf());
-    m_ptrContext->CSSetShaderResources(0, 1, envMapSRV.GetAddressOf());
-    m_ptrContext->CSSetShaderResources(1, 1, parallaxMapSRV.GetAddressOf());
-    m_ptrContext->CSSetUnorderedAccessViews(0, 1, outputUAV.GetAddressOf(), nullptr);
-    m_ptrContext->CSSetUnorderedAccessViews(1, 1, outputBufferUAV.GetAddressOf(), nullptr);
+    m_ptrContext->CSSetConstantBuffers(0, 1, constantBuffer.buffer.GetAddressOf());
+    m_ptrContext->CSSetShaderResources(0, 1, envMapGPU.srv.GetAddressOf());
+    m_ptrContext->CSSetShaderResources(1, 1, parallaxMapGPU.srv.GetAddressOf());
+    m_ptrContext->CSSetUnorderedAccessViews(0, 1, outputTexture.uav.GetAddressOf(), nullptr);
+    m_ptrContext->CSSetUnorderedAccessViews(1, 1, outputBuffer.uav.GetAddressOf(), nullptr);
 
-    pgResult = blockingDispatch(resultWidth, resultHeight, 1);
-    if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
-        return {};
-    }
+    dispatch(resultWidth, resultHeight, 1);
 
     // Clean up shader resources
     array<ID3D11ShaderResourceView*, 2> nullSRV = { nullptr, nullptr };
@@ -650,52 +791,45 @@ auto ParallaxGenD3D::upgradeToComplexMaterial(
     m_ptrContext->CSSetConstantBuffers(0, 1, nullBuffer.data());
     m_ptrContext->CSSetShader(nullptr, nullptr, 0);
 
-    // Release some objects
-    parallaxMapGPU.Reset();
-    envMapGPU.Reset();
-    parallaxMapSRV.Reset();
-    envMapSRV.Reset();
-    constantBuffer.Reset();
+    // Return inputs to the pools
+    if (parallaxExists) {
+        m_texturePool.release(parallaxMapKey, std::move(parallaxMapGPU));
+    }
+    if (envExists) {
+        m_texturePool.release(envMapKey, std::move(envMapGPU));
+    }
+    m_bufferPool.release(constantBufferKey, std::move(constantBuffer));
+    m_bufferPool.release(outputBufferKey, std::move(outputBuffer));
 
     // Generate mips
-    D3D11_TEXTURE2D_DESC outputTextureMipsDesc = {};
-    outputTexture->GetDesc(&outputTextureMipsDesc);
-    outputTextureMipsDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
-    outputTextureMipsDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
-    ComPtr<ID3D11Texture2D> outputTextureMips;
-    pgResult = createTexture2D(outputTextureMipsDesc, outputTextureMips);
-    if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
-        return {};
-    }
-    ComPtr<ID3D11ShaderResourceView> outputMipsSRV;
-    pgResult = createShaderResourceView(outputTextureMips, outputMipsSRV);
-    if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
+    const ParallaxGenGPUResourceKey outputTextureMipsKey = { .width = resultWidth,
+        .height = resultHeight,
+        .mipLevels = resultMips,
+        .format = DXGI_FORMAT_R8G8B8A8_UNORM,
+        .bindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET,
+        .miscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS,
+        .usage = D3D11_USAGE_DEFAULT };
+    GPUTexture outputTextureMips;
+    if (!m_texturePool.acquire(outputTextureMipsKey, outputTextureMips)) {
         return {};
     }
 
     // Copy texture
-    m_ptrContext->CopyResource(outputTextureMips.Get(), outputTexture.Get());
-    m_ptrContext->GenerateMips(outputMipsSRV.Get());
-    m_ptrContext->CopyResource(outputTexture.Get(), outputTextureMips.Get());
-
-    // cleanup
-    outputTextureMips.Reset();
-    outputMipsSRV.Reset();
+    m_ptrContext->CopyResource(outputTextureMips.texture.Get(), outputTexture.texture.Get());
+    m_ptrContext->GenerateMips(outputTextureMips.srv.Get());
+    m_ptrContext->CopyResource(outputTexture.texture.Get(), outputTextureMips.texture.Get());
 
-    // Read back output buffer
-    auto outputBufferData = readBack<UINT>(outputBuffer);
+    m_texturePool.release(outputTextureMipsKey, std::move(outputTextureMips));
 
-    // Read back texture (DEBUG)
-    auto outputTextureData = readBack(outputTexture);
+    // Let other threads use the context while the GPU works, the read back only copies the finished texture
+    const FenceValue fence = signalFence();
+    gpuLock.unlock();
+    waitForFence(fence);
 
-    // More cleaning
-    outputTexture.Reset();
-    outputUAV.Reset();
-    outputBuffer.Reset();
-    outputBufferUAV.Reset();
+    // Read back texture
+    auto outputTextureData = readBack(outputTexture.texture);
 
-    // Flush GPU to avoid leaks
-    m_ptrContext->Flush();
+    m_texturePool.release(outputTextureKey, std::move(outputTexture));
 
     // Import into directx scratchimage
     const DirectX::ScratchImage outputImage = loadRawPixelsToScratchImage(
@@ -717,169 +851,241 @@ auto ParallaxGenD3D::upgradeToComplexMaterial(
 void ParallaxGenD3D::convertToHDR(
     DirectX::ScratchImage* dds, bool& ddsModified, const float& luminanceMult, const DXGI_FORMAT& outputFormat)
 {
-    if ((m_ptrContext == nullptr) || (m_ptrDevice == nullptr) || (m_shaderMergeToComplexMaterial == nullptr)) {
-        throw runtime_error("GPU was not initialized");
-    }
+    const ParallaxGenTrace::Span traceSpan("convertToHDR");
 
     if (dds == nullptr) {
         throw runtime_error("DDS image is null");
     }
 
-    const lock_guard<mutex> lock(m_gpuOperationMutex);
-
-    const DirectX::TexMetadata inputMeta = dds->GetMetadata();
-
-    // Load texture on GPU
-    ComPtr<ID3D11Texture2D> inputDDSGPU;
-    if (createTexture2D(*dds, inputDDSGPU) != ParallaxGenTask::PGResult::SUCCESS) {
+    if (outputFormat != DXGI_FORMAT_R16G16B16A16_FLOAT && outputFormat != DXGI_FORMAT_R32G32B32A32_FLOAT) {
+        Logger::error(L"Unsupported HDR output format: {}", static_cast<int>(outputFormat));
         return;
     }
 
-    // Create shader resource view
-    ComPtr<ID3D11ShaderResourceView> inputDDSSRV;
-    if (createShaderResourceView(inputDDSGPU, inputDDSSRV) != ParallaxGenTask::PGResult::SUCCESS) {
-        return;
-    }
+    const DirectX::TexMetadata inputMeta = dds->GetMetadata();
 
-    // Create constant parameter buffer
-    ShaderConvertToHDRParams shaderParams {};
-    shaderParams.luminanceMult = luminanceMult;
+    // Destination has the same layout as the source, only the format changes
+    DirectX::TexMetadata outputMeta = inputMeta;
+    outputMeta.format = outputFormat;
 
-    ComPtr<ID3D11Buffer> constantBuffer;
-    if (createConstantBuffer(&shaderParams, sizeof(ShaderConvertToHDRParams), constantBuffer)
-        != ParallaxGenTask::PGResult::SUCCESS) {
+    DirectX::ScratchImage outputDDS;
+    HRESULT hr = outputDDS.Initialize(outputMeta);
+    if (FAILED(hr)) {
+        Logger::debug(L"Unable to allocate HDR texture: {}", asciitoUTF16(getHRESULTErrorMessage(hr)));
         return;
     }
 
-    // Create output texture
-    D3D11_TEXTURE2D_DESC outputDDSDesc = {};
-    inputDDSGPU->GetDesc(&outputDDSDesc);
-    outputDDSDesc.Format = outputFormat;
-    outputDDSDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+    // The source is expanded to RGBA32F one strip of rows at a time (sRGB is linearized here), so only one strip is
+    // held as float instead of the whole mip chain. Strips are a multiple of the 4 row block size
+    static constexpr size_t STRIP_ROWS = 64;
+    static constexpr size_t BLOCK_ROWS = 4;
+    const bool isCompressed = DirectX::IsCompressed(inputMeta.format);
+    const bool needsExpand = isCompressed || inputMeta.format != DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+    DirectX::ScratchImage stripDDS;
+    const DirectX::Image* srcImages = dds->GetImages();
+    const DirectX::Image* dstImages = outputDDS.GetImages();
+    for (size_t i = 0; i < outputDDS.GetImageCount(); i++) {
+        const auto& srcImage = srcImages[i];
+        const auto& dstImage = dstImages[i];
+
+        for (size_t y = 0; y < srcImage.height; y += STRIP_ROWS) {
+            const size_t numRows = min(STRIP_ROWS, srcImage.height - y);
+
+            // a row of the source image is a row of blocks for compressed formats
+            const size_t firstPitchRow = isCompressed ? y / BLOCK_ROWS : y;
+            const size_t numPitchRows = isCompressed ? (numRows + BLOCK_ROWS - 1) / BLOCK_ROWS : numRows;
+            const uint8_t* srcPixels = srcImage.pixels + (firstPitchRow * srcImage.rowPitch);
+            size_t srcRowPitch = srcImage.rowPitch;
+
+            if (needsExpand) {
+                const DirectX::Image strip = { .width = srcImage.width,
+                    .height = numRows,
+                    .format = srcImage.format,
+                    .rowPitch = srcImage.rowPitch,
+                    .slicePitch = numPitchRows * srcImage.rowPitch,
+                    .pixels = const_cast<uint8_t*>(srcPixels) }; // NOLINT(cppcoreguidelines-pro-type-const-cast)
+
+                hr = isCompressed ? DirectX::Decompress(strip, DXGI_FORMAT_R32G32B32A32_FLOAT, stripDDS)
+                                  : DirectX::Convert(strip, DXGI_FORMAT_R32G32B32A32_FLOAT, DirectX::TEX_FILTER_DEFAULT,
+                                        DirectX::TEX_THRESHOLD_DEFAULT, stripDDS);
+                if (FAILED(hr)) {
+                    Logger::debug(
+                        L"Unable to expand texture for HDR conversion: {}", asciitoUTF16(getHRESULTErrorMessage(hr)));
+                    return;
+                }
 
-    ComPtr<ID3D11Texture2D> outputDDSGPU;
-    if (createTexture2D(outputDDSDesc, outputDDSGPU) != ParallaxGenTask::PGResult::SUCCESS) {
-        return;
-    }
+                srcPixels = stripDDS.GetImages()->pixels;
+                srcRowPitch = stripDDS.GetImages()->rowPitch;
+            }
 
-    ComPtr<ID3D11UnorderedAccessView> outputDDSUAV;
-    if (createUnorderedAccessView(outputDDSGPU, outputDDSUAV) != ParallaxGenTask::PGResult::SUCCESS) {
-        return;
+            for (size_t row = 0; row < numRows; row++) {
+                const auto* srcRow = reinterpret_cast<const float*>(srcPixels + (row * srcRowPitch));
+                auto* dstRow = dstImage.pixels + ((y + row) * dstImage.rowPitch);
+                convertScanlineToHDR(srcRow, dstRow, srcImage.width, luminanceMult, outputFormat);
+            }
+        }
     }
 
-    // Dispatch shader
-    m_ptrContext->CSSetShader(m_shaderConvertToHDR.Get(), nullptr, 0);
-    m_ptrContext->CSSetConstantBuffers(0, 1, constantBuffer.GetAddressOf());
-    m_ptrContext->CSSetShaderResources(0, 1, inputDDSSRV.GetAddressOf());
-    m_ptrContext->CSSetUnorderedAccessViews(0, 1, outputDDSUAV.GetAddressOf(), nullptr);
-
-    if (blockingDispatch(static_cast<UINT>(inputMeta.width), static_cast<UINT>(inputMeta.height), 1)
-        != ParallaxGenTask::PGResult::SUCCESS) {
-        return;
-    }
+    *dds = std::move(outputDDS);
+    ddsModified = true;
+}
 
-    // Clean up shader resources
-    array<ID3D11Buffer*, 1> nullBuffer = { nullptr };
-    m_ptrContext->CSSetConstantBuffers(0, 1, nullBuffer.data());
-    array<ID3D11ShaderResourceView*, 1> nullSRV = { nullptr };
-    m_ptrContext->CSSetShaderResources(0, 1, nullSRV.data());
-    array<ID3D11UnorderedAccessView*, 1> nullUAV = { nullptr };
-    m_ptrContext->CSSetUnorderedAccessViews(0, 1, nullUAV.data(), nullptr);
-    m_ptrContext->CSSetShader(nullptr, nullptr, 0);
+//
+// GPU Helpers
+//
+auto ParallaxGenD3D::isPowerOfTwo(unsigned int x) -> bool { return (x != 0U) && ((x & (x - 1)) == 0U); }
 
-    // Release some objects
-    inputDDSGPU.Reset();
-    inputDDSSRV.Reset();
-    constantBuffer.Reset();
+auto ParallaxGenD3D::createPooledTexture(const ParallaxGenGPUResourceKey& key, GPUTexture& dest) const -> bool
+{
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = key.width;
+    desc.Height = key.height;
+    desc.MipLevels = key.mipLevels;
+    desc.ArraySize = 1;
+    desc.Format = static_cast<DXGI_FORMAT>(key.format);
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Usage = static_cast<D3D11_USAGE>(key.usage);
+    desc.BindFlags = key.bindFlags;
+    desc.CPUAccessFlags = key.usage == D3D11_USAGE_STAGING ? D3D11_CPU_ACCESS_READ : 0;
+    desc.MiscFlags = key.miscFlags;
+
+    if (createTexture2D(desc, dest.texture) != ParallaxGenTask::PGResult::SUCCESS) {
+        return false;
+    }
 
-    // Generate mips
-    D3D11_TEXTURE2D_DESC outputDDSMipsDesc = {};
-    outputDDSGPU->GetDesc(&outputDDSMipsDesc);
-    outputDDSMipsDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
-    outputDDSMipsDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
-    ComPtr<ID3D11Texture2D> outputDDSMipsGPU;
-    if (createTexture2D(outputDDSMipsDesc, outputDDSMipsGPU) != ParallaxGenTask::PGResult::SUCCESS) {
-        return;
+    if ((key.bindFlags & D3D11_BIND_SHADER_RESOURCE) != 0U
+        && createShaderResourceView(dest.texture, dest.srv) != ParallaxGenTask::PGResult::SUCCESS) {
+        return false;
     }
 
-    ComPtr<ID3D11ShaderResourceView> outputMipsSRV;
-    if (createShaderResourceView(outputDDSMipsGPU, outputMipsSRV) != ParallaxGenTask::PGResult::SUCCESS) {
-        return;
+    if ((key.bindFlags & D3D11_BIND_UNORDERED_ACCESS) != 0U
+        && createUnorderedAccessView(dest.texture, dest.uav) != ParallaxGenTask::PGResult::SUCCESS) {
+        return false;
     }
 
-    // Copy texture
-    m_ptrContext->CopyResource(outputDDSMipsGPU.Get(), outputDDSGPU.Get());
-    m_ptrContext->GenerateMips(outputMipsSRV.Get());
-    m_ptrContext->CopyResource(outputDDSGPU.Get(), outputDDSMipsGPU.Get());
+    return true;
+}
 
-    // cleanup
-    outputDDSMipsGPU.Reset();
-    outputMipsSRV.Reset();
+auto ParallaxGenD3D::createPooledBuffer(const ParallaxGenGPUResourceKey& key, GPUBuffer& dest) const -> bool
+{
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth = key.width;
+    desc.Usage = static_cast<D3D11_USAGE>(key.usage);
+    desc.BindFlags = key.bindFlags;
+    desc.MiscFlags = key.miscFlags;
+    if (key.usage == D3D11_USAGE_STAGING) {
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    } else if (key.usage == D3D11_USAGE_DYNAMIC) {
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    }
+    if ((key.miscFlags & D3D11_RESOURCE_MISC_BUFFER_STRUCTURED) != 0U) {
+        desc.StructureByteStride = key.height;
+    }
 
-    // Read back texture
-    auto outputTextureData = readBack(outputDDSGPU);
+    const HRESULT hr = m_ptrDevice->CreateBuffer(&desc, nullptr, dest.buffer.ReleaseAndGetAddressOf());
+    if (FAILED(hr)) {
+        spdlog::debug("Failed to create ID3D11Buffer on GPU: {}", getHRESULTErrorMessage(hr));
+        return false;
+    }
 
-    // More cleaning
-    outputDDSGPU.Reset();
-    outputDDSUAV.Reset();
+    if ((key.bindFlags & D3D11_BIND_UNORDERED_ACCESS) != 0U) {
+        D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+        uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+        uavDesc.Buffer.FirstElement = 0;
+        uavDesc.Buffer.NumElements = key.height != 0 ? key.width / key.height : 0;
 
-    // Flush GPU to avoid leaks
-    m_ptrContext->Flush();
+        if (createUnorderedAccessView(dest.buffer, uavDesc, dest.uav) != ParallaxGenTask::PGResult::SUCCESS) {
+            return false;
+        }
+    }
 
-    // Import into directx scratchimage
-    *dds = loadRawPixelsToScratchImage(
-        outputTextureData, inputMeta.width, inputMeta.height, inputMeta.mipLevels, outputFormat);
-    ddsModified = true;
+    return true;
 }
 
-//
-// GPU Helpers
-//
-auto ParallaxGenD3D::isPowerOfTwo(unsigned int x) -> bool { return (x != 0U) && ((x & (x - 1)) == 0U); }
-
-auto ParallaxGenD3D::createTexture2D(const DirectX::ScratchImage& texture, ComPtr<ID3D11Texture2D>& dest) const
-    -> ParallaxGenTask::PGResult
+auto ParallaxGenD3D::acquireTexture2D(const DirectX::ScratchImage& texture, ParallaxGenGPUResourceKey& key,
+    GPUTexture& dest) -> ParallaxGenTask::PGResult
 {
-    // Define error object
-    HRESULT hr {};
-
     // Verify dimention
-    auto textureMeta = texture.GetMetadata();
+    const auto& textureMeta = texture.GetMetadata();
     if (!isPowerOfTwo(static_cast<unsigned int>(textureMeta.width))
         || !isPowerOfTwo(static_cast<unsigned int>(textureMeta.height))) {
         spdlog::debug("Texture dimensions must be a power of 2: {}x{}", textureMeta.width, textureMeta.height);
         return ParallaxGenTask::PGResult::FAILURE;
     }
 
-    // Create texture
-    hr = DirectX::CreateTexture(m_ptrDevice.Get(), texture.GetImages(), texture.GetImageCount(), texture.GetMetadata(),
-        reinterpret_cast<ID3D11Resource**>(dest.ReleaseAndGetAddressOf()));
-    if (FAILED(hr)) {
-        // Log on failure
-        spdlog::debug("Failed to create ID3D11Texture2D on GPU: {}", getHRESULTErrorMessage(hr));
+    if (textureMeta.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || textureMeta.arraySize != 1
+        || textureMeta.IsCubemap()) {
+        spdlog::debug("Only single 2D textures can be uploaded to the GPU");
+        return ParallaxGenTask::PGResult::FAILURE;
+    }
+
+    key = { .width = static_cast<uint32_t>(textureMeta.width),
+        .height = static_cast<uint32_t>(textureMeta.height),
+        .mipLevels = static_cast<uint32_t>(textureMeta.mipLevels),
+        .format = static_cast<uint32_t>(textureMeta.format),
+        .bindFlags = D3D11_BIND_SHADER_RESOURCE,
+        .usage = D3D11_USAGE_DEFAULT };
+
+    if (!m_texturePool.acquire(key, dest)) {
+        spdlog::debug("Failed to create ID3D11Texture2D on GPU");
+        return ParallaxGenTask::PGResult::FAILURE;
+    }
+
+    // Upload every mip
+    for (size_t mip = 0; mip < textureMeta.mipLevels; mip++) {
+        const auto* image = texture.GetImage(mip, 0, 0);
+        m_ptrContext->UpdateSubresource(dest.texture.Get(), static_cast<UINT>(mip), nullptr, image->pixels,
+            static_cast<UINT>(image->rowPitch), static_cast<UINT>(image->slicePitch));
     }
 
     return ParallaxGenTask::PGResult::SUCCESS;
 }
 
-auto ParallaxGenD3D::createTexture2D(ComPtr<ID3D11Texture2D>& existingTexture, ComPtr<ID3D11Texture2D>& dest) const
-    -> ParallaxGenTask::PGResult
+auto ParallaxGenD3D::acquireStructuredBuffer(const void* data, const UINT& size, const UINT& stride,
+    ParallaxGenGPUResourceKey& key, GPUBuffer& dest) -> ParallaxGenTask::PGResult
 {
-    // Smart Pointer to hold texture for output
-    D3D11_TEXTURE2D_DESC textureOutDesc;
-    existingTexture->GetDesc(&textureOutDesc);
+    key = { .width = ParallaxGenGPUResourceKey::getBufferBucket(size),
+        .height = stride,
+        .bindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE,
+        .miscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED,
+        .usage = D3D11_USAGE_DEFAULT };
 
-    HRESULT hr {};
+    if (!m_bufferPool.acquire(key, dest)) {
+        return ParallaxGenTask::PGResult::FAILURE;
+    }
 
-    // Create texture
-    hr = m_ptrDevice->CreateTexture2D(&textureOutDesc, nullptr, dest.ReleaseAndGetAddressOf());
+    // Only the requested bytes are written, the shaders do not read past them
+    const D3D11_BOX box = { .left = 0, .top = 0, .front = 0, .right = size, .bottom = 1, .back = 1 };
+    m_ptrContext->UpdateSubresource(dest.buffer.Get(), 0, &box, data, 0, 0);
+
+    return ParallaxGenTask::PGResult::SUCCESS;
+}
+
+auto ParallaxGenD3D::acquireConstantBuffer(const void* data, const UINT& size, ParallaxGenGPUResourceKey& key,
+    GPUBuffer& dest) -> ParallaxGenTask::PGResult
+{
+    key = { .width = (size + GPU_BUFFER_SIZE_MULTIPLE) - (size % GPU_BUFFER_SIZE_MULTIPLE),
+        .bindFlags = D3D11_BIND_CONSTANT_BUFFER,
+        .usage = D3D11_USAGE_DYNAMIC };
+
+    if (!m_bufferPool.acquire(key, dest)) {
+        return ParallaxGenTask::PGResult::FAILURE;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    const HRESULT hr = m_ptrContext->Map(dest.buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
     if (FAILED(hr)) {
-        // Log on failure
-        spdlog::debug("Failed to create ID3D11Texture2D on GPU: {}", getHRESULTErrorMessage(hr));
+        spdlog::debug("Failed to map constant buffer: {}", getHRESULTErrorMessage(hr));
+        m_bufferPool.release(key, std::move(dest));
         return ParallaxGenTask::PGResult::FAILURE;
     }
 
-    // Create texture from description
+    memcpy(mappedResource.pData, data, size);
+    m_ptrContext->Unmap(dest.buffer.Get(), 0);
+
     return ParallaxGenTask::PGResult::SUCCESS;
 }
 
@@ -959,108 +1165,96 @@ auto ParallaxGenD3D::createUnorderedAccessView(const ComPtr<ID3D11Resource>& gpu
     return ParallaxGenTask::PGResult::SUCCESS;
 }
 
-auto ParallaxGenD3D::createBuffer(const void* data, D3D11_BUFFER_DESC& desc, ComPtr<ID3D11Buffer>& dest) const
-    -> ParallaxGenTask::PGResult
+void ParallaxGenD3D::dispatch(UINT threadGroupCountX, UINT threadGroupCountY, UINT threadGroupCountZ) const
 {
-    D3D11_SUBRESOURCE_DATA initData = {};
-    initData.pSysMem = data;
-
-    const HRESULT hr = m_ptrDevice->CreateBuffer(&desc, &initData, dest.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) {
-        spdlog::debug("Failed to create ID3D11Buffer on GPU: {}", getHRESULTErrorMessage(hr));
-        return ParallaxGenTask::PGResult::FAILURE;
-    }
-
-    return ParallaxGenTask::PGResult::SUCCESS;
+    m_ptrContext->Dispatch((threadGroupCountX + NUM_GPU_THREADS - 1) / NUM_GPU_THREADS,
+        (threadGroupCountY + NUM_GPU_THREADS - 1) / NUM_GPU_THREADS,
+        (threadGroupCountZ + NUM_GPU_THREADS - 1) / NUM_GPU_THREADS);
 }
 
-auto ParallaxGenD3D::createConstantBuffer(const void* data, const UINT& size, ComPtr<ID3D11Buffer>& dest) const
-    -> ParallaxGenTask::PGResult
+//
+// Fences
+//
+
+auto ParallaxGenD3D::signalFence() -> FenceValue
 {
-    // Define error object
-    HRESULT hr {};
+    const lock_guard<recursive_mutex> lock(m_gpuOperationMutex);
 
-    // Create buffer
-    D3D11_BUFFER_DESC cbDesc = {};
-    cbDesc.Usage = D3D11_USAGE_DYNAMIC;
-    cbDesc.ByteWidth = (size + GPU_BUFFER_SIZE_MULTIPLE) - (size % GPU_BUFFER_SIZE_MULTIPLE);
-    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    cbDesc.MiscFlags = 0;
-    cbDesc.StructureByteStride = 0;
-
-    // Create init data
-    D3D11_SUBRESOURCE_DATA cbInitData;
-    cbInitData.pSysMem = data;
-    cbInitData.SysMemPitch = 0;
-    cbInitData.SysMemSlicePitch = 0;
-
-    // Create buffer
-    hr = m_ptrDevice->CreateBuffer(&cbDesc, &cbInitData, dest.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) {
-        // Log on failure
-        spdlog::debug("Failed to create ID3D11Buffer on GPU: {}", getHRESULTErrorMessage(hr));
-        return ParallaxGenTask::PGResult::FAILURE;
+    ComPtr<ID3D11Query> query;
+    if (!m_freeFenceQueries.empty()) {
+        query = std::move(m_freeFenceQueries.back());
+        m_freeFenceQueries.pop_back();
+    } else {
+        D3D11_QUERY_DESC queryDesc = {};
+        queryDesc.Query = D3D11_QUERY_EVENT;
+        const HRESULT hr = m_ptrDevice->CreateQuery(&queryDesc, query.ReleaseAndGetAddressOf());
+        if (FAILED(hr)) {
+            throw runtime_error("Failed to create query: " + getHRESULTErrorMessage(hr));
+        }
     }
 
-    return ParallaxGenTask::PGResult::SUCCESS;
+    // event query is signaled once all previously submitted commands have completed
+    m_ptrContext->End(query.Get());
+    m_pendingFences.emplace_back(++m_lastSignaledFence, std::move(query));
+
+    return m_lastSignaledFence;
 }
 
-auto ParallaxGenD3D::blockingDispatch(UINT threadGroupCountX, UINT threadGroupCountY, UINT threadGroupCountZ) const
-    -> ParallaxGenTask::PGResult
+auto ParallaxGenD3D::getCompletedFence() -> FenceValue
 {
-    // Error object
-    HRESULT hr {};
+    const lock_guard<recursive_mutex> lock(m_gpuOperationMutex);
 
-    // query
-    ComPtr<ID3D11Query> ptrQuery = nullptr;
-    D3D11_QUERY_DESC queryDesc = {};
-    queryDesc.Query = D3D11_QUERY_EVENT;
-    hr = m_ptrDevice->CreateQuery(&queryDesc, ptrQuery.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) {
-        spdlog::debug("Failed to create query: {}", getHRESULTErrorMessage(hr));
-        return ParallaxGenTask::PGResult::FAILURE;
+    while (!m_pendingFences.empty()) {
+        auto& [fence, query] = m_pendingFences.front();
+
+        BOOL queryData = FALSE;
+        const HRESULT hr = m_ptrContext->GetData(query.Get(), &queryData, sizeof(queryData), 0);
+        if (hr == S_FALSE) {
+            // not done yet, later fences can't be done either
+            break;
+        }
+
+        if (FAILED(hr)) {
+            // don't wait forever on a broken query
+            spdlog::debug("Failed to get query data: {}", getHRESULTErrorMessage(hr));
+        }
+
+        m_lastCompletedFence = fence;
+        m_freeFenceQueries.push_back(std::move(query));
+        m_pendingFences.pop_front();
     }
 
-    // Run the shader
-    m_ptrContext->Dispatch((threadGroupCountX + NUM_GPU_THREADS - 1) / NUM_GPU_THREADS,
-        (threadGroupCountY + NUM_GPU_THREADS - 1) / NUM_GPU_THREADS,
-        (threadGroupCountZ + NUM_GPU_THREADS - 1) / NUM_GPU_THREADS);
+    return m_lastCompletedFence;
+}
 
-    // end query
-    m_ptrContext->End(ptrQuery.Get());
+void ParallaxGenD3D::waitForFence(FenceValue fence)
+{
+    const ParallaxGenTrace::Span traceSpan("waitForFence");
 
-    // wait for shader to complete
-    BOOL queryData = FALSE;
-    hr = m_ptrContext->GetData(ptrQuery.Get(), &queryData, sizeof(queryData),
-        D3D11_ASYNC_GETDATA_DONOTFLUSH); // block until complete
-    if (FAILED(hr)) {
-        spdlog::debug("Failed to get query data: {}", getHRESULTErrorMessage(hr));
-        return ParallaxGenTask::PGResult::FAILURE;
+    {
+        const lock_guard<recursive_mutex> lock(m_gpuOperationMutex);
+        m_ptrContext->Flush();
     }
-    ptrQuery.Reset();
 
-    // return success
-    return ParallaxGenTask::PGResult::SUCCESS;
+    while (getCompletedFence() < fence) {
+        this_thread::yield();
+    }
 }
 
-auto ParallaxGenD3D::readBack(const ComPtr<ID3D11Texture2D>& gpuResource) const -> vector<unsigned char>
+auto ParallaxGenD3D::readBack(const ComPtr<ID3D11Texture2D>& gpuResource) -> vector<unsigned char>
 {
+    const ParallaxGenTrace::Span traceSpan("readBack");
+
+    const lock_guard<recursive_mutex> lock(m_gpuOperationMutex);
+
     // Error object
     HRESULT hr {};
-    ParallaxGenTask::PGResult pgResult {};
 
     // Grab texture description
     D3D11_TEXTURE2D_DESC stagingTex2DDesc;
     gpuResource->GetDesc(&stagingTex2DDesc);
     const UINT mipLevels = stagingTex2DDesc.MipLevels; // Number of mip levels to read back
 
-    // Enable flags for CPU access
-    stagingTex2DDesc.Usage = D3D11_USAGE_STAGING;
-    stagingTex2DDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-    stagingTex2DDesc.BindFlags = 0;
-    stagingTex2DDesc.MiscFlags = 0;
-
     // Find bytes per pixel based on format
     UINT bytesPerChannel = 1; // Default to 8-bit
     UINT numChannels = 4; // Default to RGBA
@@ -1152,13 +1346,18 @@ auto ParallaxGenD3D::readBack(const ComPtr<ID3D11Texture2D>& gpuResource) const
     }
     const UINT bytesPerPixel = bytesPerChannel * numChannels;
 
-    // Create staging texture
-    ComPtr<ID3D11Texture2D> stagingTex2D;
-    pgResult = createTexture2D(stagingTex2DDesc, stagingTex2D);
-    if (pgResult != ParallaxGenTask::PGResult::SUCCESS) {
-        spdlog::debug("Failed to create staging texture: {}", getHRESULTErrorMessage(hr));
+    // Get pooled staging texture
+    const ParallaxGenGPUResourceKey stagingKey = { .width = stagingTex2DDesc.Width,
+        .height = stagingTex2DDesc.Height,
+        .mipLevels = mipLevels,
+        .format = static_cast<uint32_t>(stagingTex2DDesc.Format),
+        .usage = D3D11_USAGE_STAGING };
+    GPUTexture staging;
+    if (!m_texturePool.acquire(stagingKey, staging)) {
+        spdlog::debug("Failed to create staging texture");
         return {};
     }
+    const ComPtr<ID3D11Texture2D>& stagingTex2D = staging.texture;
 
     // Copy resource to staging texture
     m_ptrContext->CopyResource(stagingTex2D.Get(), gpuResource.Get());
@@ -1177,6 +1376,7 @@ auto ParallaxGenD3D::readBack(const ComPtr<ID3D11Texture2D>& gpuResource) const
         if (FAILED(hr)) {
             spdlog::debug("[GPU] Failed to map resource to CPU during read back at mip level {}: {}", mipLevel,
                 getHRESULTErrorMessage(hr));
+            m_texturePool.release(stagingKey, std::move(staging));
             return {};
         }
 
@@ -1191,54 +1391,7 @@ auto ParallaxGenD3D::readBack(const ComPtr<ID3D11Texture2D>& gpuResource) const
         m_ptrContext->Unmap(stagingTex2D.Get(), mipLevel);
     }
 
-    stagingTex2D.Reset();
-
-    return outputData;
-}
-
-template <typename T> auto ParallaxGenD3D::readBack(const ComPtr<ID3D11Buffer>& gpuResource) const -> vector<T>
-{
-    // Error object
-    HRESULT hr {};
-
-    // grab edge detection results
-    D3D11_BUFFER_DESC bufferDesc;
-    gpuResource->GetDesc(&bufferDesc);
-    // Enable flags for CPU access
-    bufferDesc.Usage = D3D11_USAGE_STAGING;
-    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-    bufferDesc.BindFlags = 0;
-    bufferDesc.MiscFlags = 0;
-    bufferDesc.StructureByteStride = 0;
-
-    // Create the staging buffer
-    ComPtr<ID3D11Buffer> stagingBuffer;
-    hr = m_ptrDevice->CreateBuffer(&bufferDesc, nullptr, stagingBuffer.ReleaseAndGetAddressOf());
-    if (FAILED(hr)) {
-        spdlog::debug("[GPU] Failed to create staging buffer: {}", getHRESULTErrorMessage(hr));
-        return std::vector<T>();
-    }
-
-    // copy resource
-    m_ptrContext->CopyResource(stagingBuffer.Get(), gpuResource.Get());
-
-    // map resource to CPU
-    D3D11_MAPPED_SUBRESOURCE mappedResource;
-    hr = m_ptrContext->Map(stagingBuffer.Get(), 0, D3D11_MAP_READ, 0, &mappedResource);
-    if (FAILED(hr)) {
-        spdlog::debug("[GPU] Failed to map resource to CPU during read back: {}", getHRESULTErrorMessage(hr));
-        return vector<T>();
-    }
-
-    // Access the texture data from MappedResource.pData
-    const size_t numElements = bufferDesc.ByteWidth / sizeof(T);
-    std::vector<T> outputData(
-        reinterpret_cast<T*>(mappedResource.pData), reinterpret_cast<T*>(mappedResource.pData) + numElements);
-
-    // Cleaup
-    m_ptrContext->Unmap(stagingBuffer.Get(), 0); // cleanup map
-
-    stagingBuffer.Reset();
+    m_texturePool.release(stagingKey, std::move(staging));
 
     return outputData;
 }
@@ -1250,6 +1403,8 @@ template <typename T> auto ParallaxGenD3D::readBack(const ComPtr<ID3D11Buffer>&
 auto ParallaxGenD3D::getDDS(const filesystem::path& ddsPath, DirectX::ScratchImage& dds) const
     -> ParallaxGenTask::PGResult
 {
+    const ParallaxGenTrace::Span traceSpan("getDDS", ddsPath);
+
     HRESULT hr {};
 
     if (m_pgd->isLooseFile(ddsPath)) {
@@ -1284,16 +1439,41 @@ auto ParallaxGenD3D::getDDS(const filesystem::path& ddsPath, DirectX::ScratchIma
 auto ParallaxGenD3D::getDDSMetadata(const filesystem::path& ddsPath, DirectX::TexMetadata& ddsMeta)
     -> ParallaxGenTask::PGResult
 {
-    // Use lock_guard to make this method thread-safe
-    const lock_guard<mutex> lock(m_ddsMetaDataMutex);
+    const ParallaxGenTrace::Span traceSpan("getDDSMetadata", ddsPath);
+
+    // Header index is immutable once ready, so no lock is needed
+    if (m_ddsHeaderIndexReady.load(memory_order_acquire)) {
+        const auto it = m_ddsHeaderIndex.find(toLowerASCII(ddsPath.wstring()));
+        if (it != m_ddsHeaderIndex.end()) {
+            ddsMeta = it->second;
+            return ParallaxGenTask::PGResult::SUCCESS;
+        }
+    }
 
     // Check if in cache
     // TODO set cache to something on failure
-    if (m_ddsMetaDataCache.find(ddsPath) != m_ddsMetaDataCache.end()) {
-        ddsMeta = m_ddsMetaDataCache[ddsPath];
-        return ParallaxGenTask::PGResult::SUCCESS;
+    {
+        const lock_guard<mutex> lock(m_ddsMetaDataMutex);
+        const auto it = m_ddsMetaDataCache.find(ddsPath);
+        if (it != m_ddsMetaDataCache.end()) {
+            ddsMeta = it->second;
+            return ParallaxGenTask::PGResult::SUCCESS;
+        }
     }
 
+    // Check the persistent texture cache
+    BethesdaDirectory::FileFingerprint fingerprint;
+    if (m_textureCache != nullptr) {
+        fingerprint = m_pgd->getFileFingerprint(ddsPath);
+        ParallaxGenTextureCache::Entry cacheEntry;
+        if (!fingerprint.source.empty() && m_textureCache->lookup(ddsPath, fingerprint, cacheEntry)
+            && cacheEntry.hasMetadata) {
+            ddsMeta = cacheEntry.metadata;
+            return ParallaxGenTask::PGResult::SUCCESS;
+        }
+    }
+
+    // Read outside of the lock so other lookups are not blocked by I/O
     HRESULT hr {};
 
     if (m_pgd->isLooseFile(ddsPath)) {
@@ -1323,6 +1503,11 @@ auto ParallaxGenD3D::getDDSMetadata(const filesystem::path& ddsPath, DirectX::Te
     }
 
     // update cache
+    if (m_textureCache != nullptr && !fingerprint.source.empty()) {
+        m_textureCache->updateMetadata(ddsPath, fingerprint, ddsMeta);
+    }
+
+    const lock_guard<mutex> lock(m_ddsMetaDataMutex);
     m_ddsMetaDataCache[ddsPath] = ddsMeta;
 
     return ParallaxGenTask::PGResult::SUCCESS;
@@ -1373,4 +1558,83 @@ auto ParallaxGenD3D::getDXGIFormatFromString(const string& format) -> DXGI_FORMA
     return DXGI_FORMAT_UNKNOWN;
 }
 
+//
+// CPU Helpers
+//
+
+void ParallaxGenD3D::convertScanlineToHDR(const float* src, uint8_t* dst, const size_t& numPixels,
+    const float& luminanceMult, const DXGI_FORMAT& outputFormat)
+{
+    static const bool hasF16C = cpuSupportsF16C();
+
+    if (outputFormat == DXGI_FORMAT_R16G16B16A16_FLOAT) {
+        auto* dstHalf = reinterpret_cast<uint16_t*>(dst);
+
+        size_t pixel = 0;
+        if (hasF16C) {
+            pixel = convertScanlineToHalfF16C(src, dstHalf, numPixels, luminanceMult);
+        }
+
+        // Scalar path for the remainder or CPUs without F16C
+        for (; pixel < numPixels; pixel++) {
+            const size_t offset = pixel * 4;
+            dstHalf[offset] = DirectX::PackedVector::XMConvertFloatToHalf(src[offset] * luminanceMult);
+            dstHalf[offset + 1] = DirectX::PackedVector::XMConvertFloatToHalf(src[offset + 1] * luminanceMult);
+            dstHalf[offset + 2] = DirectX::PackedVector::XMConvertFloatToHalf(src[offset + 2] * luminanceMult);
+            dstHalf[offset + 3] = DirectX::PackedVector::XMConvertFloatToHalf(src[offset + 3]);
+        }
+
+        return;
+    }
+
+    // DXGI_FORMAT_R32G32B32A32_FLOAT
+    auto* dstFloat = reinterpret_cast<float*>(dst);
+    for (size_t pixel = 0; pixel < numPixels; pixel++) {
+        const size_t offset = pixel * 4;
+        dstFloat[offset] = src[offset] * luminanceMult;
+        dstFloat[offset + 1] = src[offset + 1] * luminanceMult;
+        dstFloat[offset + 2] = src[offset + 2] * luminanceMult;
+        dstFloat[offset + 3] = src[offset + 3];
+    }
+}
+
+auto ParallaxGenD3D::convertScanlineToHalfF16C(
+    const float* src, uint16_t* dst, const size_t& numPixels, const float& luminanceMult) -> size_t
+{
+    // two RGBA pixels per 256 bit register, alpha lanes are multiplied by 1
+    const __m256 mult = _mm256_setr_ps(
+        luminanceMult, luminanceMult, luminanceMult, 1.0F, luminanceMult, luminanceMult, luminanceMult, 1.0F);
+
+    size_t pixel = 0;
+    for (; pixel + 2 <= numPixels; pixel += 2) {
+        const __m256 pixels = _mm256_mul_ps(_mm256_loadu_ps(src + (pixel * 4)), mult);
+        const __m128i halfPixels = _mm256_cvtps_ph(pixels, _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (pixel * 4)), halfPixels);
+    }
+
+    return pixel;
+}
+
+auto ParallaxGenD3D::cpuSupportsF16C() -> bool
+{
+    constexpr int CPUID_OSXSAVE_BIT = 27;
+    constexpr int CPUID_AVX_BIT = 28;
+    constexpr int CPUID_F16C_BIT = 29;
+    constexpr unsigned long long XCR0_AVX_STATE = 0x6;
+
+    array<int, 4> cpuInfo {};
+    __cpuid(cpuInfo.data(), 1);
+
+    const auto ecx = static_cast<unsigned int>(cpuInfo[2]);
+    const bool hasOSXSave = ((ecx >> CPUID_OSXSAVE_BIT) & 1U) != 0;
+    const bool hasAVX = ((ecx >> CPUID_AVX_BIT) & 1U) != 0;
+    const bool hasF16C = ((ecx >> CPUID_F16C_BIT) & 1U) != 0;
+    if (!hasOSXSave || !hasAVX || !hasF16C) {
+        return false;
+    }
+
+    // OS must save the YMM registers on context switch
+    return (_xgetbv(0) & XCR0_AVX_STATE) == XCR0_AVX_STATE;
+}
+
 // NOLINTEND(cppcoreguidelines-pro-type-union-access,cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
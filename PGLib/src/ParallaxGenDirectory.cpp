@@ -129,8 +129,12 @@ auto ParallaxGenDirectory::mapFiles(const vector<wstring>& nifBlocklist, const v
             continue;
         }
 
+        const auto meshSize = getFileSize(mesh);
         runner.addTask(
-            [this, &taskTracker, &mesh, &cacheNIFs] { taskTracker.completeJob(mapTexturesFromNIF(mesh, cacheNIFs)); });
+            [this, &taskTracker, &mesh, &cacheNIFs, meshSize] {
+                taskTracker.completeJob(mapTexturesFromNIF(mesh, cacheNIFs), meshSize);
+            },
+            meshSize);
     }
 
     // Blocks until all tasks are done
@@ -471,6 +475,13 @@ auto ParallaxGenDirectory::getTextureMapConst(const NIFUtil::TextureSlots& slot)
     return m_textureMaps.at(static_cast<size_t>(slot));
 }
 
+auto ParallaxGenDirectory::getTextureMapCopy(const NIFUtil::TextureSlots& slot)
+    -> map<wstring, unordered_set<NIFUtil::PGTexture, NIFUtil::PGTextureHasher>>
+{
+    const lock_guard<mutex> lock(m_textureMapsMutex);
+    return m_textureMaps.at(static_cast<size_t>(slot));
+}
+
 auto ParallaxGenDirectory::getMeshes() const -> const unordered_set<filesystem::path>& { return m_meshes; }
 
 auto ParallaxGenDirectory::getTextures() const -> const unordered_set<filesystem::path>& { return m_textures; }
@@ -546,6 +557,17 @@ void ParallaxGenDirectory::setTextureType(const filesystem::path& path, const NI
     m_textureTypes[path].type = type;
 }
 
+void ParallaxGenDirectory::addGeneratedTexture(
+    const filesystem::path& path, const NIFUtil::TextureSlots& slot, const NIFUtil::TextureType& type)
+{
+    {
+        const lock_guard<mutex> lock(m_textureMapsMutex);
+        m_textureMaps.at(static_cast<size_t>(slot))[NIFUtil::getTexBase(path)].insert({ .path = path, .type = type });
+    }
+
+    setTextureType(path, type);
+}
+
 auto ParallaxGenDirectory::getTextureType(const filesystem::path& path) -> NIFUtil::TextureType
 {
     const lock_guard<mutex> lock(m_textureTypesMutex);
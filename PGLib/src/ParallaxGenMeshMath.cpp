@@ -0,0 +1,476 @@
+#include "ParallaxGenMeshMath.hpp"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-avoid-magic-numbers)
+namespace {
+
+constexpr size_t UV_STRIDE = 2;
+constexpr size_t VERT_STRIDE = 3;
+constexpr size_t TRI_STRIDE = 3;
+constexpr size_t LANES = 4;
+constexpr float AUTO_UV_MULT = 10.0F / 4.0F;
+constexpr float DEG_TO_RAD = 3.14159265358979323846F / 180.0F;
+
+auto finishUVScale(float sumU, float sumV, const size_t& numTris) -> ParallaxGenMeshMath::UVScale
+{
+    sumU *= AUTO_UV_MULT;
+    sumV *= AUTO_UV_MULT;
+    sumU /= static_cast<float>(numTris);
+    sumV /= static_cast<float>(numTris);
+
+    const float scale = min(sumU, sumV);
+    return { .u = scale, .v = scale };
+}
+
+auto edgeLength(const float* a, const float* b) -> float
+{
+    const float x = b[0] - a[0];
+    const float y = b[1] - a[1];
+    const float z = b[2] - a[2];
+    return sqrt((x * x) + (y * y) + (z * z));
+}
+
+void addTriangleTerms(
+    const float* uvs, const float* verts, const uint16_t* tris, const size_t& tri, float& sumU, float& sumV)
+{
+    const uint16_t p1 = tris[tri * TRI_STRIDE];
+    const uint16_t p2 = tris[(tri * TRI_STRIDE) + 1];
+    const uint16_t p3 = tris[(tri * TRI_STRIDE) + 2];
+
+    const float posLength = edgeLength(verts + (p1 * VERT_STRIDE), verts + (p2 * VERT_STRIDE))
+        + edgeLength(verts + (p1 * VERT_STRIDE), verts + (p3 * VERT_STRIDE));
+    const float du = abs(uvs[p2 * UV_STRIDE] - uvs[p1 * UV_STRIDE]) + abs(uvs[p3 * UV_STRIDE] - uvs[p1 * UV_STRIDE]);
+    const float dv = abs(uvs[(p2 * UV_STRIDE) + 1] - uvs[(p1 * UV_STRIDE) + 1])
+        + abs(uvs[(p3 * UV_STRIDE) + 1] - uvs[(p1 * UV_STRIDE) + 1]);
+
+    sumU += 1.0F / (du / posLength);
+    sumV += 1.0F / (dv / posLength);
+}
+
+// Loads one component of one corner of 4 consecutive triangles
+inline auto gatherLanes(const uint16_t* tris, const size_t& tri, const size_t& corner, const float* data, const size_t& stride,
+    const size_t& component) -> __m128
+{
+    return _mm_setr_ps(data[(tris[(tri * TRI_STRIDE) + corner] * stride) + component],
+        data[(tris[((tri + 1) * TRI_STRIDE) + corner] * stride) + component],
+        data[(tris[((tri + 2) * TRI_STRIDE) + corner] * stride) + component],
+        data[(tris[((tri + 3) * TRI_STRIDE) + corner] * stride) + component]);
+}
+
+// Normalizes 4 vectors, zero vectors are left unchanged like in normalize
+void normalizeLanes(__m128& x, __m128& y, __m128& z)
+{
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    const __m128 isZero = _mm_cmpeq_ps(length, _mm_setzero_ps());
+    length = _mm_or_ps(_mm_and_ps(isZero, _mm_set1_ps(1.0F)), _mm_andnot_ps(isZero, length));
+    x = _mm_div_ps(x, length);
+    y = _mm_div_ps(y, length);
+    z = _mm_div_ps(z, length);
+}
+
+void normalize(float& x, float& y, float& z)
+{
+    float length = sqrt((x * x) + (y * y) + (z * z));
+    if (length == 0.0F) {
+        length = 1.0F;
+    }
+    x /= length;
+    y /= length;
+    z /= length;
+}
+
+void addToVertex(float* out, const size_t& vert, const float& x, const float& y, const float& z)
+{
+    out[vert * VERT_STRIDE] += x;
+    out[(vert * VERT_STRIDE) + 1] += y;
+    out[(vert * VERT_STRIDE) + 2] += z;
+}
+
+void addToCorners(float* out, const uint16_t* tris, const size_t& tri, const float& x, const float& y, const float& z)
+{
+    for (size_t corner = 0; corner < TRI_STRIDE; corner++) {
+        addToVertex(out, tris[(tri * TRI_STRIDE) + corner], x, y, z);
+    }
+}
+
+void addFaceNormal(const float* verts, const uint16_t* tris, const size_t& tri, float* normals)
+{
+    const float* v1 = verts + (tris[tri * TRI_STRIDE] * VERT_STRIDE);
+    const float* v2 = verts + (tris[(tri * TRI_STRIDE) + 1] * VERT_STRIDE);
+    const float* v3 = verts + (tris[(tri * TRI_STRIDE) + 2] * VERT_STRIDE);
+
+    const float e1x = v2[0] - v1[0];
+    const float e1y = v2[1] - v1[1];
+    const float e1z = v2[2] - v1[2];
+    const float e2x = v3[0] - v1[0];
+    const float e2y = v3[1] - v1[1];
+    const float e2z = v3[2] - v1[2];
+
+    addToCorners(normals, tris, tri, (e1y * e2z) - (e1z * e2y), (e1z * e2x) - (e1x * e2z), (e1x * e2y) - (e1y * e2x));
+}
+
+// Normalizes the summed face normals and smooths vertices that share a position
+void finishNormals(const float* verts, const size_t& numVerts, const float& smoothAngle, float* normals)
+{
+    for (size_t vert = 0; vert < numVerts; vert++) {
+        normalize(normals[vert * VERT_STRIDE], normals[(vert * VERT_STRIDE) + 1], normals[(vert * VERT_STRIDE) + 2]);
+    }
+
+    // sorting by position puts vertices that share a position next to each other, the index keeps the order stable
+    struct SortedVert {
+        float x;
+        float y;
+        float z;
+        size_t vert;
+
+        [[nodiscard]] auto samePosition(const SortedVert& other) const -> bool
+        {
+            return x == other.x && y == other.y && z == other.z;
+        }
+    };
+
+    vector<SortedVert> order(numVerts);
+    for (size_t vert = 0; vert < numVerts; vert++) {
+        order[vert] = { .x = verts[vert * VERT_STRIDE],
+            .y = verts[(vert * VERT_STRIDE) + 1],
+            .z = verts[(vert * VERT_STRIDE) + 2],
+            .vert = vert };
+    }
+    ranges::sort(order, [](const SortedVert& a, const SortedVert& b) {
+        return tie(a.x, a.y, a.z, a.vert) < tie(b.x, b.y, b.z, b.vert);
+    });
+
+    // every vertex is smoothed from the unsmoothed normals, so the result does not depend on the vertex order
+    const vector<float> unsmoothed(normals, normals + (numVerts * VERT_STRIDE));
+    const float minDot = cos(smoothAngle * DEG_TO_RAD);
+
+    size_t groupStart = 0;
+    while (groupStart < numVerts) {
+        size_t groupEnd = groupStart + 1;
+        while (groupEnd < numVerts && order[groupEnd].samePosition(order[groupStart])) {
+            groupEnd++;
+        }
+
+        for (size_t i = groupStart; groupEnd - groupStart > 1 && i < groupEnd; i++) {
+            const float* normal = unsmoothed.data() + (order[i].vert * VERT_STRIDE);
+            float x = 0.0F;
+            float y = 0.0F;
+            float z = 0.0F;
+            for (size_t j = groupStart; j < groupEnd; j++) {
+                const float* other = unsmoothed.data() + (order[j].vert * VERT_STRIDE);
+                const float dot = (normal[0] * other[0]) + (normal[1] * other[1]) + (normal[2] * other[2]);
+                if (i == j || dot > minDot) {
+                    x += other[0];
+                    y += other[1];
+                    z += other[2];
+                }
+            }
+
+            normalize(x, y, z);
+            normals[order[i].vert * VERT_STRIDE] = x;
+            normals[(order[i].vert * VERT_STRIDE) + 1] = y;
+            normals[(order[i].vert * VERT_STRIDE) + 2] = z;
+        }
+
+        groupStart = groupEnd;
+    }
+}
+
+void addTriangleTangents(const float* verts, const float* uvs, const uint16_t* tris, const size_t& tri,
+    float* tangents, float* bitangents)
+{
+    const uint16_t p1 = tris[tri * TRI_STRIDE];
+    const uint16_t p2 = tris[(tri * TRI_STRIDE) + 1];
+    const uint16_t p3 = tris[(tri * TRI_STRIDE) + 2];
+
+    const float x1 = verts[p2 * VERT_STRIDE] - verts[p1 * VERT_STRIDE];
+    const float x2 = verts[p3 * VERT_STRIDE] - verts[p1 * VERT_STRIDE];
+    const float y1 = verts[(p2 * VERT_STRIDE) + 1] - verts[(p1 * VERT_STRIDE) + 1];
+    const float y2 = verts[(p3 * VERT_STRIDE) + 1] - verts[(p1 * VERT_STRIDE) + 1];
+    const float z1 = verts[(p2 * VERT_STRIDE) + 2] - verts[(p1 * VERT_STRIDE) + 2];
+    const float z2 = verts[(p3 * VERT_STRIDE) + 2] - verts[(p1 * VERT_STRIDE) + 2];
+    const float s1 = uvs[p2 * UV_STRIDE] - uvs[p1 * UV_STRIDE];
+    const float s2 = uvs[p3 * UV_STRIDE] - uvs[p1 * UV_STRIDE];
+    const float t1 = uvs[(p2 * UV_STRIDE) + 1] - uvs[(p1 * UV_STRIDE) + 1];
+    const float t2 = uvs[(p3 * UV_STRIDE) + 1] - uvs[(p1 * UV_STRIDE) + 1];
+
+    // only the orientation of the UV mapping matters, both directions are normalized
+    const float r = ((s1 * t2) - (s2 * t1)) >= 0.0F ? 1.0F : -1.0F;
+    float sx = ((t2 * x1) - (t1 * x2)) * r;
+    float sy = ((t2 * y1) - (t1 * y2)) * r;
+    float sz = ((t2 * z1) - (t1 * z2)) * r;
+    float tx = ((s1 * x2) - (s2 * x1)) * r;
+    float ty = ((s1 * y2) - (s2 * y1)) * r;
+    float tz = ((s1 * z2) - (s2 * z1)) * r;
+    normalize(sx, sy, sz);
+    normalize(tx, ty, tz);
+
+    addToCorners(tangents, tris, tri, tx, ty, tz);
+    addToCorners(bitangents, tris, tri, sx, sy, sz);
+}
+
+// Orthogonalizes the summed directions against the normal
+void finishTangents(const float* normals, const size_t& numVerts, float* tangents, float* bitangents)
+{
+    for (size_t vert = 0; vert < numVerts; vert++) {
+        const float* n = normals + (vert * VERT_STRIDE);
+        float* t = tangents + (vert * VERT_STRIDE);
+        float* b = bitangents + (vert * VERT_STRIDE);
+
+        const bool noTangent = t[0] == 0.0F && t[1] == 0.0F && t[2] == 0.0F;
+        const bool noBitangent = b[0] == 0.0F && b[1] == 0.0F && b[2] == 0.0F;
+        if (noTangent || noBitangent) {
+            // no UV gradient, any frame around the normal
+            t[0] = n[1];
+            t[1] = n[2];
+            t[2] = n[0];
+            b[0] = (n[1] * t[2]) - (n[2] * t[1]);
+            b[1] = (n[2] * t[0]) - (n[0] * t[2]);
+            b[2] = (n[0] * t[1]) - (n[1] * t[0]);
+            continue;
+        }
+
+        normalize(t[0], t[1], t[2]);
+        const float dotNT = (n[0] * t[0]) + (n[1] * t[1]) + (n[2] * t[2]);
+        t[0] -= n[0] * dotNT;
+        t[1] -= n[1] * dotNT;
+        t[2] -= n[2] * dotNT;
+        normalize(t[0], t[1], t[2]);
+
+        normalize(b[0], b[1], b[2]);
+        const float dotNB = (n[0] * b[0]) + (n[1] * b[1]) + (n[2] * b[2]);
+        b[0] -= n[0] * dotNB;
+        b[1] -= n[1] * dotNB;
+        b[2] -= n[2] * dotNB;
+        const float dotTB = (t[0] * b[0]) + (t[1] * b[1]) + (t[2] * b[2]);
+        b[0] -= t[0] * dotTB;
+        b[1] -= t[1] * dotTB;
+        b[2] -= t[2] * dotTB;
+        normalize(b[0], b[1], b[2]);
+    }
+}
+
+}
+
+auto ParallaxGenMeshMath::autoUVScale(const float* uvs, const float* verts, const uint16_t* tris, const size_t& numTris)
+    -> UVScale
+{
+    float sumU = 0.0F;
+    float sumV = 0.0F;
+
+    // Gathers 4 triangles into SoA registers
+    const auto gather = [&tris](const size_t& tri, const size_t& corner, const float* data, const size_t& stride,
+                            const size_t& component) -> __m128 {
+        return gatherLanes(tris, tri, corner, data, stride, component);
+    };
+
+    const auto length = [](const __m128& x, const __m128& y, const __m128& z) -> __m128 {
+        return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    };
+
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 one = _mm_set1_ps(1.0F);
+
+    size_t tri = 0;
+    for (; tri + LANES <= numTris; tri += LANES) {
+        // positions
+        const __m128 x1 = gather(tri, 0, verts, VERT_STRIDE, 0);
+        const __m128 y1 = gather(tri, 0, verts, VERT_STRIDE, 1);
+        const __m128 z1 = gather(tri, 0, verts, VERT_STRIDE, 2);
+        const __m128 len12 = length(_mm_sub_ps(gather(tri, 1, verts, VERT_STRIDE, 0), x1),
+            _mm_sub_ps(gather(tri, 1, verts, VERT_STRIDE, 1), y1),
+            _mm_sub_ps(gather(tri, 1, verts, VERT_STRIDE, 2), z1));
+        const __m128 len13 = length(_mm_sub_ps(gather(tri, 2, verts, VERT_STRIDE, 0), x1),
+            _mm_sub_ps(gather(tri, 2, verts, VERT_STRIDE, 1), y1),
+            _mm_sub_ps(gather(tri, 2, verts, VERT_STRIDE, 2), z1));
+        const __m128 posLength = _mm_add_ps(len12, len13);
+
+        // uvs
+        const __m128 u1 = gather(tri, 0, uvs, UV_STRIDE, 0);
+        const __m128 v1 = gather(tri, 0, uvs, UV_STRIDE, 1);
+        const __m128 du = _mm_add_ps(_mm_and_ps(_mm_sub_ps(gather(tri, 1, uvs, UV_STRIDE, 0), u1), absMask),
+            _mm_and_ps(_mm_sub_ps(gather(tri, 2, uvs, UV_STRIDE, 0), u1), absMask));
+        const __m128 dv = _mm_add_ps(_mm_and_ps(_mm_sub_ps(gather(tri, 1, uvs, UV_STRIDE, 1), v1), absMask),
+            _mm_and_ps(_mm_sub_ps(gather(tri, 2, uvs, UV_STRIDE, 1), v1), absMask));
+
+        // 1 / (uv length / position length), same operations as the scalar version
+        array<float, LANES> termU {};
+        array<float, LANES> termV {};
+        _mm_storeu_ps(termU.data(), _mm_div_ps(one, _mm_div_ps(du, posLength)));
+        _mm_storeu_ps(termV.data(), _mm_div_ps(one, _mm_div_ps(dv, posLength)));
+
+        // accumulate in triangle order so the sum matches the scalar version
+        for (size_t lane = 0; lane < LANES; lane++) {
+            sumU += termU.at(lane);
+            sumV += termV.at(lane);
+        }
+    }
+
+    // remainder
+    for (; tri < numTris; tri++) {
+        addTriangleTerms(uvs, verts, tris, tri, sumU, sumV);
+    }
+
+    return finishUVScale(sumU, sumV, numTris);
+}
+
+auto ParallaxGenMeshMath::autoUVScaleScalar(
+    const float* uvs, const float* verts, const uint16_t* tris, const size_t& numTris) -> UVScale
+{
+    float sumU = 0.0F;
+    float sumV = 0.0F;
+    for (size_t tri = 0; tri < numTris; tri++) {
+        addTriangleTerms(uvs, verts, tris, tri, sumU, sumV);
+    }
+
+    return finishUVScale(sumU, sumV, numTris);
+}
+
+void ParallaxGenMeshMath::calcNormals(const float* verts, const size_t& numVerts, const uint16_t* tris,
+    const size_t& numTris, const float& smoothAngle, float* normals)
+{
+    fill(normals, normals + (numVerts * VERT_STRIDE), 0.0F);
+
+    const auto gather = [&tris, &verts](const size_t& tri, const size_t& corner, const size_t& component) -> __m128 {
+        return gatherLanes(tris, tri, corner, verts, VERT_STRIDE, component);
+    };
+
+    size_t tri = 0;
+    for (; tri + LANES <= numTris; tri += LANES) {
+        const __m128 x1 = gather(tri, 0, 0);
+        const __m128 y1 = gather(tri, 0, 1);
+        const __m128 z1 = gather(tri, 0, 2);
+        const __m128 e1x = _mm_sub_ps(gather(tri, 1, 0), x1);
+        const __m128 e1y = _mm_sub_ps(gather(tri, 1, 1), y1);
+        const __m128 e1z = _mm_sub_ps(gather(tri, 1, 2), z1);
+        const __m128 e2x = _mm_sub_ps(gather(tri, 2, 0), x1);
+        const __m128 e2y = _mm_sub_ps(gather(tri, 2, 1), y1);
+        const __m128 e2z = _mm_sub_ps(gather(tri, 2, 2), z1);
+
+        // cross product of the edges, same operations as addFaceNormal
+        array<float, LANES> nx {};
+        array<float, LANES> ny {};
+        array<float, LANES> nz {};
+        _mm_storeu_ps(nx.data(), _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y)));
+        _mm_storeu_ps(ny.data(), _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z)));
+        _mm_storeu_ps(nz.data(), _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x)));
+
+        // scatter in triangle order so the sums match the scalar version
+        for (size_t lane = 0; lane < LANES; lane++) {
+            addToCorners(normals, tris, tri + lane, nx.at(lane), ny.at(lane), nz.at(lane));
+        }
+    }
+
+    // remainder
+    for (; tri < numTris; tri++) {
+        addFaceNormal(verts, tris, tri, normals);
+    }
+
+    finishNormals(verts, numVerts, smoothAngle, normals);
+}
+
+void ParallaxGenMeshMath::calcNormalsScalar(const float* verts, const size_t& numVerts, const uint16_t* tris,
+    const size_t& numTris, const float& smoothAngle, float* normals)
+{
+    fill(normals, normals + (numVerts * VERT_STRIDE), 0.0F);
+
+    for (size_t tri = 0; tri < numTris; tri++) {
+        addFaceNormal(verts, tris, tri, normals);
+    }
+
+    finishNormals(verts, numVerts, smoothAngle, normals);
+}
+
+void ParallaxGenMeshMath::calcTangents(const float* verts, const float* uvs, const float* normals,
+    const size_t& numVerts, const uint16_t* tris, const size_t& numTris, float* tangents, float* bitangents)
+{
+    fill(tangents, tangents + (numVerts * VERT_STRIDE), 0.0F);
+    fill(bitangents, bitangents + (numVerts * VERT_STRIDE), 0.0F);
+
+    const auto gather = [&tris](const size_t& tri, const size_t& corner, const float* data, const size_t& stride,
+                            const size_t& component) -> __m128 {
+        return gatherLanes(tris, tri, corner, data, stride, component);
+    };
+
+    const __m128 one = _mm_set1_ps(1.0F);
+    const __m128 minusOne = _mm_set1_ps(-1.0F);
+
+    size_t tri = 0;
+    for (; tri + LANES <= numTris; tri += LANES) {
+        const __m128 vx = gather(tri, 0, verts, VERT_STRIDE, 0);
+        const __m128 vy = gather(tri, 0, verts, VERT_STRIDE, 1);
+        const __m128 vz = gather(tri, 0, verts, VERT_STRIDE, 2);
+        const __m128 x1 = _mm_sub_ps(gather(tri, 1, verts, VERT_STRIDE, 0), vx);
+        const __m128 x2 = _mm_sub_ps(gather(tri, 2, verts, VERT_STRIDE, 0), vx);
+        const __m128 y1 = _mm_sub_ps(gather(tri, 1, verts, VERT_STRIDE, 1), vy);
+        const __m128 y2 = _mm_sub_ps(gather(tri, 2, verts, VERT_STRIDE, 1), vy);
+        const __m128 z1 = _mm_sub_ps(gather(tri, 1, verts, VERT_STRIDE, 2), vz);
+        const __m128 z2 = _mm_sub_ps(gather(tri, 2, verts, VERT_STRIDE, 2), vz);
+
+        const __m128 u = gather(tri, 0, uvs, UV_STRIDE, 0);
+        const __m128 v = gather(tri, 0, uvs, UV_STRIDE, 1);
+        const __m128 s1 = _mm_sub_ps(gather(tri, 1, uvs, UV_STRIDE, 0), u);
+        const __m128 s2 = _mm_sub_ps(gather(tri, 2, uvs, UV_STRIDE, 0), u);
+        const __m128 t1 = _mm_sub_ps(gather(tri, 1, uvs, UV_STRIDE, 1), v);
+        const __m128 t2 = _mm_sub_ps(gather(tri, 2, uvs, UV_STRIDE, 1), v);
+
+        // same operations as addTriangleTangents
+        const __m128 positive = _mm_cmpge_ps(_mm_sub_ps(_mm_mul_ps(s1, t2), _mm_mul_ps(s2, t1)), _mm_setzero_ps());
+        const __m128 r = _mm_or_ps(_mm_and_ps(positive, one), _mm_andnot_ps(positive, minusOne));
+
+        __m128 sx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, x1), _mm_mul_ps(t1, x2)), r);
+        __m128 sy = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, y1), _mm_mul_ps(t1, y2)), r);
+        __m128 sz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, z1), _mm_mul_ps(t1, z2)), r);
+        __m128 tx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, x2), _mm_mul_ps(s2, x1)), r);
+        __m128 ty = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, y2), _mm_mul_ps(s2, y1)), r);
+        __m128 tz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, z2), _mm_mul_ps(s2, z1)), r);
+        normalizeLanes(sx, sy, sz);
+        normalizeLanes(tx, ty, tz);
+
+        array<array<float, LANES>, 6> dirs {};
+        _mm_storeu_ps(dirs[0].data(), tx);
+        _mm_storeu_ps(dirs[1].data(), ty);
+        _mm_storeu_ps(dirs[2].data(), tz);
+        _mm_storeu_ps(dirs[3].data(), sx);
+        _mm_storeu_ps(dirs[4].data(), sy);
+        _mm_storeu_ps(dirs[5].data(), sz);
+
+        // scatter in triangle order so the sums match the scalar version
+        for (size_t lane = 0; lane < LANES; lane++) {
+            addToCorners(tangents, tris, tri + lane, dirs[0].at(lane), dirs[1].at(lane), dirs[2].at(lane));
+            addToCorners(bitangents, tris, tri + lane, dirs[3].at(lane), dirs[4].at(lane), dirs[5].at(lane));
+        }
+    }
+
+    // remainder
+    for (; tri < numTris; tri++) {
+        addTriangleTangents(verts, uvs, tris, tri, tangents, bitangents);
+    }
+
+    finishTangents(normals, numVerts, tangents, bitangents);
+}
+
+void ParallaxGenMeshMath::calcTangentsScalar(const float* verts, const float* uvs, const float* normals,
+    const size_t& numVerts, const uint16_t* tris, const size_t& numTris, float* tangents, float* bitangents)
+{
+    fill(tangents, tangents + (numVerts * VERT_STRIDE), 0.0F);
+    fill(bitangents, bitangents + (numVerts * VERT_STRIDE), 0.0F);
+
+    for (size_t tri = 0; tri < numTris; tri++) {
+        addTriangleTangents(verts, uvs, tris, tri, tangents, bitangents);
+    }
+
+    finishTangents(normals, numVerts, tangents, bitangents);
+}
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,199 @@
+#include "ParallaxGenPipeline.hpp"
+
+#include "ParallaxGenTrace.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+void ParallaxGenPipeline::addStage(
+    const string& name, const vector<string>& inputs, function<void()> func, const bool& mainThread)
+{
+    for (const auto& stage : m_stages) {
+        if (stage.name == name) {
+            throw runtime_error("Pipeline stage " + name + " was added twice");
+        }
+    }
+
+    // inputs have to exist already, which also keeps the stages free of cycles
+    vector<size_t> inputIndices;
+    inputIndices.reserve(inputs.size());
+    for (const auto& input : inputs) {
+        inputIndices.push_back(getStageIndex(input));
+    }
+
+    m_stages.push_back(
+        { .name = name, .inputs = std::move(inputIndices), .func = std::move(func), .mainThread = mainThread });
+}
+
+void ParallaxGenPipeline::run(const bool& multithread)
+{
+    const auto runStart = chrono::steady_clock::now();
+    const auto getMS = [&runStart]() -> double {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - runStart).count();
+    };
+
+    m_stageTimes.assign(m_stages.size(), {});
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        m_stageTimes[i].name = m_stages[i].name;
+    }
+
+    if (!multithread) {
+        // stages only read from stages added before them, so the added order is a valid order
+        for (size_t i = 0; i < m_stages.size(); i++) {
+            m_stageTimes[i].startMS = getMS();
+            const ParallaxGenTrace::Span traceSpan("stage", [this, &i] { return m_stages[i].name; });
+            m_stages[i].func();
+            m_stageTimes[i].endMS = getMS();
+        }
+
+        m_wallMS = getMS();
+        return;
+    }
+
+    // stages that read from each stage
+    vector<vector<size_t>> outputs(m_stages.size());
+    vector<size_t> numPendingInputs(m_stages.size());
+    deque<size_t> ready;
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        numPendingInputs[i] = m_stages[i].inputs.size();
+        for (const auto& input : m_stages[i].inputs) {
+            outputs[input].push_back(i);
+        }
+
+        if (numPendingInputs[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    mutex stateMutex;
+    condition_variable stateChanged;
+    size_t numRunning = 0;
+    size_t numDone = 0;
+    exception_ptr firstException;
+
+    // called with stateMutex held
+    const auto finishStage = [&](const size_t& stage, exception_ptr exception) {
+        m_stageTimes[stage].endMS = getMS();
+        numDone++;
+
+        if (exception != nullptr) {
+            if (firstException == nullptr) {
+                firstException = std::move(exception);
+            }
+            return;
+        }
+
+        for (const auto& output : outputs[stage]) {
+            if (--numPendingInputs[output] == 0) {
+                ready.push_back(output);
+            }
+        }
+    };
+
+    const auto runStage = [&](const size_t& stage) -> exception_ptr {
+        try {
+            const ParallaxGenTrace::Span traceSpan("stage", [this, &stage] { return m_stages[stage].name; });
+            m_stages[stage].func();
+        } catch (...) {
+            return current_exception();
+        }
+
+        return nullptr;
+    };
+
+    vector<thread> threads;
+    unique_lock<mutex> lock(stateMutex);
+    while (true) {
+        // main thread stages are run by this loop, every other ready stage gets its own thread
+        size_t mainStage = m_stages.size();
+        while (firstException == nullptr && !ready.empty()) {
+            const size_t stage = ready.front();
+            ready.pop_front();
+            m_stageTimes[stage].startMS = getMS();
+            numRunning++;
+
+            if (m_stages[stage].mainThread) {
+                mainStage = stage;
+                break;
+            }
+
+            threads.emplace_back([&, stage] {
+                auto exception = runStage(stage);
+
+                const lock_guard<mutex> stageLock(stateMutex);
+                numRunning--;
+                finishStage(stage, std::move(exception));
+                stateChanged.notify_all();
+            });
+        }
+
+        if (mainStage < m_stages.size()) {
+            lock.unlock();
+            auto exception = runStage(mainStage);
+            lock.lock();
+
+            numRunning--;
+            finishStage(mainStage, std::move(exception));
+            continue;
+        }
+
+        if (numRunning == 0 && (ready.empty() || firstException != nullptr)) {
+            break;
+        }
+
+        stateChanged.wait(lock);
+    }
+    lock.unlock();
+
+    for (auto& curThread : threads) {
+        curThread.join();
+    }
+
+    m_wallMS = getMS();
+
+    if (firstException != nullptr) {
+        rethrow_exception(firstException);
+    }
+
+    if (numDone != m_stages.size()) {
+        throw runtime_error("Pipeline finished without running every stage");
+    }
+
+    spdlog::debug("Pipeline finished in {:.0f} ms, stages overlapped by {:.0f} ms", m_wallMS, getOverlapMS());
+}
+
+auto ParallaxGenPipeline::getStageTimes() const -> const vector<StageTime>& { return m_stageTimes; }
+
+auto ParallaxGenPipeline::getOverlapMS() const -> double
+{
+    double stageMS = 0.0;
+    for (const auto& stageTime : m_stageTimes) {
+        stageMS += stageTime.endMS - stageTime.startMS;
+    }
+
+    return stageMS - m_wallMS;
+}
+
+auto ParallaxGenPipeline::getStageIndex(const string& name) const -> size_t
+{
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        if (m_stages[i].name == name) {
+            return i;
+        }
+    }
+
+    throw runtime_error("Pipeline stage " + name + " is used before it was added");
+}
@@ -1,20 +1,35 @@
 #include "ParallaxGenPlugin.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <span>
 #include <spdlog/spdlog.h>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <winbase.h>
 
+#include "BethesdaPluginReader.hpp"
 #include "Logger.hpp"
 #include "NIFUtil.hpp"
 #include "PGDiag.hpp"
 #include "PGMutagenNE.h"
+#include "ParallaxGenTrace.hpp"
 #include "ParallaxGenUtil.hpp"
 #include "ParallaxGenWarnings.hpp"
 #include "patchers/base/PatcherUtil.hpp"
 
 using namespace std;
 
+static_assert(is_same_v<ParallaxGenPluginIndex::TXSTSlots, NIFUtil::TextureSet>,
+    "Plugin index slots must match the NIF texture sets they are compared with");
+
 namespace {
 void dnneFailure(enum failure_type type, int errorCode)
 {
@@ -35,53 +50,172 @@ void dnneFailure(enum failure_type type, int errorCode)
 
 mutex ParallaxGenPlugin::s_libMutex;
 
-void ParallaxGenPlugin::libLogMessageIfExists()
+ParallaxGenRingBuffer<ParallaxGenPlugin::LibLogMessage> ParallaxGenPlugin::s_logBuffer(LOG_BUFFER_SIZE);
+atomic<uint32_t> ParallaxGenPlugin::s_logSignal = 0;
+atomic<uint64_t> ParallaxGenPlugin::s_logPushed = 0;
+atomic<uint64_t> ParallaxGenPlugin::s_logWritten = 0;
+atomic<bool> ParallaxGenPlugin::s_logConsumerRunning = false;
+atomic<bool> ParallaxGenPlugin::s_logCritical = false;
+
+void ParallaxGenPlugin::libLogCallback(int level, const wchar_t* message, int length)
 {
-    static constexpr unsigned int TRACE_LOG = 0;
-    static constexpr unsigned int DEBUG_LOG = 1;
-    static constexpr unsigned int INFO_LOG = 2;
-    static constexpr unsigned int WARN_LOG = 3;
-    static constexpr unsigned int ERROR_LOG = 4;
-    static constexpr unsigned int CRITICAL_LOG = 5;
+    static constexpr int DEBUG_LOG = 1;
+    static constexpr int CRITICAL_LOG = 5;
+    static constexpr int MAX_PUSH_RETRIES = 65536;
 
-    int level = 0;
-    wchar_t* message = nullptr;
-    GetLogMessage(&message, &level);
+    LibLogMessage logMessage { .level = level, .prefix = {}, .message = wstring(message, static_cast<size_t>(length)) };
 
-    while (message != nullptr) {
-        const wstring messageOut(message);
-        LocalFree(static_cast<HGLOBAL>(message)); // Only free if memory was allocated.
-        message = nullptr;
+    // raised by libThrowExceptionIfExists on this thread once the message is in the log
+    if (level == CRITICAL_LOG) {
+        s_logCritical.store(true, memory_order_release);
+    }
 
-        // log the message
-        switch (level) {
-        case TRACE_LOG:
-            Logger::trace(messageOut);
-            break;
-        case DEBUG_LOG:
-            Logger::debug(messageOut);
-            break;
-        case INFO_LOG:
-            Logger::info(messageOut);
-            break;
-        case WARN_LOG:
-            Logger::warn(messageOut);
-            break;
-        case ERROR_LOG:
-            Logger::error(messageOut);
-            break;
-        case CRITICAL_LOG:
-            Logger::critical(messageOut);
+    if (!s_logConsumerRunning.load(memory_order_acquire)) {
+        logLibMessage(logMessage.level, logMessage.prefix, logMessage.message);
+        return;
+    }
+
+    // the consumer thread has no prefix of its own, so it logs with the prefix of the thread in the library
+    if (level <= DEBUG_LOG) {
+        logMessage.prefix = Logger::getPrefix();
+    }
+
+    // the consumer keeps up with normal traffic, a full buffer only slows down the library thread. If the consumer is
+    // gone or stuck the message is logged right here instead of waiting for it
+    for (int retry = 0; !s_logBuffer.tryPush(std::move(logMessage)); retry++) {
+        if (retry >= MAX_PUSH_RETRIES || !s_logConsumerRunning.load(memory_order_acquire)) {
+            logLibMessage(logMessage.level, logMessage.prefix, logMessage.message);
+            return;
+        }
+
+        this_thread::yield();
+    }
+
+    s_logPushed.fetch_add(1, memory_order_release);
+    s_logSignal.fetch_add(1, memory_order_release);
+    s_logSignal.notify_one();
+
+    // the consumer stopped after the check above, its last drain may have missed this message
+    if (!s_logConsumerRunning.load(memory_order_acquire)) {
+        drainLog();
+    }
+}
+
+void ParallaxGenPlugin::logLibMessage(const int& level, const wstring& prefix, const wstring& message)
+{
+    static constexpr int TRACE_LOG = 0;
+    static constexpr int DEBUG_LOG = 1;
+    static constexpr int INFO_LOG = 2;
+    static constexpr int WARN_LOG = 3;
+    static constexpr int ERROR_LOG = 4;
+    static constexpr int CRITICAL_LOG = 5;
+
+    switch (level) {
+    case TRACE_LOG:
+        Logger::trace(L"{}{}", prefix, message);
+        break;
+    case DEBUG_LOG:
+        Logger::debug(L"{}{}", prefix, message);
+        break;
+    case INFO_LOG:
+        Logger::info(message);
+        break;
+    case WARN_LOG:
+        Logger::warn(message);
+        break;
+    case ERROR_LOG:
+        Logger::error(message);
+        break;
+    case CRITICAL_LOG:
+        // may run on the consumer thread, the thread in the library exits once the call returns
+        Logger::error(message);
+        break;
+    }
+}
+
+ParallaxGenPlugin::LogConsumer::LogConsumer()
+{
+    s_logConsumerRunning.store(true, memory_order_release);
+    m_thread = jthread(run);
+}
+
+ParallaxGenPlugin::LogConsumer::~LogConsumer()
+{
+    m_thread.request_stop();
+    s_logSignal.fetch_add(1, memory_order_release);
+    s_logSignal.notify_one();
+
+    m_thread.join();
+
+    // producers log directly from here on, messages pushed before they noticed are written here
+    s_logConsumerRunning.store(false, memory_order_release);
+    drainLog();
+}
+
+void ParallaxGenPlugin::LogConsumer::run(const stop_token& stopToken)
+{
+    while (true) {
+        // read the signal first so a push during the drain wakes the wait below right away
+        const uint32_t signal = s_logSignal.load(memory_order_acquire);
+
+        drainLog();
+
+        if (stopToken.stop_requested()) {
             break;
         }
 
-        // Get the next message
-        GetLogMessage(&message, &level);
+        s_logSignal.wait(signal, memory_order_acquire);
+    }
+}
+
+auto ParallaxGenPlugin::getLogConsumer() -> unique_ptr<LogConsumer>&
+{
+    static unique_ptr<LogConsumer> logConsumer;
+    return logConsumer;
+}
+
+void ParallaxGenPlugin::startLogConsumer()
+{
+    auto& logConsumer = getLogConsumer();
+    if (logConsumer == nullptr) {
+        logConsumer = make_unique<LogConsumer>();
+    }
+}
+
+void ParallaxGenPlugin::stopLogConsumer() { getLogConsumer().reset(); }
+
+void ParallaxGenPlugin::drainLog()
+{
+    LibLogMessage logMessage;
+    while (s_logBuffer.tryPop(logMessage)) {
+        logLibMessage(logMessage.level, logMessage.prefix, logMessage.message);
+        s_logWritten.fetch_add(1, memory_order_release);
+    }
+    s_logWritten.notify_all();
+}
+
+void ParallaxGenPlugin::flushLog()
+{
+    if (!s_logConsumerRunning.load(memory_order_acquire)) {
+        return;
+    }
+
+    const uint64_t target = s_logPushed.load(memory_order_acquire);
+    uint64_t written = s_logWritten.load(memory_order_acquire);
+    while (written < target) {
+        s_logWritten.wait(written, memory_order_acquire);
+        written = s_logWritten.load(memory_order_acquire);
     }
 }
 
 void ParallaxGenPlugin::libThrowExceptionIfExists()
 {
+    if (s_logCritical.exchange(false, memory_order_acq_rel)) {
+        // the critical message itself is logged by the consumer, exit on the thread that made the call
+        flushLog();
+        Logger::critical("ParallaxGenMutagenWrapper.dll reported a critical error, see the log above");
+    }
+
     wchar_t* message = nullptr;
     GetLastException(&message);
 
@@ -92,12 +226,17 @@ void ParallaxGenPlugin::libThrowExceptionIfExists()
     const wstring messageOut(message);
     LocalFree(static_cast<HGLOBAL>(message)); // Only free if memory was allocated.
 
+    // library messages leading up to the exception are logged before it
+    flushLog();
+
     throw runtime_error("ParallaxGenMutagenWrapper.dll: " + ParallaxGenUtil::utf16toASCII(messageOut));
 }
 
 void ParallaxGenPlugin::libInitialize(
     const int& gameType, const std::wstring& exePath, const wstring& dataPath, const vector<wstring>& loadOrder)
 {
+    const ParallaxGenTrace::Span traceSpan("libInitialize");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     // Use vector to manage the memory for LoadOrderArr
@@ -113,36 +252,78 @@ void ParallaxGenPlugin::libInitialize(
     loadOrderArr.push_back(nullptr);
 
     Initialize(gameType, exePath.c_str(), dataPath.c_str(), loadOrderArr.data());
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 }
 
 void ParallaxGenPlugin::libPopulateObjs()
 {
+    const ParallaxGenTrace::Span traceSpan("libPopulateObjs");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     PopulateObjs();
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 }
 
 void ParallaxGenPlugin::libFinalize(const filesystem::path& outputPath, const bool& esmify)
 {
+    const ParallaxGenTrace::Span traceSpan("libFinalize");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     Finalize(outputPath.c_str(), static_cast<int>(esmify));
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 }
 
+auto ParallaxGenPlugin::libGetTXSTRefs() -> vector<ParallaxGenPluginIndex::AltTexRef>
+{
+    const ParallaxGenTrace::Span traceSpan("libGetTXSTRefs");
+
+    const lock_guard<mutex> lock(s_libMutex);
+
+    int length = 0;
+    GetTXSTRefs(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &length);
+    libThrowExceptionIfExists();
+
+    vector<int> txstIdArray(length);
+    vector<int> altTexIdArray(length);
+    vector<int> modelRecIdArray(length);
+    vector<int> index3DArray(length);
+    vector<wchar_t*> nifNameArray(length);
+    vector<char*> matchTypeArray(length);
+    GetTXSTRefs(txstIdArray.data(), altTexIdArray.data(), modelRecIdArray.data(), index3DArray.data(),
+        nifNameArray.data(), matchTypeArray.data(), nullptr);
+    libThrowExceptionIfExists();
+
+    vector<ParallaxGenPluginIndex::AltTexRef> outputArray(length);
+    for (int i = 0; i < length; ++i) {
+        auto& curRef = outputArray[i];
+        curRef.index3D = index3DArray[i];
+        curRef.txstIndex = txstIdArray[i];
+        curRef.altTexIndex = altTexIdArray[i];
+        curRef.modelRecHandle = modelRecIdArray[i];
+
+        if (nifNameArray.at(i) != nullptr) {
+            curRef.nifName = static_cast<const wchar_t*>(nifNameArray.at(i));
+            LocalFree(static_cast<HGLOBAL>(nifNameArray.at(i)));
+        }
+
+        if (matchTypeArray.at(i) != nullptr) {
+            curRef.matchType = static_cast<const char*>(matchTypeArray.at(i));
+            LocalFree(static_cast<HGLOBAL>(matchTypeArray.at(i)));
+        }
+    }
+
+    return outputArray;
+}
+
 auto ParallaxGenPlugin::libGetMatchingTXSTObjs(const wstring& nifName, const int& index3D)
-    -> vector<tuple<int, int, wstring, string>>
+    -> vector<ParallaxGenPluginIndex::Match>
 {
     const lock_guard<mutex> lock(s_libMutex);
 
     int length = 0;
     GetMatchingTXSTObjs(nifName.c_str(), index3D, nullptr, nullptr, nullptr, nullptr, &length);
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 
     vector<int> txstIdArray(length);
@@ -151,25 +332,43 @@ auto ParallaxGenPlugin::libGetMatchingTXSTObjs(const wstring& nifName, const int
     vector<char*> matchTypeArray(length);
     GetMatchingTXSTObjs(nifName.c_str(), index3D, txstIdArray.data(), altTexIdArray.data(), matchedNIFArray.data(),
         matchTypeArray.data(), nullptr);
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 
-    vector<tuple<int, int, wstring, string>> outputArray(length);
+    vector<ParallaxGenPluginIndex::Match> outputArray(length);
     for (int i = 0; i < length; ++i) {
-        const auto* matchedNIFStr = static_cast<const wchar_t*>(matchedNIFArray.at(i));
-        LocalFree(static_cast<HGLOBAL>(matchedNIFArray.at(i)));
+        auto& curMatch = outputArray[i];
+        curMatch.txstIndex = txstIdArray[i];
+        curMatch.altTexIndex = altTexIdArray[i];
 
-        const auto* matchTypeStr = static_cast<const char*>(matchTypeArray.at(i));
-        LocalFree(static_cast<HGLOBAL>(matchTypeArray.at(i)));
+        if (matchedNIFArray.at(i) != nullptr) {
+            curMatch.matchedNIF = static_cast<const wchar_t*>(matchedNIFArray.at(i));
+            LocalFree(static_cast<HGLOBAL>(matchedNIFArray.at(i)));
+        }
 
-        outputArray[i] = { txstIdArray[i], altTexIdArray[i], matchedNIFStr, matchTypeStr };
+        if (matchTypeArray.at(i) != nullptr) {
+            curMatch.matchType = static_cast<const char*>(matchTypeArray.at(i));
+            LocalFree(static_cast<HGLOBAL>(matchTypeArray.at(i)));
+        }
     }
 
     return outputArray;
 }
 
+auto ParallaxGenPlugin::libGetModelRecHandleFromAltTexHandle(const int& altTexIndex) -> int
+{
+    const lock_guard<mutex> lock(s_libMutex);
+
+    int modelRecHandle = 0;
+    GetModelRecHandleFromAltTexHandle(altTexIndex, &modelRecHandle);
+    libThrowExceptionIfExists();
+
+    return modelRecHandle;
+}
+
 auto ParallaxGenPlugin::libGetTXSTSlots(const int& txstIndex) -> array<wstring, NUM_TEXTURE_SLOTS>
 {
+    const ParallaxGenTrace::Span traceSpan("libGetTXSTSlots");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     array<wchar_t*, NUM_TEXTURE_SLOTS> slotsArray = { nullptr };
@@ -177,7 +376,6 @@ auto ParallaxGenPlugin::libGetTXSTSlots(const int& txstIndex) -> array<wstring,
 
     // Call the function
     GetTXSTSlots(txstIndex, slotsArray.data());
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 
     // Process the slots
@@ -197,6 +395,8 @@ auto ParallaxGenPlugin::libGetTXSTSlots(const int& txstIndex) -> array<wstring,
 
 void ParallaxGenPlugin::libCreateTXSTPatch(const int& txstIndex, const array<wstring, NUM_TEXTURE_SLOTS>& slots)
 {
+    const ParallaxGenTrace::Span traceSpan("libCreateTXSTPatch");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     // Prepare the array of const wchar_t* pointers from the Slots array
@@ -207,13 +407,14 @@ void ParallaxGenPlugin::libCreateTXSTPatch(const int& txstIndex, const array<wst
 
     // Call the CreateTXSTPatch function with TXSTIndex and the array of wide string pointers
     CreateTXSTPatch(txstIndex, slotsArray.data());
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 }
 
 auto ParallaxGenPlugin::libCreateNewTXSTPatch(
     const int& altTexIndex, const array<wstring, NUM_TEXTURE_SLOTS>& slots, const string& newEDID) -> int
 {
+    const ParallaxGenTrace::Span traceSpan("libCreateNewTXSTPatch");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     // Prepare the array of const wchar_t* pointers from the Slots array
@@ -225,7 +426,6 @@ auto ParallaxGenPlugin::libCreateNewTXSTPatch(
     // Call the CreateNewTXSTPatch function with AltTexIndex and the array of wide string pointers
     int newTXSTId = 0;
     CreateNewTXSTPatch(altTexIndex, slotsArray.data(), newEDID.c_str(), &newTXSTId);
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 
     return newTXSTId;
@@ -233,31 +433,34 @@ auto ParallaxGenPlugin::libCreateNewTXSTPatch(
 
 void ParallaxGenPlugin::libSetModelAltTex(const int& altTexIndex, const int& txstIndex)
 {
+    const ParallaxGenTrace::Span traceSpan("libSetModelAltTex");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     SetModelAltTex(altTexIndex, txstIndex);
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 }
 
 void ParallaxGenPlugin::libSet3DIndex(const int& altTexIndex, const int& index3D)
 {
+    const ParallaxGenTrace::Span traceSpan("libSet3DIndex");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     Set3DIndex(altTexIndex, index3D);
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 }
 
 auto ParallaxGenPlugin::libGetTXSTFormID(const int& txstIndex) -> tuple<unsigned int, wstring, wstring>
 {
+    const ParallaxGenTrace::Span traceSpan("libGetTXSTFormID");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     wchar_t* pluginName = nullptr;
     wchar_t* winningPluginName = nullptr;
     unsigned int formID = 0;
     GetTXSTFormID(txstIndex, &formID, &pluginName, &winningPluginName);
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 
     wstring pluginNameString;
@@ -283,13 +486,14 @@ auto ParallaxGenPlugin::libGetTXSTFormID(const int& txstIndex) -> tuple<unsigned
 
 auto ParallaxGenPlugin::libGetModelRecFormID(const int& modelRecHandle) -> tuple<unsigned int, wstring, wstring>
 {
+    const ParallaxGenTrace::Span traceSpan("libGetModelRecFormID");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     wchar_t* pluginName = nullptr;
     wchar_t* winningPluginName = nullptr;
     unsigned int formID = 0;
     GetModelRecFormID(modelRecHandle, &formID, &pluginName, &winningPluginName);
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 
     wstring pluginNameString;
@@ -315,13 +519,14 @@ auto ParallaxGenPlugin::libGetModelRecFormID(const int& modelRecHandle) -> tuple
 
 auto ParallaxGenPlugin::libGetAltTexFormID(const int& altTexIndex) -> tuple<unsigned int, wstring, wstring>
 {
+    const ParallaxGenTrace::Span traceSpan("libGetAltTexFormID");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     wchar_t* pluginName = nullptr;
     wchar_t* winningPluginName = nullptr;
     unsigned int formID = 0;
     GetAltTexFormID(altTexIndex, &formID, &pluginName, &winningPluginName);
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 
     wstring pluginNameString;
@@ -345,64 +550,256 @@ auto ParallaxGenPlugin::libGetAltTexFormID(const int& altTexIndex) -> tuple<unsi
     return make_tuple(formID, pluginNameString, winningPluginNameString);
 }
 
-auto ParallaxGenPlugin::libGetModelRecHandleFromAltTexHandle(const int& altTexIndex) -> int
+void ParallaxGenPlugin::libLogTestMessages(const int& numMessages, const int& level)
 {
     const lock_guard<mutex> lock(s_libMutex);
 
-    int modelRecHandle = 0;
-    GetModelRecHandleFromAltTexHandle(altTexIndex, &modelRecHandle);
-    libLogMessageIfExists();
+    LogTestMessages(numMessages, level);
     libThrowExceptionIfExists();
-
-    return modelRecHandle;
 }
 
 void ParallaxGenPlugin::libSetModelRecNIF(const int& modelRecHandle, const wstring& nifPath)
 {
+    const ParallaxGenTrace::Span traceSpan("libSetModelRecNIF");
+
     const lock_guard<mutex> lock(s_libMutex);
 
     SetModelRecNIF(modelRecHandle, nifPath.c_str());
-    libLogMessageIfExists();
     libThrowExceptionIfExists();
 }
 
 // Statics
-mutex ParallaxGenPlugin::s_createdTXSTMutex;
-unordered_map<array<wstring, NUM_TEXTURE_SLOTS>, pair<int, string>, ParallaxGenPlugin::ArrayHash,
-    ParallaxGenPlugin::ArrayEqual>
-    ParallaxGenPlugin::s_createdTXSTs;
-
-mutex ParallaxGenPlugin::s_edidCounterMutex;
-int ParallaxGenPlugin::s_edidCounter = 0;
+vector<shared_ptr<ParallaxGenPlugin::NewTXSTRequests>> ParallaxGenPlugin::s_txstRequests;
+mutex ParallaxGenPlugin::s_txstRequestsMutex;
 
 ParallaxGenDirectory* ParallaxGenPlugin::s_pgd;
 
-mutex ParallaxGenPlugin::s_processShapeMutex;
+ParallaxGenPluginIndex ParallaxGenPlugin::s_index;
+
+vector<shared_ptr<vector<ParallaxGenPlugin::PluginOp>>> ParallaxGenPlugin::s_opLogs;
+mutex ParallaxGenPlugin::s_opLogsMutex;
+
+filesystem::path ParallaxGenPlugin::s_dataPath;
+vector<wstring> ParallaxGenPlugin::s_loadOrder;
 
 void ParallaxGenPlugin::loadStatics(ParallaxGenDirectory* pgd) { ParallaxGenPlugin::s_pgd = pgd; }
 
-unordered_map<wstring, int>* ParallaxGenPlugin::s_modPriority;
+vector<int> ParallaxGenPlugin::s_modRanks;
 
-void ParallaxGenPlugin::loadModPriorityMap(std::unordered_map<std::wstring, int>* modPriority)
-{
-    ParallaxGenPlugin::s_modPriority = modPriority;
-}
+void ParallaxGenPlugin::loadModRanks(const vector<int>& modRanks) { ParallaxGenPlugin::s_modRanks = modRanks; }
 
 void ParallaxGenPlugin::initialize(const BethesdaGame& game, const filesystem::path& exePath)
 {
     set_failure_callback(dnneFailure);
 
+    // library messages are pushed into s_logBuffer instead of being polled after every call
+    startLogConsumer();
+    SetLogCallback(&libLogCallback);
+
     // Maps BethesdaGame::GameType to Mutagen game type
     static const unordered_map<BethesdaGame::GameType, int> mutagenGameTypeMap
         = { { BethesdaGame::GameType::SKYRIM, 1 }, { BethesdaGame::GameType::SKYRIM_SE, 2 },
               { BethesdaGame::GameType::SKYRIM_VR, 3 }, { BethesdaGame::GameType::ENDERAL, 5 },
               { BethesdaGame::GameType::ENDERAL_SE, 6 }, { BethesdaGame::GameType::SKYRIM_GOG, 7 } };
 
-    libInitialize(
-        mutagenGameTypeMap.at(game.getGameType()), exePath, game.getGameDataPath().wstring(), game.getActivePlugins());
+    s_dataPath = game.getGameDataPath();
+    s_loadOrder = game.getActivePlugins();
+
+    libInitialize(mutagenGameTypeMap.at(game.getGameType()), exePath, s_dataPath.wstring(), s_loadOrder);
 }
 
-void ParallaxGenPlugin::populateObjs() { libPopulateObjs(); }
+void ParallaxGenPlugin::populateObjs()
+{
+    libPopulateObjs();
+
+    // Snapshot the records so shapes can be matched without going through the library
+    s_index.clear();
+    for (auto& ref : libGetTXSTRefs()) {
+        s_index.addAltTexRef(std::move(ref));
+    }
+
+    for (const auto& txstIndex : s_index.getReferencedTXSTs()) {
+        s_index.setTXSTSlots(txstIndex, libGetTXSTSlots(txstIndex));
+    }
+
+    Logger::debug("Indexed {} plugin alternate textures", s_index.getNumAltTexRefs());
+
+    if (PGDiag::isEnabled()) {
+        // this reads every plugin a second time so we only run it if diagnostics are enabled
+        verifyNativeReader();
+    }
+}
+
+auto ParallaxGenPlugin::getLibraryDifferences(const size_t& maxDifferences) -> vector<wstring>
+{
+    vector<wstring> differences;
+    const auto addDifference = [&](wstring difference) {
+        if (differences.size() < maxDifferences) {
+            differences.push_back(std::move(difference));
+        }
+    };
+
+    // every indexed shape, the same shape of the other weight and the shape after the last indexed one
+    set<pair<wstring, int>> queries;
+    unordered_map<wstring, int> maxIndex3D;
+    for (const auto& ref : s_index.getAltTexRefs()) {
+        queries.emplace(ref.nifName, ref.index3D);
+        if (const auto otherWeightNIF = ParallaxGenPluginIndex::getOtherWeightNIF(ref.nifName);
+            !otherWeightNIF.empty()) {
+            queries.emplace(otherWeightNIF, ref.index3D);
+        }
+
+        auto& curMaxIndex3D = maxIndex3D[ref.nifName];
+        curMaxIndex3D = max(curMaxIndex3D, ref.index3D);
+    }
+    for (const auto& [nifName, index3D] : maxIndex3D) {
+        queries.emplace(nifName, index3D + 1);
+    }
+
+    vector<ParallaxGenPluginIndex::Match> nativeMatches;
+    for (const auto& [nifName, index3D] : queries) {
+        const auto libMatches = libGetMatchingTXSTObjs(nifName, index3D);
+        s_index.getMatches(nifName, index3D, nativeMatches);
+
+        const wstring queryDesc = nifName + L" [" + to_wstring(index3D) + L"]: ";
+        if (libMatches.size() != nativeMatches.size()) {
+            addDifference(queryDesc + L"match count " + to_wstring(nativeMatches.size()) + L" != "
+                + to_wstring(libMatches.size()));
+            continue;
+        }
+
+        for (size_t i = 0; i < libMatches.size(); i++) {
+            const auto& nativeMatch = nativeMatches[i];
+            const auto& libMatch = libMatches[i];
+            if (nativeMatch.txstIndex != libMatch.txstIndex || nativeMatch.altTexIndex != libMatch.altTexIndex
+                || nativeMatch.matchedNIF != libMatch.matchedNIF || nativeMatch.matchType != libMatch.matchType) {
+                addDifference(queryDesc + L"match " + to_wstring(i) + L" TXST " + to_wstring(nativeMatch.txstIndex)
+                    + L" alternate texture " + to_wstring(nativeMatch.altTexIndex) + L" != TXST "
+                    + to_wstring(libMatch.txstIndex) + L" alternate texture " + to_wstring(libMatch.altTexIndex));
+            }
+        }
+    }
+
+    for (const auto& ref : s_index.getAltTexRefs()) {
+        const int libModelRecHandle = libGetModelRecHandleFromAltTexHandle(ref.altTexIndex);
+        if (s_index.getModelRecHandle(ref.altTexIndex) != libModelRecHandle) {
+            addDifference(L"Alternate texture " + to_wstring(ref.altTexIndex) + L": model record "
+                + to_wstring(s_index.getModelRecHandle(ref.altTexIndex)) + L" != " + to_wstring(libModelRecHandle));
+        }
+    }
+
+    return differences;
+}
+
+void ParallaxGenPlugin::verifyNativeReader()
+{
+    try {
+        BethesdaPluginReader reader(s_dataPath);
+        reader.load(s_loadOrder);
+        for (const auto& warning : reader.getWarnings()) {
+            Logger::warn(L"Native plugin reader: {}", warning);
+        }
+        Logger::debug("Native plugin reader read {} TXST records and {} model records", reader.getTXSTs().size(),
+            reader.getModelRecords().size());
+
+        ParallaxGenPluginIndex nativeIndex;
+        reader.buildIndex(nativeIndex);
+
+        const auto differences = s_index.getDifferences(nativeIndex);
+        if (differences.empty()) {
+            Logger::debug("Native plugin reader matches the plugin library");
+            return;
+        }
+
+        for (const auto& difference : differences) {
+            Logger::warn(L"Native plugin reader differs from the plugin library: {}", difference);
+        }
+    } catch (const exception& e) {
+        Logger::warn(L"Native plugin reader failed: {}", ParallaxGenUtil::asciitoUTF16(e.what()));
+    }
+}
+
+auto ParallaxGenPlugin::getThreadOpLog() -> vector<PluginOp>&
+{
+    thread_local shared_ptr<vector<PluginOp>> threadOpLog;
+    if (threadOpLog == nullptr) {
+        threadOpLog = make_shared<vector<PluginOp>>();
+
+        const lock_guard<mutex> lock(s_opLogsMutex);
+        s_opLogs.push_back(threadOpLog);
+    }
+
+    return *threadOpLog;
+}
+
+auto ParallaxGenPlugin::getThreadTXSTRequests() -> NewTXSTRequests&
+{
+    thread_local shared_ptr<NewTXSTRequests> threadTXSTRequests;
+    if (threadTXSTRequests == nullptr) {
+        threadTXSTRequests = make_shared<NewTXSTRequests>();
+
+        const lock_guard<mutex> lock(s_txstRequestsMutex);
+        s_txstRequests.push_back(threadTXSTRequests);
+    }
+
+    return *threadTXSTRequests;
+}
+
+auto ParallaxGenPlugin::makeNewTXSTKey(const NIFUtil::TextureSet& slots) -> NewTXSTKey
+{
+    NewTXSTKey key;
+    for (size_t i = 0; i < NUM_TEXTURE_SLOTS; ++i) {
+        key.slots.at(i) = boost::to_lower_copy(slots.at(i));
+        boost::hash_combine(key.hash, boost::hash<wstring>()(key.slots.at(i)));
+    }
+
+    return key;
+}
+
+auto ParallaxGenPlugin::addNewTXSTRequest(NewTXSTRequests& requests, NewTXSTKey key, NewTXSTRequest request)
+    -> const NewTXSTKey*
+{
+    auto [it, inserted] = requests.try_emplace(std::move(key), std::move(request));
+    if (!inserted && request.altTexIndex < it->second.altTexIndex) {
+        // NOLINTNEXTLINE(bugprone-use-after-move,hicpp-invalid-access-moved) try_emplace does not move on failure
+        it->second = std::move(request);
+    }
+
+    return &it->first;
+}
+
+void ParallaxGenPlugin::assignNewTXSTs(const vector<const NewTXSTRequests*>& requests, vector<NewTXST>& newTXSTs,
+    unordered_map<const NewTXSTKey*, size_t>& keyIndices)
+{
+    newTXSTs.clear();
+    keyIndices.clear();
+
+    vector<pair<const NewTXSTKey*, const NewTXSTRequest*>> allRequests;
+    for (const auto* threadRequests : requests) {
+        for (const auto& [key, request] : *threadRequests) {
+            allRequests.emplace_back(&key, &request);
+        }
+    }
+
+    // slot order names the records, the lowest alternate texture index picks the request that creates them
+    ranges::sort(allRequests, [](const auto& a, const auto& b) {
+        if (a.first->slots != b.first->slots) {
+            return a.first->slots < b.first->slots;
+        }
+
+        return a.second->altTexIndex < b.second->altTexIndex;
+    });
+
+    const NewTXSTKey* lastKey = nullptr;
+    for (const auto& [key, request] : allRequests) {
+        if (lastKey == nullptr || lastKey->slots != key->slots) {
+            newTXSTs.push_back({ .request = request, .edid = fmt::format("PGTXST{:05d}", newTXSTs.size()) });
+            lastKey = key;
+        }
+
+        keyIndices[key] = newTXSTs.size() - 1;
+    }
+}
 
 auto ParallaxGenPlugin::getKeyFromFormID(const tuple<unsigned int, wstring, wstring>& formID) -> string
 {
@@ -410,17 +807,20 @@ auto ParallaxGenPlugin::getKeyFromFormID(const tuple<unsigned int, wstring, wstr
         + format("{:X}", get<0>(formID));
 }
 
-void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nifShape, const int& index3D,
-    PatcherUtil::PatcherMeshObjectSet& patchers, vector<TXSTResult>& results, const string& shapeKey,
-    PatcherUtil::ConflictModResults* conflictMods)
+void ParallaxGenPlugin::getNIFMatches(
+    const wstring& nifPath, const size_t& numShapes, ParallaxGenPluginIndex::NIFMatches& nifMatches)
 {
-    const lock_guard<mutex> lock(s_processShapeMutex);
+    s_index.getNIFMatches(nifPath, numShapes, nifMatches);
+}
 
+void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nifShape, const int& index3D,
+    span<const ParallaxGenPluginIndex::Match> pluginMatches, PatcherUtil::PatcherMeshObjectSet& patchers,
+    vector<TXSTResult>& results, const string& shapeKey, PatcherUtil::ConflictModResults* conflictMods)
+{
     results.clear();
 
     // loop through matches
-    const auto matches = libGetMatchingTXSTObjs(nifPath, index3D);
-    for (const auto& [txstIndex, altTexIndex, matchedNIF, matchType] : matches) {
+    for (const auto& [txstIndex, altTexIndex, matchedNIF, matchType] : pluginMatches) {
         // create keys for diagnostics
         string altTexJSONKey;
         string txstJSONKey;
@@ -444,7 +844,7 @@ void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nif
         // Get TXST slots
         PGDiag::insert("origTXST", txstJSONKey);
 
-        auto oldSlots = libGetTXSTSlots(txstIndex);
+        const auto& oldSlots = s_index.getTXSTSlots(txstIndex);
         auto baseSlots = oldSlots;
         {
             const PGDiag::Prefix diagOrigTexPrefix("origTextures", nlohmann::json::value_t::array);
@@ -461,7 +861,6 @@ void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nif
         }
 
         // Loop through each shader
-        unordered_set<wstring> modSet;
         for (const auto& [shader, patcher] : patchers.shaderPatchers) {
             if (shader == NIFUtil::ShapeShader::NONE) {
                 // TEMPORARILY disable default patcher
@@ -480,7 +879,7 @@ void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nif
 
             for (const auto& match : curMatches) {
                 PatcherUtil::ShaderPatcherMatch curMatch;
-                curMatch.mod = s_pgd->getMod(match.matchedPath);
+                curMatch.modID = s_pgd->getModID(match.matchedPath);
                 curMatch.shader = shader;
                 curMatch.match = match;
                 curMatch.shaderTransformTo = NIFUtil::ShapeShader::UNKNOWN;
@@ -501,28 +900,13 @@ void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nif
                 // Add to matches if shader can apply (or if transform shader exists and can apply)
                 if (patcher->canApply(*nifShape) || curMatch.shaderTransformTo != NIFUtil::ShapeShader::UNKNOWN) {
                     matches.push_back(curMatch);
-                    modSet.insert(curMatch.mod);
                 }
             }
         }
 
         // Populate conflict mods if set
         if (conflictMods != nullptr) {
-            if (modSet.size() > 1) {
-                const lock_guard<mutex> lock(conflictMods->mutex);
-
-                // add mods to conflict set
-                for (const auto& match : matches) {
-                    if (conflictMods->mods.find(match.mod) == conflictMods->mods.end()) {
-                        conflictMods->mods.insert(
-                            { match.mod, { set<NIFUtil::ShapeShader>(), unordered_set<wstring>() } });
-                    }
-
-                    get<0>(conflictMods->mods[match.mod]).insert(match.shader);
-                    get<1>(conflictMods->mods[match.mod]).insert(modSet.begin(), modSet.end());
-                }
-            }
-
+            conflictMods->addMatches(matches);
             continue;
         }
 
@@ -530,19 +914,20 @@ void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nif
         {
             const PGDiag::Prefix diagShaderPatcherPrefix("shaderPatcherMatches", nlohmann::json::value_t::array);
             for (const auto& match : matches) {
-                PGDiag::pushBack(match.getJSON());
+                PGDiag::pushBack(match.getJSON(s_pgd->getModName(match.modID)));
             }
         }
 
         // Get winning match
-        auto winningShaderMatch = PatcherUtil::getWinningMatch(matches, s_modPriority);
-        PGDiag::insert("winningShaderMatch", winningShaderMatch.getJSON());
+        auto winningShaderMatch = PatcherUtil::getWinningMatch(matches, s_modRanks);
+        const auto& winningMod = s_pgd->getModName(winningShaderMatch.modID);
+        PGDiag::insert("winningShaderMatch", winningShaderMatch.getJSON(winningMod));
 
         curResult.matchedNIF = matchedNIF;
 
         // Apply transforms
         if (PatcherUtil::applyTransformIfNeeded(winningShaderMatch, patchers)) {
-            PGDiag::insert("shaderTransformResult", winningShaderMatch.getJSON());
+            PGDiag::insert("shaderTransformResult", winningShaderMatch.getJSON(winningMod));
         }
 
         if (winningShaderMatch.shader == NIFUtil::ShapeShader::UNKNOWN) {
@@ -574,7 +959,7 @@ void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nif
         }
 
         curResult.altTexIndex = altTexIndex;
-        curResult.modelRecHandle = libGetModelRecHandleFromAltTexHandle(altTexIndex);
+        curResult.modelRecHandle = s_index.getModelRecHandle(altTexIndex);
         curResult.matchType = matchType;
 
         if (!foundDiff) {
@@ -587,31 +972,13 @@ void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nif
 
         PGDiag::insert("newTextures", NIFUtil::textureSetToStr(newSlots));
 
-        {
-            const lock_guard<mutex> lock(s_createdTXSTMutex);
-
-            // Check if we need to make a new TXST record
-            if (s_createdTXSTs.contains(newSlots)) {
-                // Already modded
-                spdlog::trace(L"Plugin Patching | {} | {} | Already added, skipping", nifPath, index3D);
-                curResult.txstIndex = s_createdTXSTs[newSlots].first;
-                results.push_back(curResult);
-
-                PGDiag::insert("newTXST", s_createdTXSTs[newSlots].second);
-
-                continue;
-            }
-
-            // Create a new TXST record
-            spdlog::trace(L"Plugin Patching | {} | {} | Creating a new TXST record and patching", nifPath, index3D);
-            const string newEDID = fmt::format("PGTXST{:05d}", s_edidCounter++);
-            curResult.txstIndex = libCreateNewTXSTPatch(altTexIndex, newSlots, newEDID);
-            patchers.shaderPatchers.at(winningShaderMatch.shader)
-                ->processNewTXSTRecord(winningShaderMatch.match, newEDID);
-            s_createdTXSTs[newSlots] = { curResult.txstIndex, newEDID };
-
-            PGDiag::insert("newTXST", newEDID);
-        }
+        // Request a new TXST record, requests of all threads are named and created in savePlugin
+        spdlog::trace(L"Plugin Patching | {} | {} | Requesting a new TXST record and patching", nifPath, index3D);
+        curResult.newTXST = addNewTXSTRequest(getThreadTXSTRequests(), makeNewTXSTKey(newSlots),
+            { .altTexIndex = altTexIndex,
+                .slots = newSlots,
+                .match = winningShaderMatch.match,
+                .writeRecord = patchers.shaderPatchers.at(winningShaderMatch.shader)->getNewTXSTRecordWriter() });
 
         // add to result
         results.push_back(curResult);
@@ -620,10 +987,10 @@ void ParallaxGenPlugin::processShape(const wstring& nifPath, nifly::NiShape* nif
 
 void ParallaxGenPlugin::assignMesh(const wstring& nifPath, const wstring& baseNIFPath, const vector<TXSTResult>& result)
 {
-    const lock_guard<mutex> lock(s_processShapeMutex);
-
     const Logger::Prefix prefix(L"assignMesh");
 
+    auto& opLog = getThreadOpLog();
+
     // Loop through results
     for (const auto& curResult : result) {
         string altTexJSONKey;
@@ -643,30 +1010,36 @@ void ParallaxGenPlugin::assignMesh(const wstring& nifPath, const wstring& baseNI
 
         if (!boost::iequals(curResult.matchedNIF, nifPath)) {
             // Set model rec handle
-            libSetModelRecNIF(curResult.altTexIndex, nifPath);
+            opLog.push_back({ .baseNIF = baseNIFPath,
+                .sequence = opLog.size(),
+                .type = PluginOp::Type::SET_MODEL_REC_NIF,
+                .altTexIndex = curResult.altTexIndex,
+                .nifPath = nifPath });
 
             PGDiag::insert("newModel", nifPath);
         }
 
         // Set model alt tex
-        libSetModelAltTex(curResult.altTexIndex, curResult.txstIndex);
+        opLog.push_back({ .baseNIF = baseNIFPath,
+            .sequence = opLog.size(),
+            .type = PluginOp::Type::SET_MODEL_ALT_TEX,
+            .altTexIndex = curResult.altTexIndex,
+            .value = curResult.txstIndex,
+            .newTXST = curResult.newTXST });
     }
 }
 
-void ParallaxGenPlugin::set3DIndices(
-    const wstring& nifPath, const vector<tuple<nifly::NiShape*, int, int, string>>& shapeTracker)
+void ParallaxGenPlugin::set3DIndices(const wstring& nifPath, const ParallaxGenPluginIndex::NIFMatches& nifMatches,
+    const vector<tuple<nifly::NiShape*, int, int, string>>& shapeTracker)
 {
-    const lock_guard<mutex> lock(s_processShapeMutex);
-
     const Logger::Prefix prefix(L"set3DIndices");
 
+    auto& opLog = getThreadOpLog();
+
     // Loop through shape tracker
     for (const auto& [shape, oldIndex3D, newIndex3D, shapeLabel] : shapeTracker) {
-        // find matches
-        const auto matches = libGetMatchingTXSTObjs(nifPath, oldIndex3D);
-
         // Set indices
-        for (const auto& [txstIndex, altTexIndex, matchedNIF, matchType] : matches) {
+        for (const auto& [txstIndex, altTexIndex, matchedNIF, matchType] : nifMatches.getShapeMatches(oldIndex3D)) {
             if (!boost::iequals(nifPath, matchedNIF)) {
                 // Skip if not the base NIF
                 continue;
@@ -689,9 +1062,120 @@ void ParallaxGenPlugin::set3DIndices(
             PGDiag::insert("newIndex3D", newIndex3D);
 
             Logger::trace(L"Setting 3D index for AltTex {} to {}", altTexIndex, newIndex3D);
-            libSet3DIndex(altTexIndex, newIndex3D);
+            opLog.push_back({ .baseNIF = nifPath,
+                .sequence = opLog.size(),
+                .type = PluginOp::Type::SET_3D_INDEX,
+                .altTexIndex = altTexIndex,
+                .value = newIndex3D });
         }
     }
 }
 
-void ParallaxGenPlugin::savePlugin(const filesystem::path& outputDir, bool esmify) { libFinalize(outputDir, esmify); }
+void ParallaxGenPlugin::applyPluginOps()
+{
+    // Name new TXSTs in slot order so EDIDs do not depend on thread timing, then create them in EDID order
+    vector<NewTXST> newTXSTs;
+    unordered_map<const NewTXSTKey*, size_t> keyIndices;
+    {
+        const lock_guard<mutex> lock(s_txstRequestsMutex);
+
+        vector<const NewTXSTRequests*> requests;
+        requests.reserve(s_txstRequests.size());
+        for (const auto& threadRequests : s_txstRequests) {
+            requests.push_back(threadRequests.get());
+        }
+
+        assignNewTXSTs(requests, newTXSTs, keyIndices);
+    }
+
+    vector<int> newTXSTIndices;
+    newTXSTIndices.reserve(newTXSTs.size());
+    for (const auto& [request, edid] : newTXSTs) {
+        newTXSTIndices.push_back(libCreateNewTXSTPatch(request->altTexIndex, request->slots, edid));
+
+        // patchers that write files for new records (like PBR texture swaps) need the EDID
+        if (request->writeRecord != nullptr) {
+            request->writeRecord(request->match, edid);
+        }
+    }
+
+    // Merge thread logs, all ops of a NIF come from the thread that processed it
+    vector<PluginOp> ops;
+    {
+        const lock_guard<mutex> lock(s_opLogsMutex);
+
+        for (const auto& opLog : s_opLogs) {
+            ops.insert(ops.end(), make_move_iterator(opLog->begin()), make_move_iterator(opLog->end()));
+            opLog->clear();
+        }
+    }
+
+    // Apply in the order meshes are queued for patching, which is the order a single threaded run logs them in
+    unordered_map<wstring, size_t> meshOrder;
+    if (s_pgd != nullptr) {
+        for (const auto& mesh : s_pgd->getMeshes()) {
+            meshOrder.emplace(mesh.wstring(), meshOrder.size());
+        }
+    }
+
+    const auto getMeshOrder = [&meshOrder](const wstring& nifPath) -> size_t {
+        const auto it = meshOrder.find(nifPath);
+        return it != meshOrder.end() ? it->second : meshOrder.size();
+    };
+
+    ranges::sort(ops, [&getMeshOrder](const PluginOp& a, const PluginOp& b) {
+        const size_t aOrder = getMeshOrder(a.baseNIF);
+        const size_t bOrder = getMeshOrder(b.baseNIF);
+        if (aOrder != bOrder) {
+            return aOrder < bOrder;
+        }
+
+        if (a.baseNIF != b.baseNIF) {
+            return a.baseNIF < b.baseNIF;
+        }
+
+        return a.sequence < b.sequence;
+    });
+
+    for (const auto& op : ops) {
+        switch (op.type) {
+        case PluginOp::Type::SET_MODEL_REC_NIF:
+            libSetModelRecNIF(op.altTexIndex, op.nifPath);
+            break;
+        case PluginOp::Type::SET_MODEL_ALT_TEX:
+            libSetModelAltTex(
+                op.altTexIndex, op.newTXST != nullptr ? newTXSTIndices.at(keyIndices.at(op.newTXST)) : op.value);
+            break;
+        case PluginOp::Type::SET_3D_INDEX:
+            libSet3DIndex(op.altTexIndex, op.value);
+            break;
+        }
+    }
+
+    // keys are referenced by the ops, so requests are only released once the ops are applied
+    {
+        const lock_guard<mutex> lock(s_txstRequestsMutex);
+        for (const auto& threadRequests : s_txstRequests) {
+            threadRequests->clear();
+        }
+    }
+
+    Logger::debug("Applied {} plugin changes and created {} texture sets", ops.size(), newTXSTIndices.size());
+}
+
+void ParallaxGenPlugin::savePlugin(const filesystem::path& outputDir, bool esmify)
+{
+    applyPluginOps();
+    libFinalize(outputDir, esmify);
+
+    stopLogConsumer();
+}
+
+void ParallaxGenPlugin::logTestMessages(const int& numMessages, const int& level, const bool& wait)
+{
+    libLogTestMessages(numMessages, level);
+
+    if (wait) {
+        flushLog();
+    }
+}
@@ -0,0 +1,257 @@
+#include "ParallaxGenPluginIndex.hpp"
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+void ParallaxGenPluginIndex::addAltTexRef(AltTexRef ref)
+{
+    const size_t refIndex = m_altTexRefs.size();
+
+    m_refsByNIF[ref.nifName].push_back(refIndex);
+    m_refsByAltTex[ref.altTexIndex] = refIndex;
+    m_altTexRefs.push_back(std::move(ref));
+}
+
+void ParallaxGenPluginIndex::setTXSTSlots(const int& txstIndex, TXSTSlots slots)
+{
+    m_txstSlots[txstIndex] = std::move(slots);
+}
+
+auto ParallaxGenPluginIndex::getReferencedTXSTs() const -> vector<int>
+{
+    vector<int> txstIndices;
+    txstIndices.reserve(m_altTexRefs.size());
+    for (const auto& ref : m_altTexRefs) {
+        txstIndices.push_back(ref.txstIndex);
+    }
+
+    ranges::sort(txstIndices);
+    const auto [first, last] = ranges::unique(txstIndices);
+    txstIndices.erase(first, last);
+
+    return txstIndices;
+}
+
+void ParallaxGenPluginIndex::getMatches(const wstring& nifName, const int& index3D, vector<Match>& matches) const
+{
+    matches.clear();
+
+    const wstring nifNameLower = boost::to_lower_copy(nifName);
+    if (const auto* refs = getNIFRefs(nifNameLower); refs != nullptr) {
+        for (const auto& refIndex : *refs) {
+            const auto& ref = m_altTexRefs[refIndex];
+            if (ref.index3D == index3D) {
+                matches.push_back({ .txstIndex = ref.txstIndex,
+                    .altTexIndex = ref.altTexIndex,
+                    .matchedNIF = nifNameLower,
+                    .matchType = ref.matchType });
+            }
+        }
+    }
+
+    // weighted meshes also match the alternate textures of their other weight
+    const wstring altNIFName = getOtherWeightNIF(nifNameLower);
+    if (const auto* altRefs = getNIFRefs(altNIFName); altRefs != nullptr) {
+        for (const auto& refIndex : *altRefs) {
+            const auto& ref = m_altTexRefs[refIndex];
+            if (ref.index3D == index3D && ref.matchType != "MODL") {
+                // MODL entries are not weighted models
+                matches.push_back({ .txstIndex = ref.txstIndex,
+                    .altTexIndex = ref.altTexIndex,
+                    .matchedNIF = altNIFName,
+                    .matchType = ref.matchType });
+            }
+        }
+    }
+}
+
+void ParallaxGenPluginIndex::getNIFMatches(
+    const wstring& nifName, const size_t& numShapes, NIFMatches& nifMatches) const
+{
+    nifMatches.shapeStart.assign(numShapes + 1, 0);
+    nifMatches.matches.clear();
+
+    const wstring nifNameLower = boost::to_lower_copy(nifName);
+    const wstring altNIFName = getOtherWeightNIF(nifNameLower);
+    const auto* refs = getNIFRefs(nifNameLower);
+    const auto* altRefs = getNIFRefs(altNIFName);
+
+    const auto forEachRef = [&](const auto& func) {
+        if (refs != nullptr) {
+            for (const auto& refIndex : *refs) {
+                func(m_altTexRefs[refIndex], nifNameLower);
+            }
+        }
+
+        if (altRefs != nullptr) {
+            for (const auto& refIndex : *altRefs) {
+                // MODL entries are not weighted models
+                if (m_altTexRefs[refIndex].matchType != "MODL") {
+                    func(m_altTexRefs[refIndex], altNIFName);
+                }
+            }
+        }
+    };
+
+    const auto inRange = [&numShapes](const AltTexRef& ref) {
+        return ref.index3D >= 0 && static_cast<size_t>(ref.index3D) < numShapes;
+    };
+
+    // count matches per shape, then place them so each shape keeps the order of getMatches
+    forEachRef([&](const AltTexRef& ref, [[maybe_unused]] const wstring& matchedNIF) {
+        if (inRange(ref)) {
+            nifMatches.shapeStart[ref.index3D + 1]++;
+        }
+    });
+
+    for (size_t shape = 0; shape < numShapes; shape++) {
+        nifMatches.shapeStart[shape + 1] += nifMatches.shapeStart[shape];
+    }
+
+    nifMatches.matches.resize(nifMatches.shapeStart[numShapes]);
+    vector<uint32_t> cursor(nifMatches.shapeStart.begin(), nifMatches.shapeStart.end() - 1);
+    forEachRef([&](const AltTexRef& ref, const wstring& matchedNIF) {
+        if (inRange(ref)) {
+            nifMatches.matches[cursor[ref.index3D]++] = { .txstIndex = ref.txstIndex,
+                .altTexIndex = ref.altTexIndex,
+                .matchedNIF = matchedNIF,
+                .matchType = ref.matchType };
+        }
+    });
+}
+
+auto ParallaxGenPluginIndex::NIFMatches::getShapeMatches(const int& index3D) const -> span<const Match>
+{
+    if (index3D < 0 || static_cast<size_t>(index3D) + 1 >= shapeStart.size()) {
+        return {};
+    }
+
+    return { matches.begin() + shapeStart[index3D], matches.begin() + shapeStart[index3D + 1] };
+}
+
+auto ParallaxGenPluginIndex::getTXSTSlots(const int& txstIndex) const -> const TXSTSlots&
+{
+    static const TXSTSlots emptySlots;
+
+    const auto it = m_txstSlots.find(txstIndex);
+    if (it == m_txstSlots.end()) {
+        return emptySlots;
+    }
+
+    return it->second;
+}
+
+auto ParallaxGenPluginIndex::getModelRecHandle(const int& altTexIndex) const -> int
+{
+    return m_altTexRefs.at(m_refsByAltTex.at(altTexIndex)).modelRecHandle;
+}
+
+auto ParallaxGenPluginIndex::getAltTexRefs() const -> const vector<AltTexRef>& { return m_altTexRefs; }
+
+auto ParallaxGenPluginIndex::getNumAltTexRefs() const -> size_t { return m_altTexRefs.size(); }
+
+auto ParallaxGenPluginIndex::getDifferences(const ParallaxGenPluginIndex& other, const size_t& maxDifferences) const
+    -> vector<wstring>
+{
+    vector<wstring> differences;
+    const auto addDifference = [&](wstring difference) {
+        if (differences.size() < maxDifferences) {
+            differences.push_back(std::move(difference));
+        }
+    };
+
+    if (m_altTexRefs.size() != other.m_altTexRefs.size()) {
+        addDifference(L"Alternate texture count " + to_wstring(m_altTexRefs.size()) + L" != "
+            + to_wstring(other.m_altTexRefs.size()));
+    }
+
+    for (const auto& ref : m_altTexRefs) {
+        const auto otherIt = other.m_refsByAltTex.find(ref.altTexIndex);
+        const wstring refDesc = L"Alternate texture " + to_wstring(ref.altTexIndex) + L": ";
+        if (otherIt == other.m_refsByAltTex.end()) {
+            addDifference(refDesc + L"missing");
+            continue;
+        }
+
+        const auto& otherRef = other.m_altTexRefs[otherIt->second];
+        if (ref.nifName != otherRef.nifName) {
+            addDifference(refDesc + L"NIF " + ref.nifName + L" != " + otherRef.nifName);
+        }
+        if (ref.index3D != otherRef.index3D) {
+            addDifference(refDesc + L"3D index " + to_wstring(ref.index3D) + L" != " + to_wstring(otherRef.index3D));
+        }
+        if (ref.txstIndex != otherRef.txstIndex) {
+            addDifference(refDesc + L"TXST " + to_wstring(ref.txstIndex) + L" != " + to_wstring(otherRef.txstIndex));
+        }
+        if (ref.modelRecHandle != otherRef.modelRecHandle) {
+            addDifference(refDesc + L"model record " + to_wstring(ref.modelRecHandle) + L" != "
+                + to_wstring(otherRef.modelRecHandle));
+        }
+        if (ref.matchType != otherRef.matchType) {
+            addDifference(refDesc + L"match type " + wstring(ref.matchType.begin(), ref.matchType.end()) + L" != "
+                + wstring(otherRef.matchType.begin(), otherRef.matchType.end()));
+        }
+    }
+
+    for (const auto& otherRef : other.m_altTexRefs) {
+        if (!m_refsByAltTex.contains(otherRef.altTexIndex)) {
+            addDifference(L"Alternate texture " + to_wstring(otherRef.altTexIndex) + L": unexpected");
+        }
+    }
+
+    for (const auto& txstIndex : getReferencedTXSTs()) {
+        const auto& slots = getTXSTSlots(txstIndex);
+        const auto& otherSlots = other.getTXSTSlots(txstIndex);
+        for (size_t slot = 0; slot < NUM_SLOTS; slot++) {
+            if (slots.at(slot) != otherSlots.at(slot)) {
+                addDifference(L"TXST " + to_wstring(txstIndex) + L" slot " + to_wstring(slot) + L": " + slots.at(slot)
+                    + L" != " + otherSlots.at(slot));
+            }
+        }
+    }
+
+    return differences;
+}
+
+void ParallaxGenPluginIndex::clear()
+{
+    m_altTexRefs.clear();
+    m_refsByNIF.clear();
+    m_refsByAltTex.clear();
+    m_txstSlots.clear();
+}
+
+auto ParallaxGenPluginIndex::getOtherWeightNIF(const wstring& nifNameLower) -> wstring
+{
+    static constexpr size_t WEIGHT_SUFFIX_LENGTH = 6;
+
+    if (boost::ends_with(nifNameLower, L"_1.nif")) {
+        return nifNameLower.substr(0, nifNameLower.size() - WEIGHT_SUFFIX_LENGTH) + L"_0.nif";
+    }
+
+    if (boost::ends_with(nifNameLower, L"_0.nif")) {
+        return nifNameLower.substr(0, nifNameLower.size() - WEIGHT_SUFFIX_LENGTH) + L"_1.nif";
+    }
+
+    return {};
+}
+
+auto ParallaxGenPluginIndex::getNIFRefs(const wstring& nifNameLower) const -> const vector<size_t>*
+{
+    if (nifNameLower.empty()) {
+        return nullptr;
+    }
+
+    const auto it = m_refsByNIF.find(nifNameLower);
+    return it != m_refsByNIF.end() ? &it->second : nullptr;
+}
@@ -2,27 +2,45 @@
 
 #include <cpptrace/from_current.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <latch>
+#include <memory>
 #include <mutex>
+#include <numeric>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "ParallaxGenScheduler.hpp"
+#include "ParallaxGenTrace.hpp"
 
 using namespace std;
 
-ParallaxGenRunner::ParallaxGenRunner(const bool& multithread)
-    : m_threadPool(std::thread::hardware_concurrency())
-    , m_multithread(multithread)
+ParallaxGenRunner::ParallaxGenRunner(const bool& multithread, ParallaxGenScheduler* scheduler)
+    : m_multithread(multithread)
+    , m_scheduler(scheduler)
     , m_completedTasks(0)
 {
 }
 
-void ParallaxGenRunner::addTask(const function<void()>& task) { m_tasks.push_back(task); }
+void ParallaxGenRunner::addTask(Task task, const uint64_t& cost)
+{
+    m_tasks.push_back(std::move(task));
+    m_costs.push_back(cost);
+}
 
 void ParallaxGenRunner::runTasks()
 {
+    const ParallaxGenTrace::Span traceSpan("runTasks", [this] { return to_string(m_tasks.size()) + " tasks"; });
+
     if (!m_multithread) {
         CPPTRACE_TRY
         {
-            for (const auto& task : m_tasks) {
+            for (auto& task : m_tasks) {
                 task();
                 m_completedTasks.fetch_add(1);
             }
@@ -35,53 +53,65 @@ void ParallaxGenRunner::runTasks()
         return;
     }
 
-    std::atomic<bool> exceptionThrown;
-    std::exception exception;
-    std::string exceptionStackTrace;
-    std::mutex exceptionMutex;
-
     // Multithreading only beyond this point
-    for (const auto& task : m_tasks) {
-        boost::asio::post(
-            m_threadPool, [this, task, &exceptionThrown, &exception, &exceptionStackTrace, &exceptionMutex] {
-                if (exceptionThrown.load()) {
-                    // Exception already thrown, don't run thread
-                    return;
-                }
-
-                CPPTRACE_TRY
-                {
-                    task();
-                    m_completedTasks.fetch_add(1);
-                }
-                CPPTRACE_CATCH(const class exception& e)
-                {
-                    if (!exceptionThrown.load()) {
-                        const lock_guard<mutex> lock(exceptionMutex);
-                        exception = e;
-                        exceptionStackTrace = cpptrace::from_current_exception().to_string();
-                        exceptionThrown.store(true);
-                    }
-                }
-            });
+    if (m_tasks.empty()) {
+        return;
     }
 
-    while (true) {
-        // Check if all tasks are done
-        if (m_completedTasks.load() >= m_tasks.size()) {
-            // All tasks done
-            break;
+    auto& scheduler = m_scheduler != nullptr ? *m_scheduler : ParallaxGenScheduler::get();
+
+    // Longest processing time first: place the most expensive tasks where the workers start
+    m_order.resize(m_tasks.size());
+    iota(m_order.begin(), m_order.end(), 0);
+    if (ranges::any_of(m_costs, [](const uint64_t& cost) { return cost > 0; })) {
+        vector<size_t> byCost(m_tasks.size());
+        iota(byCost.begin(), byCost.end(), 0);
+        ranges::stable_sort(byCost, [this](const size_t& a, const size_t& b) { return m_costs[a] > m_costs[b]; });
+
+        const auto startOrder = scheduler.getStartOrder(m_tasks.size());
+        for (size_t rank = 0; rank < byCost.size(); rank++) {
+            m_order[startOrder[rank]] = byCost[rank];
         }
+    }
 
-        // If exception stop thread pool and throw
-        if (exceptionThrown.load()) {
-            m_threadPool.stop();
-            processException(exception, exceptionStackTrace, false);
+    m_done = make_unique<latch>(static_cast<ptrdiff_t>(m_tasks.size()));
+    scheduler.submit(runTask, this, m_tasks.size());
+
+    // Help with queued work until nothing is left to take, then wait for the tasks still running elsewhere
+    while (!m_done->try_wait()) {
+        if (!scheduler.runPending()) {
+            m_done->wait();
         }
+    }
+
+    if (m_exceptionThrown.load()) {
+        processException(m_exception, m_exceptionStackTrace, false);
+    }
+}
+
+void ParallaxGenRunner::runTask(void* runner, const size_t& index)
+{
+    auto* const self = static_cast<ParallaxGenRunner*>(runner);
 
-        // Sleep in between loops
-        this_thread::sleep_for(chrono::milliseconds(LOOP_INTERVAL));
+    if (!self->m_exceptionThrown.load()) {
+        CPPTRACE_TRY
+        {
+            self->m_tasks[self->m_order[index]]();
+            self->m_completedTasks.fetch_add(1);
+        }
+        CPPTRACE_CATCH(const exception& e)
+        {
+            const lock_guard<mutex> lock(self->m_exceptionMutex);
+            if (!self->m_exceptionThrown.load()) {
+                self->m_exception = e;
+                self->m_exceptionStackTrace = cpptrace::from_current_exception().to_string();
+                self->m_exceptionThrown.store(true);
+            }
+        }
     }
+
+    // Tasks after an exception are skipped but still counted down so runTasks can return
+    self->m_done->count_down();
 }
 
 void ParallaxGenRunner::processException(const exception& e, const string& stacktrace)
@@ -0,0 +1,214 @@
+#include "ParallaxGenScheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace {
+// scheduler and queue of the calling thread if it is a worker
+thread_local const ParallaxGenScheduler* t_scheduler = nullptr;
+thread_local size_t t_workerIndex = SIZE_MAX;
+} // namespace
+
+auto ParallaxGenScheduler::get() -> ParallaxGenScheduler&
+{
+    // never destroyed: an exit() during a run must not join workers that are still in the middle of jobs
+    static auto* scheduler = new ParallaxGenScheduler();
+    return *scheduler;
+}
+
+ParallaxGenScheduler::ParallaxGenScheduler(const size_t& numThreads)
+{
+    const size_t numWorkers = numThreads > 0 ? numThreads : max<size_t>(thread::hardware_concurrency(), 1);
+
+    m_queues.reserve(numWorkers);
+    for (size_t i = 0; i < numWorkers; i++) {
+        m_queues.push_back(make_unique<WorkerQueue>());
+    }
+
+    m_workers.reserve(numWorkers);
+    for (size_t i = 0; i < numWorkers; i++) {
+        m_workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ParallaxGenScheduler::~ParallaxGenScheduler()
+{
+    m_stop.store(true);
+    m_signal.fetch_add(1);
+    m_signal.notify_all();
+
+    for (auto& worker : m_workers) {
+        if (worker.get_id() == this_thread::get_id()) {
+            // destroyed from one of its own jobs, joining would throw
+            worker.detach();
+            continue;
+        }
+
+        worker.join();
+    }
+}
+
+void ParallaxGenScheduler::submit(JobFunc func, void* context, const size_t& count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // one contiguous chunk per worker, workers split their chunk further and steal from each other when uneven
+    const size_t numChunks = min(count, m_queues.size());
+    const size_t firstQueue = m_nextQueue.fetch_add(numChunks, memory_order_relaxed);
+    for (size_t chunk = 0; chunk < numChunks; chunk++) {
+        const size_t begin = count * chunk / numChunks;
+        const size_t end = count * (chunk + 1) / numChunks;
+        pushJob((firstQueue + chunk) % m_queues.size(),
+            { .func = func, .context = context, .begin = begin, .end = end });
+    }
+
+    wakeWorkers();
+}
+
+auto ParallaxGenScheduler::getStartOrder(const size_t& count) const -> vector<size_t>
+{
+    vector<size_t> order;
+    order.reserve(count);
+
+    // same chunks as submit
+    const size_t numChunks = min(count, m_queues.size());
+    for (size_t offset = 0; order.size() < count; offset++) {
+        for (size_t chunk = 0; chunk < numChunks; chunk++) {
+            const size_t index = (count * chunk / numChunks) + offset;
+            if (index < count * (chunk + 1) / numChunks) {
+                order.push_back(index);
+            }
+        }
+    }
+
+    return order;
+}
+
+auto ParallaxGenScheduler::runPending() -> bool
+{
+    const size_t workerIndex = t_scheduler == this ? t_workerIndex : SIZE_MAX;
+
+    Job job;
+    if (!takeJob(workerIndex, job)) {
+        return false;
+    }
+
+    runJob(workerIndex, job);
+    return true;
+}
+
+auto ParallaxGenScheduler::getNumThreads() const -> size_t { return m_workers.size(); }
+
+void ParallaxGenScheduler::workerLoop(const size_t& workerIndex)
+{
+    t_scheduler = this;
+    t_workerIndex = workerIndex;
+
+    int idleRounds = 0;
+    Job job;
+    // leave on stop without draining the queues, jobs that have not started are dropped
+    while (!m_stop.load()) {
+        if (takeJob(workerIndex, job)) {
+            runJob(workerIndex, job);
+            idleRounds = 0;
+            continue;
+        }
+
+        if (++idleRounds < SPIN_COUNT) {
+            this_thread::yield();
+            continue;
+        }
+
+        // read the signal before the last look at the queues so a push after that look wakes the wait right away
+        const uint32_t signal = m_signal.load();
+        m_numSleeping.fetch_add(1);
+        if (takeJob(workerIndex, job)) {
+            m_numSleeping.fetch_sub(1);
+            runJob(workerIndex, job);
+            idleRounds = 0;
+            continue;
+        }
+
+        if (!m_stop.load()) {
+            m_signal.wait(signal);
+        }
+        m_numSleeping.fetch_sub(1);
+        idleRounds = 0;
+    }
+}
+
+auto ParallaxGenScheduler::takeJob(const size_t& workerIndex, Job& job) -> bool
+{
+    if (workerIndex < m_queues.size()) {
+        auto& ownQueue = *m_queues[workerIndex];
+        const lock_guard<mutex> lock(ownQueue.mutex);
+        if (!ownQueue.jobs.empty()) {
+            job = ownQueue.jobs.back();
+            ownQueue.jobs.pop_back();
+            return true;
+        }
+    }
+
+    // steal the oldest and largest range of another queue, start after the own queue so thieves spread out
+    const size_t numQueues = m_queues.size();
+    const size_t start = workerIndex < numQueues ? workerIndex + 1 : 0;
+    for (size_t offset = 0; offset < numQueues; offset++) {
+        const size_t queueIndex = (start + offset) % numQueues;
+        if (queueIndex == workerIndex) {
+            continue;
+        }
+
+        auto& queue = *m_queues[queueIndex];
+        const unique_lock<mutex> lock(queue.mutex, try_to_lock);
+        if (!lock.owns_lock() || queue.jobs.empty()) {
+            continue;
+        }
+
+        job = queue.jobs.front();
+        queue.jobs.pop_front();
+        return true;
+    }
+
+    return false;
+}
+
+void ParallaxGenScheduler::runJob(const size_t& workerIndex, Job job)
+{
+    while (job.end - job.begin > 1) {
+        const size_t mid = job.begin + ((job.end - job.begin) / 2);
+        const size_t queueIndex = workerIndex < m_queues.size()
+            ? workerIndex
+            : m_nextQueue.fetch_add(1, memory_order_relaxed) % m_queues.size();
+
+        pushJob(queueIndex, { .func = job.func, .context = job.context, .begin = mid, .end = job.end });
+        wakeWorkers();
+
+        job.end = mid;
+    }
+
+    job.func(job.context, job.begin);
+}
+
+void ParallaxGenScheduler::pushJob(const size_t& queueIndex, const Job& job)
+{
+    auto& queue = *m_queues[queueIndex];
+    const lock_guard<mutex> lock(queue.mutex);
+    queue.jobs.push_back(job);
+}
+
+void ParallaxGenScheduler::wakeWorkers()
+{
+    // always bump the signal, a worker about to sleep compares against it, only pay for the notify if one sleeps
+    m_signal.fetch_add(1);
+    if (m_numSleeping.load() > 0) {
+        m_signal.notify_all();
+    }
+}
@@ -0,0 +1,70 @@
+#include "ParallaxGenSuffixTrie.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+ParallaxGenSuffixTrie::ParallaxGenSuffixTrie()
+    : m_trieIds(1)
+{
+}
+
+void ParallaxGenSuffixTrie::addSuffix(const wstring& suffix, const size_t& id)
+{
+    const uint32_t node = m_trie.insert(suffix, true);
+    m_trieIds.resize(m_trie.getNumNodes());
+
+    m_trieIds[node].push_back(id);
+    m_numSuffixes++;
+    m_built = false;
+}
+
+void ParallaxGenSuffixTrie::build()
+{
+    m_trie.build();
+    const size_t numNodes = m_trie.getNumNodes();
+
+    m_idStart.assign(numNodes + 1, 0);
+    m_ids.clear();
+    m_ids.reserve(m_numSuffixes);
+    for (size_t node = 0; node < numNodes; node++) {
+        m_idStart[node] = static_cast<uint32_t>(m_ids.size());
+        m_ids.insert(m_ids.end(), m_trieIds[node].begin(), m_trieIds[node].end());
+    }
+    m_idStart[numNodes] = static_cast<uint32_t>(m_ids.size());
+
+    m_built = true;
+}
+
+void ParallaxGenSuffixTrie::findSuffixes(const wstring& text, const size_t& minLength, vector<size_t>& ids) const
+{
+    ids.clear();
+
+    if (!m_built) {
+        return;
+    }
+
+    uint32_t node = ROOT;
+    size_t depth = 0;
+    for (auto textIt = text.rbegin(); textIt != text.rend(); ++textIt) {
+        node = m_trie.findEdge(node, ParallaxGenCharTrie::toLower(*textIt));
+        if (node == ROOT) {
+            break;
+        }
+
+        depth++;
+        if (depth >= minLength) {
+            ids.insert(ids.end(), m_ids.begin() + m_idStart[node], m_ids.begin() + m_idStart[node + 1]);
+        }
+    }
+
+    ranges::sort(ids);
+    const auto [first, last] = ranges::unique(ids);
+    ids.erase(first, last);
+}
+
+auto ParallaxGenSuffixTrie::getNumSuffixes() const -> size_t { return m_numSuffixes; }
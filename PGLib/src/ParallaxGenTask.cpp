@@ -1,9 +1,34 @@
 #include "ParallaxGenTask.hpp"
 
+#include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
 using namespace std;
 
+namespace {
+const array<string, 3> PG_RESULT_STR = { "COMPLETED", "COMPLETED WITH WARNINGS", "FAILED" };
+
+// threads are spread over the counter shards in the order they first complete a job
+atomic<size_t> s_nextShard = 0;
+thread_local const size_t t_shardIndex = s_nextShard.fetch_add(1, memory_order_relaxed);
+
+constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+} // namespace
+
 ParallaxGenTask::ParallaxGenTask(string taskName, const size_t& totalJobs, const int& progressPrintModulo)
     : m_progressPrintModulo(progressPrintModulo)
     , m_taskName(std::move(taskName))
@@ -12,76 +37,193 @@ ParallaxGenTask::ParallaxGenTask(string taskName, const size_t& totalJobs, const
     initJobStatus();
 }
 
-void ParallaxGenTask::completeJob(const PGResult& result)
+ParallaxGenTask::~ParallaxGenTask()
 {
-    // Use lock_guard to make this method thread-safe
-    const lock_guard<mutex> lock(m_numJobsCompletedMutex);
+    if (!m_reporter.joinable()) {
+        return;
+    }
 
-    m_numJobsCompleted[result]++;
-    printJobStatus();
+    {
+        const lock_guard<mutex> lock(m_reporterMutex);
+        m_stopReporter = true;
+    }
+    m_reporterCV.notify_one();
+    m_reporter.join();
 }
 
-void ParallaxGenTask::initJobStatus()
+void ParallaxGenTask::completeJob(const PGResult& result, const uint64_t& numBytes)
 {
-    m_lastPerc = 0;
+    // only this shard's cache line is written, the reporter thread sums the shards when it samples
+    auto& shard = getShard();
+    shard.numJobsCompleted[static_cast<size_t>(result)].fetch_add(1, memory_order_relaxed);
+    if (numBytes > 0) {
+        shard.numBytesCompleted.fetch_add(numBytes, memory_order_relaxed);
+    }
+}
 
-    // Initialize all known PGResult values
-    m_numJobsCompleted[PGResult::FAILURE] = 0;
-    m_numJobsCompleted[PGResult::SUCCESS] = 0;
-    m_numJobsCompleted[PGResult::SUCCESS_WITH_WARNINGS] = 0;
+void ParallaxGenTask::setProgressFD(const int& fd)
+{
+    const lock_guard<mutex> lock(s_progressFDMutex);
+    s_progressFD.store(fd);
+}
 
+void ParallaxGenTask::initJobStatus()
+{
     spdlog::info("{} Starting...", m_taskName);
+
+    m_startTime = chrono::steady_clock::now();
+    m_lastSampleTime = m_startTime;
+
+    if (m_totalJobs > 0) {
+        m_reporter = thread([this] { reporterLoop(); });
+    }
+}
+
+void ParallaxGenTask::reporterLoop()
+{
+    unique_lock<mutex> lock(m_reporterMutex);
+    while (!m_reporterCV.wait_for(lock, REPORT_INTERVAL, [this] { return m_stopReporter; })) {
+        sampleJobStatus();
+        if (m_summaryPrinted) {
+            return;
+        }
+    }
+
+    // last sample when the task goes out of scope
+    sampleJobStatus();
 }
 
-void ParallaxGenTask::printJobStatus(bool force)
+void ParallaxGenTask::sampleJobStatus()
 {
-    size_t combinedJobs = getCompletedJobs();
-    size_t perc = combinedJobs * FULL_PERCENTAGE / m_totalJobs;
-    if (force || perc != m_lastPerc) {
-        m_lastPerc = perc;
+    const auto now = chrono::steady_clock::now();
+    const auto numJobsCompleted = getCompletedJobs();
 
-        if (perc % m_progressPrintModulo == 0) {
-            spdlog::info("{} Progress: {}/{} [{}%]", m_taskName, combinedJobs, m_totalJobs, perc);
+    size_t combinedJobs = 0;
+    for (const auto& numJobs : numJobsCompleted) {
+        combinedJobs += numJobs;
+    }
+
+    uint64_t combinedBytes = 0;
+    for (const auto& shard : m_shards) {
+        combinedBytes += shard.numBytesCompleted.load(memory_order_relaxed);
+    }
+
+    // rates are averaged over the last samples so the ETA follows the current speed of the task
+    const double sampleSec = chrono::duration<double>(now - m_lastSampleTime).count();
+    if (sampleSec > 0.0) {
+        const double jobsPerSec = static_cast<double>(combinedJobs - m_lastSampleJobs) / sampleSec;
+        const double bytesPerSec = static_cast<double>(combinedBytes - m_lastSampleBytes) / sampleSec;
+        const bool firstSample = m_lastSampleTime == m_startTime;
+        const auto smooth = [&firstSample](const double& average, const double& sample) -> double {
+            return firstSample ? sample : (RATE_SMOOTHING * sample) + ((1.0 - RATE_SMOOTHING) * average);
+        };
+        m_jobsPerSec = smooth(m_jobsPerSec, jobsPerSec);
+        m_bytesPerSec = smooth(m_bytesPerSec, bytesPerSec);
+    }
+    m_lastSampleTime = now;
+    m_lastSampleJobs = combinedJobs;
+    m_lastSampleBytes = combinedBytes;
+
+    const bool done = combinedJobs >= m_totalJobs;
+    const size_t perc = combinedJobs * FULL_PERCENTAGE / m_totalJobs;
+    const double etaSec
+        = done ? 0.0 : (m_jobsPerSec > 0.0 ? static_cast<double>(m_totalJobs - combinedJobs) / m_jobsPerSec : -1.0);
+
+    const size_t step = perc / static_cast<size_t>(m_progressPrintModulo);
+    if (step != m_lastPrintedStep) {
+        m_lastPrintedStep = step;
+
+        string rateStr = fmt::format("{:.0f} jobs/s", m_jobsPerSec);
+        if (combinedBytes > 0) {
+            rateStr += fmt::format(", {:.1f} MB/s", m_bytesPerSec / BYTES_PER_MB);
+        }
+        if (etaSec > 0.0) {
+            rateStr += fmt::format(", ETA {:.0f}s", etaSec);
         }
+
+        spdlog::info("{} Progress: {}/{} [{}%] {}", m_taskName, combinedJobs, m_totalJobs, perc, rateStr);
+    }
+
+    if (s_progressFD.load() >= 0) {
+        auto results = nlohmann::json::object();
+        for (size_t result = 0; result < NUM_RESULTS; result++) {
+            results[PG_RESULT_STR.at(result)] = numJobsCompleted.at(result);
+        }
+
+        const nlohmann::json progressJSON = { { "task", m_taskName }, { "completed", combinedJobs },
+            { "total", m_totalJobs }, { "percent", perc }, { "bytes", combinedBytes }, { "jobsPerSec", m_jobsPerSec },
+            { "bytesPerSec", m_bytesPerSec }, { "etaSec", etaSec },
+            { "elapsedSec", chrono::duration<double>(now - m_startTime).count() }, { "done", done },
+            { "results", results } };
+        writeProgressLine(progressJSON.dump() + "\n");
     }
 
-    if (perc == FULL_PERCENTAGE) {
-        printJobSummary();
+    if (done && !m_summaryPrinted) {
+        m_summaryPrinted = true;
+        printJobSummary(numJobsCompleted);
     }
 }
 
-void ParallaxGenTask::printJobSummary()
+void ParallaxGenTask::printJobSummary(const array<size_t, NUM_RESULTS>& numJobsCompleted)
 {
     // Print each job status Result
     string outputLog = m_taskName + " Summary: ";
-    for (const auto& pair : m_numJobsCompleted) {
-        if (pair.second > 0) {
-            const string stateStr = m_pgResultStr[pair.first];
-            outputLog += "[ " + stateStr + " : " + to_string(pair.second) + " ] ";
+    for (size_t result = 0; result < NUM_RESULTS; result++) {
+        if (numJobsCompleted.at(result) > 0) {
+            outputLog += "[ " + PG_RESULT_STR.at(result) + " : " + to_string(numJobsCompleted.at(result)) + " ] ";
         }
     }
     outputLog += "See log to see error messages, if any.";
     spdlog::info(outputLog);
 }
 
-auto ParallaxGenTask::getCompletedJobs() -> size_t
+void ParallaxGenTask::writeProgressLine(const string& line)
 {
-    // Initialize the Sum variable
-    size_t sum = 0;
+    // one write per line under the lock, so lines of tasks running side by side do not interleave
+    const lock_guard<mutex> lock(s_progressFDMutex);
+    const int fd = s_progressFD.load();
+    if (fd < 0) {
+        return;
+    }
 
-    // Iterate through the unordered_map and sum the values
-    for (const auto& pair : m_numJobsCompleted) {
-        sum += pair.second;
+    size_t written = 0;
+    while (written < line.size()) {
+#ifdef _WIN32
+        const auto result = _write(fd, line.data() + written, static_cast<unsigned int>(line.size() - written));
+#else
+        const auto result = write(fd, line.data() + written, line.size() - written);
+#endif
+        if (result <= 0) {
+            spdlog::warn("Failed to write progress to file descriptor {}, disabling progress output", fd);
+            s_progressFD.store(-1);
+            return;
+        }
+        written += static_cast<size_t>(result);
     }
+}
 
-    return sum;
+auto ParallaxGenTask::getCompletedJobs() const -> array<size_t, NUM_RESULTS>
+{
+    array<size_t, NUM_RESULTS> numJobsCompleted {};
+    for (const auto& shard : m_shards) {
+        for (size_t result = 0; result < NUM_RESULTS; result++) {
+            numJobsCompleted.at(result) += shard.numJobsCompleted.at(result).load(memory_order_relaxed);
+        }
+    }
+
+    return numJobsCompleted;
 }
 
-auto ParallaxGenTask::isCompleted() -> bool
+auto ParallaxGenTask::getShard() -> CounterShard& { return m_shards.at(t_shardIndex % NUM_SHARDS); }
+
+auto ParallaxGenTask::isCompleted() const -> bool
 {
-    const lock_guard<mutex> lock(m_numJobsCompletedMutex);
+    size_t sum = 0;
+    for (const auto& numJobs : getCompletedJobs()) {
+        sum += numJobs;
+    }
 
-    return getCompletedJobs() == m_totalJobs;
+    return sum == m_totalJobs;
 }
 
 void ParallaxGenTask::updatePGResult(PGResult& result, const PGResult& currentResult, const PGResult& threshold)
@@ -0,0 +1,198 @@
+#include "ParallaxGenTextureCache.hpp"
+
+#include "Logger.hpp"
+#include "ParallaxGenUtil.hpp"
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <utility>
+
+using namespace std;
+using namespace ParallaxGenUtil;
+
+ParallaxGenTextureCache::ParallaxGenTextureCache(filesystem::path cacheFile)
+    : m_cacheFile(std::move(cacheFile))
+{
+}
+
+auto ParallaxGenTextureCache::load() -> bool
+{
+    const lock_guard<mutex> lock(m_entriesMutex);
+    m_entries.clear();
+
+    if (!filesystem::exists(m_cacheFile)) {
+        spdlog::debug(L"Texture cache {} does not exist, starting with an empty cache", m_cacheFile.wstring());
+        return false;
+    }
+
+    ifstream cacheFileF(m_cacheFile);
+    const auto j = nlohmann::json::parse(cacheFileF, nullptr, false);
+    if (j.is_discarded() || !j.is_object() || !j.contains("version") || j["version"] != CACHE_VERSION
+        || !j.contains("textures") || !j["textures"].is_object()) {
+        spdlog::warn(L"Texture cache {} is invalid or outdated, starting with an empty cache", m_cacheFile.wstring());
+        return false;
+    }
+
+    try {
+        for (const auto& [path, texture] : j["textures"].items()) {
+            Entry entry;
+            entry.fingerprint.source = utf8toUTF16(texture.at("source").get<string>());
+            entry.fingerprint.size = texture.at("size").get<uintmax_t>();
+            entry.fingerprint.lastWriteTime = texture.at("mtime").get<int64_t>();
+
+            if (texture.contains("meta")) {
+                const auto& meta = texture["meta"];
+                entry.hasMetadata = true;
+                entry.metadata.width = meta.at(0).get<size_t>();
+                entry.metadata.height = meta.at(1).get<size_t>();
+                entry.metadata.depth = meta.at(2).get<size_t>();
+                entry.metadata.arraySize = meta.at(3).get<size_t>();
+                entry.metadata.mipLevels = meta.at(4).get<size_t>();
+                entry.metadata.miscFlags = meta.at(5).get<uint32_t>();
+                entry.metadata.miscFlags2 = meta.at(6).get<uint32_t>();
+                entry.metadata.format = static_cast<DXGI_FORMAT>(meta.at(7).get<int>());
+                entry.metadata.dimension = static_cast<DirectX::TEX_DIMENSION>(meta.at(8).get<int>());
+            }
+
+            if (texture.contains("cm")) {
+                const auto& cm = texture["cm"];
+                entry.cmChecked = true;
+                entry.isCM = cm.at(0).get<bool>();
+                entry.hasEnvMask = cm.at(1).get<bool>();
+                entry.hasGlossiness = cm.at(2).get<bool>();
+                entry.hasMetalness = cm.at(3).get<bool>();
+            }
+
+            m_entries[utf8toUTF16(path)] = { .entry = std::move(entry), .used = false };
+        }
+    } catch (const exception& e) {
+        spdlog::warn(L"Failed to read texture cache {}, starting with an empty cache: {}", m_cacheFile.wstring(),
+            asciitoUTF16(e.what()));
+        m_entries.clear();
+        return false;
+    }
+
+    spdlog::debug("Loaded {} entries from texture cache", m_entries.size());
+    return true;
+}
+
+auto ParallaxGenTextureCache::save() -> bool
+{
+    const lock_guard<mutex> lock(m_entriesMutex);
+
+    auto textures = nlohmann::json::object();
+    for (const auto& [path, cacheEntry] : m_entries) {
+        if (!cacheEntry.used) {
+            // file was not seen this run (removed from the load order)
+            continue;
+        }
+
+        const auto& entry = cacheEntry.entry;
+        auto texture = nlohmann::json::object();
+        texture["source"] = utf16toUTF8(entry.fingerprint.source);
+        texture["size"] = entry.fingerprint.size;
+        texture["mtime"] = entry.fingerprint.lastWriteTime;
+
+        if (entry.hasMetadata) {
+            texture["meta"] = { entry.metadata.width, entry.metadata.height, entry.metadata.depth,
+                entry.metadata.arraySize, entry.metadata.mipLevels, entry.metadata.miscFlags,
+                entry.metadata.miscFlags2, static_cast<int>(entry.metadata.format),
+                static_cast<int>(entry.metadata.dimension) };
+        }
+
+        if (entry.cmChecked) {
+            texture["cm"] = { entry.isCM, entry.hasEnvMask, entry.hasGlossiness, entry.hasMetalness };
+        }
+
+        textures[utf16toUTF8(path.wstring())] = std::move(texture);
+    }
+
+    nlohmann::json j;
+    j["version"] = CACHE_VERSION;
+    j["textures"] = std::move(textures);
+
+    try {
+        filesystem::create_directories(m_cacheFile.parent_path());
+
+        ofstream cacheFileF(m_cacheFile);
+        cacheFileF << j.dump();
+        if (!cacheFileF) {
+            spdlog::warn(L"Failed to write texture cache {}", m_cacheFile.wstring());
+            return false;
+        }
+    } catch (const exception& e) {
+        spdlog::warn(L"Failed to write texture cache {}: {}", m_cacheFile.wstring(), asciitoUTF16(e.what()));
+        return false;
+    }
+
+    return true;
+}
+
+auto ParallaxGenTextureCache::lookup(
+    const filesystem::path& relPath, const BethesdaDirectory::FileFingerprint& fingerprint, Entry& entry) -> bool
+{
+    const lock_guard<mutex> lock(m_entriesMutex);
+
+    auto it = m_entries.find(BethesdaDirectory::getAsciiPathLower(relPath));
+    if (it == m_entries.end() || it->second.entry.fingerprint != fingerprint) {
+        m_numMisses++;
+        return false;
+    }
+
+    it->second.used = true;
+    entry = it->second.entry;
+    m_numHits++;
+    return true;
+}
+
+void ParallaxGenTextureCache::updateMetadata(const filesystem::path& relPath,
+    const BethesdaDirectory::FileFingerprint& fingerprint, const DirectX::TexMetadata& metadata)
+{
+    const lock_guard<mutex> lock(m_entriesMutex);
+
+    auto& entry = getEntryForUpdate(relPath, fingerprint);
+    entry.hasMetadata = true;
+    entry.metadata = metadata;
+}
+
+void ParallaxGenTextureCache::updateCM(const filesystem::path& relPath,
+    const BethesdaDirectory::FileFingerprint& fingerprint, const bool& isCM, const bool& hasEnvMask,
+    const bool& hasGlossiness, const bool& hasMetalness)
+{
+    const lock_guard<mutex> lock(m_entriesMutex);
+
+    auto& entry = getEntryForUpdate(relPath, fingerprint);
+    entry.cmChecked = true;
+    entry.isCM = isCM;
+    entry.hasEnvMask = hasEnvMask;
+    entry.hasGlossiness = hasGlossiness;
+    entry.hasMetalness = hasMetalness;
+}
+
+void ParallaxGenTextureCache::logStats()
+{
+    const lock_guard<mutex> lock(m_entriesMutex);
+
+    const size_t numLookups = m_numHits + m_numMisses;
+    const double hitRate
+        = numLookups > 0 ? static_cast<double>(m_numHits) * PERCENT / static_cast<double>(numLookups) : 0.0;
+    Logger::info("Texture cache: {} hits, {} misses ({:.1f}% hit rate)", m_numHits, m_numMisses, hitRate);
+}
+
+auto ParallaxGenTextureCache::getEntryForUpdate(
+    const filesystem::path& relPath, const BethesdaDirectory::FileFingerprint& fingerprint) -> Entry&
+{
+    auto& cacheEntry = m_entries[BethesdaDirectory::getAsciiPathLower(relPath)];
+    if (cacheEntry.entry.fingerprint != fingerprint) {
+        cacheEntry.entry = Entry {};
+        cacheEntry.entry.fingerprint = fingerprint;
+    }
+
+    cacheEntry.used = true;
+    return cacheEntry.entry;
+}
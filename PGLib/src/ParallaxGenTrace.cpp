@@ -0,0 +1,159 @@
+#include "ParallaxGenTrace.hpp"
+
+#include "ParallaxGenUtil.hpp"
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t EVENTS_PER_CHUNK = 4096;
+constexpr double NS_PER_US = 1000.0;
+
+struct TraceEvent {
+    const char* name = nullptr;
+    string detail;
+    int64_t startNS {};
+    int64_t endNS {};
+};
+
+/**
+ * @struct TraceChunk
+ * @brief Fixed block of events, only the owning thread writes, save reads up to numEvents
+ */
+struct TraceChunk {
+    array<TraceEvent, EVENTS_PER_CHUNK> events;
+    atomic<size_t> numEvents = 0;
+    atomic<TraceChunk*> next = nullptr;
+    unique_ptr<TraceChunk> nextOwner;
+};
+
+struct ThreadBuffer {
+    size_t threadIndex {};
+    TraceChunk head;
+    TraceChunk* tail = &head;
+};
+
+// buffers are never freed before exit, so spans of finished threads can still be saved
+mutex s_buffersMutex;
+vector<unique_ptr<ThreadBuffer>> s_buffers;
+atomic<int64_t> s_epochNS = 0;
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+auto getThreadBuffer() -> ThreadBuffer&
+{
+    if (t_buffer == nullptr) {
+        // once per thread, not on the record path
+        const lock_guard<mutex> lock(s_buffersMutex);
+        s_buffers.push_back(make_unique<ThreadBuffer>());
+        s_buffers.back()->threadIndex = s_buffers.size();
+        t_buffer = s_buffers.back().get();
+    }
+
+    return *t_buffer;
+}
+
+auto toUS(const int64_t& ns) -> double { return static_cast<double>(ns) / NS_PER_US; }
+} // namespace
+
+ParallaxGenTrace::Span::Span(const char* name, const filesystem::path& detail)
+    : Span(name)
+{
+    if (m_startNS >= 0) {
+        setDetail(detail.wstring());
+    }
+}
+
+void ParallaxGenTrace::Span::setDetail(const string& detail) { m_detail = detail; }
+
+void ParallaxGenTrace::Span::setDetail(const wstring& detail) { m_detail = ParallaxGenUtil::utf16toUTF8(detail); }
+
+void ParallaxGenTrace::enable()
+{
+    s_epochNS.store(getNowNS());
+    s_enabled.store(true);
+}
+
+void ParallaxGenTrace::disable() { s_enabled.store(false); }
+
+void ParallaxGenTrace::record(const char* name, string&& detail, const int64_t& startNS, const int64_t& endNS)
+{
+    auto& buffer = getThreadBuffer();
+
+    TraceChunk* chunk = buffer.tail;
+    size_t numEvents = chunk->numEvents.load(memory_order_relaxed);
+    if (numEvents == EVENTS_PER_CHUNK) {
+        chunk->nextOwner = make_unique<TraceChunk>();
+        chunk->next.store(chunk->nextOwner.get(), memory_order_release);
+        chunk = chunk->nextOwner.get();
+        buffer.tail = chunk;
+        numEvents = 0;
+    }
+
+    chunk->events.at(numEvents) = { .name = name, .detail = std::move(detail), .startNS = startNS, .endNS = endNS };
+
+    // publish the event to save
+    chunk->numEvents.store(numEvents + 1, memory_order_release);
+}
+
+void ParallaxGenTrace::save(const filesystem::path& tracePath)
+{
+    ofstream traceFile(tracePath, ios::binary);
+    if (!traceFile.is_open()) {
+        throw runtime_error("Unable to open trace file " + tracePath.string());
+    }
+
+    const int64_t epochNS = s_epochNS.load();
+    const auto toJSONString = [](const string& str) -> string {
+        return nlohmann::json(str).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    };
+
+    traceFile << R"({"displayTimeUnit":"ms","traceEvents":[)";
+
+    // every thread gets a name event first, so every later event is preceded by a comma
+    size_t numSaved = 0;
+    const lock_guard<mutex> lock(s_buffersMutex);
+    for (const auto& buffer : s_buffers) {
+        traceFile << (buffer == s_buffers.front() ? "" : ",");
+        traceFile << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->threadIndex
+                  << R"(,"args":{"name":"Thread )" << buffer->threadIndex << R"("}})";
+
+        const TraceChunk* chunk = &buffer->head;
+        while (chunk != nullptr) {
+            const size_t numEvents = chunk->numEvents.load(memory_order_acquire);
+            for (size_t i = 0; i < numEvents; i++) {
+                const auto& event = chunk->events.at(i);
+                traceFile << R"(,{"name":)" << toJSONString(event.name) << R"(,"ph":"X","pid":1,"tid":)"
+                          << buffer->threadIndex << R"(,"ts":)" << fixed << toUS(event.startNS - epochNS)
+                          << R"(,"dur":)" << toUS(event.endNS - event.startNS);
+                if (!event.detail.empty()) {
+                    traceFile << R"(,"args":{"detail":)" << toJSONString(event.detail) << "}";
+                }
+                traceFile << "}";
+            }
+
+            numSaved += numEvents;
+            chunk = chunk->next.load(memory_order_acquire);
+        }
+    }
+
+    traceFile << "]}\n";
+    traceFile.close();
+
+    spdlog::info(L"Saved trace with {} spans to {}", numSaved, tracePath.wstring());
+}
@@ -9,20 +9,26 @@
 #include <Object3d.hpp>
 #include <Shaders.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/functional/hash.hpp>
 #include <nlohmann/json.hpp>
 
 #include <nifly/Particles.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Logger.hpp"
 
 using namespace std;
 
-// statics
-nlohmann::json PatcherMeshGlobalParticleLightsToLP::s_lpJsonData;
-mutex PatcherMeshGlobalParticleLightsToLP::s_lpJsonDataMutex;
-
 PatcherMeshGlobalParticleLightsToLP::PatcherMeshGlobalParticleLightsToLP(
     std::filesystem::path nifPath, nifly::NifFile* nif)
     : PatcherMeshGlobal(std::move(nifPath), nif, "ParticleLightsToLP")
@@ -38,17 +44,12 @@ auto PatcherMeshGlobalParticleLightsToLP::getFactory() -> PatcherMeshGlobal::Pat
 
 auto PatcherMeshGlobalParticleLightsToLP::applyPatch() -> bool
 {
-    // Loop through all blocks to find alpha properties
-    // Determine if NIF has attached havok animations
-    vector<NiObject*> nifBlockTree;
-    getNIF()->GetTree(nifBlockTree);
+    // Loop through all billboard nodes to find particle lights
+    const auto& billboardNodes = getNIFIndex().getBlocks("NiBillboardNode");
 
     bool appliedPatch = false;
 
-    for (NiObject* nifBlock : nifBlockTree) {
-        if (!boost::iequals(nifBlock->GetBlockName(), "NiBillboardNode")) {
-            continue;
-        }
+    for (NiObject* nifBlock : billboardNodes) {
         auto* const billboardNode = dynamic_cast<nifly::NiBillboardNode*>(nifBlock);
 
         // Get children
@@ -143,34 +144,17 @@ auto PatcherMeshGlobalParticleLightsToLP::applyPatch() -> bool
 auto PatcherMeshGlobalParticleLightsToLP::applySinglePatch(
     nifly::NiBillboardNode* node, nifly::NiShape* shape, nifly::BSEffectShaderProperty* effectShader) -> bool
 {
-    // Start generating LP JSON
-    nlohmann::json lpJson;
-
-    // Set model path
-    lpJson["models"] = nlohmann::json::array();
+    LPLight light;
 
     // Remove "meshes\\" from start of path
-    const auto nifPath = boost::ireplace_first_copy(getNIFPath().string(), "meshes\\", "");
-    lpJson["models"].push_back(nifPath);
-
-    // Create lights array
-    lpJson["lights"] = nlohmann::json::array();
-
-    // LightEntry will hold all JSON data for light
-    nlohmann::json lightEntry;
-    lightEntry["data"] = nlohmann::json::object();
+    light.model = boost::ireplace_first_copy(getNIFPath().string(), "meshes\\", "");
 
     // Set position
     MatTransform globalPosition;
     getNIF()->GetNodeTransformToGlobal(node->name.get(), globalPosition);
 
-    // Setup points array
-    lightEntry["points"] = nlohmann::json::array();
-    lightEntry["points"].push_back(nlohmann::json::array({ round(globalPosition.translation.x * 100.0) / 100.0,
-        round(globalPosition.translation.y * 100.0) / 100.0, round(globalPosition.translation.z * 100.0) / 100.0 }));
-
-    // Set Light
-    lightEntry["data"]["light"] = "MagicLightWhite01"; // Placeholder light that will be overridden
+    light.point = { round(globalPosition.translation.x * 100.0) / 100.0,
+        round(globalPosition.translation.y * 100.0) / 100.0, round(globalPosition.translation.z * 100.0) / 100.0 };
 
     // BSTriShape conversion
     auto* const shapeBSTriShape = dynamic_cast<nifly::BSTriShape*>(shape);
@@ -180,7 +164,7 @@ auto PatcherMeshGlobalParticleLightsToLP::applySinglePatch(
         return false;
     }
 
-    const auto vertData = shapeBSTriShape->vertData;
+    const auto& vertData = shapeBSTriShape->vertData;
     const auto numVerts = vertData.size();
 
     // set color
@@ -206,8 +190,7 @@ auto PatcherMeshGlobalParticleLightsToLP::applySinglePatch(
         baseColor *= WHITE_COLOR;
     }
 
-    lightEntry["data"]["color"] = nlohmann::json::array(
-        { static_cast<int>(baseColor.r), static_cast<int>(baseColor.g), static_cast<int>(baseColor.b) });
+    light.data.color = { static_cast<int>(baseColor.r), static_cast<int>(baseColor.g), static_cast<int>(baseColor.b) };
 
     // Calculate radius from average of vertex distances
     double radius = 0.0;
@@ -220,9 +203,9 @@ auto PatcherMeshGlobalParticleLightsToLP::applySinglePatch(
 
     radius /= static_cast<double>(numVerts);
 
-    lightEntry["data"]["radius"] = static_cast<int>(radius);
+    light.data.radius = static_cast<int>(radius);
 
-    lightEntry["data"]["fade"] = round(effectShader->baseColorScale * 100.0) / 100.0;
+    light.data.fade = round(effectShader->baseColorScale * 100.0) / 100.0;
 
     // Get controllers
     auto controllerRef = effectShader->controllerRef;
@@ -232,33 +215,30 @@ auto PatcherMeshGlobalParticleLightsToLP::applySinglePatch(
             break;
         }
 
-        string jsonField;
-        const auto controllerJson = getControllerJSON(controller, jsonField);
-        if (!controllerJson.empty()) {
-            lightEntry["data"][jsonField] = controllerJson;
+        bool isColorController = false;
+        auto lpController = getController(controller, isColorController);
+        if (lpController.has_value()) {
+            (isColorController ? light.data.colorController : light.data.fadeController) = std::move(lpController);
         }
 
         controllerRef = controller->nextControllerRef;
     }
 
-    lpJson["lights"].push_back(lightEntry);
-
-    // Save JSON
+    // Save light in the buffer of this thread
     {
-        const lock_guard<mutex> lock(s_lpJsonDataMutex);
-        PatcherMeshGlobalParticleLightsToLP::s_lpJsonData.push_back(lpJson);
+        auto& buffer = getThreadLightBuffer();
+        const lock_guard<mutex> lock(buffer.mutex);
+        buffer.lights.push_back(std::move(light));
     }
 
     return true;
 }
 
-auto PatcherMeshGlobalParticleLightsToLP::getControllerJSON(nifly::NiTimeController* controller, string& jsonField)
-    -> nlohmann::json
+auto PatcherMeshGlobalParticleLightsToLP::getController(nifly::NiTimeController* controller, bool& isColorController)
+    -> optional<LPController>
 {
-    nlohmann::json controllerJson = nlohmann::json::object();
-
     if (controller == nullptr) {
-        return controllerJson;
+        return nullopt;
     }
 
     auto* const floatController = dynamic_cast<nifly::BSEffectShaderPropertyFloatController*>(controller);
@@ -266,29 +246,29 @@ auto PatcherMeshGlobalParticleLightsToLP::getControllerJSON(nifly::NiTimeControl
     if (floatController != nullptr) {
         if (floatController->typeOfControlledVariable != 0) {
             // We don't care about this controller (not controlling emissive mult)
-            return controllerJson;
+            return nullopt;
         }
 
         interpRef = floatController->interpolatorRef;
 
-        jsonField = "fadeController";
+        isColorController = false;
     }
 
     auto* const colorController = dynamic_cast<nifly::BSEffectShaderPropertyColorController*>(controller);
     if (colorController != nullptr) {
         interpRef = colorController->interpolatorRef;
 
-        jsonField = "colorController";
+        isColorController = true;
     }
 
     if ((floatController == nullptr && colorController == nullptr)
         || (floatController != nullptr && colorController != nullptr)) {
         // We don't care about this controller
-        return controllerJson;
+        return nullopt;
     }
 
     if (interpRef.IsEmpty()) {
-        return controllerJson;
+        return nullopt;
     }
 
     // Find data block
@@ -310,10 +290,10 @@ auto PatcherMeshGlobalParticleLightsToLP::getControllerJSON(nifly::NiTimeControl
     if ((fadeDataBlock == nullptr && floatController != nullptr)
         || (colorDataBlock == nullptr && colorController != nullptr)) {
         // Could not find data block
-        return controllerJson;
+        return nullopt;
     }
 
-    controllerJson["keys"] = nlohmann::json::array();
+    LPController lpController;
 
     nifly::NiKeyType interpolationType = nifly::NiKeyType::LINEAR_KEY;
     if (floatController != nullptr) {
@@ -325,126 +305,221 @@ auto PatcherMeshGlobalParticleLightsToLP::getControllerJSON(nifly::NiTimeControl
     // Get interpolation method
     switch (interpolationType) {
     case nifly::NiKeyType::LINEAR_KEY:
-        controllerJson["interpolation"] = "Linear";
+        lpController.interpolation = "Linear";
         break;
     case nifly::NiKeyType::QUADRATIC_KEY:
-        controllerJson["interpolation"] = "Cubic";
+        lpController.interpolation = "Cubic";
         break;
     case nifly::NiKeyType::NO_INTERP:
-        controllerJson["interpolation"] = "Step";
+        lpController.interpolation = "Step";
         break;
     default:
         // Linear interpolation default
-        controllerJson["interpolation"] = "Linear";
+        lpController.interpolation = "Linear";
         break;
     }
 
-    // Add keys to JSON
-    uint32_t numKeys = 0;
-    if (floatController != nullptr) {
-        numKeys = fadeDataBlock->data.GetNumKeys();
-    } else if (colorController != nullptr) {
-        numKeys = colorDataBlock->data.GetNumKeys();
-    }
+    // Add keys
+    const auto roundValue = [](const float& value) -> float { return round(value * ROUNDING_VALUE) / ROUNDING_VALUE; };
+    const auto toColor = [](const nifly::Vector3& value) -> array<int, 3> {
+        return { static_cast<int>(value.x), static_cast<int>(value.y), static_cast<int>(value.z) };
+    };
 
-    for (uint32_t i = 0; i < numKeys; i++) {
-        if (floatController != nullptr) {
+    if (floatController != nullptr) {
+        const auto numKeys = fadeDataBlock->data.GetNumKeys();
+        lpController.fadeKeys.reserve(numKeys);
+        for (uint32_t i = 0; i < numKeys; i++) {
             const auto curKey = fadeDataBlock->data.GetKey(static_cast<int>(i));
-
-            controllerJson["keys"].push_back(
-                nlohmann::json::object({ { "time", round(curKey.time * ROUNDING_VALUE) / ROUNDING_VALUE },
-                    { "value", round(curKey.value * ROUNDING_VALUE) / ROUNDING_VALUE },
-                    { "forward", round(curKey.forward * ROUNDING_VALUE) / ROUNDING_VALUE },
-                    { "backward", round(curKey.backward * ROUNDING_VALUE) / ROUNDING_VALUE } }));
-        } else if (colorController != nullptr) {
+            lpController.fadeKeys.push_back({ .time = roundValue(curKey.time),
+                .value = roundValue(curKey.value),
+                .forward = roundValue(curKey.forward),
+                .backward = roundValue(curKey.backward) });
+        }
+    } else if (colorController != nullptr) {
+        const auto numKeys = colorDataBlock->data.GetNumKeys();
+        lpController.colorKeys.reserve(numKeys);
+        for (uint32_t i = 0; i < numKeys; i++) {
             const auto curKey = colorDataBlock->data.GetKey(static_cast<int>(i));
-
-            controllerJson["keys"].push_back(
-                nlohmann::json::object({ { "time", round(curKey.time * ROUNDING_VALUE) / ROUNDING_VALUE },
-                    { "color",
-                        nlohmann::json::array({ static_cast<int>(curKey.value.x), static_cast<int>(curKey.value.y),
-                            static_cast<int>(curKey.value.z) }) },
-                    { "forward",
-                        nlohmann::json::array({ static_cast<int>(curKey.forward.x), static_cast<int>(curKey.forward.y),
-                            static_cast<int>(curKey.forward.z) }) },
-                    { "backward",
-                        nlohmann::json::array({ static_cast<int>(curKey.backward.x),
-                            static_cast<int>(curKey.backward.y), static_cast<int>(curKey.backward.z) }) } }));
+            lpController.colorKeys.push_back({ .time = roundValue(curKey.time),
+                .color = toColor(curKey.value),
+                .forward = toColor(curKey.forward),
+                .backward = toColor(curKey.backward) });
         }
     }
 
-    return controllerJson;
+    return lpController;
 }
 
-void PatcherMeshGlobalParticleLightsToLP::finalize()
+auto PatcherMeshGlobalParticleLightsToLP::LPController::getJSON() const -> nlohmann::json
 {
-    const lock_guard<mutex> lock(s_lpJsonDataMutex);
+    nlohmann::json controllerJson = nlohmann::json::object();
+    controllerJson["interpolation"] = interpolation;
+    controllerJson["keys"] = nlohmann::json::array();
 
-    // Check if output JSON is empty
-    if (s_lpJsonData.empty()) {
-        return;
+    for (const auto& key : fadeKeys) {
+        controllerJson["keys"].push_back(nlohmann::json::object({ { "time", key.time }, { "value", key.value },
+            { "forward", key.forward }, { "backward", key.backward } }));
     }
 
-    // Key type for grouping: the stringified "models" array.
-    std::unordered_map<std::string, std::unordered_map<std::string, std::vector<nlohmann::json>>> modelsToDataPoints;
+    for (const auto& key : colorKeys) {
+        controllerJson["keys"].push_back(nlohmann::json::object({ { "time", key.time }, { "color", key.color },
+            { "forward", key.forward }, { "backward", key.backward } }));
+    }
 
-    // Merge all lights into a single JSON object
-    for (auto& obj : s_lpJsonData) {
-        const std::string modelsKey = obj["models"].dump();
+    return controllerJson;
+}
 
-        auto& dataGroup = modelsToDataPoints[modelsKey];
+auto PatcherMeshGlobalParticleLightsToLP::LPLightData::getJSON() const -> nlohmann::json
+{
+    nlohmann::json dataJson = nlohmann::json::object();
+    dataJson["light"] = PLACEHOLDER_LIGHT;
+    dataJson["color"] = color;
+    dataJson["radius"] = radius;
+    dataJson["fade"] = fade;
+
+    if (fadeController.has_value()) {
+        dataJson["fadeController"] = fadeController->getJSON();
+    }
 
-        for (auto& light : obj["lights"]) {
-            const std::string dataKey = light["data"].dump();
-            for (auto& p : light["points"]) {
-                dataGroup[dataKey].push_back(p);
-            }
-        }
+    if (colorController.has_value()) {
+        dataJson["colorController"] = colorController->getJSON();
     }
 
-    nlohmann::json mergedOutput = nlohmann::json::array();
+    return dataJson;
+}
 
-    for (auto& kv : modelsToDataPoints) {
-        const auto& modelsKey = kv.first;
-        const auto& dataGroup = kv.second;
+auto PatcherMeshGlobalParticleLightsToLP::LPLightDataHash::operator()(const LPLightData& data) const -> size_t
+{
+    size_t hash = 0;
+    boost::hash_combine(hash, data.color);
+    boost::hash_combine(hash, data.radius);
+    boost::hash_combine(hash, data.fade);
+
+    const auto hashController = [&hash](const optional<LPController>& controller) {
+        boost::hash_combine(hash, controller.has_value());
+        if (!controller.has_value()) {
+            return;
+        }
 
-        const nlohmann::json modelsJson = nlohmann::json::parse(modelsKey);
+        boost::hash_combine(hash, controller->interpolation);
+        for (const auto& key : controller->fadeKeys) {
+            boost::hash_combine(hash, key.time);
+            boost::hash_combine(hash, key.value);
+            boost::hash_combine(hash, key.forward);
+            boost::hash_combine(hash, key.backward);
+        }
+        for (const auto& key : controller->colorKeys) {
+            boost::hash_combine(hash, key.time);
+            boost::hash_combine(hash, key.color);
+            boost::hash_combine(hash, key.forward);
+            boost::hash_combine(hash, key.backward);
+        }
+    };
 
-        nlohmann::json lightsArray = nlohmann::json::array();
+    hashController(data.fadeController);
+    hashController(data.colorController);
 
-        for (const auto& dataKv : dataGroup) {
-            const std::string dataKey = dataKv.first;
-            const nlohmann::json dataObj = nlohmann::json::parse(dataKey);
+    return hash;
+}
 
-            const auto& allPoints = dataKv.second; // vector<json>
+auto PatcherMeshGlobalParticleLightsToLP::getLightBuffers() -> vector<shared_ptr<LPLightBuffer>>&
+{
+    static vector<shared_ptr<LPLightBuffer>> lightBuffers;
+    return lightBuffers;
+}
 
-            nlohmann::json lightEntry;
-            lightEntry["data"] = dataObj;
-            lightEntry["points"] = nlohmann::json::array();
+auto PatcherMeshGlobalParticleLightsToLP::getLightBuffersMutex() -> mutex&
+{
+    static mutex lightBuffersMutex;
+    return lightBuffersMutex;
+}
 
-            for (const auto& pt : allPoints) {
-                lightEntry["points"].push_back(pt);
-            }
+auto PatcherMeshGlobalParticleLightsToLP::getThreadLightBuffer() -> LPLightBuffer&
+{
+    // the registry keeps the buffer alive after the thread exits
+    thread_local const shared_ptr<LPLightBuffer> threadBuffer = [] {
+        auto buffer = make_shared<LPLightBuffer>();
+        const lock_guard<mutex> lock(getLightBuffersMutex());
+        getLightBuffers().push_back(buffer);
+        return buffer;
+    }();
+
+    return *threadBuffer;
+}
 
-            lightsArray.push_back(lightEntry);
+void PatcherMeshGlobalParticleLightsToLP::finalize()
+{
+    // Collect lights of all threads
+    vector<LPLight> lights;
+    {
+        const lock_guard<mutex> lock(getLightBuffersMutex());
+        for (const auto& buffer : getLightBuffers()) {
+            const lock_guard<mutex> bufferLock(buffer->mutex);
+            lights.insert(lights.end(), make_move_iterator(buffer->lights.begin()),
+                make_move_iterator(buffer->lights.end()));
+            buffer->lights.clear();
         }
+    }
 
-        // Now assemble the final group object
-        nlohmann::json groupObj;
-        groupObj["models"] = modelsJson;
-        groupObj["lights"] = lightsArray;
-
-        // Add to the final merged output
-        mergedOutput.push_back(groupObj);
+    // Check if output JSON is empty
+    if (lights.empty()) {
+        return;
     }
 
+    // Lights of one model are found in block order by one thread, sorting by model keeps that order
+    ranges::stable_sort(lights, [](const LPLight& a, const LPLight& b) { return a.model < b.model; });
+
     const auto outputJSON = getPGD()->getGeneratedPath() / "LightPlacer/parallaxgen.json";
 
     // Create directories for parent path
     filesystem::create_directories(outputJSON.parent_path());
 
-    // Save JSON to file
+    // Stream one group per model, the output is the same as dumping the whole array with an indent of 2
     ofstream lpJsonFile(outputJSON);
-    lpJsonFile << mergedOutput.dump(2) << "\n";
+    lpJsonFile << "[";
+
+    bool firstGroup = true;
+    auto modelBegin = lights.begin();
+    while (modelBegin != lights.end()) {
+        const auto modelEnd = find_if(
+            modelBegin, lights.end(), [&modelBegin](const LPLight& light) { return light.model != modelBegin->model; });
+
+        // Group points of lights with the same data in order of first appearance
+        unordered_map<LPLightData, size_t, LPLightDataHash> dataGroupIndex;
+        vector<pair<const LPLightData*, nlohmann::json>> dataGroups;
+        for (auto it = modelBegin; it != modelEnd; it++) {
+            const auto [groupIt, inserted] = dataGroupIndex.try_emplace(it->data, dataGroups.size());
+            if (inserted) {
+                dataGroups.emplace_back(&it->data, nlohmann::json::array());
+            }
+            dataGroups[groupIt->second].second.push_back(it->point);
+        }
+
+        nlohmann::json groupObj;
+        groupObj["models"] = nlohmann::json::array({ modelBegin->model });
+        groupObj["lights"] = nlohmann::json::array();
+        for (auto& [data, points] : dataGroups) {
+            nlohmann::json lightEntry;
+            lightEntry["data"] = data->getJSON();
+            lightEntry["points"] = std::move(points);
+            groupObj["lights"].push_back(std::move(lightEntry));
+        }
+
+        // Indent the group by one level
+        lpJsonFile << (firstGroup ? "\n" : ",\n");
+        firstGroup = false;
+
+        istringstream groupLines(groupObj.dump(2));
+        string line;
+        bool firstLine = true;
+        while (getline(groupLines, line)) {
+            lpJsonFile << (firstLine ? "" : "\n") << "  " << line;
+            firstLine = false;
+        }
+
+        modelBegin = modelEnd;
+    }
+
+    lpJsonFile << "\n]\n";
     lpJsonFile.close();
 }
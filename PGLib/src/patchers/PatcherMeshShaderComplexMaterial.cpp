@@ -73,7 +73,7 @@ auto PatcherMeshShaderComplexMaterial::shouldApply(nifly::NiShape& nifShape, std
 auto PatcherMeshShaderComplexMaterial::shouldApply(
     const NIFUtil::TextureSet& oldSlots, std::vector<PatcherMatch>& matches) -> bool
 {
-    static const auto cmBaseMap = getPGD()->getTextureMapConst(NIFUtil::TextureSlots::ENVMASK);
+    static const auto cmBaseMap = getPGD()->getTextureMapCopy(NIFUtil::TextureSlots::ENVMASK);
 
     matches.clear();
 
@@ -175,8 +175,6 @@ auto PatcherMeshShaderComplexMaterial::applyPatchSlots(
     return newSlots != oldSlots;
 }
 
-void PatcherMeshShaderComplexMaterial::processNewTXSTRecord(const PatcherMatch& match, const std::string& edid) { }
-
 auto PatcherMeshShaderComplexMaterial::applyShader(NiShape& nifShape) -> bool
 {
     bool changed = false;
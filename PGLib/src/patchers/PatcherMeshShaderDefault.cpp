@@ -68,6 +68,4 @@ auto PatcherMeshShaderDefault::applyPatchSlots(const NIFUtil::TextureSet& oldSlo
     return false;
 }
 
-void PatcherMeshShaderDefault::processNewTXSTRecord(const PatcherMatch& match, const std::string& edid) { }
-
 auto PatcherMeshShaderDefault::applyShader([[maybe_unused]] nifly::NiShape& nifShape) -> bool { return false; }
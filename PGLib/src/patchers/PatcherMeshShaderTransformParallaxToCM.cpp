@@ -2,15 +2,23 @@
 
 #include "Logger.hpp"
 #include "NIFUtil.hpp"
+#include "ParallaxGenContentCache.hpp"
+#include "ParallaxGenOnceMap.hpp"
 #include "ParallaxGenUtil.hpp"
 
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <cstddef>
 #include <filesystem>
-#include <mutex>
+#include <string>
 #include <utility>
+#include <vector>
 
 using namespace std;
 
-mutex PatcherMeshShaderTransformParallaxToCM::s_upgradeCMMutex;
+ParallaxGenContentCache* PatcherMeshShaderTransformParallaxToCM::s_cmCache = nullptr;
+
+void PatcherMeshShaderTransformParallaxToCM::loadCMCache(ParallaxGenContentCache* cmCache) { s_cmCache = cmCache; }
 
 auto PatcherMeshShaderTransformParallaxToCM::getFactory()
     -> PatcherMeshShaderTransform::PatcherMeshShaderTransformFactory
@@ -36,11 +44,15 @@ PatcherMeshShaderTransformParallaxToCM::PatcherMeshShaderTransformParallaxToCM(
 {
 }
 
+auto PatcherMeshShaderTransformParallaxToCM::getUpgradeResults() -> ParallaxGenOnceMap<wstring, bool>&
+{
+    static ParallaxGenOnceMap<wstring, bool> upgradeResults;
+    return upgradeResults;
+}
+
 auto PatcherMeshShaderTransformParallaxToCM::transform(
     const PatcherMeshShader::PatcherMatch& fromMatch, PatcherMeshShader::PatcherMatch& result) -> bool
 {
-    const lock_guard<mutex> lock(s_upgradeCMMutex);
-
     const auto heightMap = fromMatch.matchedPath;
 
     result = fromMatch;
@@ -52,12 +64,20 @@ auto PatcherMeshShaderTransformParallaxToCM::transform(
 
     result.matchedPath = complexMap;
 
+    // the first caller for a map generates it, concurrent callers for the same map wait for that result
+    return getUpgradeResults().getOrCompute(
+        boost::to_lower_copy(complexMap.wstring()), [&]() { return upgradeToCM(heightMap, texBase, complexMap); });
+}
+
+auto PatcherMeshShaderTransformParallaxToCM::upgradeToCM(
+    const wstring& heightMap, const wstring& texBase, const filesystem::path& complexMap) -> bool
+{
     if (getPGD()->isGenerated(complexMap)) {
         // this was already upgraded
         return true;
     }
 
-    static const auto cmBaseMap = getPGD()->getTextureMapConst(NIFUtil::TextureSlots::ENVMASK);
+    static const auto cmBaseMap = getPGD()->getTextureMapCopy(NIFUtil::TextureSlots::ENVMASK);
     auto existingMask = NIFUtil::getTexMatch(texBase, NIFUtil::TextureType::ENVIRONMENTMASK, cmBaseMap);
     filesystem::path envMask = filesystem::path();
     if (!existingMask.empty()) {
@@ -66,12 +86,28 @@ auto PatcherMeshShaderTransformParallaxToCM::transform(
         envMask = existingMask[0].path;
     }
 
+    const filesystem::path outputPath = getPGD()->getGeneratedPath() / complexMap;
+
+    // reuse a map generated from the same inputs in a previous run
+    string cacheKey;
+    if (s_cmCache != nullptr) {
+        vector<vector<std::byte>> cacheInputs;
+        cacheInputs.push_back(getPGD()->getFile(heightMap));
+        cacheInputs.push_back(envMask.empty() ? vector<std::byte>() : getPGD()->getFile(envMask));
+        cacheKey = ParallaxGenContentCache::getKey(cacheInputs, CM_GENERATOR_VERSION);
+
+        if (!cacheKey.empty() && s_cmCache->fetch(cacheKey, outputPath)) {
+            addGeneratedComplexMap(complexMap, heightMap);
+            Logger::debug(L"Reused cached complex material map: {}", complexMap.wstring());
+            return true;
+        }
+    }
+
     // upgrade to complex material
     const DirectX::ScratchImage newComplexMap = getPGD3D()->upgradeToComplexMaterial(heightMap, envMask);
 
     // save to file
     if (newComplexMap.GetImageCount() > 0) {
-        const filesystem::path outputPath = getPGD()->getGeneratedPath() / complexMap;
         filesystem::create_directories(outputPath.parent_path());
 
         const HRESULT hr = DirectX::SaveToDDSFile(newComplexMap.GetImages(), newComplexMap.GetImageCount(),
@@ -82,14 +118,11 @@ auto PatcherMeshShaderTransformParallaxToCM::transform(
             return false;
         }
 
-        // add newly created file to complexMaterialMaps for later processing
-        getPGD()->getTextureMap(NIFUtil::TextureSlots::ENVMASK)[texBase].insert(
-            { complexMap, NIFUtil::TextureType::COMPLEXMATERIAL });
-        getPGD()->setTextureType(complexMap, NIFUtil::TextureType::COMPLEXMATERIAL);
+        if (s_cmCache != nullptr) {
+            s_cmCache->store(cacheKey, outputPath);
+        }
 
-        // Update file map
-        auto heightMapMod = getPGD()->getMod(heightMap);
-        getPGD()->addGeneratedFile(complexMap, heightMapMod);
+        addGeneratedComplexMap(complexMap, heightMap);
 
         Logger::debug(L"Generated complex material map: {}", complexMap.wstring());
 
@@ -98,3 +131,14 @@ auto PatcherMeshShaderTransformParallaxToCM::transform(
 
     return false;
 }
+
+void PatcherMeshShaderTransformParallaxToCM::addGeneratedComplexMap(
+    const filesystem::path& complexMap, const filesystem::path& heightMap)
+{
+    // add newly created file to complexMaterialMaps for later processing
+    getPGD()->addGeneratedTexture(complexMap, NIFUtil::TextureSlots::ENVMASK, NIFUtil::TextureType::COMPLEXMATERIAL);
+
+    // Update file map
+    auto heightMapMod = getPGD()->getMod(heightMap);
+    getPGD()->addGeneratedFile(complexMap, heightMapMod);
+}
@@ -5,13 +5,19 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <memory>
 #include <nlohmann/json_fwd.hpp>
+#include <optional>
+#include <ranges>
 #include <string>
+#include <vector>
 
 #include "Logger.hpp"
 #include "NIFUtil.hpp"
+#include "PGDiag.hpp"
+#include "ParallaxGenMeshMath.hpp"
 #include "ParallaxGenUtil.hpp"
 
 using namespace std;
@@ -21,34 +27,24 @@ PatcherMeshShaderTruePBR::PatcherMeshShaderTruePBR(filesystem::path nifPath, nif
 {
 }
 
-auto PatcherMeshShaderTruePBR::getTruePBRConfigs() -> map<size_t, nlohmann::json>&
-{
-    static map<size_t, nlohmann::json> truePBRConfigs = {};
-    return truePBRConfigs;
-}
-
-auto PatcherMeshShaderTruePBR::getPathLookupJSONs() -> map<size_t, nlohmann::json>&
-{
-    static map<size_t, nlohmann::json> pathLookupJSONs = {};
-    return pathLookupJSONs;
-}
+auto PatcherMeshShaderTruePBR::getTruePBRRules() -> const vector<TruePBRRule>& { return s_truePBRRules; }
 
-auto PatcherMeshShaderTruePBR::getTruePBRDiffuseInverse() -> map<wstring, vector<size_t>>&
+auto PatcherMeshShaderTruePBR::getPathContainsMatcher() -> ParallaxGenAhoCorasick&
 {
-    static map<wstring, vector<size_t>> truePBRDiffuseInverse = {};
-    return truePBRDiffuseInverse;
+    static ParallaxGenAhoCorasick pathContainsMatcher;
+    return pathContainsMatcher;
 }
 
-auto PatcherMeshShaderTruePBR::getTruePBRNormalInverse() -> map<wstring, vector<size_t>>&
+auto PatcherMeshShaderTruePBR::getTruePBRDiffuseLookup() -> ParallaxGenSuffixTrie&
 {
-    static map<wstring, vector<size_t>> truePBRNormalInverse = {};
-    return truePBRNormalInverse;
+    static ParallaxGenSuffixTrie truePBRDiffuseLookup;
+    return truePBRDiffuseLookup;
 }
 
-auto PatcherMeshShaderTruePBR::getPathLookupCache() -> unordered_map<tuple<wstring, wstring>, bool, TupleStrHash>&
+auto PatcherMeshShaderTruePBR::getTruePBRNormalLookup() -> ParallaxGenSuffixTrie&
 {
-    static unordered_map<tuple<wstring, wstring>, bool, TupleStrHash> pathLookupCache = {};
-    return pathLookupCache;
+    static ParallaxGenSuffixTrie truePBRNormalLookup;
+    return truePBRNormalLookup;
 }
 
 auto PatcherMeshShaderTruePBR::getTruePBRConfigFilenameFields() -> vector<string>
@@ -60,7 +56,11 @@ auto PatcherMeshShaderTruePBR::getTruePBRConfigFilenameFields() -> vector<string
 // Statics
 void PatcherMeshShaderTruePBR::loadStatics(const std::vector<std::filesystem::path>& pbrJSONs)
 {
-    size_t configOrder = 0;
+    s_truePBRRules.clear();
+    getTruePBRNormalLookup() = {};
+    getTruePBRDiffuseLookup() = {};
+    getPathContainsMatcher() = {};
+
     for (const auto& config : pbrJSONs) {
         // check if Config is valid
         auto configFileBytes = getPGD()->getFile(config);
@@ -86,9 +86,16 @@ void PatcherMeshShaderTruePBR::loadStatics(const std::vector<std::filesystem::pa
                     }
                 }
 
-                Logger::trace(
-                    L"TruePBR Config {} Loaded: {}", configOrder, ParallaxGenUtil::utf8toUTF16(element.dump()));
-                getTruePBRConfigs()[configOrder++] = element;
+                try {
+                    s_truePBRRules.push_back(compileRule(element));
+                } catch (nlohmann::json::exception& e) {
+                    Logger::error(L"Skipping invalid TruePBR entry in config file {}: {}", config.wstring(),
+                        ParallaxGenUtil::asciitoUTF16(e.what()));
+                    continue;
+                }
+
+                Logger::trace(L"TruePBR Config {} Loaded: {}", s_truePBRRules.size() - 1,
+                    ParallaxGenUtil::utf8toUTF16(element.dump()));
             }
         } catch (nlohmann::json::parse_error& e) {
             Logger::error(L"Unable to parse TruePBR Config file {}: {}", config.wstring(),
@@ -97,34 +104,289 @@ void PatcherMeshShaderTruePBR::loadStatics(const std::vector<std::filesystem::pa
         }
     }
 
-    Logger::info(L"Found {} TruePBR entries", getTruePBRConfigs().size());
+    Logger::info(L"Found {} TruePBR entries", s_truePBRRules.size());
 
     // Create helper vectors
-    for (const auto& config : getTruePBRConfigs()) {
-        // "match_normal" attribute
-        if (config.second.contains("match_normal")) {
-            auto revNormal = ParallaxGenUtil::utf8toUTF16(config.second["match_normal"].get<string>());
-            revNormal = NIFUtil::getTexBase(revNormal);
-            std::ranges::reverse(revNormal);
+    for (size_t cfg = 0; cfg < s_truePBRRules.size(); cfg++) {
+        const auto& rule = s_truePBRRules[cfg];
 
-            getTruePBRNormalInverse()[boost::to_lower_copy(revNormal)].push_back(config.first);
+        // "match_normal" attribute
+        if (rule.has(TruePBRRule::FIELD_MATCH_NORMAL)) {
+            getTruePBRNormalLookup().addSuffix(NIFUtil::getTexBase(rule.matchNormal), cfg);
             continue;
         }
 
         // "match_diffuse" attribute
-        if (config.second.contains("match_diffuse")) {
-            auto revDiffuse = ParallaxGenUtil::utf8toUTF16(config.second["match_diffuse"].get<string>());
-            revDiffuse = NIFUtil::getTexBase(revDiffuse);
-            std::ranges::reverse(revDiffuse);
-
-            getTruePBRDiffuseInverse()[boost::to_lower_copy(revDiffuse)].push_back(config.first);
+        if (rule.has(TruePBRRule::FIELD_MATCH_DIFFUSE)) {
+            getTruePBRDiffuseLookup().addSuffix(NIFUtil::getTexBase(rule.matchDiffuse), cfg);
         }
 
         // "path_contains" attribute
-        if (config.second.contains("path_contains")) {
-            getPathLookupJSONs()[config.first] = config.second;
+        if (rule.has(TruePBRRule::FIELD_PATH_CONTAINS)) {
+            getPathContainsMatcher().addPattern(rule.pathContains, cfg);
+        }
+    }
+
+    getTruePBRNormalLookup().build();
+    getTruePBRDiffuseLookup().build();
+    getPathContainsMatcher().build();
+
+    // JSON form is only built when diagnostics are enabled
+    if (PGDiag::isEnabled()) {
+        const PGDiag::Prefix diagRulesPrefix("truePBRRules", nlohmann::json::value_t::array);
+        for (const auto& rule : s_truePBRRules) {
+            PGDiag::pushBack(rule.getJSON());
+        }
+    }
+}
+
+auto PatcherMeshShaderTruePBR::compileRule(const nlohmann::json& element) -> TruePBRRule
+{
+    TruePBRRule rule;
+
+    const auto readBool = [&rule](const nlohmann::json& parent, const char* key, const TruePBRRule::Field& field) {
+        if (!parent.contains(key)) {
+            return;
+        }
+
+        rule.fields |= field;
+        if (parent[key].get<bool>()) {
+            rule.flags |= field;
+        }
+    };
+
+    const auto readFloat
+        = [&rule](const nlohmann::json& parent, const char* key, const TruePBRRule::Field& field, float& out) {
+              if (!parent.contains(key)) {
+                  return;
+              }
+
+              rule.fields |= field;
+              out = parent[key].get<float>();
+          };
+
+    // colors are only applied if they have enough components
+    const auto readColor = [&rule](const nlohmann::json& parent, const char* key, const TruePBRRule::Field& field,
+                               auto& out) {
+        if (!parent.contains(key) || parent[key].size() < out.size()) {
+            return;
+        }
+
+        rule.fields |= field;
+        for (size_t i = 0; i < out.size(); i++) {
+            out.at(i) = parent[key][i].template get<float>();
+        }
+    };
+
+    const auto readPath = [&rule](const nlohmann::json& parent, const char* key, const TruePBRRule::Field& field,
+                              wstring& out) {
+        if (!parent.contains(key)) {
+            return;
+        }
+
+        rule.fields |= field;
+        out = ParallaxGenUtil::utf8toUTF16(parent[key].get<string>());
+    };
+
+    rule.json = ParallaxGenUtil::utf8toUTF16(element["json"].get<string>());
+
+    // Matching
+    readPath(element, "match_normal", TruePBRRule::FIELD_MATCH_NORMAL, rule.matchNormal);
+    readPath(element, "match_diffuse", TruePBRRule::FIELD_MATCH_DIFFUSE, rule.matchDiffuse);
+    readPath(element, "path_contains", TruePBRRule::FIELD_PATH_CONTAINS, rule.pathContains);
+    readPath(element, "nif_filter", TruePBRRule::FIELD_NIF_FILTER, rule.nifFilter);
+    readPath(element, "rename", TruePBRRule::FIELD_RENAME, rule.pbrSuffix);
+    readPath(element, "cubemap", TruePBRRule::FIELD_CUBEMAP, rule.cubemap);
+
+    // match_normal takes priority over match_diffuse
+    const auto& matchField = rule.has(TruePBRRule::FIELD_MATCH_NORMAL) ? rule.matchNormal : rule.matchDiffuse;
+    rule.matchFieldBaseLength = NIFUtil::getTexBase(matchField).length();
+    if (!rule.has(TruePBRRule::FIELD_RENAME)) {
+        rule.pbrSuffix = matchField;
+    }
+    boost::to_lower(rule.pbrSuffix);
+    boost::to_lower(rule.pathContains);
+    boost::to_lower(rule.nifFilter);
+
+    // "SlotX" attributes
+    for (size_t i = 0; i < NUM_TEXTURE_SLOTS - 1; i++) {
+        const std::string slotName = "slot" + std::to_string(i + 1);
+        if (!element.contains(slotName)) {
+            continue;
+        }
+
+        std::string newSlot = element[slotName].get<std::string>();
+
+        // Prepend "textures\\" if it's not already there
+        if (!boost::istarts_with(newSlot, "textures\\")) {
+            newSlot.insert(0, "textures\\");
+        }
+
+        rule.slotFields |= static_cast<uint8_t>(1U << i);
+        rule.slots.at(i) = ParallaxGenUtil::utf8toUTF16(newSlot);
+    }
+
+    // Shape attributes
+    readBool(element, "pbr", TruePBRRule::FIELD_PBR);
+    readBool(element, "delete", TruePBRRule::FIELD_DELETE);
+    readBool(element, "env_mapping", TruePBRRule::FIELD_ENV_MAPPING);
+    readFloat(element, "smooth_angle", TruePBRRule::FIELD_SMOOTH_ANGLE, rule.smoothAngle);
+    readFloat(element, "auto_uv", TruePBRRule::FIELD_AUTO_UV, rule.autoUV);
+    readBool(element, "vertex_colors", TruePBRRule::FIELD_VERTEX_COLORS);
+    readFloat(element, "specular_level", TruePBRRule::FIELD_SPECULAR_LEVEL, rule.specularLevel);
+    readColor(element, "subsurface_color", TruePBRRule::FIELD_SUBSURFACE_COLOR, rule.subsurfaceColor);
+    readFloat(element, "roughness_scale", TruePBRRule::FIELD_ROUGHNESS_SCALE, rule.roughnessScale);
+    readFloat(element, "subsurface_opacity", TruePBRRule::FIELD_SUBSURFACE_OPACITY, rule.subsurfaceOpacity);
+    readFloat(element, "displacement_scale", TruePBRRule::FIELD_DISPLACEMENT_SCALE, rule.displacementScale);
+    readFloat(element, "env_map_scale", TruePBRRule::FIELD_ENV_MAP_SCALE, rule.envMapScale);
+    readFloat(element, "env_map_scale_mult", TruePBRRule::FIELD_ENV_MAP_SCALE_MULT, rule.envMapScaleMult);
+    readFloat(element, "emissive_scale", TruePBRRule::FIELD_EMISSIVE_SCALE, rule.emissiveScale);
+    readColor(element, "emissive_color", TruePBRRule::FIELD_EMISSIVE_COLOR, rule.emissiveColor);
+    readFloat(element, "uv_scale", TruePBRRule::FIELD_UV_SCALE, rule.uvScale);
+
+    // Slot attributes
+    readBool(element, "lock_diffuse", TruePBRRule::FIELD_LOCK_DIFFUSE);
+    readBool(element, "lock_normal", TruePBRRule::FIELD_LOCK_NORMAL);
+    readBool(element, "emissive", TruePBRRule::FIELD_EMISSIVE);
+    readBool(element, "lock_emissive", TruePBRRule::FIELD_LOCK_EMISSIVE);
+    readBool(element, "parallax", TruePBRRule::FIELD_PARALLAX);
+    readBool(element, "lock_parallax", TruePBRRule::FIELD_LOCK_PARALLAX);
+    readBool(element, "lock_cubemap", TruePBRRule::FIELD_LOCK_CUBEMAP);
+    readBool(element, "lock_rmaos", TruePBRRule::FIELD_LOCK_RMAOS);
+    readBool(element, "lock_cnr", TruePBRRule::FIELD_LOCK_CNR);
+    readBool(element, "lock_subsurface", TruePBRRule::FIELD_LOCK_SUBSURFACE);
+
+    // Shader attributes
+    readBool(element, "subsurface_foliage", TruePBRRule::FIELD_SUBSURFACE_FOLIAGE);
+    readBool(element, "subsurface", TruePBRRule::FIELD_SUBSURFACE);
+    readBool(element, "hair", TruePBRRule::FIELD_HAIR);
+    readBool(element, "multilayer", TruePBRRule::FIELD_MULTILAYER);
+    readColor(element, "coat_color", TruePBRRule::FIELD_COAT_COLOR, rule.coatColor);
+    readFloat(element, "coat_specular_level", TruePBRRule::FIELD_COAT_SPECULAR_LEVEL, rule.coatSpecularLevel);
+    readFloat(element, "coat_roughness", TruePBRRule::FIELD_COAT_ROUGHNESS, rule.coatRoughness);
+    readFloat(element, "coat_strength", TruePBRRule::FIELD_COAT_STRENGTH, rule.coatStrength);
+    readBool(element, "coat_diffuse", TruePBRRule::FIELD_COAT_DIFFUSE);
+    readBool(element, "coat_parallax", TruePBRRule::FIELD_COAT_PARALLAX);
+    readBool(element, "coat_normal", TruePBRRule::FIELD_COAT_NORMAL);
+    readFloat(element, "inner_uv_scale", TruePBRRule::FIELD_INNER_UV_SCALE, rule.innerUVScale);
+
+    if (element.contains("glint")) {
+        const auto& glint = element["glint"];
+        rule.fields |= TruePBRRule::FIELD_GLINT;
+        readFloat(glint, "screen_space_scale", TruePBRRule::FIELD_GLINT_SCREEN_SPACE_SCALE, rule.glintScreenSpaceScale);
+        readFloat(glint, "log_microfacet_density", TruePBRRule::FIELD_GLINT_LOG_MICROFACET_DENSITY,
+            rule.glintLogMicrofacetDensity);
+        readFloat(
+            glint, "microfacet_density", TruePBRRule::FIELD_GLINT_MICROFACET_DENSITY, rule.glintMicrofacetDensity);
+        readFloat(glint, "microfacet_roughness", TruePBRRule::FIELD_GLINT_MICROFACET_ROUGHNESS,
+            rule.glintMicrofacetRoughness);
+        readFloat(glint, "density_randomization", TruePBRRule::FIELD_GLINT_DENSITY_RANDOMIZATION,
+            rule.glintDensityRandomization);
+    }
+
+    if (element.contains("fuzz")) {
+        const auto& fuzz = element["fuzz"];
+        rule.fields |= TruePBRRule::FIELD_FUZZ;
+        readColor(fuzz, "color", TruePBRRule::FIELD_FUZZ_COLOR, rule.fuzzColor);
+        readFloat(fuzz, "weight", TruePBRRule::FIELD_FUZZ_WEIGHT, rule.fuzzWeight);
+        readBool(fuzz, "texture", TruePBRRule::FIELD_FUZZ_TEXTURE);
+    }
+
+    return rule;
+}
+
+auto PatcherMeshShaderTruePBR::TruePBRRule::getJSON() const -> nlohmann::json
+{
+    nlohmann::json j = nlohmann::json::object();
+
+    const auto writeBool = [this](nlohmann::json& parent, const char* key, const Field& field) {
+        if (has(field)) {
+            parent[key] = flag(field);
+        }
+    };
+
+    const auto writeValue = [this](nlohmann::json& parent, const char* key, const Field& field, const auto& value) {
+        if (has(field)) {
+            parent[key] = value;
+        }
+    };
+
+    const auto writePath = [this](nlohmann::json& parent, const char* key, const Field& field, const wstring& value) {
+        if (has(field)) {
+            parent[key] = ParallaxGenUtil::utf16toUTF8(value);
+        }
+    };
+
+    j["json"] = ParallaxGenUtil::utf16toUTF8(json);
+    writePath(j, "match_normal", FIELD_MATCH_NORMAL, matchNormal);
+    writePath(j, "match_diffuse", FIELD_MATCH_DIFFUSE, matchDiffuse);
+    writePath(j, "path_contains", FIELD_PATH_CONTAINS, pathContains);
+    writePath(j, "nif_filter", FIELD_NIF_FILTER, nifFilter);
+    writePath(j, "rename", FIELD_RENAME, pbrSuffix);
+    writePath(j, "cubemap", FIELD_CUBEMAP, cubemap);
+
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (hasSlot(i)) {
+            j["slot" + std::to_string(i + 1)] = ParallaxGenUtil::utf16toUTF8(slots.at(i));
         }
     }
+
+    writeBool(j, "pbr", FIELD_PBR);
+    writeBool(j, "delete", FIELD_DELETE);
+    writeBool(j, "env_mapping", FIELD_ENV_MAPPING);
+    writeValue(j, "smooth_angle", FIELD_SMOOTH_ANGLE, smoothAngle);
+    writeValue(j, "auto_uv", FIELD_AUTO_UV, autoUV);
+    writeBool(j, "vertex_colors", FIELD_VERTEX_COLORS);
+    writeValue(j, "specular_level", FIELD_SPECULAR_LEVEL, specularLevel);
+    writeValue(j, "subsurface_color", FIELD_SUBSURFACE_COLOR, subsurfaceColor);
+    writeValue(j, "roughness_scale", FIELD_ROUGHNESS_SCALE, roughnessScale);
+    writeValue(j, "subsurface_opacity", FIELD_SUBSURFACE_OPACITY, subsurfaceOpacity);
+    writeValue(j, "displacement_scale", FIELD_DISPLACEMENT_SCALE, displacementScale);
+    writeValue(j, "env_map_scale", FIELD_ENV_MAP_SCALE, envMapScale);
+    writeValue(j, "env_map_scale_mult", FIELD_ENV_MAP_SCALE_MULT, envMapScaleMult);
+    writeValue(j, "emissive_scale", FIELD_EMISSIVE_SCALE, emissiveScale);
+    writeValue(j, "emissive_color", FIELD_EMISSIVE_COLOR, emissiveColor);
+    writeValue(j, "uv_scale", FIELD_UV_SCALE, uvScale);
+    writeBool(j, "lock_diffuse", FIELD_LOCK_DIFFUSE);
+    writeBool(j, "lock_normal", FIELD_LOCK_NORMAL);
+    writeBool(j, "emissive", FIELD_EMISSIVE);
+    writeBool(j, "lock_emissive", FIELD_LOCK_EMISSIVE);
+    writeBool(j, "parallax", FIELD_PARALLAX);
+    writeBool(j, "lock_parallax", FIELD_LOCK_PARALLAX);
+    writeBool(j, "lock_cubemap", FIELD_LOCK_CUBEMAP);
+    writeBool(j, "lock_rmaos", FIELD_LOCK_RMAOS);
+    writeBool(j, "lock_cnr", FIELD_LOCK_CNR);
+    writeBool(j, "lock_subsurface", FIELD_LOCK_SUBSURFACE);
+    writeBool(j, "subsurface_foliage", FIELD_SUBSURFACE_FOLIAGE);
+    writeBool(j, "subsurface", FIELD_SUBSURFACE);
+    writeBool(j, "hair", FIELD_HAIR);
+    writeBool(j, "multilayer", FIELD_MULTILAYER);
+    writeValue(j, "coat_color", FIELD_COAT_COLOR, coatColor);
+    writeValue(j, "coat_specular_level", FIELD_COAT_SPECULAR_LEVEL, coatSpecularLevel);
+    writeValue(j, "coat_roughness", FIELD_COAT_ROUGHNESS, coatRoughness);
+    writeValue(j, "coat_strength", FIELD_COAT_STRENGTH, coatStrength);
+    writeBool(j, "coat_diffuse", FIELD_COAT_DIFFUSE);
+    writeBool(j, "coat_parallax", FIELD_COAT_PARALLAX);
+    writeBool(j, "coat_normal", FIELD_COAT_NORMAL);
+    writeValue(j, "inner_uv_scale", FIELD_INNER_UV_SCALE, innerUVScale);
+
+    if (has(FIELD_GLINT)) {
+        auto& glint = j["glint"] = nlohmann::json::object();
+        writeValue(glint, "screen_space_scale", FIELD_GLINT_SCREEN_SPACE_SCALE, glintScreenSpaceScale);
+        writeValue(glint, "log_microfacet_density", FIELD_GLINT_LOG_MICROFACET_DENSITY, glintLogMicrofacetDensity);
+        writeValue(glint, "microfacet_density", FIELD_GLINT_MICROFACET_DENSITY, glintMicrofacetDensity);
+        writeValue(glint, "microfacet_roughness", FIELD_GLINT_MICROFACET_ROUGHNESS, glintMicrofacetRoughness);
+        writeValue(glint, "density_randomization", FIELD_GLINT_DENSITY_RANDOMIZATION, glintDensityRandomization);
+    }
+
+    if (has(FIELD_FUZZ)) {
+        auto& fuzz = j["fuzz"] = nlohmann::json::object();
+        writeValue(fuzz, "color", FIELD_FUZZ_COLOR, fuzzColor);
+        writeValue(fuzz, "weight", FIELD_FUZZ_WEIGHT, fuzzWeight);
+        writeBool(fuzz, "texture", FIELD_FUZZ_TEXTURE);
+    }
+
+    return j;
 }
 
 auto PatcherMeshShaderTruePBR::getFactory() -> PatcherMeshShader::PatcherMeshShaderFactory
@@ -188,34 +450,32 @@ auto PatcherMeshShaderTruePBR::shouldApply(const NIFUtil::TextureSet& oldSlots,
     // get search prefixes
     auto searchPrefixes = NIFUtil::getSearchPrefixes(oldSlots);
 
-    map<size_t, tuple<nlohmann::json, wstring>> truePBRData;
-    // "match_normal" attribute: Binary search for normal map
-    getSlotMatch(truePBRData, searchPrefixes[1], getTruePBRNormalInverse(), L"match_normal", getNIFPath().wstring());
+    const auto nifPathLower = boost::to_lower_copy(getNIFPath().wstring());
 
-    // "match_diffuse" attribute: Binary search for diffuse map
-    getSlotMatch(truePBRData, searchPrefixes[0], getTruePBRDiffuseInverse(), L"match_diffuse", getNIFPath().wstring());
+    TruePBRMatchData truePBRData;
+    // "match_normal" attribute: Suffix lookup for normal map
+    getSlotMatch(truePBRData, searchPrefixes[1], getTruePBRNormalLookup(), L"match_normal", nifPathLower);
+
+    // "match_diffuse" attribute: Suffix lookup for diffuse map
+    getSlotMatch(truePBRData, searchPrefixes[0], getTruePBRDiffuseLookup(), L"match_diffuse", nifPathLower);
 
     // "path_contains" attribute: Linear search for path_contains
-    getPathContainsMatch(truePBRData, searchPrefixes[0], getNIFPath().wstring());
+    getPathContainsMatch(truePBRData, searchPrefixes[0], nifPathLower);
 
     // Split data into individual JSONs
-    unordered_map<wstring, map<size_t, tuple<nlohmann::json, wstring>>> truePBROutputData;
+    const auto& rules = getTruePBRRules();
+    unordered_map<wstring, TruePBRMatchData> truePBROutputData;
     unordered_map<wstring, unordered_set<NIFUtil::TextureSlots>> truePBRMatchedFrom;
-    for (const auto& [sequence, data] : truePBRData) {
-        // get current JSON
-        auto matchedPath = ParallaxGenUtil::utf8toUTF16(get<0>(data)["json"].get<string>());
+    for (const auto& [sequence, pbrPath] : truePBRData) {
+        const auto& rule = rules[sequence];
 
         // Add to output
-        if (truePBROutputData.find(matchedPath) == truePBROutputData.end()) {
-            // If MatchedPath doesn't exist, insert it with an empty map and then add Sequence, Data
-            truePBROutputData.emplace(matchedPath, map<size_t, tuple<nlohmann::json, wstring>> {});
-        }
-        truePBROutputData[matchedPath][sequence] = data;
+        truePBROutputData[rule.json][sequence] = pbrPath;
 
-        if (get<0>(data).contains("match_normal")) {
-            truePBRMatchedFrom[matchedPath].insert(NIFUtil::TextureSlots::NORMAL);
+        if (rule.has(TruePBRRule::FIELD_MATCH_NORMAL)) {
+            truePBRMatchedFrom[rule.json].insert(NIFUtil::TextureSlots::NORMAL);
         } else {
-            truePBRMatchedFrom[matchedPath].insert(NIFUtil::TextureSlots::DIFFUSE);
+            truePBRMatchedFrom[rule.json].insert(NIFUtil::TextureSlots::DIFFUSE);
         }
     }
 
@@ -228,8 +488,8 @@ auto PatcherMeshShaderTruePBR::shouldApply(const NIFUtil::TextureSet& oldSlots,
 
         // loop through json data
         bool deleteShape = false;
-        for (const auto& [sequence, data] : jsonData) {
-            if (get<0>(data).contains("delete") && get<0>(data)["delete"].get<bool>()) {
+        for (const auto& [sequence, pbrPath] : jsonData) {
+            if (rules[sequence].flag(TruePBRRule::FIELD_DELETE)) {
                 Logger::trace(L"PBR JSON Match: Result marked for deletion, skipping slot checks");
                 deleteShape = true;
                 break;
@@ -269,8 +529,8 @@ auto PatcherMeshShaderTruePBR::shouldApply(const NIFUtil::TextureSet& oldSlots,
     // Sort matches by ExtraData key minimum value (this preserves order of JSONs to be 0 having priority if mod order
     // does not exist)
     std::ranges::sort(matches, [](const PatcherMatch& a, const PatcherMatch& b) {
-        return get<0>(*(static_pointer_cast<map<size_t, tuple<nlohmann::json, wstring>>>(a.extraData)->begin()))
-            > get<0>(*(static_pointer_cast<map<size_t, tuple<nlohmann::json, wstring>>>(b.extraData)->begin()));
+        return static_pointer_cast<TruePBRMatchData>(a.extraData)->begin()->first
+            > static_pointer_cast<TruePBRMatchData>(b.extraData)->begin()->first;
     });
 
     // Check for no-JSON RMAOS
@@ -292,56 +552,16 @@ auto PatcherMeshShaderTruePBR::shouldApply(const NIFUtil::TextureSet& oldSlots,
     return !matches.empty();
 }
 
-void PatcherMeshShaderTruePBR::getSlotMatch(map<size_t, tuple<nlohmann::json, wstring>>& truePBRData,
-    const wstring& texName, const map<wstring, vector<size_t>>& lookup, const wstring& slotLabel,
-    const wstring& nifPath)
+void PatcherMeshShaderTruePBR::getSlotMatch(TruePBRMatchData& truePBRData, const wstring& texName,
+    const ParallaxGenSuffixTrie& lookup, const wstring& slotLabel, const wstring& nifPath)
 {
-    // binary search for map
-    auto mapReverse = boost::to_lower_copy(texName);
-    std::ranges::reverse(mapReverse);
-    auto it = lookup.lower_bound(mapReverse);
-
-    // get the first element of the reverse path
-    auto reverseFile = mapReverse;
-    auto pos = reverseFile.find_first_of(L"\\");
-    if (pos != wstring::npos) {
-        reverseFile = reverseFile.substr(0, pos);
-    }
-
-    // Check if match is 1 back
-    if (it != lookup.begin() && boost::starts_with(prev(it)->first, reverseFile)) {
-        it = prev(it);
-    } else if (it != lookup.end() && boost::starts_with(it->first, reverseFile)) {
-        // Check if match is current iterator, just continue here
-    } else {
-        // No match found
-        Logger::trace(L"No PBR JSON match found for \"{}\":\"{}\"", slotLabel, texName);
-        return;
-    }
+    // matched fields have to cover at least the whole file name
+    const auto fileNamePos = texName.find_last_of(L'\\');
+    const size_t fileNameLength = fileNamePos == wstring::npos ? texName.length() : texName.length() - fileNamePos - 1;
 
-    auto beginIt = it;
-    while (beginIt != lookup.begin()) {
-        if (boost::starts_with(prev(beginIt)->first, reverseFile)) {
-            beginIt = prev(beginIt);
-        } else {
-            break;
-        }
-    }
-
-    // Initialize CFG set
-    set<size_t> cfgs;
-
-    // create vector of all matches based on beginIt and It
-    while (beginIt != next(it)) {
-        if (!boost::starts_with(mapReverse, beginIt->first)) {
-            // not a valid match
-            beginIt = next(beginIt);
-            continue;
-        }
-
-        cfgs.insert(beginIt->second.begin(), beginIt->second.end());
-        beginIt = next(beginIt);
-    }
+    // reused per thread, findSuffixes clears it
+    static thread_local vector<size_t> cfgs;
+    lookup.findSuffixes(texName, fileNameLength, cfgs);
 
     if (cfgs.empty()) {
         Logger::trace(L"No PBR JSON match found for \"{}\":\"{}\"", slotLabel, texName);
@@ -357,47 +577,32 @@ void PatcherMeshShaderTruePBR::getSlotMatch(map<size_t, tuple<nlohmann::json, ws
 }
 
 void PatcherMeshShaderTruePBR::getPathContainsMatch(
-    std::map<size_t, std::tuple<nlohmann::json, std::wstring>>& truePBRData, const std::wstring& diffuse,
-    const wstring& nifPath)
+    TruePBRMatchData& truePBRData, const std::wstring& diffuse, const wstring& nifPath)
 {
-    // "patch_contains" attribute: Linear search for path_contains
-    auto& cache = getPathLookupCache();
-
-    // Check for path_contains only if no name match because it's a O(n) operation
-    size_t numMatches = 0;
-    for (const auto& config : getPathLookupJSONs()) {
-        // Check if in cache
-        auto cacheKey = make_tuple(ParallaxGenUtil::utf8toUTF16(config.second["path_contains"].get<string>()), diffuse);
-
-        bool pathMatch = false;
-        if (cache.find(cacheKey) == cache.end()) {
-            // Not in cache, update it
-            cache[cacheKey] = boost::icontains(diffuse, get<0>(cacheKey));
-        }
+    // "patch_contains" attribute: single pass over the diffuse path for all path_contains rules
+    // reused per thread, findAll clears it
+    static thread_local vector<size_t> cfgs;
+    getPathContainsMatcher().findAll(diffuse, cfgs);
 
-        pathMatch = cache[cacheKey];
-        if (pathMatch) {
-            numMatches++;
-            insertTruePBRData(truePBRData, diffuse, config.first, nifPath);
-        }
+    for (const auto& cfg : cfgs) {
+        insertTruePBRData(truePBRData, diffuse, cfg, nifPath);
     }
 
     const wstring slotLabel = L"path_contains";
-    if (numMatches > 0) {
-        Logger::trace(L"Matched {} PBR JSONs for \"{}\":\"{}\"", numMatches, slotLabel, diffuse);
+    if (!cfgs.empty()) {
+        Logger::trace(L"Matched {} PBR JSONs for \"{}\":\"{}\"", cfgs.size(), slotLabel, diffuse);
     } else {
         Logger::trace(L"No PBR JSON match found for \"{}\":\"{}\"", slotLabel, diffuse);
     }
 }
 
 auto PatcherMeshShaderTruePBR::insertTruePBRData(
-    std::map<size_t, std::tuple<nlohmann::json, std::wstring>>& truePBRData, const wstring& texName, size_t cfg,
-    const wstring& nifPath) -> void
+    TruePBRMatchData& truePBRData, const wstring& texName, size_t cfg, const wstring& nifPath) -> void
 {
-    const auto curCfg = getTruePBRConfigs()[cfg];
+    const auto& rule = getTruePBRRules()[cfg];
 
     // Check if we should skip this due to nif filter (this is expsenive, so we do it last)
-    if (curCfg.contains("nif_filter") && !boost::icontains(nifPath, curCfg["nif_filter"].get<string>())) {
+    if (rule.has(TruePBRRule::FIELD_NIF_FILTER) && !boost::contains(nifPath, rule.nifFilter)) {
         Logger::trace(L"Config {} PBR JSON Rejected: nif_filter {}", cfg, nifPath);
         return;
     }
@@ -410,32 +615,24 @@ auto PatcherMeshShaderTruePBR::insertTruePBRData(
     }
 
     // Get PBR path, which is the path without the matched field
-    auto matchedFieldStr = curCfg.contains("match_normal") ? curCfg["match_normal"].get<string>()
-                                                           : curCfg["match_diffuse"].get<string>();
-    auto matchedFieldBase = NIFUtil::getTexBase(matchedFieldStr);
-    texPath.erase(texPath.length() - matchedFieldBase.length(), matchedFieldBase.length());
-
-    auto matchedField = ParallaxGenUtil::utf8toUTF16(matchedFieldStr);
-
-    // "rename" attribute
-    if (curCfg.contains("rename")) {
-        auto renameField = curCfg["rename"].get<string>();
-        if (!boost::iequals(renameField, matchedField)) {
-            matchedField = ParallaxGenUtil::utf8toUTF16(renameField);
-        }
+    if (rule.matchFieldBaseLength > texPath.length()) {
+        Logger::trace(L"Config {} PBR JSON Rejected: matched field longer than {}", cfg, texName);
+        return;
     }
+    texPath.erase(texPath.length() - rule.matchFieldBaseLength, rule.matchFieldBaseLength);
 
-    Logger::trace(L"Config {} PBR texture path created: {}", cfg, matchedField);
+    Logger::trace(L"Config {} PBR texture path created: {}", cfg, rule.pbrSuffix);
 
     // Check if named_field is a directory
-    wstring matchedPath = boost::to_lower_copy(texPath + matchedField);
-    const bool enableTruePBR = (!curCfg.contains("pbr") || curCfg["pbr"]) && !matchedPath.empty();
+    wstring matchedPath = boost::to_lower_copy(texPath) + rule.pbrSuffix;
+    const bool enableTruePBR
+        = (!rule.has(TruePBRRule::FIELD_PBR) || rule.flag(TruePBRRule::FIELD_PBR)) && !matchedPath.empty();
     if (!enableTruePBR) {
         matchedPath = L"";
     }
 
     Logger::trace(L"Config {} PBR JSON accepted", cfg);
-    truePBRData.insert({ cfg, { curCfg, matchedPath } });
+    truePBRData.insert({ cfg, matchedPath });
 }
 
 auto PatcherMeshShaderTruePBR::applyPatch(
@@ -458,17 +655,72 @@ auto PatcherMeshShaderTruePBR::applyPatch(
     // get extra data from match
     bool changed = false;
 
-    auto extraData = static_pointer_cast<map<size_t, tuple<nlohmann::json, wstring>>>(match.extraData);
-    for (const auto& [Sequence, Data] : *extraData) {
+    const auto& rules = getTruePBRRules();
+    auto extraData = static_pointer_cast<TruePBRMatchData>(match.extraData);
+    for (const auto& [sequence, matchedPath] : *extraData) {
         // apply one patch
-        auto truePBRData = get<0>(Data);
-        auto matchedPath = get<1>(Data);
-        changed |= applyOnePatch(&nifShape, truePBRData, matchedPath, newSlots);
+        changed |= applyOnePatch(&nifShape, rules[sequence], matchedPath, newSlots);
+    }
+
+    // "smooth_angle" attribute: normals are rebuilt from positions, so they are recalculated once per shape
+    const auto smoothAngle = getSmoothAngle(*extraData);
+    if (smoothAngle.has_value()) {
+        recalcNormalsAndTangents(nifShape, smoothAngle.value());
+        changed = true;
     }
 
     return changed;
 }
 
+auto PatcherMeshShaderTruePBR::getSmoothAngle(const TruePBRMatchData& truePBRData) -> optional<float>
+{
+    // rules are applied in config order and later rules override earlier ones, so the last rule with the attribute wins
+    const auto& rules = getTruePBRRules();
+    for (const auto& [sequence, matchedPath] : views::reverse(truePBRData)) {
+        const auto& rule = rules[sequence];
+        if (rule.has(TruePBRRule::FIELD_SMOOTH_ANGLE) && !rule.flag(TruePBRRule::FIELD_DELETE)) {
+            return rule.smoothAngle;
+        }
+    }
+
+    return nullopt;
+}
+
+void PatcherMeshShaderTruePBR::recalcNormalsAndTangents(nifly::NiShape& nifShape, const float& smoothAngle)
+{
+    auto* bsTriShape = dynamic_cast<BSTriShape*>(&nifShape);
+    const auto* verts = getNIF()->GetVertsForShape(&nifShape);
+    const auto* uvs = getNIF()->GetUvsForShape(&nifShape);
+    if (bsTriShape == nullptr || !bsTriShape->HasNormals() || !bsTriShape->HasTangents() || verts == nullptr
+        || uvs == nullptr || uvs->size() != verts->size()) {
+        // other shape types keep tangents in extra data, nifly handles those
+        getNIF()->CalcNormalsForShape(&nifShape, true, true, smoothAngle);
+        getNIF()->CalcTangentsForShape(&nifShape);
+        return;
+    }
+
+    vector<Triangle> tris;
+    nifShape.GetTriangles(tris);
+
+    vector<Vector3> normals(verts->size());
+    vector<Vector3> tangents(verts->size());
+    vector<Vector3> bitangents(verts->size());
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+    ParallaxGenMeshMath::calcNormals(reinterpret_cast<const float*>(verts->data()), verts->size(),
+        reinterpret_cast<const uint16_t*>(tris.data()), tris.size(), smoothAngle,
+        reinterpret_cast<float*>(normals.data()));
+    ParallaxGenMeshMath::calcTangents(reinterpret_cast<const float*>(verts->data()),
+        reinterpret_cast<const float*>(uvs->data()), reinterpret_cast<const float*>(normals.data()), verts->size(),
+        reinterpret_cast<const uint16_t*>(tris.data()), tris.size(), reinterpret_cast<float*>(tangents.data()),
+        reinterpret_cast<float*>(bitangents.data()));
+    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+
+    getNIF()->SetNormalsForShape(&nifShape, normals);
+    bsTriShape->SetTangentData(tangents);
+    bsTriShape->SetBitangentData(bitangents);
+}
+
 auto PatcherMeshShaderTruePBR::applyPatchSlots(
     const NIFUtil::TextureSet& oldSlots, const PatcherMatch& match, NIFUtil::TextureSet& newSlots) -> bool
 {
@@ -486,86 +738,85 @@ auto PatcherMeshShaderTruePBR::applyPatchSlots(
     }
 
     newSlots = oldSlots;
-    auto extraData = static_pointer_cast<map<size_t, tuple<nlohmann::json, wstring>>>(match.extraData);
-    for (const auto& [Sequence, Data] : *extraData) {
-        auto truePBRData = get<0>(Data);
-        auto matchedPath = get<1>(Data);
-        applyOnePatchSlots(newSlots, truePBRData, matchedPath);
+    const auto& rules = getTruePBRRules();
+    auto extraData = static_pointer_cast<TruePBRMatchData>(match.extraData);
+    for (const auto& [sequence, matchedPath] : *extraData) {
+        applyOnePatchSlots(newSlots, rules[sequence], matchedPath);
     }
 
     return newSlots != oldSlots;
 }
 
-void PatcherMeshShaderTruePBR::applyOnePatchSwapJSON(const nlohmann::json& truePBRData, nlohmann::json& output)
+void PatcherMeshShaderTruePBR::applyOnePatchSwapJSON(const TruePBRRule& rule, nlohmann::json& output)
 {
     // "coatColor"
-    if (truePBRData.contains("coat_color")) {
-        output["coatColor"] = truePBRData["coat_color"];
+    if (rule.has(TruePBRRule::FIELD_COAT_COLOR)) {
+        output["coatColor"] = rule.coatColor;
     }
     // "coatRoughness"
-    if (truePBRData.contains("coat_roughness")) {
-        output["coatRoughness"] = truePBRData["coat_roughness"];
+    if (rule.has(TruePBRRule::FIELD_COAT_ROUGHNESS)) {
+        output["coatRoughness"] = rule.coatRoughness;
     }
     // "coatSpecularLevel"
-    if (truePBRData.contains("coat_specular_level")) {
-        output["coatSpecularLevel"] = truePBRData["coat_specular_level"];
+    if (rule.has(TruePBRRule::FIELD_COAT_SPECULAR_LEVEL)) {
+        output["coatSpecularLevel"] = rule.coatSpecularLevel;
     }
     // "coatStrength"
-    if (truePBRData.contains("coat_strength")) {
-        output["coatStrength"] = truePBRData["coat_strength"];
+    if (rule.has(TruePBRRule::FIELD_COAT_STRENGTH)) {
+        output["coatStrength"] = rule.coatStrength;
     }
     // "displacementScale"
-    if (truePBRData.contains("displacement_scale")) {
-        output["displacementScale"] = truePBRData["displacement_scale"];
+    if (rule.has(TruePBRRule::FIELD_DISPLACEMENT_SCALE)) {
+        output["displacementScale"] = rule.displacementScale;
     }
     // "fuzzColor"
-    if (truePBRData.contains("fuzz") && truePBRData["fuzz"].contains("color")) {
-        output["fuzzColor"] = truePBRData["fuzz"]["color"];
+    if (rule.has(TruePBRRule::FIELD_FUZZ_COLOR)) {
+        output["fuzzColor"] = rule.fuzzColor;
     }
     // "fuzzWeight"
-    if (truePBRData.contains("fuzz") && truePBRData["fuzz"].contains("weight")) {
-        output["fuzzWeight"] = truePBRData["fuzz"]["weight"];
+    if (rule.has(TruePBRRule::FIELD_FUZZ_WEIGHT)) {
+        output["fuzzWeight"] = rule.fuzzWeight;
     }
     // "glintParameters"
-    if (truePBRData.contains("glint")) {
+    if (rule.has(TruePBRRule::FIELD_GLINT)) {
         output["glintParameters"] = nlohmann::json::object();
         output["glintParameters"]["enabled"] = true;
     }
     // "densityRandomization"
-    if (truePBRData.contains("glint") && truePBRData["glint"].contains("density_randomization")) {
-        output["glintParameters"]["densityRandomization"] = truePBRData["glint"]["density_randomization"];
+    if (rule.has(TruePBRRule::FIELD_GLINT_DENSITY_RANDOMIZATION)) {
+        output["glintParameters"]["densityRandomization"] = rule.glintDensityRandomization;
     }
     // "logMicrofacetDensity"
-    if (truePBRData.contains("glint") && truePBRData["glint"].contains("log_microfacet_density")) {
-        output["glintParameters"]["logMicrofacetDensity"] = truePBRData["glint"]["log_microfacet_density"];
+    if (rule.has(TruePBRRule::FIELD_GLINT_LOG_MICROFACET_DENSITY)) {
+        output["glintParameters"]["logMicrofacetDensity"] = rule.glintLogMicrofacetDensity;
     }
     // "microfacetDensity"
-    if (truePBRData.contains("glint") && truePBRData["glint"].contains("microfacet_density")) {
-        output["glintParameters"]["microfacetDensity"] = truePBRData["glint"]["microfacet_density"];
+    if (rule.has(TruePBRRule::FIELD_GLINT_MICROFACET_DENSITY)) {
+        output["glintParameters"]["microfacetDensity"] = rule.glintMicrofacetDensity;
     }
     // "screenSpaceScale"
-    if (truePBRData.contains("glint") && truePBRData["glint"].contains("screen_space_scale")) {
-        output["glintParameters"]["screenSpaceScale"] = truePBRData["glint"]["screen_space_scale"];
+    if (rule.has(TruePBRRule::FIELD_GLINT_SCREEN_SPACE_SCALE)) {
+        output["glintParameters"]["screenSpaceScale"] = rule.glintScreenSpaceScale;
     }
     // "innerLayerDisplacementOffset"
     // if (truePBRData.contains("inner_layer_displacement_offset")) {
     //  output["innerLayerDisplacementOffset"] = truePBRData["inner_layer_displacement_offset"];
     //}
     // "roughnessScale"
-    if (truePBRData.contains("roughness_scale")) {
-        output["roughnessScale"] = truePBRData["roughness_scale"];
+    if (rule.has(TruePBRRule::FIELD_ROUGHNESS_SCALE)) {
+        output["roughnessScale"] = rule.roughnessScale;
     }
     // "specularLevel"
-    if (truePBRData.contains("specular_level")) {
-        output["specularLevel"] = truePBRData["specular_level"];
+    if (rule.has(TruePBRRule::FIELD_SPECULAR_LEVEL)) {
+        output["specularLevel"] = rule.specularLevel;
     }
     // "subsurfaceColor"
-    if (truePBRData.contains("subsurface_color")) {
-        output["subsurfaceColor"] = truePBRData["subsurface_color"];
+    if (rule.has(TruePBRRule::FIELD_SUBSURFACE_COLOR)) {
+        output["subsurfaceColor"] = rule.subsurfaceColor;
     }
     // "subsurfaceOpacity"
-    if (truePBRData.contains("subsurface_opacity")) {
-        output["subsurfaceOpacity"] = truePBRData["subsurface_opacity"];
+    if (rule.has(TruePBRRule::FIELD_SUBSURFACE_OPACITY)) {
+        output["subsurfaceOpacity"] = rule.subsurfaceOpacity;
     }
 }
 
@@ -610,6 +861,8 @@ void PatcherMeshShaderTruePBR::loadOptions(const bool& checkPaths, const bool& p
     s_printNonExistentPaths = printNonExistentPaths;
 }
 
+auto PatcherMeshShaderTruePBR::getNewTXSTRecordWriter() const -> NewTXSTRecordWriter { return processNewTXSTRecord; }
+
 void PatcherMeshShaderTruePBR::processNewTXSTRecord(const PatcherMatch& match, const std::string& edid)
 {
     // create texture swap json
@@ -622,10 +875,10 @@ void PatcherMeshShaderTruePBR::processNewTXSTRecord(const PatcherMatch& match, c
     }
 
     nlohmann::json textureSwap = nlohmann::json::object();
-    auto extraData = static_pointer_cast<map<size_t, tuple<nlohmann::json, wstring>>>(match.extraData);
-    for (const auto& [sequence, data] : *extraData) {
-        auto truePBRData = get<0>(data);
-        applyOnePatchSwapJSON(truePBRData, textureSwap);
+    const auto& rules = getTruePBRRules();
+    auto extraData = static_pointer_cast<TruePBRMatchData>(match.extraData);
+    for (const auto& [sequence, matchedPath] : *extraData) {
+        applyOnePatchSwapJSON(rules[sequence], textureSwap);
     }
 
     // write to file
@@ -637,7 +890,7 @@ void PatcherMeshShaderTruePBR::processNewTXSTRecord(const PatcherMatch& match, c
     out.close();
 }
 
-auto PatcherMeshShaderTruePBR::applyOnePatch(NiShape* nifShape, nlohmann::json& truePBRData,
+auto PatcherMeshShaderTruePBR::applyOnePatch(NiShape* nifShape, const TruePBRRule& rule,
     const std::wstring& matchedPath, NIFUtil::TextureSet& newSlots) -> bool
 {
     bool changed = false;
@@ -646,10 +899,10 @@ auto PatcherMeshShaderTruePBR::applyOnePatch(NiShape* nifShape, nlohmann::json&
     auto* nifShader = getNIF()->GetShader(nifShape);
     auto* const nifShaderBSLSP = dynamic_cast<BSLightingShaderProperty*>(nifShader);
     const bool enableTruePBR = !matchedPath.empty();
-    const bool enableEnvMapping = truePBRData.contains("env_mapping") && truePBRData["env_mapping"] && !enableTruePBR;
+    const bool enableEnvMapping = rule.flag(TruePBRRule::FIELD_ENV_MAPPING) && !enableTruePBR;
 
     // "delete" attribute
-    if (truePBRData.contains("delete") && truePBRData["delete"]) {
+    if (rule.flag(TruePBRRule::FIELD_DELETE)) {
         if (nifShader->GetAlpha() > 0.0) {
             nifShader->SetAlpha(0.0);
             changed = true;
@@ -657,25 +910,18 @@ auto PatcherMeshShaderTruePBR::applyOnePatch(NiShape* nifShape, nlohmann::json&
         return changed;
     }
 
-    // "smooth_angle" attribute
-    if (truePBRData.contains("smooth_angle")) {
-        getNIF()->CalcNormalsForShape(nifShape, true, true, truePBRData["smooth_angle"]);
-        getNIF()->CalcTangentsForShape(nifShape);
-        changed = true;
-    }
-
     // "auto_uv" attribute
-    if (truePBRData.contains("auto_uv")) {
+    if (rule.has(TruePBRRule::FIELD_AUTO_UV)) {
         vector<Triangle> tris;
         nifShape->GetTriangles(tris);
         auto newUVScale = autoUVScale(getNIF()->GetUvsForShape(nifShape), getNIF()->GetVertsForShape(nifShape), tris)
-            / truePBRData["auto_uv"];
+            / rule.autoUV;
         changed |= NIFUtil::setShaderVec2(nifShaderBSLSP->uvScale, newUVScale);
     }
 
     // "vertex_colors" attribute
-    if (truePBRData.contains("vertex_colors")) {
-        auto newVertexColors = truePBRData["vertex_colors"].get<bool>();
+    if (rule.has(TruePBRRule::FIELD_VERTEX_COLORS)) {
+        auto newVertexColors = rule.flag(TruePBRRule::FIELD_VERTEX_COLORS);
         if (nifShape->HasVertexColors() != newVertexColors) {
             nifShape->SetVertexColors(newVertexColors);
             changed = true;
@@ -688,18 +934,16 @@ auto PatcherMeshShaderTruePBR::applyOnePatch(NiShape* nifShape, nlohmann::json&
     }
 
     // "specular_level" attribute
-    if (truePBRData.contains("specular_level")) {
-        auto newSpecularLevel = truePBRData["specular_level"].get<float>();
-        if (nifShader->GetGlossiness() != newSpecularLevel) {
-            nifShader->SetGlossiness(newSpecularLevel);
+    if (rule.has(TruePBRRule::FIELD_SPECULAR_LEVEL)) {
+        if (nifShader->GetGlossiness() != rule.specularLevel) {
+            nifShader->SetGlossiness(rule.specularLevel);
             changed = true;
         }
     }
 
     // "subsurface_color" attribute
-    if (truePBRData.contains("subsurface_color") && truePBRData["subsurface_color"].size() >= 3) {
-        auto newSpecularColor = Vector3(truePBRData["subsurface_color"][0].get<float>(),
-            truePBRData["subsurface_color"][1].get<float>(), truePBRData["subsurface_color"][2].get<float>());
+    if (rule.has(TruePBRRule::FIELD_SUBSURFACE_COLOR)) {
+        auto newSpecularColor = Vector3(rule.subsurfaceColor[0], rule.subsurfaceColor[1], rule.subsurfaceColor[2]);
         if (nifShader->GetSpecularColor() != newSpecularColor) {
             nifShader->SetSpecularColor(newSpecularColor);
             changed = true;
@@ -707,24 +951,21 @@ auto PatcherMeshShaderTruePBR::applyOnePatch(NiShape* nifShape, nlohmann::json&
     }
 
     // "roughness_scale" attribute
-    if (truePBRData.contains("roughness_scale")) {
-        auto newRoughnessScale = truePBRData["roughness_scale"].get<float>();
-        if (nifShader->GetSpecularStrength() != newRoughnessScale) {
-            nifShader->SetSpecularStrength(newRoughnessScale);
+    if (rule.has(TruePBRRule::FIELD_ROUGHNESS_SCALE)) {
+        if (nifShader->GetSpecularStrength() != rule.roughnessScale) {
+            nifShader->SetSpecularStrength(rule.roughnessScale);
             changed = true;
         }
     }
 
     // "subsurface_opacity" attribute
-    if (truePBRData.contains("subsurface_opacity")) {
-        auto newSubsurfaceOpacity = truePBRData["subsurface_opacity"].get<float>();
-        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->softlighting, newSubsurfaceOpacity);
+    if (rule.has(TruePBRRule::FIELD_SUBSURFACE_OPACITY)) {
+        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->softlighting, rule.subsurfaceOpacity);
     }
 
     // "displacement_scale" attribute
-    if (truePBRData.contains("displacement_scale")) {
-        auto newDisplacementScale = truePBRData["displacement_scale"].get<float>();
-        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->rimlightPower, newDisplacementScale);
+    if (rule.has(TruePBRRule::FIELD_DISPLACEMENT_SCALE)) {
+        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->rimlightPower, rule.displacementScale);
     }
 
     // "EnvMapping" attribute
@@ -735,31 +976,28 @@ auto PatcherMeshShaderTruePBR::applyOnePatch(NiShape* nifShape, nlohmann::json&
     }
 
     // "EnvMap_scale" attribute
-    if (truePBRData.contains("env_map_scale") && enableEnvMapping) {
-        auto newEnvMapScale = truePBRData["env_map_scale"].get<float>();
-        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->environmentMapScale, newEnvMapScale);
+    if (rule.has(TruePBRRule::FIELD_ENV_MAP_SCALE) && enableEnvMapping) {
+        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->environmentMapScale, rule.envMapScale);
     }
 
     // "EnvMap_scale_mult" attribute
-    if (truePBRData.contains("env_map_scale_mult") && enableEnvMapping) {
-        nifShaderBSLSP->environmentMapScale *= truePBRData["env_map_scale_mult"].get<float>();
+    if (rule.has(TruePBRRule::FIELD_ENV_MAP_SCALE_MULT) && enableEnvMapping) {
+        nifShaderBSLSP->environmentMapScale *= rule.envMapScaleMult;
         changed = true;
     }
 
     // "emmissive_scale" attribute
-    if (truePBRData.contains("emissive_scale")) {
-        auto newEmissiveScale = truePBRData["emissive_scale"].get<float>();
-        if (nifShader->GetEmissiveMultiple() != newEmissiveScale) {
-            nifShader->SetEmissiveMultiple(newEmissiveScale);
+    if (rule.has(TruePBRRule::FIELD_EMISSIVE_SCALE)) {
+        if (nifShader->GetEmissiveMultiple() != rule.emissiveScale) {
+            nifShader->SetEmissiveMultiple(rule.emissiveScale);
             changed = true;
         }
     }
 
     // "emmissive_color" attribute
-    if (truePBRData.contains("emissive_color") && truePBRData["emissive_color"].size() >= 4) {
-        auto newEmissiveColor
-            = Color4(truePBRData["emissive_color"][0].get<float>(), truePBRData["emissive_color"][1].get<float>(),
-                truePBRData["emissive_color"][2].get<float>(), truePBRData["emissive_color"][3].get<float>());
+    if (rule.has(TruePBRRule::FIELD_EMISSIVE_COLOR)) {
+        auto newEmissiveColor = Color4(
+            rule.emissiveColor[0], rule.emissiveColor[1], rule.emissiveColor[2], rule.emissiveColor[3]);
         if (nifShader->GetEmissiveColor() != newEmissiveColor) {
             nifShader->SetEmissiveColor(newEmissiveColor);
             changed = true;
@@ -767,43 +1005,43 @@ auto PatcherMeshShaderTruePBR::applyOnePatch(NiShape* nifShape, nlohmann::json&
     }
 
     // "uv_scale" attribute
-    if (truePBRData.contains("uv_scale")) {
-        auto newUVScale = Vector2(truePBRData["uv_scale"].get<float>(), truePBRData["uv_scale"].get<float>());
+    if (rule.has(TruePBRRule::FIELD_UV_SCALE)) {
+        auto newUVScale = Vector2(rule.uvScale, rule.uvScale);
         changed |= NIFUtil::setShaderVec2(nifShaderBSLSP->uvScale, newUVScale);
     }
 
     // "pbr" attribute
     if (enableTruePBR) {
         // no pbr, we can return here
-        changed |= enableTruePBROnShape(nifShape, nifShader, nifShaderBSLSP, truePBRData, matchedPath, newSlots);
+        changed |= enableTruePBROnShape(nifShape, nifShader, nifShaderBSLSP, rule, matchedPath, newSlots);
     }
 
     return changed;
 }
 
 void PatcherMeshShaderTruePBR::applyOnePatchSlots(
-    NIFUtil::TextureSet& slots, const nlohmann::json& truePBRData, const std::wstring& matchedPath)
+    NIFUtil::TextureSet& slots, const TruePBRRule& rule, const std::wstring& matchedPath)
 {
     if (matchedPath.empty()) {
         return;
     }
 
     // "lock_diffuse" attribute
-    if (!flag(truePBRData, "lock_diffuse")) {
+    if (!rule.flag(TruePBRRule::FIELD_LOCK_DIFFUSE)) {
         auto newDiffuse = matchedPath + L".dds";
         slots[static_cast<size_t>(NIFUtil::TextureSlots::DIFFUSE)] = newDiffuse;
     }
 
     // "lock_normal" attribute
-    if (!flag(truePBRData, "lock_normal")) {
+    if (!rule.flag(TruePBRRule::FIELD_LOCK_NORMAL)) {
         auto newNormal = matchedPath + L"_n.dds";
         slots[static_cast<size_t>(NIFUtil::TextureSlots::NORMAL)] = newNormal;
     }
 
     // "emissive" attribute
-    if (truePBRData.contains("emissive") && !flag(truePBRData, "lock_emissive")) {
+    if (rule.has(TruePBRRule::FIELD_EMISSIVE) && !rule.flag(TruePBRRule::FIELD_LOCK_EMISSIVE)) {
         wstring newGlow;
-        if (truePBRData["emissive"].get<bool>()) {
+        if (rule.flag(TruePBRRule::FIELD_EMISSIVE)) {
             newGlow = matchedPath + L"_g.dds";
         }
 
@@ -811,9 +1049,9 @@ void PatcherMeshShaderTruePBR::applyOnePatchSlots(
     }
 
     // "parallax" attribute
-    if (truePBRData.contains("parallax") && !flag(truePBRData, "lock_parallax")) {
+    if (rule.has(TruePBRRule::FIELD_PARALLAX) && !rule.flag(TruePBRRule::FIELD_LOCK_PARALLAX)) {
         wstring newParallax;
-        if (truePBRData["parallax"].get<bool>()) {
+        if (rule.flag(TruePBRRule::FIELD_PARALLAX)) {
             newParallax = matchedPath + L"_p.dds";
         }
 
@@ -821,29 +1059,28 @@ void PatcherMeshShaderTruePBR::applyOnePatchSlots(
     }
 
     // "cubemap" attribute
-    if (truePBRData.contains("cubemap") && !flag(truePBRData, "lock_cubemap")) {
-        auto newCubemap = ParallaxGenUtil::utf8toUTF16(truePBRData["cubemap"].get<string>());
-        slots[static_cast<size_t>(NIFUtil::TextureSlots::CUBEMAP)] = newCubemap;
+    if (rule.has(TruePBRRule::FIELD_CUBEMAP) && !rule.flag(TruePBRRule::FIELD_LOCK_CUBEMAP)) {
+        slots[static_cast<size_t>(NIFUtil::TextureSlots::CUBEMAP)] = rule.cubemap;
     } else {
         slots[static_cast<size_t>(NIFUtil::TextureSlots::CUBEMAP)] = L"";
     }
 
     // "lock_rmaos" attribute
-    if (!flag(truePBRData, "lock_rmaos")) {
+    if (!rule.flag(TruePBRRule::FIELD_LOCK_RMAOS)) {
         auto newRMAOS = matchedPath + L"_rmaos.dds";
         slots[static_cast<size_t>(NIFUtil::TextureSlots::ENVMASK)] = newRMAOS;
     }
 
     // "lock_cnr" attribute
-    if (!flag(truePBRData, "lock_cnr")) {
+    if (!rule.flag(TruePBRRule::FIELD_LOCK_CNR)) {
         // "coat_normal" attribute
         wstring newCNR;
-        if (truePBRData.contains("coat_normal") && truePBRData["coat_normal"].get<bool>()) {
+        if (rule.flag(TruePBRRule::FIELD_COAT_NORMAL)) {
             newCNR = matchedPath + L"_cnr.dds";
         }
 
         // Fuzz texture slot
-        if (truePBRData.contains("fuzz") && flag(truePBRData["fuzz"], "texture")) {
+        if (rule.flag(TruePBRRule::FIELD_FUZZ_TEXTURE)) {
             newCNR = matchedPath + L"_f.dds";
         }
 
@@ -851,12 +1088,11 @@ void PatcherMeshShaderTruePBR::applyOnePatchSlots(
     }
 
     // "lock_subsurface" attribute
-    if (!flag(truePBRData, "lock_subsurface")) {
+    if (!rule.flag(TruePBRRule::FIELD_LOCK_SUBSURFACE)) {
         // "subsurface_foliage" attribute
         wstring newSubsurface;
-        if ((truePBRData.contains("subsurface_foliage") && truePBRData["subsurface_foliage"].get<bool>())
-            || (truePBRData.contains("subsurface") && truePBRData["subsurface"].get<bool>())
-            || (truePBRData.contains("coat_diffuse") && truePBRData["coat_diffuse"].get<bool>())) {
+        if (rule.flag(TruePBRRule::FIELD_SUBSURFACE_FOLIAGE) || rule.flag(TruePBRRule::FIELD_SUBSURFACE)
+            || rule.flag(TruePBRRule::FIELD_COAT_DIFFUSE)) {
             newSubsurface = matchedPath + L"_s.dds";
         }
 
@@ -864,36 +1100,26 @@ void PatcherMeshShaderTruePBR::applyOnePatchSlots(
     }
 
     // "SlotX" attributes
-    for (int i = 0; i < NUM_TEXTURE_SLOTS - 1; i++) {
-        std::string slotName("slot");
-        slotName += std::to_string(i + 1);
-
-        if (truePBRData.contains(slotName)) {
-            std::string newSlot = truePBRData[slotName].get<std::string>();
-
-            // Prepend "textures\\" if it's not already there
-            if (!boost::istarts_with(newSlot, "textures\\")) {
-                newSlot.insert(0, "textures\\");
-            }
-
-            slots.at(i) = ParallaxGenUtil::utf8toUTF16(newSlot);
+    for (size_t i = 0; i < NUM_TEXTURE_SLOTS - 1; i++) {
+        if (rule.hasSlot(i)) {
+            slots.at(i) = rule.slots.at(i);
         }
     }
 }
 
 auto PatcherMeshShaderTruePBR::enableTruePBROnShape(NiShape* nifShape, NiShader* nifShader,
-    BSLightingShaderProperty* nifShaderBSLSP, nlohmann::json& truePBRData, const wstring& matchedPath,
+    BSLightingShaderProperty* nifShaderBSLSP, const TruePBRRule& rule, const wstring& matchedPath,
     NIFUtil::TextureSet& newSlots) -> bool
 {
     bool changed = false;
 
-    applyOnePatchSlots(newSlots, truePBRData, matchedPath);
+    applyOnePatchSlots(newSlots, rule, matchedPath);
     changed |= setTextureSet(*nifShape, newSlots);
 
     // "emissive" attribute
-    if (truePBRData.contains("emissive")) {
+    if (rule.has(TruePBRRule::FIELD_EMISSIVE)) {
         changed |= NIFUtil::configureShaderFlag(
-            nifShaderBSLSP, SLSF1_EXTERNAL_EMITTANCE, truePBRData["emissive"].get<bool>());
+            nifShaderBSLSP, SLSF1_EXTERNAL_EMITTANCE, rule.flag(TruePBRRule::FIELD_EMISSIVE));
     }
 
     // revert to default NIFShader type, remove flags used in other types
@@ -905,34 +1131,32 @@ auto PatcherMeshShaderTruePBR::enableTruePBROnShape(NiShape* nifShape, NiShader*
     // Enable PBR flag
     changed |= NIFUtil::setShaderFlag(nifShaderBSLSP, SLSF2_UNUSED01);
 
-    if (truePBRData.contains("subsurface_foliage") && truePBRData["subsurface_foliage"].get<bool>()
-        && truePBRData.contains("subsurface") && truePBRData["subsurface"].get<bool>()) {
+    if (rule.flag(TruePBRRule::FIELD_SUBSURFACE_FOLIAGE) && rule.flag(TruePBRRule::FIELD_SUBSURFACE)) {
         Logger::error(L"Error: Subsurface and foliage NIFShader chosen at once, undefined behavior!");
     }
 
     // "subsurface" attribute
-    if (truePBRData.contains("subsurface")) {
-        changed
-            |= NIFUtil::configureShaderFlag(nifShaderBSLSP, SLSF2_RIM_LIGHTING, truePBRData["subsurface"].get<bool>());
+    if (rule.has(TruePBRRule::FIELD_SUBSURFACE)) {
+        changed |= NIFUtil::configureShaderFlag(
+            nifShaderBSLSP, SLSF2_RIM_LIGHTING, rule.flag(TruePBRRule::FIELD_SUBSURFACE));
     }
 
     // "hair" attribute
-    if (flag(truePBRData, "hair")) {
+    if (rule.flag(TruePBRRule::FIELD_HAIR)) {
         changed |= NIFUtil::setShaderFlag(nifShaderBSLSP, SLSF2_BACK_LIGHTING);
     }
 
     // "multilayer" attribute
     bool enableMultiLayer = false;
-    if (truePBRData.contains("multilayer") && truePBRData["multilayer"]) {
+    if (rule.flag(TruePBRRule::FIELD_MULTILAYER)) {
         enableMultiLayer = true;
 
         changed |= NIFUtil::setShaderType(nifShader, BSLSP_MULTILAYERPARALLAX);
         changed |= NIFUtil::setShaderFlag(nifShaderBSLSP, SLSF2_MULTI_LAYER_PARALLAX);
 
         // "coat_color" attribute
-        if (truePBRData.contains("coat_color") && truePBRData["coat_color"].size() >= 3) {
-            auto newCoatColor = Vector3(truePBRData["coat_color"][0].get<float>(),
-                truePBRData["coat_color"][1].get<float>(), truePBRData["coat_color"][2].get<float>());
+        if (rule.has(TruePBRRule::FIELD_COAT_COLOR)) {
+            auto newCoatColor = Vector3(rule.coatColor[0], rule.coatColor[1], rule.coatColor[2]);
             if (nifShader->GetSpecularColor() != newCoatColor) {
                 nifShader->SetSpecularColor(newCoatColor);
                 changed = true;
@@ -940,50 +1164,45 @@ auto PatcherMeshShaderTruePBR::enableTruePBROnShape(NiShape* nifShape, NiShader*
         }
 
         // "coat_specular_level" attribute
-        if (truePBRData.contains("coat_specular_level")) {
-            auto newCoatSpecularLevel = truePBRData["coat_specular_level"].get<float>();
-            changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxRefractionScale, newCoatSpecularLevel);
+        if (rule.has(TruePBRRule::FIELD_COAT_SPECULAR_LEVEL)) {
+            changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxRefractionScale, rule.coatSpecularLevel);
         }
 
         // "coat_roughness" attribute
-        if (truePBRData.contains("coat_roughness")) {
-            auto newCoatRoughness = truePBRData["coat_roughness"].get<float>();
-            changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxInnerLayerThickness, newCoatRoughness);
+        if (rule.has(TruePBRRule::FIELD_COAT_ROUGHNESS)) {
+            changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxInnerLayerThickness, rule.coatRoughness);
         }
 
         // "coat_strength" attribute
-        if (truePBRData.contains("coat_strength")) {
-            auto newCoatStrength = truePBRData["coat_strength"].get<float>();
-            changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->softlighting, newCoatStrength);
+        if (rule.has(TruePBRRule::FIELD_COAT_STRENGTH)) {
+            changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->softlighting, rule.coatStrength);
         }
 
         // "coat_diffuse" attribute
-        if (truePBRData.contains("coat_diffuse")) {
+        if (rule.has(TruePBRRule::FIELD_COAT_DIFFUSE)) {
             changed |= NIFUtil::configureShaderFlag(
-                nifShaderBSLSP, SLSF2_EFFECT_LIGHTING, truePBRData["coat_diffuse"].get<bool>());
+                nifShaderBSLSP, SLSF2_EFFECT_LIGHTING, rule.flag(TruePBRRule::FIELD_COAT_DIFFUSE));
         }
 
         // "coat_parallax" attribute
-        if (truePBRData.contains("coat_parallax")) {
+        if (rule.has(TruePBRRule::FIELD_COAT_PARALLAX)) {
             changed |= NIFUtil::configureShaderFlag(
-                nifShaderBSLSP, SLSF2_SOFT_LIGHTING, truePBRData["coat_parallax"].get<bool>());
+                nifShaderBSLSP, SLSF2_SOFT_LIGHTING, rule.flag(TruePBRRule::FIELD_COAT_PARALLAX));
         }
 
         // "coat_normal" attribute
-        if (truePBRData.contains("coat_normal")) {
+        if (rule.has(TruePBRRule::FIELD_COAT_NORMAL)) {
             changed |= NIFUtil::configureShaderFlag(
-                nifShaderBSLSP, SLSF2_BACK_LIGHTING, truePBRData["coat_normal"].get<bool>());
+                nifShaderBSLSP, SLSF2_BACK_LIGHTING, rule.flag(TruePBRRule::FIELD_COAT_NORMAL));
         }
 
         // "inner_uv_scale" attribute
-        if (truePBRData.contains("inner_uv_scale")) {
-            auto newInnerUVScale
-                = Vector2(truePBRData["inner_uv_scale"].get<float>(), truePBRData["inner_uv_scale"].get<float>());
+        if (rule.has(TruePBRRule::FIELD_INNER_UV_SCALE)) {
+            auto newInnerUVScale = Vector2(rule.innerUVScale, rule.innerUVScale);
             changed |= NIFUtil::setShaderVec2(nifShaderBSLSP->parallaxInnerLayerTextureScale, newInnerUVScale);
         }
-    } else if (truePBRData.contains("glint")) {
+    } else if (rule.has(TruePBRRule::FIELD_GLINT)) {
         // glint is enabled
-        const auto& glintParams = truePBRData["glint"];
 
         // Set shader type to MLP
         changed |= NIFUtil::setShaderType(nifShader, BSLSP_MULTILAYERPARALLAX);
@@ -991,51 +1210,37 @@ auto PatcherMeshShaderTruePBR::enableTruePBROnShape(NiShape* nifShape, NiShader*
         changed |= NIFUtil::setShaderFlag(nifShaderBSLSP, SLSF2_FIT_SLOPE);
 
         // Glint parameters
-        if (glintParams.contains("screen_space_scale")) {
-            changed |= NIFUtil::setShaderFloat(
-                nifShaderBSLSP->parallaxInnerLayerThickness, glintParams["screen_space_scale"]);
+        if (rule.has(TruePBRRule::FIELD_GLINT_SCREEN_SPACE_SCALE)) {
+            changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxInnerLayerThickness, rule.glintScreenSpaceScale);
         }
 
-        if (glintParams.contains("log_microfacet_density")) {
-            changed |= NIFUtil::setShaderFloat(
-                nifShaderBSLSP->parallaxRefractionScale, glintParams["log_microfacet_density"]);
+        if (rule.has(TruePBRRule::FIELD_GLINT_LOG_MICROFACET_DENSITY)) {
+            changed
+                |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxRefractionScale, rule.glintLogMicrofacetDensity);
         }
 
-        if (glintParams.contains("microfacet_roughness")) {
+        if (rule.has(TruePBRRule::FIELD_GLINT_MICROFACET_ROUGHNESS)) {
             changed |= NIFUtil::setShaderFloat(
-                nifShaderBSLSP->parallaxInnerLayerTextureScale.u, glintParams["microfacet_roughness"]);
+                nifShaderBSLSP->parallaxInnerLayerTextureScale.u, rule.glintMicrofacetRoughness);
         }
 
-        if (glintParams.contains("density_randomization")) {
+        if (rule.has(TruePBRRule::FIELD_GLINT_DENSITY_RANDOMIZATION)) {
             changed |= NIFUtil::setShaderFloat(
-                nifShaderBSLSP->parallaxInnerLayerTextureScale.v, glintParams["density_randomization"]);
+                nifShaderBSLSP->parallaxInnerLayerTextureScale.v, rule.glintDensityRandomization);
         }
-    } else if (truePBRData.contains("fuzz")) {
+    } else if (rule.has(TruePBRRule::FIELD_FUZZ)) {
         // fuzz is enabled
-        const auto& fuzzParams = truePBRData["fuzz"];
 
         // Set shader type to MLP
         changed |= NIFUtil::setShaderType(nifShader, BSLSP_MULTILAYERPARALLAX);
         // Enable Fuzz with soft lighting flag
         changed |= NIFUtil::setShaderFlag(nifShaderBSLSP, SLSF2_SOFT_LIGHTING);
 
-        // get color
-        auto fuzzColor = vector<float> { 0.0F, 0.0F, 0.0F };
-        if (fuzzParams.contains("color")) {
-            fuzzColor = fuzzParams["color"].get<vector<float>>();
-        }
-
-        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxInnerLayerThickness, fuzzColor[0]);
-        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxRefractionScale, fuzzColor[1]);
-        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxInnerLayerTextureScale.u, fuzzColor[2]);
-
-        // get weight
-        auto fuzzWeight = 1.0F;
-        if (fuzzParams.contains("weight")) {
-            fuzzWeight = fuzzParams["weight"].get<float>();
-        }
-
-        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxInnerLayerTextureScale.v, fuzzWeight);
+        // color defaults to black and weight to 1 when not set
+        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxInnerLayerThickness, rule.fuzzColor[0]);
+        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxRefractionScale, rule.fuzzColor[1]);
+        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxInnerLayerTextureScale.u, rule.fuzzColor[2]);
+        changed |= NIFUtil::setShaderFloat(nifShaderBSLSP->parallaxInnerLayerTextureScale.v, rule.fuzzWeight);
     } else {
         // Revert to default NIFShader type
         changed |= NIFUtil::setShaderType(nifShader, BSLSP_DEFAULT);
@@ -1045,11 +1250,11 @@ auto PatcherMeshShaderTruePBR::enableTruePBROnShape(NiShape* nifShape, NiShader*
         // Clear multilayer flags
         changed |= NIFUtil::clearShaderFlag(nifShaderBSLSP, SLSF2_MULTI_LAYER_PARALLAX);
 
-        if (!flag(truePBRData, "hair")) {
+        if (!rule.flag(TruePBRRule::FIELD_HAIR)) {
             changed |= NIFUtil::clearShaderFlag(nifShaderBSLSP, SLSF2_BACK_LIGHTING);
         }
 
-        if (!truePBRData.contains("fuzz")) {
+        if (!rule.has(TruePBRRule::FIELD_FUZZ)) {
             changed |= NIFUtil::clearShaderFlag(nifShaderBSLSP, SLSF2_SOFT_LIGHTING);
         }
     }
@@ -1061,35 +1266,17 @@ auto PatcherMeshShaderTruePBR::enableTruePBROnShape(NiShape* nifShape, NiShader*
 // Helpers
 //
 
-auto PatcherMeshShaderTruePBR::abs2(Vector2 v) -> Vector2 { return { abs(v.u), abs(v.v) }; }
-
-// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
 auto PatcherMeshShaderTruePBR::autoUVScale(
-    const vector<Vector2>* uvs, const vector<Vector3>* verts, vector<Triangle>& tris) -> Vector2
+    const vector<Vector2>* uvs, const vector<Vector3>* verts, const vector<Triangle>& tris) -> Vector2
 {
-    Vector2 scale;
-    for (const Triangle& t : tris) {
-        auto v1 = (*verts)[t.p1];
-        auto v2 = (*verts)[t.p2];
-        auto v3 = (*verts)[t.p3];
-        auto uv1 = (*uvs)[t.p1];
-        auto uv2 = (*uvs)[t.p2];
-        auto uv3 = (*uvs)[t.p3];
-
-        auto s = (abs2(uv2 - uv1) + abs2(uv3 - uv1)) / ((v2 - v1).length() + (v3 - v1).length());
-        scale += Vector2(1.0F / s.u, 1.0F / s.v);
-    }
+    static_assert(sizeof(Vector2) == 2 * sizeof(float), "Vector2 must be two packed floats");
+    static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 must be three packed floats");
+    static_assert(sizeof(Triangle) == 3 * sizeof(uint16_t), "Triangle must be three packed indices");
 
-    scale *= 10.0 / 4.0;
-    scale /= static_cast<float>(tris.size());
-    scale.u = min(scale.u, scale.v);
-    scale.v = min(scale.u, scale.v);
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto scale = ParallaxGenMeshMath::autoUVScale(reinterpret_cast<const float*>(uvs->data()),
+        reinterpret_cast<const float*>(verts->data()), reinterpret_cast<const uint16_t*>(tris.data()), tris.size());
+    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
 
-    return scale;
-}
-// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
-
-auto PatcherMeshShaderTruePBR::flag(const nlohmann::json& json, const char* key) -> bool
-{
-    return json.contains(key) && json[key];
+    return { scale.u, scale.v };
 }
@@ -1,7 +1,6 @@
 #include "patchers/PatcherMeshShaderVanillaParallax.hpp"
 
 #include <Geometry.hpp>
-#include <boost/algorithm/string.hpp>
 
 #include "Logger.hpp"
 #include "NIFUtil.hpp"
@@ -23,30 +22,23 @@ auto PatcherMeshShaderVanillaParallax::getShaderType() -> NIFUtil::ShapeShader
 PatcherMeshShaderVanillaParallax::PatcherMeshShaderVanillaParallax(filesystem::path nifPath, nifly::NifFile* nif)
     : PatcherMeshShader(std::move(nifPath), nif, "VanillaParallax")
 {
-    // Determine if NIF has attached havok animations
-    vector<NiObject*> nifBlockTree;
-    nif->GetTree(nifBlockTree);
-
-    for (NiObject* nifBlock : nifBlockTree) {
-        if (boost::iequals(nifBlock->GetBlockName(), "BSBehaviorGraphExtraData")) {
-            m_hasAttachedHavok = true;
-        }
-    }
 }
 
 auto PatcherMeshShaderVanillaParallax::canApply(NiShape& nifShape) -> bool
 {
-    auto* nifShader = getNIF()->GetShader(&nifShape);
+    const auto& nifIndex = getNIFIndex();
+    const auto shapeInfo = nifIndex.getShapeInfo(*getNIF(), &nifShape);
+    auto* nifShader = shapeInfo.shader;
     auto* const nifShaderBSLSP = dynamic_cast<BSLightingShaderProperty*>(nifShader);
 
     // Check if nif has attached havok (Results in crashes for vanilla Parallax)
-    if (m_hasAttachedHavok) {
+    if (nifIndex.hasAttachedHavok()) {
         Logger::trace(L"Cannot Apply: Attached havok animations");
         return false;
     }
 
     // ignore skinned meshes, these don't support Parallax
-    if (nifShape.HasSkinInstance() || nifShape.IsSkinned()) {
+    if (shapeInfo.isSkinned) {
         Logger::trace(L"Cannot Apply: Skinned mesh");
         return false;
     }
@@ -186,5 +178,3 @@ auto PatcherMeshShaderVanillaParallax::applyShader(nifly::NiShape& nifShape) ->
 
     return changed;
 }
-
-void PatcherMeshShaderVanillaParallax::processNewTXSTRecord(const PatcherMatch& match, const std::string& edid) { }
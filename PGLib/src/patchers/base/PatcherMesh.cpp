@@ -1,5 +1,12 @@
 #include "patchers/base/PatcherMesh.hpp"
 
+#include <Geometry.hpp>
+#include <Shaders.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
 using namespace std;
 
 PatcherMesh::PatcherMesh(filesystem::path nifPath, nifly::NifFile* nif, string patcherName, const bool& triggerSave)
@@ -11,3 +18,111 @@ PatcherMesh::PatcherMesh(filesystem::path nifPath, nifly::NifFile* nif, string p
 
 auto PatcherMesh::getNIFPath() const -> filesystem::path { return m_nifPath; }
 auto PatcherMesh::getNIF() const -> nifly::NifFile* { return m_nif; }
+void PatcherMesh::bind(filesystem::path nifPath, nifly::NifFile* nif)
+{
+    m_nifPath = std::move(nifPath);
+    m_nif = nif;
+    m_nifIndex = nullptr;
+    m_ownNIFIndex.reset();
+}
+
+auto PatcherMesh::getNIFIndex() -> const NIFIndex&
+{
+    if (m_nifIndex == nullptr) {
+        m_ownNIFIndex = make_shared<NIFIndex>(*m_nif);
+        m_nifIndex = m_ownNIFIndex.get();
+    }
+
+    return *m_nifIndex;
+}
+
+void PatcherMesh::setNIFIndex(const NIFIndex* nifIndex)
+{
+    m_nifIndex = nifIndex;
+    m_ownNIFIndex.reset();
+}
+
+//
+// NIFIndex
+//
+
+PatcherMesh::NIFIndex::NIFIndex(nifly::NifFile& nif)
+{
+    vector<nifly::NiObject*> nifBlockTree;
+    nif.GetTree(nifBlockTree);
+
+    for (nifly::NiObject* nifBlock : nifBlockTree) {
+        if (nifBlock == nullptr) {
+            continue;
+        }
+
+        const string blockName = nifBlock->GetBlockName();
+        m_blocksByType[blockName].push_back(nifBlock);
+
+        if (blockName == "BSBehaviorGraphExtraData") {
+            m_hasAttachedHavok = true;
+        }
+
+        auto* const nifShape = dynamic_cast<nifly::NiShape*>(nifBlock);
+        if (nifShape != nullptr) {
+            const auto shapeInfo = buildShapeInfo(nif, nifShape);
+            m_hasSkinnedShapes |= shapeInfo.isSkinned;
+            m_shapes.emplace(nifShape, shapeInfo);
+        }
+    }
+}
+
+auto PatcherMesh::NIFIndex::getBlocks(const string& blockName) const -> const vector<nifly::NiObject*>&
+{
+    static const vector<nifly::NiObject*> emptyBlocks;
+
+    const auto it = m_blocksByType.find(blockName);
+    if (it == m_blocksByType.end()) {
+        return emptyBlocks;
+    }
+
+    return it->second;
+}
+
+auto PatcherMesh::NIFIndex::getShapeInfo(nifly::NifFile& nif, nifly::NiShape* nifShape) const -> ShapeInfo
+{
+    const auto it = m_shapes.find(nifShape);
+    if (it != m_shapes.end()) {
+        return it->second;
+    }
+
+    // shape is not reachable from the root (still patched like any other shape)
+    return buildShapeInfo(nif, nifShape);
+}
+
+auto PatcherMesh::NIFIndex::hasAttachedHavok() const -> bool { return m_hasAttachedHavok; }
+auto PatcherMesh::NIFIndex::hasSkinnedShapes() const -> bool { return m_hasSkinnedShapes; }
+
+auto PatcherMesh::NIFIndex::buildShapeInfo(nifly::NifFile& nif, nifly::NiShape* nifShape) -> ShapeInfo
+{
+    ShapeInfo shapeInfo;
+    if (nifShape == nullptr) {
+        return shapeInfo;
+    }
+
+    const string shapeName = nifShape->GetBlockName();
+    shapeInfo.isPatchableType = shapeName == "NiTriShape" || shapeName == "BSTriShape" || shapeName == "BSLODTriShape"
+        || shapeName == "BSMeshLODTriShape";
+    shapeInfo.isSkinned = nifShape->HasSkinInstance() || nifShape->IsSkinned();
+
+    if (!nifShape->HasShaderProperty()) {
+        return shapeInfo;
+    }
+
+    shapeInfo.shader = nif.GetShader(nifShape);
+    if (shapeInfo.shader == nullptr) {
+        return shapeInfo;
+    }
+
+    shapeInfo.hasLightingShader = dynamic_cast<nifly::BSLightingShaderProperty*>(shapeInfo.shader) != nullptr;
+    if (shapeInfo.shader->HasTextureSet()) {
+        shapeInfo.textureSet = nif.GetHeader().GetBlock<nifly::BSShaderTextureSet>(shapeInfo.shader->TextureSetRef());
+    }
+
+    return shapeInfo;
+}
@@ -5,36 +5,40 @@
 #include <BasicTypes.hpp>
 #include <Shaders.hpp>
 #include <memory>
-#include <mutex>
 #include <string>
 #include <utility>
 
 using namespace std;
 
-// statics
-
-unordered_map<tuple<filesystem::path, uint32_t>, PatcherMeshShader::PatchedTextureSet,
-    PatcherMeshShader::PatchedTextureSetsHash>
-    PatcherMeshShader::s_patchedTextureSets;
-mutex PatcherMeshShader::s_patchedTextureSetsMutex;
-
 // Constructor
 PatcherMeshShader::PatcherMeshShader(filesystem::path nifPath, nifly::NifFile* nif, string patcherName)
     : PatcherMesh(std::move(nifPath), nif, std::move(patcherName))
 {
 }
 
-auto PatcherMeshShader::getTextureSet(nifly::NiShape& nifShape) -> array<wstring, NUM_TEXTURE_SLOTS>
+void PatcherMeshShader::bind(filesystem::path nifPath, nifly::NifFile* nif)
 {
-    const lock_guard<mutex> lock(s_patchedTextureSetsMutex);
+    PatcherMesh::bind(std::move(nifPath), nif);
+    m_patchedTextureSets = nullptr;
+}
 
-    auto* const nifShader = getNIF()->GetShader(&nifShape);
-    const auto texturesetBlockID = getNIF()->GetBlockID(getNIF()->GetHeader().GetBlock(nifShader->TextureSetRef()));
-    const auto nifShapeKey = make_tuple(getNIFPath(), texturesetBlockID);
+void PatcherMeshShader::setPatchedTextureSets(PatchedTextureSets* patchedTextureSets)
+{
+    m_patchedTextureSets = patchedTextureSets;
+}
 
-    // check if in patchedtexturesets
-    if (s_patchedTextureSets.find(nifShapeKey) != s_patchedTextureSets.end()) {
-        return s_patchedTextureSets[nifShapeKey].original;
+auto PatcherMeshShader::getTextureSet(nifly::NiShape& nifShape) -> array<wstring, NUM_TEXTURE_SLOTS>
+{
+    if (m_patchedTextureSets != nullptr) {
+        auto* const nifShader = getNIF()->GetShader(&nifShape);
+        const auto textureSetBlockID
+            = getNIF()->GetBlockID(getNIF()->GetHeader().GetBlock(nifShader->TextureSetRef()));
+
+        // check if in patchedtexturesets
+        const auto it = m_patchedTextureSets->find(textureSetBlockID);
+        if (it != m_patchedTextureSets->end()) {
+            return it->second.original;
+        }
     }
 
     // get the texture slots
@@ -44,19 +48,20 @@ auto PatcherMeshShader::getTextureSet(nifly::NiShape& nifShape) -> array<wstring
 auto PatcherMeshShader::setTextureSet(nifly::NiShape& nifShape, const array<wstring, NUM_TEXTURE_SLOTS>& textures)
     -> bool
 {
-    // TODO this can be local not static
-    const lock_guard<mutex> lock(s_patchedTextureSetsMutex);
+    if (m_patchedTextureSets == nullptr) {
+        return NIFUtil::setTextureSlots(getNIF(), &nifShape, textures);
+    }
 
     auto* const nifShader = getNIF()->GetShader(&nifShape);
     const auto textureSetBlockID = getNIF()->GetBlockID(getNIF()->GetHeader().GetBlock(nifShader->TextureSetRef()));
-    const auto nifShapeKey = make_tuple(getNIFPath(), textureSetBlockID);
 
-    if (s_patchedTextureSets.find(nifShapeKey) != s_patchedTextureSets.end()) {
+    const auto it = m_patchedTextureSets->find(textureSetBlockID);
+    if (it != m_patchedTextureSets->end()) {
         // This texture set has been patched before
         uint32_t newBlockID = 0;
 
         // already been patched, check if it is the same
-        for (const auto& [possibleTexRecordID, possibleTextures] : s_patchedTextureSets[nifShapeKey].patchResults) {
+        for (const auto& [possibleTexRecordID, possibleTextures] : it->second.patchResults) {
             if (possibleTextures == textures) {
                 newBlockID = possibleTexRecordID;
 
@@ -84,19 +89,19 @@ auto PatcherMeshShader::setTextureSet(nifly::NiShape& nifShape, const array<wstr
         const NiBlockRef<BSShaderTextureSet> newBlockRef(newBlockID);
         nifShaderBSLSP->textureSetRef = newBlockRef;
 
-        s_patchedTextureSets[nifShapeKey].patchResults[newBlockID] = textures;
+        it->second.patchResults[newBlockID] = textures;
         return true;
     }
 
     // set original for future use
-    const auto slots = NIFUtil::getTextureSlots(getNIF(), &nifShape);
-    s_patchedTextureSets[nifShapeKey].original = slots;
+    auto& patchedTextureSet = (*m_patchedTextureSets)[textureSetBlockID];
+    patchedTextureSet.original = NIFUtil::getTextureSlots(getNIF(), &nifShape);
 
     // set the texture slots for the shape like normal
     const bool changed = NIFUtil::setTextureSlots(getNIF(), &nifShape, textures);
 
     // update the patchedtexturesets
-    s_patchedTextureSets[nifShapeKey].patchResults[textureSetBlockID] = textures;
+    patchedTextureSet.patchResults[textureSetBlockID] = textures;
 
     return changed;
 }
@@ -3,38 +3,44 @@
 #include "Logger.hpp"
 #include "NIFUtil.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 using namespace std;
 
 // TODO these methods should probably move into shader and transform classes respectively
-auto PatcherUtil::getWinningMatch(
-    const vector<ShaderPatcherMatch>& matches, const unordered_map<wstring, int>* modPriority) -> ShaderPatcherMatch
+auto PatcherUtil::getWinningMatch(const vector<ShaderPatcherMatch>& matches, const vector<int>& modRanks)
+    -> ShaderPatcherMatch
 {
     // Find winning mod
     int maxPriority = -1;
-    auto winningShaderMatch = PatcherUtil::ShaderPatcherMatch();
+    const ShaderPatcherMatch* winningShaderMatch = nullptr;
 
     for (const auto& match : matches) {
-        const Logger::Prefix prefixMod(match.mod);
-        Logger::trace(L"Checking mod");
-
-        int curPriority = -1;
-        if (modPriority != nullptr && modPriority->find(match.mod) != modPriority->end()) {
-            curPriority = modPriority->at(match.mod);
-        }
-
+        const int curPriority = match.modID < modRanks.size() ? modRanks[match.modID] : -1;
         if (curPriority < maxPriority) {
             // skip mods with lower priority than current winner
-            Logger::trace(L"Rejecting: Mod has lower priority than current winner");
+            Logger::trace(L"Rejecting mod {}: Mod has lower priority than current winner", match.modID);
             continue;
         }
 
-        Logger::trace(L"Mod accepted");
+        Logger::trace(L"Mod {} accepted", match.modID);
         maxPriority = curPriority;
-        winningShaderMatch = match;
+        winningShaderMatch = &match;
+    }
+
+    if (winningShaderMatch == nullptr) {
+        return {};
     }
 
-    Logger::trace(L"Winning mod: {}", winningShaderMatch.mod);
-    return winningShaderMatch;
+    Logger::trace(L"Winning mod: {}", winningShaderMatch->modID);
+    return *winningShaderMatch;
 }
 
 auto PatcherUtil::applyTransformIfNeeded(ShaderPatcherMatch& match, const PatcherMeshObjectSet& patchers) -> bool
@@ -57,3 +63,175 @@ auto PatcherUtil::applyTransformIfNeeded(ShaderPatcherMatch& match, const Patche
 
     return false;
 }
+
+//
+// ModSet
+//
+
+void PatcherUtil::ModSet::insert(const uint32_t& modID)
+{
+    const size_t word = modID / WORD_BITS;
+    if (word >= m_words.size()) {
+        m_words.resize(word + 1, 0);
+    }
+
+    m_words[word] |= uint64_t(1) << (modID % WORD_BITS);
+}
+
+auto PatcherUtil::ModSet::contains(const uint32_t& modID) const -> bool
+{
+    const size_t word = modID / WORD_BITS;
+    return word < m_words.size() && (m_words[word] & (uint64_t(1) << (modID % WORD_BITS))) != 0;
+}
+
+//
+// ConflictModResults
+//
+
+void PatcherUtil::ConflictModResults::addMatches(const vector<ShaderPatcherMatch>& matches)
+{
+    // only shapes matched by more than one mod are conflicts
+    if (ranges::all_of(matches, [&](const ShaderPatcherMatch& match) { return match.modID == matches[0].modID; })) {
+        return;
+    }
+
+    const lock_guard<std::mutex> lock(this->mutex);
+
+    for (const auto& match : matches) {
+        if (match.modID >= mods.size()) {
+            mods.resize(match.modID + 1);
+        }
+
+        auto& conflictMod = mods[match.modID];
+        conflictMod.shaders |= 1U << static_cast<uint32_t>(match.shader);
+        for (const auto& otherMatch : matches) {
+            conflictMod.mods.insert(otherMatch.modID);
+        }
+    }
+}
+
+//
+// PatcherMeshObjectSet
+//
+
+void PatcherUtil::PatcherMeshObjectSet::bind(const filesystem::path& nifPath, nifly::NifFile* nif)
+{
+    nifIndex = nif != nullptr ? PatcherMesh::NIFIndex(*nif) : PatcherMesh::NIFIndex();
+    patchedTextureSets.clear();
+
+    const auto bindPatcher = [&](PatcherMesh& patcher) {
+        patcher.bind(nifPath, nif);
+        patcher.setNIFIndex(&nifIndex);
+    };
+
+    for (const auto& patcher : prePatchers) {
+        bindPatcher(*patcher);
+    }
+    for (const auto& [shader, patcher] : shaderPatchers) {
+        bindPatcher(*patcher);
+        patcher->setPatchedTextureSets(&patchedTextureSets);
+    }
+    for (const auto& [shader, transforms] : shaderTransformPatchers) {
+        for (const auto& [transformShader, transform] : transforms) {
+            bindPatcher(*transform);
+        }
+    }
+    for (const auto& patcher : globalPatchers) {
+        bindPatcher(*patcher);
+    }
+}
+
+void PatcherUtil::PatcherMeshObjectSet::unbind()
+{
+    nifIndex = PatcherMesh::NIFIndex();
+    patchedTextureSets = PatcherMeshShader::PatchedTextureSets();
+}
+
+//
+// PatcherMeshObjectPool
+//
+
+PatcherUtil::PatcherMeshObjectPool::Handle::Handle(
+    PatcherMeshObjectPool* pool, unique_ptr<PatcherMeshObjectSet> set)
+    : m_pool(pool)
+    , m_set(std::move(set))
+{
+}
+
+PatcherUtil::PatcherMeshObjectPool::Handle::~Handle()
+{
+    if (m_pool != nullptr && m_set != nullptr) {
+        m_pool->release(std::move(m_set));
+    }
+}
+
+auto PatcherUtil::PatcherMeshObjectPool::Handle::operator*() const -> PatcherMeshObjectSet& { return *m_set; }
+auto PatcherUtil::PatcherMeshObjectPool::Handle::operator->() const -> PatcherMeshObjectSet* { return m_set.get(); }
+
+void PatcherUtil::PatcherMeshObjectPool::loadFactories(const PatcherMeshSet& factories)
+{
+    const lock_guard<mutex> lock(m_mutex);
+
+    m_factories = factories;
+    m_freeSets.clear();
+    m_numCreated = 0;
+}
+
+auto PatcherUtil::PatcherMeshObjectPool::acquire(const filesystem::path& nifPath, nifly::NifFile* nif) -> Handle
+{
+    unique_ptr<PatcherMeshObjectSet> set;
+
+    {
+        const lock_guard<mutex> lock(m_mutex);
+        if (!m_freeSets.empty()) {
+            set = std::move(m_freeSets.back());
+            m_freeSets.pop_back();
+        } else {
+            m_numCreated++;
+        }
+    }
+
+    if (set == nullptr) {
+        // factories are only replaced while no handles are alive, so they can be read without the lock
+        set = createSet(m_factories, nifPath, nif);
+    }
+
+    set->bind(nifPath, nif);
+    return { this, std::move(set) };
+}
+
+auto PatcherUtil::PatcherMeshObjectPool::getNumCreated() -> size_t
+{
+    const lock_guard<mutex> lock(m_mutex);
+    return m_numCreated;
+}
+
+auto PatcherUtil::PatcherMeshObjectPool::createSet(const PatcherMeshSet& factories, const filesystem::path& nifPath,
+    nifly::NifFile* nif) -> unique_ptr<PatcherMeshObjectSet>
+{
+    auto set = make_unique<PatcherMeshObjectSet>();
+    for (const auto& factory : factories.prePatchers) {
+        set->prePatchers.emplace_back(factory(nifPath, nif));
+    }
+    for (const auto& [shader, factory] : factories.shaderPatchers) {
+        set->shaderPatchers.emplace(shader, factory(nifPath, nif));
+    }
+    for (const auto& [shader, transformFactories] : factories.shaderTransformPatchers) {
+        for (const auto& [transformShader, transformFactory] : transformFactories) {
+            set->shaderTransformPatchers[shader].emplace(transformShader, transformFactory(nifPath, nif));
+        }
+    }
+    for (const auto& factory : factories.globalPatchers) {
+        set->globalPatchers.emplace_back(factory(nifPath, nif));
+    }
+
+    return set;
+}
+
+void PatcherUtil::PatcherMeshObjectPool::release(unique_ptr<PatcherMeshObjectSet> set)
+{
+    set->unbind();
+
+    const lock_guard<mutex> lock(m_mutex);
+    m_freeSets.push_back(std::move(set));
+}
@@ -0,0 +1,301 @@
+#include "BethesdaPluginReader.hpp"
+#include "ParallaxGenPluginIndex.hpp"
+
+#include <gtest/gtest.h>
+
+#include <miniz.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-pro-type-reinterpret-cast)
+namespace {
+
+using Bytes = vector<std::byte>;
+
+constexpr uint32_t FLAG_DELETED = 0x20;
+constexpr uint32_t FLAG_COMPRESSED = 0x40000;
+
+template <typename T> void appendValue(Bytes& bytes, const T& value)
+{
+    const auto* valueBytes = reinterpret_cast<const std::byte*>(&value);
+    bytes.insert(bytes.end(), valueBytes, valueBytes + sizeof(T));
+}
+
+void appendType(Bytes& bytes, const string& type)
+{
+    const auto* typeBytes = reinterpret_cast<const std::byte*>(type.data());
+    bytes.insert(bytes.end(), typeBytes, typeBytes + 4);
+}
+
+auto zstring(const string& str) -> Bytes
+{
+    const auto* strBytes = reinterpret_cast<const std::byte*>(str.c_str());
+    return { strBytes, strBytes + str.size() + 1 };
+}
+
+auto subrecord(const string& type, const Bytes& data) -> Bytes
+{
+    Bytes bytes;
+    appendType(bytes, type);
+    appendValue(bytes, static_cast<uint16_t>(data.size()));
+    bytes.insert(bytes.end(), data.begin(), data.end());
+    return bytes;
+}
+
+auto altTexs(const vector<tuple<string, uint32_t, int32_t>>& entries) -> Bytes
+{
+    Bytes bytes;
+    appendValue(bytes, static_cast<uint32_t>(entries.size()));
+    for (const auto& [name3D, txstFormID, index3D] : entries) {
+        appendValue(bytes, static_cast<uint32_t>(name3D.size()));
+        const auto* nameBytes = reinterpret_cast<const std::byte*>(name3D.data());
+        bytes.insert(bytes.end(), nameBytes, nameBytes + name3D.size());
+        appendValue(bytes, txstFormID);
+        appendValue(bytes, index3D);
+    }
+    return bytes;
+}
+
+auto record(const string& type, const uint32_t& formID, const vector<Bytes>& subrecords, uint32_t flags = 0) -> Bytes
+{
+    Bytes data;
+    for (const auto& sub : subrecords) {
+        data.insert(data.end(), sub.begin(), sub.end());
+    }
+
+    if ((flags & FLAG_COMPRESSED) != 0U) {
+        mz_ulong compressedSize = mz_compressBound(static_cast<mz_ulong>(data.size()));
+        Bytes compressed(compressedSize);
+        mz_compress(reinterpret_cast<unsigned char*>(compressed.data()), &compressedSize,
+            reinterpret_cast<const unsigned char*>(data.data()), static_cast<mz_ulong>(data.size()));
+        compressed.resize(compressedSize);
+
+        Bytes compressedData;
+        appendValue(compressedData, static_cast<uint32_t>(data.size()));
+        compressedData.insert(compressedData.end(), compressed.begin(), compressed.end());
+        data = std::move(compressedData);
+    }
+
+    Bytes bytes;
+    appendType(bytes, type);
+    appendValue(bytes, static_cast<uint32_t>(data.size()));
+    appendValue(bytes, flags);
+    appendValue(bytes, formID);
+    appendValue(bytes, static_cast<uint32_t>(0));
+    appendValue(bytes, static_cast<uint16_t>(44));
+    appendValue(bytes, static_cast<uint16_t>(0));
+    bytes.insert(bytes.end(), data.begin(), data.end());
+    return bytes;
+}
+
+auto group(const string& label, const vector<Bytes>& records) -> Bytes
+{
+    Bytes data;
+    for (const auto& rec : records) {
+        data.insert(data.end(), rec.begin(), rec.end());
+    }
+
+    Bytes bytes;
+    appendType(bytes, "GRUP");
+    appendValue(bytes, static_cast<uint32_t>(data.size() + 24));
+    appendType(bytes, label);
+    appendValue(bytes, static_cast<int32_t>(0));
+    appendValue(bytes, static_cast<uint32_t>(0));
+    appendValue(bytes, static_cast<uint32_t>(0));
+    bytes.insert(bytes.end(), data.begin(), data.end());
+    return bytes;
+}
+
+void writePlugin(const filesystem::path& path, const vector<string>& masters, const vector<Bytes>& groups)
+{
+    vector<Bytes> headerSubrecords;
+    for (const auto& master : masters) {
+        headerSubrecords.push_back(subrecord("MAST", zstring(master)));
+        headerSubrecords.push_back(subrecord("DATA", Bytes(8)));
+    }
+
+    Bytes bytes = record("TES4", 0, headerSubrecords);
+    for (const auto& grp : groups) {
+        bytes.insert(bytes.end(), grp.begin(), grp.end());
+    }
+
+    ofstream file(path, ios::binary);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<streamsize>(bytes.size()));
+}
+
+} // namespace
+
+// NOLINTBEGIN(misc-non-private-member-variables-in-classes,cppcoreguidelines-non-private-member-variables-in-classes)
+class BethesdaPluginReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        m_dataPath = filesystem::temp_directory_path() / "BethesdaPluginReaderTest";
+        filesystem::remove_all(m_dataPath);
+        filesystem::create_directories(m_dataPath);
+
+        // garbage in groups that are not needed must never be read
+        Bytes unusedRecord;
+        appendType(unusedRecord, "NPC_");
+        appendValue(unusedRecord, static_cast<uint32_t>(0xFFFFFF));
+        unusedRecord.resize(24);
+
+        writePlugin(m_dataPath / "Master.esm", {},
+            { group("TXST",
+                  { record("TXST", 0x000800, { subrecord("TX00", zstring("Clutter\\Barrel.dds")) }),
+                      record("TXST", 0x000801,
+                          { subrecord("TX00", zstring("b.dds")), subrecord("TX01", zstring("Textures\\B_n.dds")),
+                              subrecord("TX02", zstring("b_m.dds")), subrecord("TX03", zstring("b_g.dds")) }) }),
+                group("NPC_", { unusedRecord }),
+                group("ACTI",
+                    { record("ACTI", 0x000B00,
+                        { subrecord("MODL", zstring("activator.nif")),
+                            subrecord("MODS", altTexs({ { "Shape", 0x000800, 0 } })) }) }),
+                group("ARMA",
+                    { record("ARMA", 0x000A00,
+                        { subrecord("MOD2", zstring("Armor\\Cuirass_1.nif")),
+                            subrecord("MO2S", altTexs({ { "Body", 0x000801, 0 } })),
+                            subrecord("MOD3", zstring("armor\\f_cuirass_1.nif")),
+                            subrecord("MOD4", zstring("armor\\1st.nif")),
+                            subrecord("MO4S", altTexs({ { "Arms", 0x000800, 1 }, { "Hands", 0x000999, 3 } })) }) }),
+                group("STAT",
+                    { record("STAT", 0x000900,
+                          { subrecord("MODL", zstring("\\Meshes\\Clutter\\Barrel.nif")),
+                              subrecord("MODS", altTexs({ { "Barrel", 0x000800, 2 } })) }),
+                        record("STAT", 0x000901, { subrecord("MODL", zstring("x.nif")) }),
+                        record("STAT", 0x000902,
+                            { subrecord("MODL", zstring("deleted.nif")),
+                                subrecord("MODS", altTexs({ { "Deleted", 0x000801, 0 } })) }) }) });
+
+        writePlugin(m_dataPath / "Patch.esp", { "Master.esm" },
+            { group("TXST",
+                  { record("TXST", 0x01000802, { subrecord("TX00", zstring("c.dds")) }),
+                      record("TXST", 0x00000800, { subrecord("TX00", zstring("Override\\Barrel.dds")) },
+                          FLAG_COMPRESSED) }),
+                group("ACTI", { record("ACTI", 0x00000B00, { subrecord("MODL", zstring("activator.nif")) }) }),
+                group("STAT",
+                    { record("STAT", 0x00000901,
+                          { subrecord("MODL", zstring("x.nif")),
+                              subrecord("MODS", altTexs({ { "X", 0x01000802, 5 } })) },
+                          FLAG_COMPRESSED),
+                        record("STAT", 0x00000902, {}, FLAG_DELETED) }) });
+    }
+
+    void TearDown() override { filesystem::remove_all(m_dataPath); }
+
+    filesystem::path m_dataPath;
+};
+// NOLINTEND(misc-non-private-member-variables-in-classes,cppcoreguidelines-non-private-member-variables-in-classes)
+
+TEST_F(BethesdaPluginReaderTest, WinningOverrides)
+{
+    BethesdaPluginReader reader(m_dataPath);
+    reader.load({ L"Master.esm", L"Patch.esp", L"Missing.esp" });
+
+    // highest priority plugin first, overrides replace the whole record
+    const auto& txsts = reader.getTXSTs();
+    ASSERT_EQ(txsts.size(), 3);
+    EXPECT_EQ(txsts[0].formKey, reader.getFormKey(L"patch.esp", 0x802));
+    EXPECT_EQ(txsts[0].slots[0], L"textures\\c.dds");
+    EXPECT_EQ(txsts[1].formKey, reader.getFormKey(L"Master.esm", 0x800));
+    EXPECT_EQ(txsts[1].slots[0], L"textures\\override\\barrel.dds");
+    EXPECT_EQ(txsts[2].formKey, reader.getFormKey(L"master.esm", 0x801));
+
+    // TXST subrecords are reordered into NIF slots
+    EXPECT_EQ(txsts[2].slots[0], L"textures\\b.dds");
+    EXPECT_EQ(txsts[2].slots[1], L"textures\\b_n.dds");
+    EXPECT_EQ(txsts[2].slots[2], L"textures\\b_g.dds");
+    EXPECT_EQ(txsts[2].slots[5], L"textures\\b_m.dds");
+    EXPECT_TRUE(txsts[2].slots[3].empty());
+
+    // records are grouped by type, overrides without alternate textures and deleted records hide older ones
+    const auto& modelRecords = reader.getModelRecords();
+    ASSERT_EQ(modelRecords.size(), 3);
+    EXPECT_EQ(modelRecords[0].recordType, "ARMA");
+    ASSERT_EQ(modelRecords[0].models.size(), 2);
+    EXPECT_EQ(modelRecords[0].models[0].matchType, "MALE");
+    EXPECT_EQ(modelRecords[0].models[1].matchType, "1STMALE");
+    EXPECT_EQ(modelRecords[0].models[1].altTexs[1].name3D, "Hands");
+    EXPECT_EQ(modelRecords[1].formKey, reader.getFormKey(L"master.esm", 0x901));
+    EXPECT_EQ(modelRecords[2].models[0].nifName, L"meshes\\clutter\\barrel.nif");
+
+    // problems are kept instead of logged, missing plugins first and then missing TXSTs
+    const auto& warnings = reader.getWarnings();
+    ASSERT_EQ(warnings.size(), 2);
+    EXPECT_EQ(warnings[0], L"Plugin Missing.esp does not exist or is empty, skipping");
+    EXPECT_EQ(warnings[1], L"Referenced TXST record 000999 (master.esm) in 000A00 (master.esm) does not exist");
+}
+
+TEST_F(BethesdaPluginReaderTest, Windows1252Strings)
+{
+    writePlugin(m_dataPath / "CodePage.esp", {},
+        { group("TXST", { record("TXST", 0x000800, { subrecord("TX00", zstring("caf\xE9\x80\x81.dds")) }) }) });
+
+    BethesdaPluginReader reader(m_dataPath);
+    reader.load({ L"CodePage.esp" });
+
+    // bytes above 0x7F are windows-1252, unassigned bytes keep their value
+    ASSERT_EQ(reader.getTXSTs().size(), 1);
+    EXPECT_EQ(reader.getTXSTs()[0].slots[0], L"textures\\caf\u00E9\u20AC\u0081.dds");
+    EXPECT_TRUE(reader.getWarnings().empty());
+}
+
+TEST_F(BethesdaPluginReaderTest, BuildIndex)
+{
+    BethesdaPluginReader reader(m_dataPath);
+    reader.load({ L"Master.esm", L"Patch.esp" }, 1);
+
+    ParallaxGenPluginIndex index;
+    reader.buildIndex(index);
+
+    // handles as handed out by PGMutagen, the alternate texture with a missing TXST still takes an index
+    ParallaxGenPluginIndex expected;
+    expected.addAltTexRef({ .nifName = L"meshes\\armor\\cuirass_1.nif",
+        .index3D = 0,
+        .txstIndex = 2,
+        .altTexIndex = 0,
+        .modelRecHandle = 0,
+        .matchType = "MALE" });
+    expected.addAltTexRef({ .nifName = L"meshes\\armor\\1st.nif",
+        .index3D = 1,
+        .txstIndex = 1,
+        .altTexIndex = 1,
+        .modelRecHandle = 1,
+        .matchType = "1STMALE" });
+    expected.addAltTexRef({ .nifName = L"meshes\\x.nif",
+        .index3D = 5,
+        .txstIndex = 0,
+        .altTexIndex = 3,
+        .modelRecHandle = 2,
+        .matchType = "MODL" });
+    expected.addAltTexRef({ .nifName = L"meshes\\clutter\\barrel.nif",
+        .index3D = 2,
+        .txstIndex = 1,
+        .altTexIndex = 4,
+        .modelRecHandle = 3,
+        .matchType = "MODL" });
+    for (int txstIndex = 0; txstIndex < 3; txstIndex++) {
+        expected.setTXSTSlots(txstIndex, reader.getTXSTs()[txstIndex].slots);
+    }
+
+    EXPECT_TRUE(index.getDifferences(expected).empty());
+
+    // parsing groups on more threads gives the same result
+    BethesdaPluginReader parallelReader(m_dataPath);
+    parallelReader.load({ L"Master.esm", L"Patch.esp" }, 4);
+    ParallaxGenPluginIndex parallelIndex;
+    parallelReader.buildIndex(parallelIndex);
+    EXPECT_TRUE(index.getDifferences(parallelIndex).empty());
+
+    expected.setTXSTSlots(0, {});
+    EXPECT_EQ(index.getDifferences(expected).size(), 1);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-pro-type-reinterpret-cast)
@@ -0,0 +1,86 @@
+#include "ParallaxGenAhoCorasick.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenAhoCorasickTests, MatchTests)
+{
+    ParallaxGenAhoCorasick matcher;
+
+    vector<size_t> ids;
+    matcher.findAll(L"textures\\test.dds", ids);
+    EXPECT_TRUE(ids.empty());
+
+    matcher.addPattern(L"\\Armor\\", 3);
+    matcher.addPattern(L"armor\\iron", 1);
+    matcher.addPattern(L"iron", 7);
+    matcher.addPattern(L"ironwood", 2);
+    matcher.addPattern(L"on", 5);
+    matcher.addPattern(L"iron", 4);
+    matcher.build();
+    EXPECT_EQ(matcher.getNumPatterns(), 6);
+
+    // overlapping matches are all found, ids are sorted and unique
+    matcher.findAll(L"Textures\\ARMOR\\Iron\\cuirass", ids);
+    EXPECT_EQ(ids, (vector<size_t> { 1, 3, 4, 5, 7 }));
+
+    // matches found through failure links
+    matcher.findAll(L"textures\\irironwood", ids);
+    EXPECT_EQ(ids, (vector<size_t> { 2, 4, 5, 7 }));
+
+    matcher.findAll(L"textures\\clutter", ids);
+    EXPECT_TRUE(ids.empty());
+
+    matcher.findAll(L"", ids);
+    EXPECT_TRUE(ids.empty());
+}
+
+TEST(ParallaxGenAhoCorasickTests, EmptyPatternTests)
+{
+    ParallaxGenAhoCorasick matcher;
+    matcher.addPattern(L"", 0);
+    matcher.addPattern(L"a", 1);
+    matcher.build();
+
+    vector<size_t> ids;
+    matcher.findAll(L"", ids);
+    EXPECT_EQ(ids, (vector<size_t> { 0 }));
+
+    matcher.findAll(L"bab", ids);
+    EXPECT_EQ(ids, (vector<size_t> { 0, 1 }));
+}
+
+TEST(ParallaxGenAhoCorasickTests, MatchesIContainsTests)
+{
+    const vector<wstring> patterns
+        = { L"a", L"ab", L"bab", L"abc", L"cab", L"bca", L"\\c", L"aa", L"aaa", L"b\\", L"abab", L"c" };
+    const vector<wstring> texts = { L"", L"a", L"AAAA", L"ababab", L"cabcab", L"b\\cab", L"xyz", L"bcabcaB\\C" };
+
+    ParallaxGenAhoCorasick matcher;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        matcher.addPattern(patterns[i], i);
+    }
+    matcher.build();
+
+    for (const auto& text : texts) {
+        vector<size_t> expected;
+        for (size_t i = 0; i < patterns.size(); i++) {
+            if (boost::icontains(text, patterns[i])) {
+                expected.push_back(i);
+            }
+        }
+
+        vector<size_t> ids;
+        matcher.findAll(text, ids);
+        EXPECT_EQ(ids, expected);
+    }
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,135 @@
+#include "CommonTests.hpp"
+#include "ParallaxGenContentCache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+void writeTestFile(const filesystem::path& path, const size_t& size)
+{
+    filesystem::create_directories(path.parent_path());
+    ofstream file(path, ios::binary);
+    const string data(size, 'x');
+    file << data;
+}
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenContentCacheTests, KeyTests)
+{
+    const vector<std::byte> heightMap = { std::byte { 1 }, std::byte { 2 }, std::byte { 3 } };
+    const vector<std::byte> envMask = { std::byte { 4 } };
+
+    const auto key = ParallaxGenContentCache::getKey({ heightMap, envMask }, "1");
+    EXPECT_EQ(key.size(), 64);
+    EXPECT_EQ(key, ParallaxGenContentCache::getKey({ heightMap, envMask }, "1"));
+
+    // generator version, input order and input boundaries are part of the key
+    EXPECT_NE(key, ParallaxGenContentCache::getKey({ heightMap, envMask }, "2"));
+    EXPECT_NE(key, ParallaxGenContentCache::getKey({ envMask, heightMap }, "1"));
+    const vector<std::byte> joined = { std::byte { 1 }, std::byte { 2 }, std::byte { 3 }, std::byte { 4 } };
+    EXPECT_NE(key, ParallaxGenContentCache::getKey({ joined, {} }, "1"));
+}
+
+TEST(ParallaxGenContentCacheTests, CacheTests)
+{
+    const filesystem::path testDir = PGTestEnvs::s_exePath / "output" / "contentcache";
+    filesystem::remove_all(testDir);
+
+    const filesystem::path cacheDir = testDir / "cache";
+    ParallaxGenContentCache cache(cacheDir, L".dds", 250);
+
+    const auto key1 = ParallaxGenContentCache::getKey({ { std::byte { 1 } } }, "1");
+    const auto key2 = ParallaxGenContentCache::getKey({ { std::byte { 2 } } }, "1");
+    const auto key3 = ParallaxGenContentCache::getKey({ { std::byte { 3 } } }, "1");
+
+    // miss, then store and fetch
+    const filesystem::path generated = testDir / "generated" / "test_m.dds";
+    writeTestFile(generated, 100);
+    const filesystem::path fetched = testDir / "output" / "textures" / "test_m.dds";
+    EXPECT_FALSE(cache.fetch(key1, fetched));
+    EXPECT_TRUE(cache.store(key1, generated));
+    EXPECT_TRUE(cache.fetch(key1, fetched));
+    EXPECT_EQ(filesystem::file_size(fetched), 100);
+    EXPECT_EQ(cache.getSize(), 100);
+
+    // writing the output in place leaves the cached file alone
+    {
+        ofstream fetchedFile(fetched, ios::binary | ios::in | ios::out);
+        fetchedFile << "modified";
+    }
+    EXPECT_TRUE(cache.fetch(key1, fetched));
+    ifstream fetchedFile(fetched, ios::binary);
+    const string fetchedData((istreambuf_iterator<char>(fetchedFile)), istreambuf_iterator<char>());
+    fetchedFile.close();
+    EXPECT_EQ(fetchedData, string(100, 'x'));
+
+    // eviction removes the least recently used files first
+    EXPECT_TRUE(cache.store(key2, generated));
+    EXPECT_TRUE(cache.store(key3, generated));
+    EXPECT_EQ(cache.getSize(), 300);
+    filesystem::last_write_time(cacheDir / (wstring(key2.begin(), key2.end()) + L".dds"),
+        filesystem::file_time_type::clock::now() - chrono::hours(1));
+
+    cache.evict();
+    EXPECT_EQ(cache.getSize(), 200);
+    EXPECT_TRUE(cache.fetch(key1, fetched));
+    EXPECT_FALSE(cache.fetch(key2, fetched));
+    EXPECT_TRUE(cache.fetch(key3, fetched));
+
+    filesystem::remove_all(testDir);
+}
+
+TEST(ParallaxGenContentCacheTests, ConcurrentStoreTests)
+{
+    const filesystem::path testDir = PGTestEnvs::s_exePath / "output" / "contentcacheconcurrent";
+    filesystem::remove_all(testDir);
+
+    const filesystem::path cacheDir = testDir / "cache";
+    ParallaxGenContentCache cache(cacheDir, L".dds", ParallaxGenContentCache::DEFAULT_MAX_SIZE);
+
+    // threads storing the same keys at once all succeed and leave complete files and no temporary files
+    constexpr size_t NUM_THREADS = 8;
+    constexpr size_t NUM_KEYS = 20;
+    constexpr size_t FILE_SIZE = 1 << 20;
+    vector<thread> threads;
+    vector<int> numFailed(NUM_THREADS, 0);
+    for (size_t thread = 0; thread < NUM_THREADS; thread++) {
+        threads.emplace_back([&, thread] {
+            const filesystem::path generated = testDir / "generated" / (to_string(thread) + ".dds");
+            writeTestFile(generated, FILE_SIZE);
+            for (size_t key = 0; key < NUM_KEYS; key++) {
+                const auto cacheKey = ParallaxGenContentCache::getKey({ { static_cast<std::byte>(key) } }, "1");
+                numFailed[thread] += static_cast<int>(!cache.store(cacheKey, generated));
+            }
+        });
+    }
+    for (auto& curThread : threads) {
+        curThread.join();
+    }
+
+    for (const auto& failed : numFailed) {
+        EXPECT_EQ(failed, 0);
+    }
+
+    size_t numFiles = 0;
+    for (const auto& entry : filesystem::directory_iterator(cacheDir)) {
+        EXPECT_EQ(entry.path().extension(), ".dds");
+        EXPECT_EQ(filesystem::file_size(entry.path()), FILE_SIZE);
+        numFiles++;
+    }
+    EXPECT_EQ(numFiles, NUM_KEYS);
+
+    filesystem::remove_all(testDir);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -6,11 +6,13 @@
 #include "ParallaxGenD3D.hpp"
 #include "ParallaxGenDirectory.hpp"
 
+#include <DirectXPackedVector.h>
 #include <DirectXTex.h>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 
 using namespace std;
@@ -167,6 +169,95 @@ TEST_P(ParallaxGenD3DTest, TextureTests)
     }
 }
 
+TEST_P(ParallaxGenD3DTest, ConvertToHDRTests)
+{
+    constexpr size_t TEX_WIDTH = 5; // odd width exercises the scalar remainder of the F16C path
+    constexpr size_t TEX_HEIGHT = 4;
+    constexpr size_t TEX_MIPLEVELS = 3;
+    constexpr float LUMINANCE_MULT = 2.5F;
+    constexpr float ALLOWEDDIFFERENCE = 0.01F;
+
+    DirectX::ScratchImage input;
+    ASSERT_TRUE(SUCCEEDED(input.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, TEX_WIDTH, TEX_HEIGHT, 1, TEX_MIPLEVELS)));
+    uint8_t* inputPixels = input.GetPixels();
+    for (size_t i = 0; i < input.GetPixelsSize(); i++) {
+        inputPixels[i] = static_cast<uint8_t>(i % (MAX_CHANNEL_VALUE + 1)); // NOLINT
+    }
+
+    // null input throws, GPU is not required
+    bool ddsModified = false;
+    EXPECT_THROW(ParallaxGenD3D::convertToHDR(nullptr, ddsModified, LUMINANCE_MULT), runtime_error);
+    EXPECT_FALSE(ddsModified);
+
+    DirectX::ScratchImage converted;
+    ASSERT_TRUE(SUCCEEDED(converted.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, TEX_WIDTH, TEX_HEIGHT, 1, TEX_MIPLEVELS)));
+    std::memcpy(converted.GetPixels(), input.GetPixels(), input.GetPixelsSize());
+
+    ParallaxGenD3D::convertToHDR(&converted, ddsModified, LUMINANCE_MULT);
+    EXPECT_TRUE(ddsModified);
+    EXPECT_TRUE(converted.GetMetadata().format == DXGI_FORMAT_R16G16B16A16_FLOAT);
+    EXPECT_TRUE(converted.GetMetadata().mipLevels == TEX_MIPLEVELS);
+    EXPECT_TRUE(converted.GetMetadata().width == TEX_WIDTH);
+    EXPECT_TRUE(converted.GetMetadata().height == TEX_HEIGHT);
+
+    // every mip is converted: rgb is multiplied, alpha is untouched
+    for (size_t mip = 0; mip < TEX_MIPLEVELS; mip++) {
+        const auto* inImage = input.GetImage(mip, 0, 0);
+        const auto* outImage = converted.GetImage(mip, 0, 0);
+        for (size_t y = 0; y < inImage->height; y++) {
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-type-reinterpret-cast)
+            const uint8_t* inRow = inImage->pixels + (y * inImage->rowPitch);
+            const auto* outRow = reinterpret_cast<const uint16_t*>(outImage->pixels + (y * outImage->rowPitch));
+            for (size_t c = 0; c < inImage->width * 4; c++) {
+                const float mult = (c % 4 == 3) ? 1.0F : LUMINANCE_MULT; // alpha is channel 3
+                const float expected = (static_cast<float>(inRow[c]) / MAX_CHANNEL_VALUE) * mult;
+                const float actual = DirectX::PackedVector::XMConvertHalfToFloat(outRow[c]);
+                ASSERT_NEAR(expected, actual, ALLOWEDDIFFERENCE * max(1.0F, expected));
+            }
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-type-reinterpret-cast)
+        }
+    }
+
+    // block compressed input taller than one conversion strip matches decompressing the whole chain up front
+    constexpr size_t BC_SIZE = 200;
+    constexpr size_t BC_MIPLEVELS = 4;
+    DirectX::ScratchImage bcSource;
+    ASSERT_TRUE(SUCCEEDED(bcSource.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, BC_SIZE, BC_SIZE, 1, BC_MIPLEVELS)));
+    uint8_t* bcSourcePixels = bcSource.GetPixels();
+    for (size_t i = 0; i < bcSource.GetPixelsSize(); i++) {
+        bcSourcePixels[i] = static_cast<uint8_t>((i * 7) % (MAX_CHANNEL_VALUE + 1)); // NOLINT
+    }
+
+    DirectX::ScratchImage bcInput;
+    ASSERT_TRUE(SUCCEEDED(DirectX::Compress(bcSource.GetImages(), bcSource.GetImageCount(), bcSource.GetMetadata(),
+        DXGI_FORMAT_BC3_UNORM, DirectX::TEX_COMPRESS_DEFAULT, 1.0F, bcInput)));
+
+    DirectX::ScratchImage bcExpected;
+    ASSERT_TRUE(SUCCEEDED(DirectX::Decompress(bcInput.GetImages(), bcInput.GetImageCount(), bcInput.GetMetadata(),
+        DXGI_FORMAT_R32G32B32A32_FLOAT, bcExpected)));
+
+    ddsModified = false;
+    ParallaxGenD3D::convertToHDR(&bcInput, ddsModified, LUMINANCE_MULT, DXGI_FORMAT_R32G32B32A32_FLOAT);
+    EXPECT_TRUE(ddsModified);
+    ASSERT_TRUE(bcInput.GetMetadata().format == DXGI_FORMAT_R32G32B32A32_FLOAT);
+    ASSERT_TRUE(bcInput.GetMetadata().mipLevels == BC_MIPLEVELS);
+
+    for (size_t mip = 0; mip < BC_MIPLEVELS; mip++) {
+        const auto* inImage = bcExpected.GetImage(mip, 0, 0);
+        const auto* outImage = bcInput.GetImage(mip, 0, 0);
+        for (size_t y = 0; y < inImage->height; y++) {
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-type-reinterpret-cast)
+            const auto* inRow = reinterpret_cast<const float*>(inImage->pixels + (y * inImage->rowPitch));
+            const auto* outRow = reinterpret_cast<const float*>(outImage->pixels + (y * outImage->rowPitch));
+            for (size_t c = 0; c < inImage->width * 4; c++) {
+                const float mult = (c % 4 == 3) ? 1.0F : LUMINANCE_MULT; // alpha is channel 3
+                ASSERT_NEAR(inRow[c] * mult, outRow[c], ALLOWEDDIFFERENCE * max(1.0F, inRow[c] * mult));
+            }
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-type-reinterpret-cast)
+        }
+    }
+}
+
 INSTANTIATE_TEST_SUITE_P(GameParametersSE, ParallaxGenD3DTest, ::testing::Values(PGTestEnvs::s_testENVSkyrimSE));
 
 #pragma warning(pop)
@@ -0,0 +1,139 @@
+#include "ParallaxGenGPUPool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+namespace {
+/// @brief CPU stand-in device where fences complete when the test says so
+class TestGPUDevice : public ParallaxGenGPUDevice {
+public:
+    FenceValue m_signaled = 0;
+    FenceValue m_completed = 0;
+    size_t m_numWaits = 0;
+
+    auto signalFence() -> FenceValue override { return ++m_signaled; }
+    auto getCompletedFence() -> FenceValue override { return m_completed; }
+    void waitForFence(FenceValue fence) override
+    {
+        m_numWaits++;
+        m_completed = max(m_completed, fence);
+    }
+};
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenGPUPoolTests, ResourceKeyTests)
+{
+    EXPECT_EQ(ParallaxGenGPUResourceKey::getBufferBucket(0), 16);
+    EXPECT_EQ(ParallaxGenGPUResourceKey::getBufferBucket(16), 16);
+    EXPECT_EQ(ParallaxGenGPUResourceKey::getBufferBucket(17), 32);
+    EXPECT_EQ(ParallaxGenGPUResourceKey::getBufferBucket(1000), 1024);
+
+    const ParallaxGenGPUResourceKey key1 = { .width = 256, .height = 256, .mipLevels = 9, .format = 28 };
+    ParallaxGenGPUResourceKey key2 = key1;
+    EXPECT_EQ(key1, key2);
+    EXPECT_EQ(ParallaxGenGPUResourceKeyHash {}(key1), ParallaxGenGPUResourceKeyHash {}(key2));
+
+    key2.mipLevels = 1;
+    EXPECT_NE(key1, key2);
+}
+
+TEST(ParallaxGenGPUPoolTests, ResourcePoolTests)
+{
+    int nextID = 0;
+    ParallaxGenGPUResourcePool<int> pool(
+        [&nextID](const ParallaxGenGPUResourceKey& key, int& dest) {
+            if (key.width == 0) {
+                return false;
+            }
+            dest = ++nextID;
+            return true;
+        },
+        2);
+
+    const ParallaxGenGPUResourceKey keyA = { .width = 64, .height = 64 };
+    const ParallaxGenGPUResourceKey keyB = { .width = 128, .height = 128 };
+
+    // empty pool creates
+    int resA1 = 0;
+    EXPECT_TRUE(pool.acquire(keyA, resA1));
+    EXPECT_EQ(resA1, 1);
+
+    // released resource is reused for the same key only
+    pool.release(keyA, resA1);
+    int resB1 = 0;
+    EXPECT_TRUE(pool.acquire(keyB, resB1));
+    EXPECT_EQ(resB1, 2);
+    int resA2 = 0;
+    EXPECT_TRUE(pool.acquire(keyA, resA2));
+    EXPECT_EQ(resA2, 1);
+    EXPECT_EQ(pool.getNumCreated(), 2);
+    EXPECT_EQ(pool.getNumReused(), 1);
+
+    // failed creation
+    int resFail = 0;
+    EXPECT_FALSE(pool.acquire({}, resFail));
+    EXPECT_EQ(pool.getNumCreated(), 2);
+
+    // idle limit per bucket
+    pool.release(keyB, 10);
+    pool.release(keyB, 11);
+    pool.release(keyB, 12);
+    int res = 0;
+    EXPECT_TRUE(pool.acquire(keyB, res));
+    EXPECT_EQ(res, 11);
+    EXPECT_TRUE(pool.acquire(keyB, res));
+    EXPECT_EQ(res, 10);
+    EXPECT_TRUE(pool.acquire(keyB, res));
+    EXPECT_EQ(res, 3);
+
+    // clear drops idle resources
+    pool.release(keyA, resA2);
+    pool.clear();
+    EXPECT_TRUE(pool.acquire(keyA, res));
+    EXPECT_EQ(res, 4);
+}
+
+TEST(ParallaxGenGPUPoolTests, BatchTests)
+{
+    TestGPUDevice device;
+    vector<int> retired;
+
+    {
+        ParallaxGenGPUBatch<int> batch(&device, 2, [&retired](int& job) { retired.push_back(job); });
+
+        // window not full, nothing retires
+        batch.push(0);
+        batch.push(1);
+        EXPECT_EQ(batch.getNumInFlight(), 2);
+        EXPECT_TRUE(retired.empty());
+        EXPECT_EQ(device.m_numWaits, 0);
+
+        // window full, blocks on the oldest job
+        batch.push(2);
+        EXPECT_EQ(batch.getNumInFlight(), 2);
+        EXPECT_EQ(retired, vector<int>({ 0 }));
+        EXPECT_EQ(device.m_numWaits, 1);
+
+        // completed jobs retire without waiting
+        device.m_completed = 2;
+        batch.retireCompleted();
+        EXPECT_EQ(retired, vector<int>({ 0, 1 }));
+        EXPECT_EQ(device.m_numWaits, 1);
+
+        batch.push(3);
+        batch.flush();
+        EXPECT_EQ(batch.getNumInFlight(), 0);
+        EXPECT_EQ(retired, vector<int>({ 0, 1, 2, 3 }));
+
+        // destructor flushes
+        batch.push(4);
+    }
+
+    EXPECT_EQ(retired, vector<int>({ 0, 1, 2, 3, 4 }));
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
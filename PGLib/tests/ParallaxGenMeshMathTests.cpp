@@ -0,0 +1,255 @@
+#include "ParallaxGenMeshMath.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace {
+/// @brief Wavy grid mesh with a little noise so every triangle has different edge lengths
+struct TestMesh {
+    vector<float> uvs;
+    vector<float> verts;
+    vector<uint16_t> tris;
+
+    [[nodiscard]] auto numTris() const -> size_t { return tris.size() / 3; }
+};
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+auto createGridMesh(const size_t& gridSize, const size_t& numTris) -> TestMesh
+{
+    TestMesh mesh;
+    for (size_t y = 0; y < gridSize; y++) {
+        for (size_t x = 0; x < gridSize; x++) {
+            const auto fx = static_cast<float>(x);
+            const auto fy = static_cast<float>(y);
+            mesh.verts.push_back((fx * 16.0F) + sin(fy));
+            mesh.verts.push_back((fy * 16.0F) + cos(fx));
+            mesh.verts.push_back(sin(fx * 0.3F) * cos(fy * 0.7F) * 40.0F);
+            mesh.uvs.push_back((fx / static_cast<float>(gridSize)) * 3.0F);
+            mesh.uvs.push_back((fy / static_cast<float>(gridSize)) * 2.0F + (sin(fx) * 0.001F));
+        }
+    }
+
+    // quads are reused once the grid runs out so shapes can be larger than the uint16_t vertex limit allows
+    size_t quad = 0;
+    while (mesh.numTris() < numTris) {
+        const size_t x = quad % (gridSize - 1);
+        const size_t y = (quad / (gridSize - 1)) % (gridSize - 1);
+        const auto i0 = static_cast<uint16_t>((y * gridSize) + x);
+        const auto i1 = static_cast<uint16_t>(i0 + 1);
+        const auto i2 = static_cast<uint16_t>(i0 + gridSize);
+        const auto i3 = static_cast<uint16_t>(i2 + 1);
+        mesh.tris.insert(mesh.tris.end(), { i0, i1, i2 });
+        if (mesh.numTris() < numTris) {
+            mesh.tris.insert(mesh.tris.end(), { i1, i3, i2 });
+        }
+        quad++;
+    }
+
+    return mesh;
+}
+}
+
+TEST(ParallaxGenMeshMathTests, AutoUVScaleTests)
+{
+    // every remainder length of the 4 wide loop
+    for (size_t numTris = 1; numTris <= 9; numTris++) {
+        const auto mesh = createGridMesh(4, numTris);
+        const auto scalar = ParallaxGenMeshMath::autoUVScaleScalar(
+            mesh.uvs.data(), mesh.verts.data(), mesh.tris.data(), mesh.numTris());
+        const auto simd
+            = ParallaxGenMeshMath::autoUVScale(mesh.uvs.data(), mesh.verts.data(), mesh.tris.data(), mesh.numTris());
+        EXPECT_EQ(simd.u, scalar.u);
+        EXPECT_EQ(simd.v, scalar.v);
+        EXPECT_EQ(simd.u, simd.v);
+    }
+
+    // results are bit identical on large shapes
+    const auto mesh = createGridMesh(250, 100000);
+    const auto scalar
+        = ParallaxGenMeshMath::autoUVScaleScalar(mesh.uvs.data(), mesh.verts.data(), mesh.tris.data(), mesh.numTris());
+    const auto simd
+        = ParallaxGenMeshMath::autoUVScale(mesh.uvs.data(), mesh.verts.data(), mesh.tris.data(), mesh.numTris());
+    EXPECT_EQ(simd.u, scalar.u);
+    EXPECT_EQ(simd.v, scalar.v);
+    EXPECT_TRUE(isfinite(simd.u));
+}
+
+TEST(ParallaxGenMeshMathTests, NormalTests)
+{
+    // every remainder length of the 4 wide loop, with and without smoothing
+    for (size_t numTris = 1; numTris <= 9; numTris++) {
+        const auto mesh = createGridMesh(4, numTris);
+        const size_t numVerts = mesh.verts.size() / 3;
+        for (const float smoothAngle : { 0.0F, 60.0F, 180.0F }) {
+            vector<float> scalar(mesh.verts.size());
+            vector<float> simd(mesh.verts.size());
+            ParallaxGenMeshMath::calcNormalsScalar(
+                mesh.verts.data(), numVerts, mesh.tris.data(), mesh.numTris(), smoothAngle, scalar.data());
+            ParallaxGenMeshMath::calcNormals(
+                mesh.verts.data(), numVerts, mesh.tris.data(), mesh.numTris(), smoothAngle, simd.data());
+            EXPECT_EQ(simd, scalar);
+        }
+    }
+
+    // results are bit identical on large shapes
+    const auto mesh = createGridMesh(250, 100000);
+    const size_t numVerts = mesh.verts.size() / 3;
+    vector<float> scalar(mesh.verts.size());
+    vector<float> simd(mesh.verts.size());
+    ParallaxGenMeshMath::calcNormalsScalar(
+        mesh.verts.data(), numVerts, mesh.tris.data(), mesh.numTris(), 60.0F, scalar.data());
+    ParallaxGenMeshMath::calcNormals(mesh.verts.data(), numVerts, mesh.tris.data(), mesh.numTris(), 60.0F, simd.data());
+    EXPECT_EQ(simd, scalar);
+
+    // two quads folded by 90 degrees along x = 1, the vertices on the fold are split (3 to 4 and 5 to 6)
+    const vector<float> verts = { 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 1, 0, 1, 1, 1, 1 };
+    const vector<uint16_t> tris = { 0, 2, 1, 1, 2, 3, 4, 6, 5, 5, 6, 7 };
+    vector<float> normals(verts.size());
+
+    // fold is sharper than the smooth angle, every vertex keeps its face normal
+    ParallaxGenMeshMath::calcNormals(verts.data(), 8, tris.data(), 4, 60.0F, normals.data());
+    for (size_t vert = 0; vert < 4; vert++) {
+        EXPECT_EQ(normals[vert * 3], 0.0F);
+        EXPECT_EQ(normals[(vert * 3) + 1], 0.0F);
+        EXPECT_EQ(normals[(vert * 3) + 2], 1.0F);
+    }
+    EXPECT_EQ(normals[4 * 3], -1.0F);
+
+    // fold is within the smooth angle, split vertices share the averaged normal
+    ParallaxGenMeshMath::calcNormals(verts.data(), 8, tris.data(), 4, 100.0F, normals.data());
+    const float halfSqrt2 = sqrt(0.5F);
+    for (const size_t vert : { 2, 3, 4, 5 }) {
+        EXPECT_NEAR(normals[vert * 3], -halfSqrt2, 1e-6F);
+        EXPECT_NEAR(normals[(vert * 3) + 1], 0.0F, 1e-6F);
+        EXPECT_NEAR(normals[(vert * 3) + 2], halfSqrt2, 1e-6F);
+    }
+    EXPECT_EQ(normals[2], 1.0F);
+    EXPECT_EQ(normals[7 * 3], -1.0F);
+}
+
+TEST(ParallaxGenMeshMathTests, TangentTests)
+{
+    // every remainder length of the 4 wide loop
+    for (size_t numTris = 1; numTris <= 9; numTris++) {
+        const auto mesh = createGridMesh(4, numTris);
+        const size_t numVerts = mesh.verts.size() / 3;
+        vector<float> normals(mesh.verts.size());
+        ParallaxGenMeshMath::calcNormals(
+            mesh.verts.data(), numVerts, mesh.tris.data(), mesh.numTris(), 60.0F, normals.data());
+
+        array<vector<float>, 4> results;
+        for (auto& result : results) {
+            result.resize(mesh.verts.size());
+        }
+        ParallaxGenMeshMath::calcTangentsScalar(mesh.verts.data(), mesh.uvs.data(), normals.data(), numVerts,
+            mesh.tris.data(), mesh.numTris(), results[0].data(), results[1].data());
+        ParallaxGenMeshMath::calcTangents(mesh.verts.data(), mesh.uvs.data(), normals.data(), numVerts,
+            mesh.tris.data(), mesh.numTris(), results[2].data(), results[3].data());
+        EXPECT_EQ(results[2], results[0]);
+        EXPECT_EQ(results[3], results[1]);
+    }
+
+    // results are bit identical on large shapes and orthogonal to the normal
+    const auto mesh = createGridMesh(250, 100000);
+    const size_t numVerts = mesh.verts.size() / 3;
+    vector<float> normals(mesh.verts.size());
+    ParallaxGenMeshMath::calcNormals(
+        mesh.verts.data(), numVerts, mesh.tris.data(), mesh.numTris(), 60.0F, normals.data());
+    array<vector<float>, 4> results;
+    for (auto& result : results) {
+        result.resize(mesh.verts.size());
+    }
+    ParallaxGenMeshMath::calcTangentsScalar(mesh.verts.data(), mesh.uvs.data(), normals.data(), numVerts,
+        mesh.tris.data(), mesh.numTris(), results[0].data(), results[1].data());
+    ParallaxGenMeshMath::calcTangents(mesh.verts.data(), mesh.uvs.data(), normals.data(), numVerts, mesh.tris.data(),
+        mesh.numTris(), results[2].data(), results[3].data());
+    EXPECT_EQ(results[2], results[0]);
+    EXPECT_EQ(results[3], results[1]);
+    for (size_t vert = 0; vert < numVerts; vert++) {
+        const float* n = normals.data() + (vert * 3);
+        const float* t = results[0].data() + (vert * 3);
+        EXPECT_NEAR((n[0] * t[0]) + (n[1] * t[1]) + (n[2] * t[2]), 0.0F, 1e-4F);
+    }
+
+    // flat quad mapped 1:1, the tangent follows v and the bitangent follows u
+    const vector<float> verts = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+    const vector<float> uvs = { 0, 0, 1, 0, 0, 1, 1, 1 };
+    const vector<uint16_t> tris = { 0, 1, 2, 2, 1, 3 };
+    vector<float> flatNormals(verts.size());
+    vector<float> tangents(verts.size());
+    vector<float> bitangents(verts.size());
+    ParallaxGenMeshMath::calcNormals(verts.data(), 4, tris.data(), 2, 60.0F, flatNormals.data());
+    ParallaxGenMeshMath::calcTangents(
+        verts.data(), uvs.data(), flatNormals.data(), 4, tris.data(), 2, tangents.data(), bitangents.data());
+    for (size_t vert = 0; vert < 4; vert++) {
+        EXPECT_EQ(flatNormals[(vert * 3) + 2], 1.0F);
+        EXPECT_EQ(tangents[(vert * 3) + 1], 1.0F);
+        EXPECT_EQ(bitangents[vert * 3], 1.0F);
+    }
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests --gtest_filter=*AutoUVScaleBenchmark*
+TEST(ParallaxGenMeshMathTests, DISABLED_AutoUVScaleBenchmark)
+{
+    constexpr size_t NUM_TRIS = 100000;
+    constexpr size_t NUM_RUNS = 200;
+
+    const auto mesh = createGridMesh(250, NUM_TRIS);
+
+    const auto benchmark = [&mesh](const auto& kernel) -> double {
+        float sink = 0.0F;
+        const auto start = chrono::steady_clock::now();
+        for (size_t run = 0; run < NUM_RUNS; run++) {
+            sink += kernel(mesh.uvs.data(), mesh.verts.data(), mesh.tris.data(), mesh.numTris()).u;
+        }
+        const auto end = chrono::steady_clock::now();
+        EXPECT_TRUE(isfinite(sink));
+        return chrono::duration<double, milli>(end - start).count() / static_cast<double>(NUM_RUNS);
+    };
+
+    const double scalarMs = benchmark(ParallaxGenMeshMath::autoUVScaleScalar);
+    const double simdMs = benchmark(ParallaxGenMeshMath::autoUVScale);
+
+    cout << "autoUVScale " << NUM_TRIS << " triangles: scalar " << scalarMs << " ms, SSE2 " << simdMs << " ms ("
+         << scalarMs / simdMs << "x)\n";
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests --gtest_filter=*NormalsTangentsBenchmark*
+TEST(ParallaxGenMeshMathTests, DISABLED_NormalsTangentsBenchmark)
+{
+    constexpr size_t NUM_TRIS = 100000;
+    constexpr size_t NUM_RUNS = 50;
+
+    const auto mesh = createGridMesh(250, NUM_TRIS);
+    const size_t numVerts = mesh.verts.size() / 3;
+    vector<float> normals(mesh.verts.size());
+    vector<float> tangents(mesh.verts.size());
+    vector<float> bitangents(mesh.verts.size());
+
+    const auto benchmark = [&](const auto& normalKernel, const auto& tangentKernel) -> double {
+        const auto start = chrono::steady_clock::now();
+        for (size_t run = 0; run < NUM_RUNS; run++) {
+            normalKernel(mesh.verts.data(), numVerts, mesh.tris.data(), mesh.numTris(), 60.0F, normals.data());
+            tangentKernel(mesh.verts.data(), mesh.uvs.data(), normals.data(), numVerts, mesh.tris.data(),
+                mesh.numTris(), tangents.data(), bitangents.data());
+        }
+        const auto end = chrono::steady_clock::now();
+        return chrono::duration<double, milli>(end - start).count() / static_cast<double>(NUM_RUNS);
+    };
+
+    const double scalarMs = benchmark(ParallaxGenMeshMath::calcNormalsScalar, ParallaxGenMeshMath::calcTangentsScalar);
+    const double simdMs = benchmark(ParallaxGenMeshMath::calcNormals, ParallaxGenMeshMath::calcTangents);
+
+    cout << "calcNormals + calcTangents " << NUM_TRIS << " triangles: scalar " << scalarMs << " ms, SSE2 " << simdMs
+         << " ms (" << scalarMs / simdMs << "x)\n";
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
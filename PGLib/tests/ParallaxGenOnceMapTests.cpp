@@ -0,0 +1,78 @@
+#include "ParallaxGenOnceMap.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenOnceMapTests, OnceMapTests)
+{
+    ParallaxGenOnceMap<wstring, int> onceMap;
+
+    EXPECT_EQ(onceMap.getOrCompute(L"a", [] { return 1; }), 1);
+    // value is computed only once
+    EXPECT_EQ(onceMap.getOrCompute(L"a", [] { return 2; }), 1);
+    EXPECT_EQ(onceMap.getOrCompute(L"b", [] { return 3; }), 3);
+    EXPECT_TRUE(onceMap.contains(L"a"));
+    EXPECT_FALSE(onceMap.contains(L"c"));
+    EXPECT_EQ(onceMap.size(), 2);
+
+    // exceptions are passed to every caller of the key
+    EXPECT_THROW(onceMap.getOrCompute(L"c", []() -> int { throw runtime_error("failed"); }), runtime_error);
+    EXPECT_THROW(onceMap.getOrCompute(L"c", [] { return 4; }), runtime_error);
+
+    onceMap.clear();
+    EXPECT_EQ(onceMap.size(), 0);
+    EXPECT_EQ(onceMap.getOrCompute(L"a", [] { return 5; }), 5);
+}
+
+TEST(ParallaxGenOnceMapTests, ConcurrentTests)
+{
+    constexpr size_t NUM_THREADS = 8;
+    constexpr size_t NUM_KEYS = 4;
+
+    ParallaxGenOnceMap<size_t, size_t> onceMap;
+    atomic<size_t> numComputed = 0;
+    atomic<size_t> numRunning = 0;
+    atomic<size_t> maxRunning = 0;
+
+    vector<thread> threads;
+    vector<vector<size_t>> results(NUM_THREADS);
+    for (size_t t = 0; t < NUM_THREADS; t++) {
+        threads.emplace_back([&, t] {
+            for (size_t key = 0; key < NUM_KEYS; key++) {
+                // threads start on different keys so unrelated keys are computed at the same time
+                const size_t curKey = (key + t) % NUM_KEYS;
+                results[t].push_back(onceMap.getOrCompute(curKey, [&] {
+                    numComputed++;
+                    const size_t running = ++numRunning;
+                    size_t prevMax = maxRunning;
+                    while (prevMax < running && !maxRunning.compare_exchange_weak(prevMax, running)) { }
+                    this_thread::sleep_for(chrono::milliseconds(20));
+                    numRunning--;
+                    return curKey * 10;
+                }));
+            }
+        });
+    }
+    for (auto& curThread : threads) {
+        curThread.join();
+    }
+
+    EXPECT_EQ(numComputed, NUM_KEYS);
+    EXPECT_GT(maxRunning, 1);
+    for (size_t t = 0; t < NUM_THREADS; t++) {
+        for (size_t key = 0; key < NUM_KEYS; key++) {
+            EXPECT_EQ(results[t][key], ((key + t) % NUM_KEYS) * 10);
+        }
+    }
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,234 @@
+#include "BethesdaGame.hpp"
+#include "CommonTests.hpp"
+#include "ParallaxGen.hpp"
+#include "ParallaxGenD3D.hpp"
+#include "ParallaxGenDirectory.hpp"
+#include "ParallaxGenPipeline.hpp"
+#include "ParallaxGenUtil.hpp"
+#include "ParallaxGenWarnings.hpp"
+#include "patchers/PatcherMeshPreFixTextureSlotCount.hpp"
+#include "patchers/PatcherMeshShaderComplexMaterial.hpp"
+#include "patchers/PatcherMeshShaderDefault.hpp"
+#include "patchers/PatcherMeshShaderVanillaParallax.hpp"
+#include "patchers/base/Patcher.hpp"
+#include "patchers/base/PatcherUtil.hpp"
+
+#include <boost/crc.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+// stage durations shaped like a PG Patcher run: plugin loading is long and only needed once conflicts are found
+const vector<tuple<string, vector<string>, int>> SYNTHETIC_STAGES = {
+    { "plugins", {}, 400 },
+    { "modFiles", {}, 50 },
+    { "fileMap", { "modFiles" }, 150 },
+    { "textureMaps", { "fileMap" }, 200 },
+    { "ddsHeaders", { "fileMap" }, 150 },
+    { "cmMaps", { "textureMaps", "ddsHeaders" }, 100 },
+    { "patchers", { "textureMaps" }, 50 },
+    { "modOrder", { "plugins", "cmMaps", "patchers" }, 50 },
+    { "meshes", { "modOrder" }, 500 },
+    { "plugin", { "meshes" }, 100 },
+};
+
+/**
+ * @brief Patch the meshes of the test environment with the stage graph of PG Patcher (without plugins and the mod order
+ * dialog) and hash every output file
+ *
+ * @param outputDir output directory, deleted first
+ * @param multithread run the stages on the dependency graph instead of one after another
+ * @return map<wstring, uint32_t> CRC32 of every output file by path relative to the output directory
+ */
+auto patchTestEnv(const filesystem::path& outputDir, const bool& multithread) -> map<wstring, uint32_t>
+{
+    const auto& params = PGTestEnvs::s_testENVSkyrimSE;
+
+    filesystem::remove_all(outputDir);
+    filesystem::create_directories(outputDir);
+
+    BethesdaGame bg(params.GameType, false, params.GamePath, params.AppDataPath, params.DocumentPath);
+    ParallaxGenDirectory pgd(&bg, outputDir, nullptr);
+    ParallaxGenD3D pgd3d(&pgd, outputDir, PGTestEnvs::s_exePath);
+    ParallaxGen pg(outputDir, &pgd, &pgd3d, false);
+    unordered_map<wstring, int> modPriority;
+
+    pgd3d.initGPU();
+    Patcher::loadStatics(pgd, pgd3d);
+
+    // stages themselves run single threaded in both runs so only the stage order differs
+    const vector<wstring> bsaExcludes { L"Skyrim - Textures5.bsa" };
+    ParallaxGenPipeline pipeline;
+    pipeline.addStage("fileMap", {}, [&] { pgd.populateFileMap(false); });
+    pipeline.addStage("textureMaps", { "fileMap" }, [&] { pgd.mapFiles({}, {}, {}, bsaExcludes, true, false); });
+    pipeline.addStage("ddsHeaders", { "fileMap" }, [&] { pgd3d.buildDDSHeaderIndex(false); });
+    pipeline.addStage("cmMaps", { "textureMaps", "ddsHeaders" }, [&] { pgd3d.findCMMaps(bsaExcludes); });
+    pipeline.addStage("patchers", { "textureMaps" }, [&] {
+        PatcherUtil::PatcherMeshSet meshPatchers;
+        meshPatchers.prePatchers.emplace_back(PatcherMeshPreFixTextureSlotCount::getFactory());
+        meshPatchers.shaderPatchers.emplace(
+            PatcherMeshShaderDefault::getShaderType(), PatcherMeshShaderDefault::getFactory());
+        meshPatchers.shaderPatchers.emplace(
+            PatcherMeshShaderVanillaParallax::getShaderType(), PatcherMeshShaderVanillaParallax::getFactory());
+        meshPatchers.shaderPatchers.emplace(
+            PatcherMeshShaderComplexMaterial::getShaderType(), PatcherMeshShaderComplexMaterial::getFactory());
+        PatcherMeshShaderComplexMaterial::loadStatics(false, {});
+        pg.loadPatchers(meshPatchers, {});
+    });
+    pipeline.addStage("meshes", { "cmMaps", "patchers" }, [&] {
+        pg.loadModPriorityMap(&modPriority);
+        ParallaxGenWarnings::init(&pgd, &modPriority);
+        pg.patch(false, false);
+    });
+    pipeline.run(multithread);
+
+    map<wstring, uint32_t> outputHashes;
+    for (const auto& entry : filesystem::recursive_directory_iterator(outputDir)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+
+        const auto fileBytes = ParallaxGenUtil::getFileBytes(entry.path());
+        boost::crc_32_type crc {};
+        crc.process_bytes(fileBytes.data(), fileBytes.size());
+        outputHashes[filesystem::relative(entry.path(), outputDir).wstring()] = crc.checksum();
+    }
+
+    return outputHashes;
+}
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenPipelineTests, DependencyTests)
+{
+    // every stage starts after the stages it reads from are done
+    for (const bool multithread : { true, false }) {
+        mutex orderMutex;
+        vector<string> order;
+        ParallaxGenPipeline pipeline;
+        for (const auto& [name, inputs, duration] : SYNTHETIC_STAGES) {
+            pipeline.addStage(name, inputs, [&orderMutex, &order, name] {
+                this_thread::sleep_for(chrono::milliseconds(1));
+                const lock_guard<mutex> lock(orderMutex);
+                order.push_back(name);
+            });
+        }
+        pipeline.run(multithread);
+
+        ASSERT_EQ(order.size(), SYNTHETIC_STAGES.size());
+        unordered_map<string, size_t> position;
+        for (size_t i = 0; i < order.size(); i++) {
+            position[order[i]] = i;
+        }
+        for (const auto& [name, inputs, duration] : SYNTHETIC_STAGES) {
+            for (const auto& input : inputs) {
+                EXPECT_LT(position[input], position[name]);
+            }
+        }
+
+        // stage times are in the added order
+        unordered_map<string, ParallaxGenPipeline::StageTime> stageTimes;
+        for (const auto& stageTime : pipeline.getStageTimes()) {
+            stageTimes[stageTime.name] = stageTime;
+        }
+        for (const auto& [name, inputs, duration] : SYNTHETIC_STAGES) {
+            EXPECT_LE(stageTimes[name].startMS, stageTimes[name].endMS);
+            for (const auto& input : inputs) {
+                EXPECT_LE(stageTimes[input].endMS, stageTimes[name].startMS);
+            }
+        }
+
+        // single threaded runs in the added order like the barrier pipeline
+        if (!multithread) {
+            for (size_t i = 0; i < order.size(); i++) {
+                EXPECT_EQ(order[i], get<0>(SYNTHETIC_STAGES[i]));
+            }
+        }
+    }
+
+    // main thread stages run on the thread calling run
+    ParallaxGenPipeline mainPipeline;
+    thread::id mainStageThread;
+    mainPipeline.addStage("worker", {}, [] { });
+    mainPipeline.addStage("main", { "worker" }, [&mainStageThread] { mainStageThread = this_thread::get_id(); }, true);
+    mainPipeline.run();
+    EXPECT_EQ(mainStageThread, this_thread::get_id());
+
+    // stages can only read from stages added before them
+    ParallaxGenPipeline badPipeline;
+    badPipeline.addStage("a", {}, [] { });
+    EXPECT_THROW(badPipeline.addStage("b", { "c" }, [] { }), runtime_error);
+    EXPECT_THROW(badPipeline.addStage("a", {}, [] { }), runtime_error);
+}
+
+TEST(ParallaxGenPipelineTests, ExceptionTests)
+{
+    // the exception is rethrown on the calling thread once running stages are done, stages reading from the failed
+    // stage never start
+    bool dependentRan = false;
+    bool independentRan = false;
+    ParallaxGenPipeline pipeline;
+    pipeline.addStage("failing", {}, [] { throw runtime_error("stage failed"); });
+    pipeline.addStage("independent", {}, [&independentRan] { independentRan = true; });
+    pipeline.addStage("dependent", { "failing" }, [&dependentRan] { dependentRan = true; });
+    EXPECT_THROW(pipeline.run(), runtime_error);
+    EXPECT_TRUE(independentRan);
+    EXPECT_FALSE(dependentRan);
+
+    ParallaxGenPipeline mainPipeline;
+    mainPipeline.addStage("main", {}, [] { throw runtime_error("main stage failed"); }, true);
+    EXPECT_THROW(mainPipeline.run(), runtime_error);
+}
+
+TEST(ParallaxGenPipelineTests, FixtureOutputTests)
+{
+    // running the stages on the dependency graph writes the same files as running them one after another
+    const auto sequentialHashes = patchTestEnv(PGTestEnvs::s_exePath / "output" / "sequential", false);
+    const auto pipelineHashes = patchTestEnv(PGTestEnvs::s_exePath / "output" / "pipeline", true);
+
+    EXPECT_FALSE(sequentialHashes.empty());
+    EXPECT_EQ(sequentialHashes.size(), pipelineHashes.size());
+    for (const auto& [file, hash] : sequentialHashes) {
+        const auto it = pipelineHashes.find(file);
+        ASSERT_NE(it, pipelineHashes.end()) << ParallaxGenUtil::utf16toUTF8(file);
+        EXPECT_EQ(it->second, hash) << ParallaxGenUtil::utf16toUTF8(file);
+    }
+}
+
+TEST(ParallaxGenPipelineTests, DISABLED_OverlapBenchmark)
+{
+    // stages sleep so the result does not depend on the number of cores of the machine
+    const auto runSynthetic = [](const bool& multithread) -> pair<double, double> {
+        ParallaxGenPipeline pipeline;
+        for (const auto& [name, inputs, duration] : SYNTHETIC_STAGES) {
+            pipeline.addStage(name, inputs, [duration] { this_thread::sleep_for(chrono::milliseconds(duration)); });
+        }
+
+        const auto start = chrono::steady_clock::now();
+        pipeline.run(multithread);
+        const double wallMS = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return { wallMS, pipeline.getOverlapMS() };
+    };
+
+    const double barrierMS = runSynthetic(false).first;
+    const auto [pipelineMS, pipelineOverlapMS] = runSynthetic(true);
+    cout << SYNTHETIC_STAGES.size() << " stages: barrier " << barrierMS << " ms, dependency graph " << pipelineMS
+         << " ms, overlapped " << pipelineOverlapMS << " ms\n";
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
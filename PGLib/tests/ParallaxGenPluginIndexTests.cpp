@@ -0,0 +1,184 @@
+#include "ParallaxGenPluginIndex.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenPluginIndexTests, MatchTests)
+{
+    ParallaxGenPluginIndex index;
+    index.addAltTexRef({ .nifName = L"meshes\\clutter\\barrel.nif",
+        .index3D = 2,
+        .txstIndex = 10,
+        .altTexIndex = 0,
+        .modelRecHandle = 0,
+        .matchType = "MODL" });
+    index.addAltTexRef({ .nifName = L"meshes\\clutter\\barrel.nif",
+        .index3D = 2,
+        .txstIndex = 11,
+        .altTexIndex = 1,
+        .modelRecHandle = 1,
+        .matchType = "MODL" });
+    index.addAltTexRef({ .nifName = L"meshes\\armor\\cuirass_0.nif",
+        .index3D = 0,
+        .txstIndex = 12,
+        .altTexIndex = 2,
+        .modelRecHandle = 2,
+        .matchType = "MOD2" });
+    index.addAltTexRef({ .nifName = L"meshes\\armor\\cuirass_0.nif",
+        .index3D = 0,
+        .txstIndex = 10,
+        .altTexIndex = 3,
+        .modelRecHandle = 3,
+        .matchType = "MODL" });
+    EXPECT_EQ(index.getNumAltTexRefs(), 4);
+    EXPECT_EQ(index.getReferencedTXSTs(), (vector<int> { 10, 11, 12 }));
+
+    vector<ParallaxGenPluginIndex::Match> matches;
+
+    // refs keep the order they were added in, lookups are case insensitive
+    index.getMatches(L"meshes\\Clutter\\Barrel.nif", 2, matches);
+    ASSERT_EQ(matches.size(), 2);
+    EXPECT_EQ(matches[0].txstIndex, 10);
+    EXPECT_EQ(matches[0].altTexIndex, 0);
+    EXPECT_EQ(matches[0].matchedNIF, L"meshes\\clutter\\barrel.nif");
+    EXPECT_EQ(matches[1].altTexIndex, 1);
+
+    index.getMatches(L"meshes\\clutter\\barrel.nif", 1, matches);
+    EXPECT_TRUE(matches.empty());
+
+    // the other weight matches, except for MODL entries
+    index.getMatches(L"meshes\\armor\\cuirass_1.nif", 0, matches);
+    ASSERT_EQ(matches.size(), 1);
+    EXPECT_EQ(matches[0].altTexIndex, 2);
+    EXPECT_EQ(matches[0].matchedNIF, L"meshes\\armor\\cuirass_0.nif");
+    EXPECT_EQ(matches[0].matchType, "MOD2");
+
+    index.getMatches(L"meshes\\armor\\cuirass_0.nif", 0, matches);
+    EXPECT_EQ(matches.size(), 2);
+
+    EXPECT_EQ(index.getModelRecHandle(3), 3);
+    EXPECT_THROW(static_cast<void>(index.getModelRecHandle(4)), out_of_range);
+}
+
+TEST(ParallaxGenPluginIndexTests, TXSTSlotTests)
+{
+    ParallaxGenPluginIndex index;
+
+    ParallaxGenPluginIndex::TXSTSlots slots;
+    slots[0] = L"textures\\clutter\\barrel.dds";
+    slots[1] = L"textures\\clutter\\barrel_n.dds";
+    index.setTXSTSlots(5, slots);
+
+    EXPECT_EQ(index.getTXSTSlots(5), slots);
+    EXPECT_TRUE(index.getTXSTSlots(6)[0].empty());
+
+    index.clear();
+    EXPECT_TRUE(index.getTXSTSlots(5)[0].empty());
+    EXPECT_EQ(index.getNumAltTexRefs(), 0);
+}
+
+TEST(ParallaxGenPluginIndexTests, NIFMatchTests)
+{
+    ParallaxGenPluginIndex index;
+    const auto addRef = [&index](const wstring& nifName, int index3D, int altTexIndex, const string& matchType) {
+        index.addAltTexRef({ .nifName = nifName,
+            .index3D = index3D,
+            .txstIndex = altTexIndex,
+            .altTexIndex = altTexIndex,
+            .modelRecHandle = altTexIndex,
+            .matchType = matchType });
+    };
+    addRef(L"meshes\\armor\\boots_1.nif", 1, 0, "MODL");
+    addRef(L"meshes\\armor\\boots_0.nif", 1, 1, "MOD4");
+    addRef(L"meshes\\armor\\boots_1.nif", 0, 2, "MOD2");
+    addRef(L"meshes\\armor\\boots_1.nif", 1, 3, "MOD2");
+    addRef(L"meshes\\armor\\boots_1.nif", 5, 4, "MOD2");
+    addRef(L"meshes\\armor\\boots_1.nif", -1, 5, "MOD2");
+
+    constexpr size_t NUM_SHAPES = 3;
+    ParallaxGenPluginIndex::NIFMatches nifMatches;
+    index.getNIFMatches(L"Meshes\\Armor\\Boots_1.nif", NUM_SHAPES, nifMatches);
+
+    // every shape matches the same entries in the same order as a single shape lookup
+    vector<ParallaxGenPluginIndex::Match> matches;
+    for (int shape = 0; shape < static_cast<int>(NUM_SHAPES); shape++) {
+        index.getMatches(L"meshes\\armor\\boots_1.nif", shape, matches);
+        const auto shapeMatches = nifMatches.getShapeMatches(shape);
+        ASSERT_EQ(shapeMatches.size(), matches.size());
+        for (size_t i = 0; i < matches.size(); i++) {
+            EXPECT_EQ(shapeMatches[i].altTexIndex, matches[i].altTexIndex);
+            EXPECT_EQ(shapeMatches[i].matchedNIF, matches[i].matchedNIF);
+        }
+    }
+
+    const auto shapeMatches = nifMatches.getShapeMatches(1);
+    ASSERT_EQ(shapeMatches.size(), 3);
+    EXPECT_EQ(shapeMatches[0].altTexIndex, 0);
+    EXPECT_EQ(shapeMatches[1].altTexIndex, 3);
+    EXPECT_EQ(shapeMatches[2].altTexIndex, 1);
+    EXPECT_EQ(shapeMatches[2].matchedNIF, L"meshes\\armor\\boots_0.nif");
+
+    // 3D indices outside of the NIF are dropped
+    EXPECT_EQ(nifMatches.matches.size(), 4);
+    EXPECT_TRUE(nifMatches.getShapeMatches(-1).empty());
+    EXPECT_TRUE(nifMatches.getShapeMatches(5).empty());
+
+    index.getNIFMatches(L"meshes\\armor\\gloves.nif", NUM_SHAPES, nifMatches);
+    EXPECT_TRUE(nifMatches.matches.empty());
+    EXPECT_TRUE(nifMatches.getShapeMatches(0).empty());
+}
+
+// Compares per shape lookups against one lookup per NIF, run with --gtest_also_run_disabled_tests
+TEST(ParallaxGenPluginIndexTests, DISABLED_NIFMatchBenchmark)
+{
+    constexpr int NUM_NIFS = 5000;
+    constexpr int NUM_SHAPES = 10;
+
+    ParallaxGenPluginIndex index;
+    for (int nif = 0; nif < NUM_NIFS; nif++) {
+        for (int shape = 0; shape < NUM_SHAPES; shape++) {
+            const int refIndex = (nif * NUM_SHAPES) + shape;
+            index.addAltTexRef({ .nifName = L"meshes\\bench\\model" + to_wstring(nif) + L"_1.nif",
+                .index3D = shape,
+                .txstIndex = refIndex,
+                .altTexIndex = refIndex,
+                .modelRecHandle = refIndex,
+                .matchType = "MOD2" });
+        }
+    }
+
+    size_t numShapeMatches = 0;
+    vector<ParallaxGenPluginIndex::Match> matches;
+    const auto shapeStart = chrono::steady_clock::now();
+    for (int nif = 0; nif < NUM_NIFS; nif++) {
+        const wstring nifName = L"Meshes\\Bench\\Model" + to_wstring(nif) + L"_1.nif";
+        for (int shape = 0; shape < NUM_SHAPES; shape++) {
+            index.getMatches(nifName, shape, matches);
+            numShapeMatches += matches.size();
+        }
+    }
+    const auto shapeTime = chrono::steady_clock::now() - shapeStart;
+
+    size_t numNIFMatches = 0;
+    ParallaxGenPluginIndex::NIFMatches nifMatches;
+    const auto nifStart = chrono::steady_clock::now();
+    for (int nif = 0; nif < NUM_NIFS; nif++) {
+        const wstring nifName = L"Meshes\\Bench\\Model" + to_wstring(nif) + L"_1.nif";
+        index.getNIFMatches(nifName, NUM_SHAPES, nifMatches);
+        numNIFMatches += nifMatches.matches.size();
+    }
+    const auto nifTime = chrono::steady_clock::now() - nifStart;
+
+    EXPECT_EQ(numShapeMatches, numNIFMatches);
+    cout << "Per shape: " << chrono::duration_cast<chrono::milliseconds>(shapeTime).count() << " ms, per NIF: "
+         << chrono::duration_cast<chrono::milliseconds>(nifTime).count() << " ms\n";
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
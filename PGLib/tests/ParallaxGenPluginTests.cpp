@@ -1,11 +1,84 @@
 #include "BethesdaGame.hpp"
 #include "CommonTests.hpp"
+#include "ParallaxGen.hpp"
+#include "ParallaxGenD3D.hpp"
+#include "ParallaxGenDirectory.hpp"
 #include "ParallaxGenPlugin.hpp"
+#include "ParallaxGenUtil.hpp"
+#include "ParallaxGenWarnings.hpp"
+#include "patchers/PatcherMeshPreFixTextureSlotCount.hpp"
+#include "patchers/PatcherMeshShaderComplexMaterial.hpp"
+#include "patchers/PatcherMeshShaderDefault.hpp"
+#include "patchers/PatcherMeshShaderVanillaParallax.hpp"
+#include "patchers/base/Patcher.hpp"
+#include "patchers/base/PatcherUtil.hpp"
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 using namespace std;
 
+namespace {
+/**
+ * @brief Patch the meshes of the test environment with plugin patching and save the plugin
+ *
+ * @param params test environment
+ * @param outputDir output directory, deleted first
+ * @param multithread patch meshes on all threads
+ * @return vector<std::byte> bytes of the saved ParallaxGen.esp
+ */
+auto patchTestEnvPlugin(const PGTesting::TestEnvGameParams& params, const filesystem::path& outputDir,
+    const bool& multithread) -> vector<std::byte>
+{
+    filesystem::remove_all(outputDir);
+    filesystem::create_directories(outputDir);
+
+    BethesdaGame bg(params.GameType, false, params.GamePath, params.AppDataPath, params.DocumentPath);
+    ParallaxGenDirectory pgd(&bg, outputDir, nullptr);
+    ParallaxGenD3D pgd3d(&pgd, outputDir, PGTestEnvs::s_exePath);
+    ParallaxGen pg(outputDir, &pgd, &pgd3d, false);
+    unordered_map<wstring, int> modPriority;
+
+    pgd.populateFileMap(false);
+    pgd.mapFiles({}, {}, {}, {}, true, false);
+    pgd3d.initGPU();
+    pgd3d.findCMMaps({});
+    Patcher::loadStatics(pgd, pgd3d);
+
+    PatcherUtil::PatcherMeshSet meshPatchers;
+    meshPatchers.prePatchers.emplace_back(PatcherMeshPreFixTextureSlotCount::getFactory());
+    meshPatchers.shaderPatchers.emplace(
+        PatcherMeshShaderDefault::getShaderType(), PatcherMeshShaderDefault::getFactory());
+    meshPatchers.shaderPatchers.emplace(
+        PatcherMeshShaderVanillaParallax::getShaderType(), PatcherMeshShaderVanillaParallax::getFactory());
+    meshPatchers.shaderPatchers.emplace(
+        PatcherMeshShaderComplexMaterial::getShaderType(), PatcherMeshShaderComplexMaterial::getFactory());
+    PatcherMeshShaderComplexMaterial::loadStatics(false, {});
+    pg.loadPatchers(meshPatchers, {});
+
+    ParallaxGenPlugin::loadStatics(&pgd);
+    ParallaxGenPlugin::initialize(bg, "");
+    ParallaxGenPlugin::populateObjs();
+
+    pg.loadModPriorityMap(&modPriority);
+    ParallaxGenWarnings::init(&pgd, &modPriority);
+    pg.patch(multithread, true);
+    ParallaxGenPlugin::savePlugin(outputDir, false);
+
+    return ParallaxGenUtil::getFileBytes(outputDir / "ParallaxGen.esp");
+}
+} // namespace
+
 class ParallaxGenPluginTests : public ::testing::TestWithParam<PGTesting::TestEnvGameParams> {
 protected:
     // Set up code for each test
@@ -32,4 +105,154 @@ TEST_P(ParallaxGenPluginTests, TestPopulateObjs)
     EXPECT_NO_THROW(ParallaxGenPlugin::populateObjs());
 }
 
+TEST_P(ParallaxGenPluginTests, TestIndexMatchesLibrary)
+{
+    ParallaxGenPlugin::populateObjs();
+
+    // the native index must resolve exactly what GetMatchingTXSTObjs of the library resolves
+    const auto differences = ParallaxGenPlugin::getLibraryDifferences();
+    for (const auto& difference : differences) {
+        ADD_FAILURE() << ParallaxGenUtil::utf16toUTF8(difference);
+    }
+    EXPECT_TRUE(differences.empty());
+}
+
+TEST_P(ParallaxGenPluginTests, TestSavedPluginMatchesReference)
+{
+    const auto& params = GetParam();
+
+    // the op log is applied in mesh order, so the thread count must not change a single byte of the plugin
+    const auto singleThreaded = patchTestEnvPlugin(params, PGTestEnvs::s_exePath / "output" / "plugin_single", false);
+    const auto multiThreaded = patchTestEnvPlugin(params, PGTestEnvs::s_exePath / "output" / "plugin_multi", true);
+    ASSERT_FALSE(singleThreaded.empty());
+    EXPECT_TRUE(singleThreaded == multiThreaded);
+
+    // ParallaxGen.esp saved from this environment by the build before plugin writes went through the op log, where
+    // every write was made right away by the patching thread
+    const filesystem::path referencePath = params.GamePath.parent_path() / "expected" / "ParallaxGen.esp";
+    if (!filesystem::exists(referencePath)) {
+        GTEST_SKIP() << "No reference plugin at " << referencePath.string();
+    }
+
+    EXPECT_TRUE(singleThreaded == ParallaxGenUtil::getFileBytes(referencePath));
+}
+
+TEST_P(ParallaxGenPluginTests, DISABLED_LogChannelBenchmark)
+{
+    constexpr int NUM_MESSAGES = 1000000;
+    constexpr int NUM_CALLS = 100000;
+    constexpr int TRACE_LOG = 0;
+
+    // messages logged by the managed side until they are written to the log
+    const auto throughputStart = chrono::steady_clock::now();
+    ParallaxGenPlugin::logTestMessages(NUM_MESSAGES, TRACE_LOG);
+    const double throughputS = chrono::duration<double>(chrono::steady_clock::now() - throughputStart).count();
+
+    // time a lib call spends in the library, with no message and with one message pushed to the consumer
+    const auto timeCalls = [](const int& numMessages) -> double {
+        const auto start = chrono::steady_clock::now();
+        for (int call = 0; call < NUM_CALLS; call++) {
+            ParallaxGenPlugin::logTestMessages(numMessages, TRACE_LOG, false);
+        }
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / NUM_CALLS;
+    };
+    const double emptyCallNS = timeCalls(0);
+    const double messageCallNS = timeCalls(1);
+    ParallaxGenPlugin::logTestMessages(0, TRACE_LOG); // waits for the messages of the timed calls
+
+    cout << NUM_MESSAGES << " managed messages in " << throughputS << " s (" << NUM_MESSAGES / throughputS
+         << " messages/s), lib call " << emptyCallNS << " ns, lib call with one message " << messageCallNS << " ns (+"
+         << messageCallNS - emptyCallNS << " ns)\n";
+}
+
 INSTANTIATE_TEST_SUITE_P(TestEnvs, ParallaxGenPluginTests, ::testing::Values(PGTestEnvs::s_testENVSkyrimSE));
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenPluginNewTXSTTests, DeterministicEDIDTests)
+{
+    // requests as shapes make them: the same slots from many alternate textures, in whatever case the patcher returned
+    constexpr int NUM_SLOT_SETS = 300;
+    constexpr int NUM_REQUESTS = 5000;
+
+    vector<pair<int, NIFUtil::TextureSet>> requests;
+    mt19937 rng(1); // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    for (int altTexIndex = 0; altTexIndex < NUM_REQUESTS; altTexIndex++) {
+        const auto slotSet = static_cast<int>(rng() % NUM_SLOT_SETS);
+
+        NIFUtil::TextureSet slots;
+        slots.at(0) = L"textures\\set" + to_wstring(slotSet) + L"\\diffuse.dds";
+        slots.at(1) = L"textures\\set" + to_wstring(slotSet) + L"\\normal_n.dds";
+        if (altTexIndex % 3 == 0) {
+            slots.at(0) = L"Textures\\Set" + to_wstring(slotSet) + L"\\Diffuse.dds";
+        }
+
+        requests.emplace_back(altTexIndex, slots);
+    }
+
+    // returns the records to create and the EDID every request ends up with
+    const auto runRequests = [&requests](const size_t& numThreads, const unsigned int& seed) -> wstring {
+        auto shuffled = requests;
+        mt19937 shuffleRng(seed);
+        ranges::shuffle(shuffled, shuffleRng);
+
+        vector<ParallaxGenPlugin::NewTXSTRequests> threadRequests(numThreads);
+        vector<vector<pair<int, const ParallaxGenPlugin::NewTXSTKey*>>> threadKeys(numThreads);
+        vector<thread> threads;
+        for (size_t thread = 0; thread < numThreads; thread++) {
+            threads.emplace_back([&, thread] {
+                for (size_t i = thread; i < shuffled.size(); i += numThreads) {
+                    const auto& [altTexIndex, slots] = shuffled[i];
+                    threadKeys[thread].emplace_back(altTexIndex,
+                        ParallaxGenPlugin::addNewTXSTRequest(threadRequests[thread],
+                            ParallaxGenPlugin::makeNewTXSTKey(slots),
+                            { .altTexIndex = altTexIndex, .slots = slots }));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        vector<const ParallaxGenPlugin::NewTXSTRequests*> requestPtrs;
+        for (const auto& curRequests : threadRequests) {
+            requestPtrs.push_back(&curRequests);
+        }
+
+        vector<ParallaxGenPlugin::NewTXST> newTXSTs;
+        unordered_map<const ParallaxGenPlugin::NewTXSTKey*, size_t> keyIndices;
+        ParallaxGenPlugin::assignNewTXSTs(requestPtrs, newTXSTs, keyIndices);
+
+        wstring output;
+        for (const auto& [request, edid] : newTXSTs) {
+            output += wstring(edid.begin(), edid.end()) + L" " + to_wstring(request->altTexIndex);
+            for (const auto& slot : request->slots) {
+                output += L" " + slot;
+            }
+            output += L"\n";
+        }
+
+        vector<pair<int, size_t>> assigned;
+        for (const auto& keys : threadKeys) {
+            for (const auto& [altTexIndex, key] : keys) {
+                assigned.emplace_back(altTexIndex, keyIndices.at(key));
+            }
+        }
+        ranges::sort(assigned);
+        for (const auto& [altTexIndex, index] : assigned) {
+            output += to_wstring(altTexIndex) + L" -> " + to_wstring(index) + L"\n";
+        }
+
+        return output;
+    };
+
+    const auto expected = runRequests(1, 1);
+    EXPECT_NE(expected.find(L"PGTXST00299 "), wstring::npos);
+    EXPECT_EQ(expected.find(L"PGTXST00300 "), wstring::npos);
+
+    for (const size_t numThreads : { 1, 4, 32 }) {
+        for (const unsigned int seed : { 2U, 3U }) {
+            EXPECT_EQ(runRequests(numThreads, seed), expected) << numThreads << " threads, seed " << seed;
+        }
+    }
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
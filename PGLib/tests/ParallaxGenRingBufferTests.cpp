@@ -0,0 +1,105 @@
+#include "ParallaxGenRingBuffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenRingBufferTests, RingBufferTests)
+{
+    ParallaxGenRingBuffer<wstring> buffer(3);
+    EXPECT_EQ(buffer.capacity(), 4);
+
+    wstring value;
+    EXPECT_FALSE(buffer.tryPop(value));
+
+    // values come out in push order, a full buffer rejects the value without taking it
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(buffer.tryPush(to_wstring(i)));
+    }
+    wstring rejected = L"rejected";
+    EXPECT_FALSE(buffer.tryPush(std::move(rejected)));
+    EXPECT_EQ(rejected, L"rejected"); // NOLINT(bugprone-use-after-move,hicpp-invalid-access-moved)
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(buffer.tryPop(value));
+        EXPECT_EQ(value, to_wstring(i));
+    }
+    EXPECT_FALSE(buffer.tryPop(value));
+
+    // slots are reused after wrapping around
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(buffer.tryPush(to_wstring(i)));
+        ASSERT_TRUE(buffer.tryPop(value));
+        EXPECT_EQ(value, to_wstring(i));
+    }
+}
+
+TEST(ParallaxGenRingBufferTests, DISABLED_StressTests)
+{
+    // plugin library log traffic: many short messages from several threads, one consumer draining them
+    constexpr size_t NUM_PRODUCERS = 4;
+    constexpr size_t NUM_MESSAGES = 1000000;
+    constexpr size_t MESSAGES_PER_PRODUCER = NUM_MESSAGES / NUM_PRODUCERS;
+
+    ParallaxGenRingBuffer<pair<size_t, wstring>> buffer(8192);
+    atomic<size_t> numFullPushes = 0;
+
+    const auto start = chrono::steady_clock::now();
+
+    vector<thread> producers;
+    for (size_t producer = 0; producer < NUM_PRODUCERS; producer++) {
+        producers.emplace_back([&, producer] {
+            for (size_t i = 0; i < MESSAGES_PER_PRODUCER; i++) {
+                pair<size_t, wstring> message { producer, L"[PopulateObjs] Adding TXST record " + to_wstring(i) };
+                while (!buffer.tryPush(std::move(message))) {
+                    numFullPushes++;
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // every producer's messages arrive complete and in order
+    vector<size_t> nextIndex(NUM_PRODUCERS, 0);
+    size_t numPopped = 0;
+    bool inOrder = true;
+    pair<size_t, wstring> message;
+    while (numPopped < NUM_MESSAGES) {
+        if (!buffer.tryPop(message)) {
+            this_thread::yield();
+            continue;
+        }
+
+        const auto& [producer, text] = message;
+        inOrder &= text == L"[PopulateObjs] Adding TXST record " + to_wstring(nextIndex[producer]);
+        nextIndex[producer]++;
+        numPopped++;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    const auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    EXPECT_TRUE(inOrder);
+    EXPECT_FALSE(buffer.tryPop(message));
+    for (const auto& count : nextIndex) {
+        EXPECT_EQ(count, MESSAGES_PER_PRODUCER);
+    }
+
+    cout << NUM_MESSAGES << " messages in " << elapsed * 1000.0 << " ms ("
+         << static_cast<size_t>(NUM_MESSAGES / elapsed) << " messages/s, " << elapsed * 1e9 / NUM_MESSAGES
+         << " ns per message, " << numFullPushes << " retries on a full buffer)\n";
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
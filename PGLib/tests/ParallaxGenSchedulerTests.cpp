@@ -0,0 +1,240 @@
+#include "ParallaxGenRunner.hpp"
+#include "ParallaxGenScheduler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+void countIndex(void* context, const size_t& index) { (*static_cast<vector<atomic<int>>*>(context))[index]++; }
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+void spinMicrosecond()
+{
+    const auto end = chrono::steady_clock::now() + chrono::microseconds(1);
+    while (chrono::steady_clock::now() < end) {
+    }
+}
+
+// what ParallaxGenRunner did before the scheduler: a new pool per run, copied tasks and a 10 ms completion poll
+auto runOnPool(const vector<function<void()>>& tasks) -> double
+{
+    static constexpr int LOOP_INTERVAL = 10;
+
+    const auto start = chrono::steady_clock::now();
+    boost::asio::thread_pool threadPool(thread::hardware_concurrency());
+    atomic<size_t> completedTasks = 0;
+    for (const auto& task : tasks) {
+        boost::asio::post(threadPool, [task, &completedTasks] {
+            task();
+            completedTasks.fetch_add(1);
+        });
+    }
+
+    while (completedTasks.load() < tasks.size()) {
+        this_thread::sleep_for(chrono::milliseconds(LOOP_INTERVAL));
+    }
+    const auto elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    threadPool.join();
+    return elapsed;
+}
+
+auto runOnRunner(const vector<function<void()>>& tasks) -> double
+{
+    const auto start = chrono::steady_clock::now();
+    ParallaxGenRunner runner;
+    for (const auto& task : tasks) {
+        runner.addTask(task);
+    }
+    runner.runTasks();
+
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenSchedulerTests, SchedulerTests)
+{
+    ParallaxGenScheduler scheduler(4);
+    EXPECT_EQ(scheduler.getNumThreads(), 4);
+
+    // every index runs exactly once, also with fewer indices than workers
+    for (const size_t count : { 1, 3, 1000, 100000 }) {
+        vector<atomic<int>> counts(count);
+        scheduler.submit(countIndex, &counts, count);
+
+        size_t numDone = 0;
+        while (numDone < count) {
+            scheduler.runPending();
+            numDone = 0;
+            for (const auto& curCount : counts) {
+                numDone += static_cast<size_t>(curCount.load() > 0);
+            }
+        }
+
+        for (const auto& curCount : counts) {
+            EXPECT_EQ(curCount.load(), 1);
+        }
+    }
+}
+
+TEST(ParallaxGenSchedulerTests, StartOrderTests)
+{
+    ParallaxGenScheduler scheduler(3);
+
+    // chunks [0, 3), [3, 6) and [6, 10) are started front to back side by side
+    EXPECT_EQ(scheduler.getStartOrder(10), vector<size_t>({ 0, 3, 6, 1, 4, 7, 2, 5, 8, 9 }));
+    EXPECT_EQ(scheduler.getStartOrder(2), vector<size_t>({ 0, 1 }));
+    EXPECT_TRUE(scheduler.getStartOrder(0).empty());
+
+    // tasks with cost hints still run exactly once
+    vector<atomic<int>> counts(1000);
+    ParallaxGenRunner runner(true, &scheduler);
+    for (size_t i = 0; i < counts.size(); i++) {
+        runner.addTask([&counts, i] { counts[i]++; }, i % 7);
+    }
+    runner.runTasks();
+    for (const auto& count : counts) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
+TEST(ParallaxGenSchedulerTests, StopTests)
+{
+    // destroying the scheduler finishes running jobs but drops the queued ones
+    constexpr size_t NUM_JOBS = 1000;
+    atomic<size_t> numRun = 0;
+    {
+        ParallaxGenScheduler scheduler(1);
+        scheduler.submit(
+            [](void* context, const size_t& /*index*/) {
+                this_thread::sleep_for(chrono::milliseconds(1));
+                static_cast<atomic<size_t>*>(context)->fetch_add(1);
+            },
+            &numRun, NUM_JOBS);
+        this_thread::sleep_for(chrono::milliseconds(5));
+    }
+
+    const size_t numRunAtStop = numRun.load();
+    EXPECT_LT(numRunAtStop, NUM_JOBS);
+    this_thread::sleep_for(chrono::milliseconds(5));
+    EXPECT_EQ(numRun.load(), numRunAtStop);
+}
+
+TEST(ParallaxGenSchedulerTests, RunnerTests)
+{
+    // tasks are move only and runners can be used from within tasks
+    atomic<int> sum = 0;
+    ParallaxGenRunner runner;
+    for (int i = 0; i < 64; i++) {
+        auto value = make_unique<int>(i);
+        runner.addTask([value = std::move(value), &sum] {
+            ParallaxGenRunner innerRunner;
+            for (int j = 0; j < 10; j++) {
+                innerRunner.addTask([&sum, &value] { sum += *value; });
+            }
+            innerRunner.runTasks();
+        });
+    }
+    runner.runTasks();
+    EXPECT_EQ(sum.load(), 10 * (63 * 64 / 2));
+
+    // the first exception is rethrown on the calling thread once all tasks are done or skipped
+    ParallaxGenRunner throwingRunner;
+    atomic<int> numRun = 0;
+    for (int i = 0; i < 1000; i++) {
+        throwingRunner.addTask([i, &numRun] {
+            numRun++;
+            if (i == 10) {
+                throw runtime_error("task failed");
+            }
+        });
+    }
+    EXPECT_THROW(throwingRunner.runTasks(), runtime_error);
+    EXPECT_GE(numRun.load(), 1);
+
+    // single threaded runners run in order on the calling thread
+    vector<int> order;
+    ParallaxGenRunner singleRunner(false);
+    for (int i = 0; i < 5; i++) {
+        singleRunner.addTask([i, &order] { order.push_back(i); });
+    }
+    singleRunner.runTasks();
+    EXPECT_EQ(order, vector<int>({ 0, 1, 2, 3, 4 }));
+}
+
+TEST(ParallaxGenSchedulerTests, DISABLED_RunnerBenchmark)
+{
+    constexpr size_t NUM_TASKS = 100000;
+
+    const vector<function<void()>> emptyTasks(NUM_TASKS, [] { });
+    const vector<function<void()>> microTasks(NUM_TASKS, spinMicrosecond);
+
+    // start the scheduler outside of the timing, it lives for the whole process
+    ParallaxGenScheduler::get();
+
+    for (const auto& [name, tasks] : { pair { "empty", &emptyTasks }, pair { "1 us", &microTasks } }) {
+        const double poolTime = runOnPool(*tasks);
+        const double runnerTime = runOnRunner(*tasks);
+        cout << NUM_TASKS << " " << name << " tasks: thread pool " << poolTime << " ms, scheduler " << runnerTime
+             << " ms\n";
+    }
+}
+
+TEST(ParallaxGenSchedulerTests, DISABLED_LPTBenchmark)
+{
+    // heavy tailed task durations like the file sizes of a mod list: mostly small files and a few huge ones
+    constexpr size_t NUM_TASKS = 1000;
+    constexpr size_t NUM_THREADS = 8;
+    constexpr double PARETO_ALPHA = 1.5;
+    constexpr double MIN_MICROSECONDS = 500.0;
+
+    mt19937 rng(1); // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    vector<uint64_t> durations(NUM_TASKS);
+    for (auto& duration : durations) {
+        duration = static_cast<uint64_t>(MIN_MICROSECONDS / pow(1.0 - uniform(rng), 1.0 / PARETO_ALPHA));
+    }
+
+    const uint64_t total = accumulate(durations.begin(), durations.end(), uint64_t { 0 });
+    const uint64_t lowerBound = max(total / NUM_THREADS, ranges::max(durations));
+
+    // tasks sleep instead of spinning so the makespan does not depend on the number of cores of the machine
+    ParallaxGenScheduler scheduler(NUM_THREADS);
+    const auto runMakespan = [&](const bool& useCosts) -> double {
+        ParallaxGenRunner runner(true, &scheduler);
+        for (const auto& duration : durations) {
+            runner.addTask([duration] { this_thread::sleep_for(chrono::microseconds(duration)); },
+                useCosts ? duration : 0);
+        }
+
+        const auto start = chrono::steady_clock::now();
+        runner.runTasks();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    const double addedOrder = runMakespan(false);
+    const double largestFirst = runMakespan(true);
+    cout << NUM_TASKS << " tasks on " << NUM_THREADS << " threads, total " << static_cast<double>(total) / 1000.0
+         << " ms, lower bound " << static_cast<double>(lowerBound) / 1000.0 << " ms: added order " << addedOrder
+         << " ms, largest first " << largestFirst << " ms\n";
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
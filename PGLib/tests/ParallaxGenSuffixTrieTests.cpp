@@ -0,0 +1,73 @@
+#include "ParallaxGenSuffixTrie.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenSuffixTrieTests, MatchTests)
+{
+    ParallaxGenSuffixTrie trie;
+
+    vector<size_t> ids;
+    trie.findSuffixes(L"textures\\test", 0, ids);
+    EXPECT_TRUE(ids.empty());
+
+    trie.addSuffix(L"\\Architecture\\Whiterun\\WRWall", 4);
+    trie.addSuffix(L"\\whiterun\\wrwall", 2);
+    trie.addSuffix(L"\\wrwall", 9);
+    trie.addSuffix(L"\\wrwall", 1);
+    trie.addSuffix(L"wall", 3);
+    trie.addSuffix(L"\\wrwall02", 5);
+    trie.build();
+    EXPECT_EQ(trie.getNumSuffixes(), 6);
+
+    // all suffixes are found, ids are sorted and unique
+    trie.findSuffixes(L"textures\\architecture\\whiterun\\WRWALL", 0, ids);
+    EXPECT_EQ(ids, (vector<size_t> { 1, 2, 3, 4, 9 }));
+
+    // minimum length filters suffixes that do not cover the file name
+    trie.findSuffixes(L"textures\\architecture\\whiterun\\wrwall", 7, ids);
+    EXPECT_EQ(ids, (vector<size_t> { 1, 2, 4, 9 }));
+
+    trie.findSuffixes(L"textures\\clutter\\wrwall", 7, ids);
+    EXPECT_EQ(ids, (vector<size_t> { 1, 9 }));
+
+    trie.findSuffixes(L"textures\\clutter\\wrwall01", 0, ids);
+    EXPECT_TRUE(ids.empty());
+
+    trie.findSuffixes(L"", 0, ids);
+    EXPECT_TRUE(ids.empty());
+}
+
+TEST(ParallaxGenSuffixTrieTests, MatchesIEndsWithTests)
+{
+    const vector<wstring> suffixes = { L"a", L"ba", L"\\ba", L"b\\a", L"AB", L"bab", L"\\", L"abab", L"cab" };
+    const vector<wstring> texts = { L"", L"a", L"ba", L"x\\ba", L"b\\A", L"ababab", L"cab", L"y\\", L"xyz" };
+
+    ParallaxGenSuffixTrie trie;
+    for (size_t i = 0; i < suffixes.size(); i++) {
+        trie.addSuffix(suffixes[i], i);
+    }
+    trie.build();
+
+    for (const auto& text : texts) {
+        vector<size_t> expected;
+        for (size_t i = 0; i < suffixes.size(); i++) {
+            if (boost::iends_with(text, suffixes[i])) {
+                expected.push_back(i);
+            }
+        }
+
+        vector<size_t> ids;
+        trie.findSuffixes(text, 0, ids);
+        EXPECT_EQ(ids, expected);
+    }
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,144 @@
+#include "ParallaxGenTask.hpp"
+
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+#ifdef _WIN32
+auto getFD(FILE* file) -> int { return _fileno(file); }
+#else
+auto getFD(FILE* file) -> int { return fileno(file); }
+#endif
+
+// what completeJob did before the counters were atomic: a mutex, a map and a percentage check on every job
+class MutexTask {
+    static constexpr size_t FULL_PERCENTAGE = 100;
+
+    size_t m_totalJobs;
+    size_t m_lastPerc = 0;
+    mutex m_mutex;
+    unordered_map<ParallaxGenTask::PGResult, size_t> m_numJobsCompleted;
+
+public:
+    explicit MutexTask(const size_t& totalJobs)
+        : m_totalJobs(totalJobs)
+    {
+    }
+
+    void completeJob(const ParallaxGenTask::PGResult& result)
+    {
+        const lock_guard<mutex> lock(m_mutex);
+        m_numJobsCompleted[result]++;
+
+        size_t combinedJobs = 0;
+        for (const auto& [curResult, numJobs] : m_numJobsCompleted) {
+            combinedJobs += numJobs;
+        }
+        m_lastPerc = combinedJobs * FULL_PERCENTAGE / m_totalJobs;
+    }
+};
+
+template <typename T> auto completeOnThreads(T& task, const size_t& numThreads, const size_t& jobsPerThread) -> double
+{
+    const auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    threads.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; i++) {
+        threads.emplace_back([&task, &jobsPerThread] {
+            for (size_t job = 0; job < jobsPerThread; job++) {
+                task.completeJob(ParallaxGenTask::PGResult::SUCCESS);
+            }
+        });
+    }
+
+    for (auto& curThread : threads) {
+        curThread.join();
+    }
+
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenTaskTests, ProgressTests)
+{
+    FILE* progressFile = tmpfile();
+    ASSERT_NE(progressFile, nullptr);
+    ParallaxGenTask::setProgressFD(getFD(progressFile));
+
+    constexpr size_t NUM_THREADS = 8;
+    constexpr size_t JOBS_PER_THREAD = 1000;
+    {
+        ParallaxGenTask task("Test Task", NUM_THREADS * JOBS_PER_THREAD);
+        vector<thread> threads;
+        for (size_t i = 0; i < NUM_THREADS; i++) {
+            threads.emplace_back([&task] {
+                for (size_t job = 0; job < JOBS_PER_THREAD; job++) {
+                    task.completeJob(job % 10 == 0 ? ParallaxGenTask::PGResult::FAILURE
+                                                   : ParallaxGenTask::PGResult::SUCCESS,
+                        100);
+                }
+            });
+        }
+        for (auto& curThread : threads) {
+            curThread.join();
+        }
+
+        EXPECT_TRUE(task.isCompleted());
+    }
+    ParallaxGenTask::setProgressFD(-1);
+
+    // the task writes at least its last sample when it goes out of scope
+    rewind(progressFile);
+    string lastLine;
+    array<char, 4096> buffer {};
+    while (fgets(buffer.data(), static_cast<int>(buffer.size()), progressFile) != nullptr) {
+        lastLine = buffer.data();
+    }
+    fclose(progressFile);
+
+    ASSERT_FALSE(lastLine.empty());
+    const auto progress = nlohmann::json::parse(lastLine);
+    EXPECT_EQ(progress["task"], "Test Task");
+    EXPECT_EQ(progress["completed"], NUM_THREADS * JOBS_PER_THREAD);
+    EXPECT_EQ(progress["total"], NUM_THREADS * JOBS_PER_THREAD);
+    EXPECT_EQ(progress["percent"], 100);
+    EXPECT_EQ(progress["bytes"], NUM_THREADS * JOBS_PER_THREAD * 100);
+    EXPECT_EQ(progress["done"], true);
+    EXPECT_EQ(progress["results"]["FAILED"], NUM_THREADS * JOBS_PER_THREAD / 10);
+    EXPECT_EQ(progress["results"]["COMPLETED"], NUM_THREADS * JOBS_PER_THREAD * 9 / 10);
+
+    // tasks without jobs do not report
+    const ParallaxGenTask emptyTask("Empty Task", 0);
+    EXPECT_TRUE(emptyTask.isCompleted());
+}
+
+TEST(ParallaxGenTaskTests, DISABLED_CompleteJobBenchmark)
+{
+    constexpr size_t NUM_THREADS = 32;
+    constexpr size_t JOBS_PER_THREAD = 100000;
+
+    MutexTask mutexTask(NUM_THREADS * JOBS_PER_THREAD);
+    const double mutexTime = completeOnThreads(mutexTask, NUM_THREADS, JOBS_PER_THREAD);
+
+    ParallaxGenTask atomicTask("Benchmark", NUM_THREADS * JOBS_PER_THREAD);
+    const double atomicTime = completeOnThreads(atomicTask, NUM_THREADS, JOBS_PER_THREAD);
+
+    cout << NUM_THREADS << " threads completing " << JOBS_PER_THREAD << " no-op jobs each: mutex " << mutexTime
+         << " ms, sharded atomics " << atomicTime << " ms\n";
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,87 @@
+#include "BethesdaDirectory.hpp"
+#include "CommonTests.hpp"
+#include "ParallaxGenTextureCache.hpp"
+
+#include <DirectXTex.h>
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+using namespace std;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenTextureCacheTests, CacheTests)
+{
+    const filesystem::path cacheFile = PGTestEnvs::s_exePath / "output" / "cache" / "textures.json";
+    filesystem::remove(cacheFile);
+
+    const BethesdaDirectory::FileFingerprint fingerprint
+        = { .source = L"C:\\data\\textures\\test_m.dds", .size = 1024, .lastWriteTime = 12345 };
+    const BethesdaDirectory::FileFingerprint changedFingerprint
+        = { .source = L"C:\\data\\textures\\test_m.dds", .size = 1024, .lastWriteTime = 54321 };
+
+    DirectX::TexMetadata meta {};
+    meta.width = 512;
+    meta.height = 256;
+    meta.depth = 1;
+    meta.arraySize = 1;
+    meta.mipLevels = 10;
+    meta.format = DXGI_FORMAT_BC3_UNORM;
+    meta.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+
+    {
+        ParallaxGenTextureCache cache(cacheFile);
+        EXPECT_FALSE(cache.load());
+
+        ParallaxGenTextureCache::Entry entry;
+        EXPECT_FALSE(cache.lookup(L"textures\\test_m.dds", fingerprint, entry));
+
+        cache.updateMetadata(L"textures\\test_m.dds", fingerprint, meta);
+        cache.updateCM(L"Textures\\Test_m.dds", fingerprint, true, true, false, true);
+        cache.updateCM(L"textures\\removed_m.dds", fingerprint, false, false, false, false);
+        EXPECT_TRUE(cache.save());
+    }
+
+    {
+        ParallaxGenTextureCache cache(cacheFile);
+        EXPECT_TRUE(cache.load());
+
+        // entries round trip, path lookup ignores case
+        ParallaxGenTextureCache::Entry entry;
+        EXPECT_TRUE(cache.lookup(L"TEXTURES\\TEST_M.DDS", fingerprint, entry));
+        EXPECT_TRUE(entry.hasMetadata);
+        EXPECT_EQ(entry.metadata.width, 512);
+        EXPECT_EQ(entry.metadata.height, 256);
+        EXPECT_EQ(entry.metadata.mipLevels, 10);
+        EXPECT_EQ(entry.metadata.format, DXGI_FORMAT_BC3_UNORM);
+        EXPECT_EQ(entry.metadata.dimension, DirectX::TEX_DIMENSION_TEXTURE2D);
+        EXPECT_TRUE(entry.cmChecked);
+        EXPECT_TRUE(entry.isCM);
+        EXPECT_TRUE(entry.hasEnvMask);
+        EXPECT_FALSE(entry.hasGlossiness);
+        EXPECT_TRUE(entry.hasMetalness);
+
+        // changed file invalidates the entry
+        EXPECT_FALSE(cache.lookup(L"textures\\test_m.dds", changedFingerprint, entry));
+        cache.updateCM(L"textures\\test_m.dds", changedFingerprint, false, false, false, false);
+        EXPECT_TRUE(cache.lookup(L"textures\\test_m.dds", changedFingerprint, entry));
+        EXPECT_FALSE(entry.hasMetadata);
+        EXPECT_FALSE(entry.isCM);
+
+        // removed_m.dds is not used this run
+        EXPECT_TRUE(cache.save());
+    }
+
+    {
+        ParallaxGenTextureCache cache(cacheFile);
+        EXPECT_TRUE(cache.load());
+
+        ParallaxGenTextureCache::Entry entry;
+        EXPECT_FALSE(cache.lookup(L"textures\\removed_m.dds", fingerprint, entry));
+        EXPECT_TRUE(cache.lookup(L"textures\\test_m.dds", changedFingerprint, entry));
+    }
+
+    filesystem::remove(cacheFile);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
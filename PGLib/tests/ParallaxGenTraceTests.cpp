@@ -0,0 +1,153 @@
+#include "ParallaxGenTrace.hpp"
+
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+void spinMicroseconds(const int& microseconds)
+{
+    const auto end = chrono::steady_clock::now() + chrono::microseconds(microseconds);
+    while (chrono::steady_clock::now() < end) {
+    }
+}
+
+// synthetic stand in for patching one mesh: spin loops instead of NIF work, with the span layout of processNIF (the
+// mesh, its file and a few patcher calls per shape)
+void patchSyntheticMesh(const filesystem::path& meshPath, const bool& withSpans)
+{
+    static constexpr int NUM_SHAPES = 5;
+    static constexpr int WORK_US = 20;
+
+    const auto patchShape = [] {
+        for (int patcher = 0; patcher < 4; patcher++) {
+            spinMicroseconds(1);
+        }
+    };
+
+    if (!withSpans) {
+        spinMicroseconds(WORK_US);
+        for (int shape = 0; shape < NUM_SHAPES; shape++) {
+            patchShape();
+        }
+        return;
+    }
+
+    const ParallaxGenTrace::Span meshSpan("processNIF", meshPath);
+    {
+        const ParallaxGenTrace::Span fileSpan("getFile", meshPath);
+        spinMicroseconds(WORK_US);
+    }
+    static const string patcherName = "Test Patcher";
+    for (int shape = 0; shape < NUM_SHAPES; shape++) {
+        const ParallaxGenTrace::Span shouldApplySpan("shouldApply", [] { return patcherName; });
+        const ParallaxGenTrace::Span applySpan("applyPatch", [] { return patcherName; });
+        patchShape();
+    }
+}
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(ParallaxGenTraceTests, SaveTests)
+{
+    const filesystem::path tracePath = filesystem::temp_directory_path() / "ParallaxGenTraceTests.json";
+
+    // spans started while disabled are never recorded
+    {
+        const ParallaxGenTrace::Span disabledSpan("disabledSpan");
+    }
+
+    // more spans than fit into one chunk on some threads, nested spans and details
+    ParallaxGenTrace::enable();
+    constexpr size_t NUM_THREADS = 4;
+    constexpr size_t SPANS_PER_THREAD = 5000;
+    vector<thread> threads;
+    for (size_t i = 0; i < NUM_THREADS; i++) {
+        threads.emplace_back([] {
+            const ParallaxGenTrace::Span outerSpan("outer", filesystem::path(L"meshes/test\\\"quoted\".nif"));
+            for (size_t span = 0; span < SPANS_PER_THREAD; span++) {
+                const ParallaxGenTrace::Span innerSpan("inner");
+            }
+        });
+    }
+    for (auto& curThread : threads) {
+        curThread.join();
+    }
+    ParallaxGenTrace::disable();
+
+    ParallaxGenTrace::save(tracePath);
+
+    ifstream traceFile(tracePath);
+    const auto trace = nlohmann::json::parse(traceFile);
+    traceFile.close();
+    filesystem::remove(tracePath);
+
+    unordered_map<string, size_t> numSpans;
+    unordered_map<int, nlohmann::json> outerSpans;
+    for (const auto& event : trace["traceEvents"]) {
+        if (event["ph"] != "X") {
+            continue;
+        }
+
+        numSpans[event["name"]]++;
+        if (event["name"] == "outer") {
+            EXPECT_EQ(event["args"]["detail"], "meshes/test\\\"quoted\".nif");
+            outerSpans[event["tid"]] = event;
+        }
+    }
+
+    EXPECT_EQ(numSpans["disabledSpan"], 0);
+    EXPECT_EQ(numSpans["outer"], NUM_THREADS);
+    EXPECT_EQ(numSpans["inner"], NUM_THREADS * SPANS_PER_THREAD);
+
+    // inner spans are inside the outer span of their thread
+    for (const auto& event : trace["traceEvents"]) {
+        if (event["ph"] == "X" && event["name"] == "inner") {
+            const auto& outer = outerSpans[event["tid"]];
+            EXPECT_GE(event["ts"].get<double>(), outer["ts"].get<double>());
+            EXPECT_LE(event["ts"].get<double>() + event["dur"].get<double>(),
+                outer["ts"].get<double>() + outer["dur"].get<double>() + 0.001);
+        }
+    }
+}
+
+TEST(ParallaxGenTraceTests, DISABLED_SyntheticOverheadBenchmark)
+{
+    // synthetic: measures span cost against spin loops of a fixed length, not against real processNIF work. Real meshes
+    // take longer per span, so the relative overhead of a real run is lower
+    constexpr size_t NUM_MESHES = 20000;
+    const filesystem::path meshPath = "meshes/architecture/whiterun/wrbuildings/wrhouse01.nif";
+
+    const auto runMeshes = [&meshPath](const bool& withSpans) -> double {
+        const auto start = chrono::steady_clock::now();
+        for (size_t mesh = 0; mesh < NUM_MESHES; mesh++) {
+            patchSyntheticMesh(meshPath, withSpans);
+        }
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    ParallaxGenTrace::disable();
+    const double withoutSpans = runMeshes(false);
+    const double disabledSpans = runMeshes(true);
+    ParallaxGenTrace::enable();
+    const double enabledSpans = runMeshes(true);
+    ParallaxGenTrace::disable();
+
+    cout << NUM_MESHES << " synthetic meshes: no spans " << withoutSpans << " ms, tracing off " << disabledSpans
+         << " ms (" << (disabledSpans / withoutSpans - 1.0) * 100.0 << "%), tracing on " << enabledSpans << " ms ("
+         << (enabledSpans / withoutSpans - 1.0) * 100.0 << "%)\n";
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
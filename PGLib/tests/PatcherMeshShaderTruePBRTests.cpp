@@ -0,0 +1,216 @@
+#include "CommonTests.hpp"
+#include "ParallaxGenD3D.hpp"
+#include "ParallaxGenDirectory.hpp"
+#include "patchers/PatcherMeshShaderTruePBR.hpp"
+#include "patchers/base/Patcher.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+using Rule = PatcherMeshShaderTruePBR::TruePBRRule;
+
+// NOLINTBEGIN(misc-non-private-member-variables-in-classes,cppcoreguidelines-non-private-member-variables-in-classes)
+class PatcherMeshShaderTruePBRTest : public ::testing::Test {
+protected:
+    // one config file per group of fields, loaded in this order
+    static inline const vector<filesystem::path> s_configs = { L"pbrnifpatcher\\matching.json",
+        L"pbrnifpatcher\\shape.json", L"pbrnifpatcher\\slots.json", L"pbrnifpatcher\\shader.json",
+        L"pbrnifpatcher\\glintfuzz.json", L"pbrnifpatcher\\defaults.json", L"pbrnifpatcher\\smoothangle.json" };
+
+    void SetUp() override
+    {
+        m_pgd = make_unique<ParallaxGenDirectory>(PGTestEnvs::s_exePath / "env" / "truepbr"); // no logging
+        m_pgd->populateFileMap(false);
+        m_pgd3d = make_unique<ParallaxGenD3D>(m_pgd.get(), PGTestEnvs::s_exePath / "output", PGTestEnvs::s_exePath);
+
+        Patcher::loadStatics(*m_pgd, *m_pgd3d);
+        PatcherMeshShaderTruePBR::loadStatics(s_configs);
+    }
+
+    std::unique_ptr<ParallaxGenDirectory> m_pgd;
+    std::unique_ptr<ParallaxGenD3D> m_pgd3d;
+};
+// NOLINTEND(misc-non-private-member-variables-in-classes,cppcoreguidelines-non-private-member-variables-in-classes)
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST_F(PatcherMeshShaderTruePBRTest, ConfigTests)
+{
+    const auto& rules = PatcherMeshShaderTruePBR::getTruePBRRules();
+
+    // the entry with a wrongly typed value is skipped, the entries around it are kept
+    ASSERT_EQ(rules.size(), 14);
+
+    // matching.json: match fields, filters, rename, slots and cubemap
+    const auto& normalRule = rules[0];
+    EXPECT_EQ(normalRule.json, L"pbrnifpatcher\\matching.json");
+    EXPECT_TRUE(normalRule.has(Rule::FIELD_MATCH_NORMAL));
+    EXPECT_FALSE(normalRule.has(Rule::FIELD_MATCH_DIFFUSE));
+    EXPECT_EQ(normalRule.matchNormal, L"\\architecture\\whiterun\\wrwoodplank01_n.dds");
+    EXPECT_EQ(normalRule.matchFieldBaseLength, wstring(L"\\architecture\\whiterun\\wrwoodplank01").length());
+    EXPECT_TRUE(normalRule.has(Rule::FIELD_RENAME));
+    EXPECT_EQ(normalRule.pbrSuffix, L"\\architecture\\whiterun\\wrwoodplankpbr");
+    EXPECT_TRUE(normalRule.flag(Rule::FIELD_PBR));
+
+    const auto& textureRule = rules[1];
+    EXPECT_TRUE(textureRule.has(Rule::FIELD_MATCH_DIFFUSE));
+    EXPECT_EQ(textureRule.matchDiffuse, L"\\clutter\\common\\rug01");
+    EXPECT_EQ(textureRule.pbrSuffix, L"\\clutter\\common\\rug01");
+    EXPECT_TRUE(textureRule.has(Rule::FIELD_PATH_CONTAINS));
+    EXPECT_EQ(textureRule.pathContains, L"clutter\\common");
+    EXPECT_TRUE(textureRule.has(Rule::FIELD_NIF_FILTER));
+    EXPECT_EQ(textureRule.nifFilter, L"meshes\\clutter\\common\\rug01.nif");
+    EXPECT_EQ(textureRule.slotFields, 0);
+
+    const auto& slotRule = rules[2];
+    EXPECT_EQ(slotRule.matchDiffuse, L"\\clutter\\common\\rug02");
+    EXPECT_FALSE(slotRule.has(Rule::FIELD_PBR));
+    EXPECT_TRUE(slotRule.hasSlot(0));
+    EXPECT_EQ(slotRule.slots[0], L"textures\\clutter\\common\\rug02pbr.dds");
+    EXPECT_TRUE(slotRule.hasSlot(1));
+    EXPECT_EQ(slotRule.slots[1], L"textures\\clutter\\common\\rug02pbr_n.dds");
+    EXPECT_FALSE(slotRule.hasSlot(2));
+    EXPECT_TRUE(slotRule.has(Rule::FIELD_CUBEMAP));
+    EXPECT_EQ(slotRule.cubemap, L"cubemaps\\shinyglass_e.dds");
+
+    // shape.json: shape attributes
+    const auto& shapeRule = rules[3];
+    EXPECT_TRUE(shapeRule.flag(Rule::FIELD_PBR));
+    EXPECT_TRUE(shapeRule.has(Rule::FIELD_DELETE));
+    EXPECT_FALSE(shapeRule.flag(Rule::FIELD_DELETE));
+    EXPECT_TRUE(shapeRule.flag(Rule::FIELD_ENV_MAPPING));
+    EXPECT_TRUE(shapeRule.has(Rule::FIELD_VERTEX_COLORS));
+    EXPECT_FALSE(shapeRule.flag(Rule::FIELD_VERTEX_COLORS));
+    EXPECT_FLOAT_EQ(shapeRule.smoothAngle, 75.5F);
+    EXPECT_FLOAT_EQ(shapeRule.autoUV, 2.0F);
+    EXPECT_FLOAT_EQ(shapeRule.specularLevel, 0.04F);
+    EXPECT_TRUE(shapeRule.has(Rule::FIELD_SUBSURFACE_COLOR));
+    EXPECT_EQ(shapeRule.subsurfaceColor, (array<float, 3> { 0.5F, 0.25F, 0.125F }));
+    EXPECT_FLOAT_EQ(shapeRule.roughnessScale, 1.5F);
+    EXPECT_FLOAT_EQ(shapeRule.subsurfaceOpacity, 0.75F);
+    EXPECT_FLOAT_EQ(shapeRule.displacementScale, 0.5F);
+    EXPECT_FLOAT_EQ(shapeRule.envMapScale, 3.0F);
+    EXPECT_FLOAT_EQ(shapeRule.envMapScaleMult, 0.5F);
+    EXPECT_FLOAT_EQ(shapeRule.emissiveScale, 2.5F);
+    EXPECT_TRUE(shapeRule.has(Rule::FIELD_EMISSIVE_COLOR));
+    EXPECT_EQ(shapeRule.emissiveColor, (array<float, 4> { 1.0F, 0.5F, 0.25F, 0.75F }));
+    EXPECT_FLOAT_EQ(shapeRule.uvScale, 4.0F);
+
+    // slots.json: slot attributes, present false values are kept apart from missing ones
+    const auto& slotFlagsRule = rules[4];
+    EXPECT_TRUE(slotFlagsRule.flag(Rule::FIELD_LOCK_DIFFUSE));
+    EXPECT_TRUE(slotFlagsRule.has(Rule::FIELD_LOCK_NORMAL));
+    EXPECT_FALSE(slotFlagsRule.flag(Rule::FIELD_LOCK_NORMAL));
+    EXPECT_TRUE(slotFlagsRule.flag(Rule::FIELD_EMISSIVE));
+    EXPECT_TRUE(slotFlagsRule.flag(Rule::FIELD_LOCK_EMISSIVE));
+    EXPECT_TRUE(slotFlagsRule.flag(Rule::FIELD_PARALLAX));
+    EXPECT_TRUE(slotFlagsRule.has(Rule::FIELD_LOCK_PARALLAX));
+    EXPECT_FALSE(slotFlagsRule.flag(Rule::FIELD_LOCK_PARALLAX));
+    EXPECT_TRUE(slotFlagsRule.flag(Rule::FIELD_LOCK_CUBEMAP));
+    EXPECT_TRUE(slotFlagsRule.flag(Rule::FIELD_LOCK_RMAOS));
+    EXPECT_TRUE(slotFlagsRule.has(Rule::FIELD_LOCK_CNR));
+    EXPECT_FALSE(slotFlagsRule.flag(Rule::FIELD_LOCK_CNR));
+    EXPECT_TRUE(slotFlagsRule.flag(Rule::FIELD_LOCK_SUBSURFACE));
+    EXPECT_FALSE(slotFlagsRule.has(Rule::FIELD_PBR));
+
+    // shader.json: shader attributes
+    const auto& shaderRule = rules[5];
+    EXPECT_TRUE(shaderRule.flag(Rule::FIELD_SUBSURFACE_FOLIAGE));
+    EXPECT_TRUE(shaderRule.has(Rule::FIELD_SUBSURFACE));
+    EXPECT_FALSE(shaderRule.flag(Rule::FIELD_SUBSURFACE));
+    EXPECT_TRUE(shaderRule.flag(Rule::FIELD_HAIR));
+    EXPECT_TRUE(shaderRule.flag(Rule::FIELD_MULTILAYER));
+    EXPECT_EQ(shaderRule.coatColor, (array<float, 3> { 0.25F, 0.5F, 1.0F }));
+    EXPECT_FLOAT_EQ(shaderRule.coatSpecularLevel, 0.02F);
+    EXPECT_FLOAT_EQ(shaderRule.coatRoughness, 0.3F);
+    EXPECT_FLOAT_EQ(shaderRule.coatStrength, 0.9F);
+    EXPECT_TRUE(shaderRule.flag(Rule::FIELD_COAT_DIFFUSE));
+    EXPECT_TRUE(shaderRule.has(Rule::FIELD_COAT_PARALLAX));
+    EXPECT_FALSE(shaderRule.flag(Rule::FIELD_COAT_PARALLAX));
+    EXPECT_TRUE(shaderRule.flag(Rule::FIELD_COAT_NORMAL));
+    EXPECT_FLOAT_EQ(shaderRule.innerUVScale, 1.25F);
+
+    // glintfuzz.json: nested glint and fuzz objects
+    const auto& glintFuzzRule = rules[6];
+    EXPECT_TRUE(glintFuzzRule.has(Rule::FIELD_GLINT));
+    EXPECT_FLOAT_EQ(glintFuzzRule.glintScreenSpaceScale, 1.5F);
+    EXPECT_FLOAT_EQ(glintFuzzRule.glintLogMicrofacetDensity, 18.0F);
+    EXPECT_FLOAT_EQ(glintFuzzRule.glintMicrofacetDensity, 40.0F);
+    EXPECT_FLOAT_EQ(glintFuzzRule.glintMicrofacetRoughness, 0.015F);
+    EXPECT_FLOAT_EQ(glintFuzzRule.glintDensityRandomization, 2.0F);
+    EXPECT_TRUE(glintFuzzRule.has(Rule::FIELD_FUZZ));
+    EXPECT_EQ(glintFuzzRule.fuzzColor, (array<float, 3> { 0.1F, 0.2F, 0.3F }));
+    EXPECT_FLOAT_EQ(glintFuzzRule.fuzzWeight, 0.6F);
+    EXPECT_TRUE(glintFuzzRule.flag(Rule::FIELD_FUZZ_TEXTURE));
+
+    // empty glint and fuzz objects enable the feature with default values
+    const auto& emptyGlintFuzzRule = rules[7];
+    EXPECT_TRUE(emptyGlintFuzzRule.has(Rule::FIELD_GLINT));
+    EXPECT_FALSE(emptyGlintFuzzRule.has(Rule::FIELD_GLINT_SCREEN_SPACE_SCALE));
+    EXPECT_TRUE(emptyGlintFuzzRule.has(Rule::FIELD_FUZZ));
+    EXPECT_FALSE(emptyGlintFuzzRule.has(Rule::FIELD_FUZZ_COLOR));
+    EXPECT_FALSE(emptyGlintFuzzRule.has(Rule::FIELD_FUZZ_WEIGHT));
+    EXPECT_FLOAT_EQ(emptyGlintFuzzRule.fuzzWeight, 1.0F);
+
+    // defaults.json: only the match field is present, everything else keeps its default
+    const auto& minimalRule = rules[8];
+    EXPECT_EQ(minimalRule.fields, Rule::FIELD_MATCH_DIFFUSE);
+    EXPECT_EQ(minimalRule.flags, 0);
+    EXPECT_EQ(minimalRule.slotFields, 0);
+    EXPECT_EQ(minimalRule.pbrSuffix, L"\\defaults\\minimal");
+    EXPECT_TRUE(minimalRule.pathContains.empty());
+    EXPECT_TRUE(minimalRule.nifFilter.empty());
+    EXPECT_FLOAT_EQ(minimalRule.smoothAngle, 0.0F);
+    EXPECT_FLOAT_EQ(minimalRule.fuzzWeight, 1.0F);
+    EXPECT_EQ(minimalRule.emissiveColor, (array<float, 4> {}));
+
+    // colors with too few components are ignored
+    const auto& shortColorsRule = rules[9];
+    EXPECT_FALSE(shortColorsRule.has(Rule::FIELD_SUBSURFACE_COLOR));
+    EXPECT_FALSE(shortColorsRule.has(Rule::FIELD_EMISSIVE_COLOR));
+    EXPECT_FALSE(shortColorsRule.has(Rule::FIELD_COAT_COLOR));
+    EXPECT_EQ(shortColorsRule.subsurfaceColor, (array<float, 3> {}));
+
+    const auto& afterInvalidRule = rules[10];
+    EXPECT_EQ(afterInvalidRule.matchDiffuse, L"\\defaults\\afterinvalid");
+    EXPECT_FLOAT_EQ(afterInvalidRule.smoothAngle, 30.0F);
+
+    // the JSON form holds the values that were read
+    const auto shapeJSON = shapeRule.getJSON();
+    EXPECT_FLOAT_EQ(shapeJSON["smooth_angle"].get<float>(), 75.5F);
+    EXPECT_EQ(shapeJSON["delete"], false);
+    EXPECT_FALSE(shapeJSON.contains("lock_diffuse"));
+    EXPECT_FALSE(minimalRule.getJSON().contains("pbr"));
+}
+
+TEST_F(PatcherMeshShaderTruePBRTest, SmoothAngleTests)
+{
+    // smoothangle.json: rules 11 (30), 12 (60) and 13 (90, deleted)
+    const auto getSmoothAngle = [](const vector<size_t>& cfgs) {
+        PatcherMeshShaderTruePBR::TruePBRMatchData truePBRData;
+        for (const auto& cfg : cfgs) {
+            truePBRData[cfg] = L"";
+        }
+        return PatcherMeshShaderTruePBR::getSmoothAngle(truePBRData);
+    };
+
+    EXPECT_FALSE(getSmoothAngle({}).has_value());
+    EXPECT_FALSE(getSmoothAngle({ 8 }).has_value());
+    EXPECT_EQ(getSmoothAngle({ 11 }), 30.0F);
+
+    // the last rule in config order wins, rules without the attribute or deleted shapes do not count
+    EXPECT_EQ(getSmoothAngle({ 11, 12 }), 60.0F);
+    EXPECT_EQ(getSmoothAngle({ 12, 11 }), 60.0F);
+    EXPECT_EQ(getSmoothAngle({ 3, 11, 12, 13 }), 60.0F);
+    EXPECT_EQ(getSmoothAngle({ 3, 11 }), 30.0F);
+    EXPECT_EQ(getSmoothAngle({ 10, 3 }), 75.5F);
+    EXPECT_FALSE(getSmoothAngle({ 8, 13 }).has_value());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
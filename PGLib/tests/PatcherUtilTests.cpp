@@ -0,0 +1,232 @@
+#include "patchers/PatcherMeshGlobalParticleLightsToLP.hpp"
+#include "patchers/PatcherMeshPreFixMeshLighting.hpp"
+#include "patchers/PatcherMeshPreFixTextureSlotCount.hpp"
+#include "patchers/PatcherMeshShaderComplexMaterial.hpp"
+#include "patchers/PatcherMeshShaderDefault.hpp"
+#include "patchers/PatcherMeshShaderTransformParallaxToCM.hpp"
+#include "patchers/PatcherMeshShaderTruePBR.hpp"
+#include "patchers/PatcherMeshShaderVanillaParallax.hpp"
+#include "patchers/base/PatcherUtil.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#ifdef _DEBUG
+#include <crtdbg.h>
+#endif
+
+using namespace std;
+
+#ifdef _DEBUG
+namespace {
+/**
+ * @class AllocationCounter
+ * @brief Counts debug CRT heap allocations while alive. PGLib links the same CRT, so allocations inside the DLL count
+ */
+class AllocationCounter {
+private:
+    static inline atomic<size_t> s_numAllocations = 0;
+    _CRT_ALLOC_HOOK m_prevHook;
+
+public:
+    AllocationCounter()
+    {
+        s_numAllocations = 0;
+        m_prevHook = _CrtSetAllocHook(countAllocation);
+    }
+
+    ~AllocationCounter() { _CrtSetAllocHook(m_prevHook); }
+
+    AllocationCounter(const AllocationCounter& other) = delete;
+    auto operator=(const AllocationCounter& other) -> AllocationCounter& = delete;
+    AllocationCounter(AllocationCounter&& other) noexcept = delete;
+    auto operator=(AllocationCounter&& other) noexcept -> AllocationCounter& = delete;
+
+    [[nodiscard]] static auto getNumAllocations() -> size_t { return s_numAllocations; }
+
+private:
+    static auto __cdecl countAllocation(int allocType, [[maybe_unused]] void* userData, [[maybe_unused]] size_t size,
+        [[maybe_unused]] int blockType, [[maybe_unused]] long requestNumber,
+        [[maybe_unused]] const unsigned char* filename, [[maybe_unused]] int lineNumber) -> int
+    {
+        if (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC) {
+            s_numAllocations++;
+        }
+
+        return TRUE;
+    }
+};
+} // namespace
+#endif
+
+namespace {
+auto getTestPatcherSet() -> PatcherUtil::PatcherMeshSet
+{
+    PatcherUtil::PatcherMeshSet meshPatchers;
+    meshPatchers.prePatchers.emplace_back(PatcherMeshPreFixMeshLighting::getFactory());
+    meshPatchers.prePatchers.emplace_back(PatcherMeshPreFixTextureSlotCount::getFactory());
+    meshPatchers.shaderPatchers.emplace(
+        PatcherMeshShaderDefault::getShaderType(), PatcherMeshShaderDefault::getFactory());
+    meshPatchers.shaderPatchers.emplace(
+        PatcherMeshShaderVanillaParallax::getShaderType(), PatcherMeshShaderVanillaParallax::getFactory());
+    meshPatchers.shaderPatchers.emplace(
+        PatcherMeshShaderComplexMaterial::getShaderType(), PatcherMeshShaderComplexMaterial::getFactory());
+    meshPatchers.shaderPatchers.emplace(
+        PatcherMeshShaderTruePBR::getShaderType(), PatcherMeshShaderTruePBR::getFactory());
+    meshPatchers.shaderTransformPatchers[PatcherMeshShaderTransformParallaxToCM::getFromShader()].emplace(
+        PatcherMeshShaderTransformParallaxToCM::getToShader(), PatcherMeshShaderTransformParallaxToCM::getFactory());
+    meshPatchers.globalPatchers.emplace_back(PatcherMeshGlobalParticleLightsToLP::getFactory());
+
+    return meshPatchers;
+}
+} // namespace
+
+TEST(PatcherUtilTests, ObjectPoolTests)
+{
+    PatcherUtil::PatcherMeshObjectPool pool;
+    pool.loadFactories(getTestPatcherSet());
+
+    {
+        const auto handle = pool.acquire(L"meshes\\test1.nif", nullptr);
+        EXPECT_EQ(handle->prePatchers.size(), 2);
+        EXPECT_EQ(handle->shaderPatchers.size(), 4);
+        EXPECT_EQ(handle->shaderTransformPatchers.size(), 1);
+        EXPECT_EQ(handle->globalPatchers.size(), 1);
+    }
+    EXPECT_EQ(pool.getNumCreated(), 1);
+
+    // released sets are reused
+    {
+        const auto handle = pool.acquire(L"meshes\\test2.nif", nullptr);
+        EXPECT_TRUE(handle->patchedTextureSets.empty());
+    }
+    EXPECT_EQ(pool.getNumCreated(), 1);
+
+    // nested acquire (duplicate NIFs) needs a second set
+    {
+        const auto outerHandle = pool.acquire(L"meshes\\test3.nif", nullptr);
+        const auto innerHandle = pool.acquire(L"meshes\\pg1\\test3.nif", nullptr);
+        EXPECT_NE(&*outerHandle, &*innerHandle);
+    }
+    EXPECT_EQ(pool.getNumCreated(), 2);
+
+    // new factories drop the pooled sets
+    pool.loadFactories(PatcherUtil::PatcherMeshSet());
+    {
+        const auto handle = pool.acquire(L"meshes\\test4.nif", nullptr);
+        EXPECT_TRUE(handle->shaderPatchers.empty());
+    }
+    EXPECT_EQ(pool.getNumCreated(), 1);
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+TEST(PatcherUtilTests, ModSetTests)
+{
+    PatcherUtil::ModSet modSet;
+    EXPECT_FALSE(modSet.contains(0));
+    EXPECT_FALSE(modSet.contains(1000));
+
+    modSet.insert(3);
+    modSet.insert(64);
+    modSet.insert(200);
+    modSet.insert(3);
+    EXPECT_TRUE(modSet.contains(3));
+    EXPECT_TRUE(modSet.contains(64));
+    EXPECT_FALSE(modSet.contains(63));
+
+    vector<uint32_t> modIDs;
+    modSet.forEach([&](const uint32_t& modID) { modIDs.push_back(modID); });
+    EXPECT_EQ(modIDs, vector<uint32_t>({ 3, 64, 200 }));
+}
+
+TEST(PatcherUtilTests, WinningMatchTests)
+{
+    vector<PatcherUtil::ShaderPatcherMatch> matches(3);
+    matches[0].modID = 1;
+    matches[0].shader = NIFUtil::ShapeShader::VANILLAPARALLAX;
+    matches[1].modID = 2;
+    matches[1].shader = NIFUtil::ShapeShader::COMPLEXMATERIAL;
+    matches[2].modID = 3;
+    matches[2].shader = NIFUtil::ShapeShader::TRUEPBR;
+
+    // highest rank wins, mods without a rank lose to ranked mods
+    EXPECT_EQ(PatcherUtil::getWinningMatch(matches, { -1, 5, 7 }).modID, 2);
+    EXPECT_EQ(PatcherUtil::getWinningMatch(matches, { -1, 5, 7, 1 }).modID, 2);
+    // equal ranks keep the last match
+    EXPECT_EQ(PatcherUtil::getWinningMatch(matches).modID, 3);
+    EXPECT_EQ(PatcherUtil::getWinningMatch({}).shader, NIFUtil::ShapeShader::UNKNOWN);
+}
+
+TEST(PatcherUtilTests, ConflictModResultsTests)
+{
+    PatcherUtil::ConflictModResults conflictMods;
+
+    vector<PatcherUtil::ShaderPatcherMatch> matches(2);
+    matches[0].modID = 1;
+    matches[0].shader = NIFUtil::ShapeShader::VANILLAPARALLAX;
+    matches[1].modID = 1;
+    matches[1].shader = NIFUtil::ShapeShader::COMPLEXMATERIAL;
+
+    // matches from a single mod are not a conflict
+    conflictMods.addMatches(matches);
+    EXPECT_TRUE(conflictMods.mods.empty());
+
+    matches[1].modID = 4;
+    conflictMods.addMatches(matches);
+    ASSERT_EQ(conflictMods.mods.size(), 5);
+    EXPECT_EQ(conflictMods.mods[0].shaders, 0);
+    EXPECT_EQ(conflictMods.mods[1].shaders, 1U << static_cast<uint32_t>(NIFUtil::ShapeShader::VANILLAPARALLAX));
+    EXPECT_EQ(conflictMods.mods[4].shaders, 1U << static_cast<uint32_t>(NIFUtil::ShapeShader::COMPLEXMATERIAL));
+    EXPECT_TRUE(conflictMods.mods[1].mods.contains(1));
+    EXPECT_TRUE(conflictMods.mods[1].mods.contains(4));
+    EXPECT_TRUE(conflictMods.mods[4].mods.contains(1));
+    EXPECT_FALSE(conflictMods.mods[4].mods.contains(2));
+}
+
+TEST(PatcherUtilTests, DISABLED_ObjectPoolAllocationBenchmark)
+{
+#ifndef _DEBUG
+    GTEST_SKIP() << "Counting allocations needs the debug CRT (_CrtSetAllocHook), run a Debug build";
+#else
+    constexpr size_t NUM_NIFS = 10000;
+
+    const auto meshPatchers = getTestPatcherSet();
+    const filesystem::path nifPath = L"meshes\\architecture\\whiterun\\wrtempleofkynareth01.nif";
+
+    // one set constructed from the factories per NIF
+    size_t perNIFAllocations = 0;
+    {
+        const AllocationCounter counter;
+        for (size_t i = 0; i < NUM_NIFS; i++) {
+            auto set = PatcherUtil::PatcherMeshObjectPool::createSet(meshPatchers, nifPath, nullptr);
+            set->bind(nifPath, nullptr);
+        }
+        perNIFAllocations = AllocationCounter::getNumAllocations();
+    }
+
+    // sets reused from the pool
+    PatcherUtil::PatcherMeshObjectPool pool;
+    pool.loadFactories(meshPatchers);
+    size_t pooledAllocations = 0;
+    {
+        const AllocationCounter counter;
+        for (size_t i = 0; i < NUM_NIFS; i++) {
+            const auto handle = pool.acquire(nifPath, nullptr);
+        }
+        pooledAllocations = AllocationCounter::getNumAllocations();
+    }
+
+    EXPECT_EQ(pool.getNumCreated(), 1);
+    EXPECT_LT(pooledAllocations, perNIFAllocations);
+    cout << "Patcher set allocations per NIF: constructed " << static_cast<double>(perNIFAllocations) / NUM_NIFS
+         << ", pooled " << static_cast<double>(pooledAllocations) / NUM_NIFS << " (" << pool.getNumCreated()
+         << " sets created)\n";
+#endif
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
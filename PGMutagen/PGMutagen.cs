@@ -48,9 +48,12 @@ public static class ExceptionHandler
 
 public static class MessageHandler
 {
+    // Messages logged before a callback is registered
     private static Queue<Tuple<string, int>> LogQueue = [];
 
-    public static void Log(string message, int level = 0)
+    private static unsafe delegate* unmanaged[Cdecl]<int, char*, int, void> LogCallback = null;
+
+    public static unsafe void Log(string message, int level = 0)
     {
         // Level values
         // 0: Trace
@@ -59,21 +62,47 @@ public static class MessageHandler
         // 3: Warning
         // 4: Error
         // 5: Critical
-        LogQueue.Enqueue(new Tuple<string, int>(message, level));
+        if (LogCallback == null)
+        {
+            LogQueue.Enqueue(new Tuple<string, int>(message, level));
+            return;
+        }
+
+        // The callback copies the message before returning, so no unmanaged allocation is needed
+        fixed (char* messagePtr = message)
+        {
+            LogCallback(level, messagePtr, message.Length);
+        }
     }
 
-    [UnmanagedCallersOnly(EntryPoint = "GetLogMessage", CallConvs = [typeof(CallConvCdecl)])]
-    public static unsafe void GetLogMessage([DNNE.C99Type("wchar_t**")] IntPtr* messagePtr, [DNNE.C99Type("int*")] int* level)
+    [UnmanagedCallersOnly(EntryPoint = "SetLogCallback", CallConvs = [typeof(CallConvCdecl)])]
+    [DNNE.C99DeclCode("typedef void (*PGLogCallback)(int level, const wchar_t* message, int length);")]
+    public static unsafe void SetLogCallback([DNNE.C99Type("PGLogCallback")] delegate* unmanaged[Cdecl]<int, char*, int, void> callback)
     {
-        if (LogQueue.Count == 0)
+        LogCallback = callback;
+
+        while (callback != null && LogQueue.Count > 0)
         {
-            return;
+            var logMessage = LogQueue.Dequeue();
+            Log(logMessage.Item1, logMessage.Item2);
         }
+    }
 
-        var logMessage = LogQueue.Dequeue();
-        string message = logMessage.Item1;
-        *messagePtr = Marshal.StringToHGlobalUni(logMessage.Item1);
-        *level = logMessage.Item2;
+    [UnmanagedCallersOnly(EntryPoint = "LogTestMessages", CallConvs = [typeof(CallConvCdecl)])]
+    public static void LogTestMessages([DNNE.C99Type("const int")] int numMessages, [DNNE.C99Type("const int")] int level)
+    {
+        // Messages take the same path as library messages, used to measure the native log channel
+        try
+        {
+            for (int i = 0; i < numMessages; i++)
+            {
+                Log("[LogTestMessages] Message " + i, level);
+            }
+        }
+        catch (Exception ex)
+        {
+            ExceptionHandler.SetLastException(ex);
+        }
     }
 }
 
@@ -847,6 +876,61 @@ public class PGMutagen
         }
     }
 
+    [UnmanagedCallersOnly(EntryPoint = "GetTXSTRefs", CallConvs = [typeof(CallConvCdecl)])]
+    public static unsafe void GetTXSTRefs(
+      [DNNE.C99Type("int*")] int* TXSTHandles,
+      [DNNE.C99Type("int*")] int* AltTexHandles,
+      [DNNE.C99Type("int*")] int* ModelRecHandles,
+      [DNNE.C99Type("int*")] int* Index3Ds,
+      [DNNE.C99Type("wchar_t**")] IntPtr* NIFNames,
+      [DNNE.C99Type("char**")] IntPtr* MatchTypes,
+      [DNNE.C99Type("int*")] int* length)
+    {
+        try
+        {
+            if (TXSTRefs is null)
+            {
+                throw new Exception("PopulateObjs must be called before GetTXSTRefs");
+            }
+
+            if (length is not null)
+            {
+                *length = TXSTRefs.Values.Sum(x => x.Count);
+                MessageHandler.Log("[GetTXSTRefs] Found " + *length + " TXST References", 0);
+            }
+
+            if (TXSTHandles is null || AltTexHandles is null || ModelRecHandles is null || Index3Ds is null || NIFNames is null || MatchTypes is null)
+            {
+                return;
+            }
+
+            // Copy every reference, references of the same key keep their order
+            int i = 0;
+            foreach (var (key, value) in TXSTRefs)
+            {
+                foreach (var txst in value)
+                {
+                    var altTexRef = AltTexRefs[txst.Item2];
+                    TXSTHandles[i] = txst.Item1;
+                    AltTexHandles[i] = txst.Item2;
+                    ModelRecHandles[i] = altTexRef.Item3;
+                    Index3Ds[i] = key.Item2;
+                    NIFNames[i] = key.Item1.IsNullOrEmpty() ? IntPtr.Zero : Marshal.StringToHGlobalUni(key.Item1);
+                    MatchTypes[i] = altTexRef.Item4.IsNullOrEmpty() ? IntPtr.Zero : Marshal.StringToHGlobalAnsi(altTexRef.Item4);
+                    i++;
+                }
+            }
+        }
+        catch (Exception ex)
+        {
+            ExceptionHandler.SetLastException(ex);
+            if (length is not null)
+            {
+                *length = 0;
+            }
+        }
+    }
+
     [UnmanagedCallersOnly(EntryPoint = "GetTXSTSlots", CallConvs = [typeof(CallConvCdecl)])]
     public static unsafe void GetTXSTSlots(
       [DNNE.C99Type("const int")] int txstIndex,
@@ -4,11 +4,16 @@
 #include "PGDiag.hpp"
 #include "ParallaxGen.hpp"
 #include "ParallaxGenConfig.hpp"
+#include "ParallaxGenContentCache.hpp"
 #include "ParallaxGenD3D.hpp"
 #include "ParallaxGenDirectory.hpp"
 #include "ParallaxGenHandlers.hpp"
+#include "ParallaxGenPipeline.hpp"
 #include "ParallaxGenPlugin.hpp"
 #include "ParallaxGenRunner.hpp"
+#include "ParallaxGenTask.hpp"
+#include "ParallaxGenTrace.hpp"
+#include "ParallaxGenTextureCache.hpp"
 #include "ParallaxGenUI.hpp"
 #include "ParallaxGenUtil.hpp"
 #include "ParallaxGenWarnings.hpp"
@@ -34,14 +39,18 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
+#include <io.h>
 #include <windows.h>
 
+#include <charconv>
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <filesystem>
 #include <iostream>
 #include <string>
+#include <system_error>
 #include <unordered_map>
 
 constexpr unsigned MAX_LOG_SIZE = 5242880;
@@ -52,9 +61,31 @@ struct ParallaxGenCLIArgs {
     int verbosity = 0;
     bool autostart = false;
     bool fullDump = false;
+    int progressFD = -1;
+    string tracePath;
 };
 
 namespace {
+// File the timeline is saved to on exit, empty if --trace is not set
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+filesystem::path s_tracePath;
+
+/**
+ * @brief Save the timeline if --trace is set, runs on every exit including failed and aborted runs
+ */
+void saveTrace()
+{
+    if (s_tracePath.empty()) {
+        return;
+    }
+
+    try {
+        ParallaxGenTrace::save(s_tracePath);
+    } catch (const exception& e) {
+        cerr << "Failed to save trace: " << e.what() << "\n";
+    }
+}
+
 auto deployAssets(const filesystem::path& outputDir, const filesystem::path& exePath) -> void
 {
     // Install default cubemap file
@@ -139,10 +170,13 @@ void mainRunner(ParallaxGenCLIArgs& args, const filesystem::path& exePath)
 
     auto mmd = ModManagerDirectory(params.ModManager.type);
     auto pgd = ParallaxGenDirectory(&bg, params.Output.dir, &mmd);
+    ParallaxGenTextureCache textureCache(exePath / "cache" / "textures.json");
+    ParallaxGenContentCache cmCache(exePath / "cache" / "cm", L".dds", ParallaxGenContentCache::DEFAULT_MAX_SIZE);
     auto pgd3d = ParallaxGenD3D(&pgd, params.Output.dir, exePath);
     auto pg = ParallaxGen(params.Output.dir, &pgd, &pgd3d, params.PostPatcher.optimizeMeshes);
 
     Patcher::loadStatics(pgd, pgd3d);
+    PatcherMeshShaderTransformParallaxToCM::loadCMCache(&cmCache);
 
     // Check if GPU needs to be initialized
     Logger::info("Initializing GPU");
@@ -187,25 +221,7 @@ void mainRunner(ParallaxGenCLIArgs& args, const filesystem::path& exePath)
 
     PGDiag::insert("ActivePlugins", ParallaxGenUtil::utf16VectorToUTF8(activePlugins));
 
-    // Init PGP library
-    if (params.Processing.pluginPatching) {
-        Logger::info("Initializing plugin patching");
-        ParallaxGenPlugin::loadStatics(&pgd);
-        ParallaxGenPlugin::initialize(bg, exePath);
-        ParallaxGenPlugin::populateObjs();
-    }
-
-    // Populate file map from data directory
-    if (params.ModManager.type == ModManagerDirectory::ModManagerType::MODORGANIZER2
-        && !params.ModManager.mo2InstanceDir.empty() && !params.ModManager.mo2Profile.empty()) {
-        // MO2
-        mmd.populateModFileMapMO2(params.ModManager.mo2InstanceDir, params.ModManager.mo2Profile, params.Output.dir);
-    } else if (params.ModManager.type == ModManagerDirectory::ModManagerType::VORTEX) {
-        // Vortex
-        mmd.populateModFileMapVortex(bg.getGameDataPath());
-    }
-
-    // delete existing output
+    // delete existing output, exits on foreign files so it runs before any stage starts
     pg.deleteOutputDir();
 
     // Check if ParallaxGen output already exists in data directory
@@ -215,106 +231,169 @@ void mainRunner(ParallaxGenCLIArgs& args, const filesystem::path& exePath)
                          "re-running.");
     }
 
-    // Init file map
-    pgd.populateFileMap(params.Processing.bsa);
-
-    // Map files
-    pgd.mapFiles(params.MeshRules.blockList, params.MeshRules.allowList, params.TextureRules.textureMaps,
-        params.TextureRules.vanillaBSAList, params.Processing.mapFromMeshes, params.Processing.multithread,
-        params.Processing.highMem);
+    // Stages run as soon as the stages they read from are done, so plugin loading overlaps with file mapping and
+    // patcher setup overlaps with DDS header reading and complex material detection
+    ParallaxGenPipeline pipeline;
+    PatcherUtil::PatcherMeshSet meshPatchers;
+    unordered_map<wstring, int> modPriorityMap;
+
+    pipeline.addStage("plugins", {}, [&] {
+        // Init PGP library
+        if (params.Processing.pluginPatching) {
+            Logger::info("Initializing plugin patching");
+            ParallaxGenPlugin::loadStatics(&pgd);
+            ParallaxGenPlugin::initialize(bg, exePath);
+            ParallaxGenPlugin::populateObjs();
+        }
+    });
 
-    // Find CM maps
-    if (params.ShaderPatcher.complexMaterial) {
-        pgd3d.findCMMaps(params.TextureRules.vanillaBSAList);
-    }
+    pipeline.addStage("modFiles", {}, [&] {
+        // Populate file map from data directory
+        if (params.ModManager.type == ModManagerDirectory::ModManagerType::MODORGANIZER2
+            && !params.ModManager.mo2InstanceDir.empty() && !params.ModManager.mo2Profile.empty()) {
+            // MO2
+            mmd.populateModFileMapMO2(
+                params.ModManager.mo2InstanceDir, params.ModManager.mo2Profile, params.Output.dir);
+        } else if (params.ModManager.type == ModManagerDirectory::ModManagerType::VORTEX) {
+            // Vortex
+            mmd.populateModFileMapVortex(bg.getGameDataPath());
+        }
+    });
+
+    pipeline.addStage("fileMap", { "modFiles" }, [&] {
+        // Init file map
+        pgd.populateFileMap(params.Processing.bsa);
+    });
+
+    pipeline.addStage("textureMaps", { "fileMap" }, [&] {
+        // Map files
+        pgd.mapFiles(params.MeshRules.blockList, params.MeshRules.allowList, params.TextureRules.textureMaps,
+            params.TextureRules.vanillaBSAList, params.Processing.mapFromMeshes, params.Processing.multithread,
+            params.Processing.highMem);
+    });
+
+    pipeline.addStage("ddsHeaders", { "fileMap" }, [&] {
+        // Load texture analysis results from previous runs
+        textureCache.load();
+        pgd3d.loadTextureCache(&textureCache);
+
+        // Index DDS headers
+        pgd3d.buildDDSHeaderIndex(params.Processing.multithread);
+    });
+
+    pipeline.addStage("cmMaps", { "textureMaps", "ddsHeaders" }, [&] {
+        // Find CM maps
+        if (params.ShaderPatcher.complexMaterial) {
+            pgd3d.findCMMaps(params.TextureRules.vanillaBSAList);
+        }
+    });
 
-    // Create patcher factory
-    PatcherUtil::PatcherMeshSet meshPatchers;
-    if (params.PrePatcher.fixMeshLighting) {
-        Logger::debug("Adding Mesh Lighting Fix pre-patcher");
-        meshPatchers.prePatchers.emplace_back(PatcherMeshPreFixMeshLighting::getFactory());
-    }
-    if (params.ShaderPatcher.parallax || params.ShaderPatcher.complexMaterial || params.ShaderPatcher.truePBR) {
-        // fix slots only needed for shader patchers
-        meshPatchers.prePatchers.emplace_back(PatcherMeshPreFixTextureSlotCount::getFactory());
-    }
+    pipeline.addStage("patchers", { "textureMaps" }, [&] {
+        // Create patcher factory
+        if (params.PrePatcher.fixMeshLighting) {
+            Logger::debug("Adding Mesh Lighting Fix pre-patcher");
+            meshPatchers.prePatchers.emplace_back(PatcherMeshPreFixMeshLighting::getFactory());
+        }
+        if (params.ShaderPatcher.parallax || params.ShaderPatcher.complexMaterial || params.ShaderPatcher.truePBR) {
+            // fix slots only needed for shader patchers
+            meshPatchers.prePatchers.emplace_back(PatcherMeshPreFixTextureSlotCount::getFactory());
+        }
 
-    meshPatchers.shaderPatchers.emplace(
-        PatcherMeshShaderDefault::getShaderType(), PatcherMeshShaderDefault::getFactory());
-    if (params.ShaderPatcher.parallax) {
-        Logger::debug("Adding Parallax shader patcher");
-        meshPatchers.shaderPatchers.emplace(
-            PatcherMeshShaderVanillaParallax::getShaderType(), PatcherMeshShaderVanillaParallax::getFactory());
-    }
-    if (params.ShaderPatcher.complexMaterial) {
-        Logger::debug("Adding Complex Material shader patcher");
-        meshPatchers.shaderPatchers.emplace(
-            PatcherMeshShaderComplexMaterial::getShaderType(), PatcherMeshShaderComplexMaterial::getFactory());
-        PatcherMeshShaderComplexMaterial::loadStatics(
-            params.PrePatcher.disableMLP, params.ShaderPatcher.ShaderPatcherComplexMaterial.listsDyncubemapBlocklist);
-    }
-    if (params.ShaderPatcher.truePBR) {
-        Logger::debug("Adding True PBR shader patcher");
         meshPatchers.shaderPatchers.emplace(
-            PatcherMeshShaderTruePBR::getShaderType(), PatcherMeshShaderTruePBR::getFactory());
-        PatcherMeshShaderTruePBR::loadOptions(params.ShaderPatcher.ShaderPatcherTruePBR.checkPaths,
-            params.ShaderPatcher.ShaderPatcherTruePBR.printNonExistentPaths);
-        PatcherMeshShaderTruePBR::loadStatics(pgd.getPBRJSONs());
-    }
-    if (params.ShaderTransforms.parallaxToCM) {
-        Logger::debug("Adding Parallax to Complex Material shader transform patcher");
-        meshPatchers.shaderTransformPatchers[PatcherMeshShaderTransformParallaxToCM::getFromShader()].emplace(
-            PatcherMeshShaderTransformParallaxToCM::getToShader(),
-            PatcherMeshShaderTransformParallaxToCM::getFactory());
-    }
+            PatcherMeshShaderDefault::getShaderType(), PatcherMeshShaderDefault::getFactory());
+        if (params.ShaderPatcher.parallax) {
+            Logger::debug("Adding Parallax shader patcher");
+            meshPatchers.shaderPatchers.emplace(
+                PatcherMeshShaderVanillaParallax::getShaderType(), PatcherMeshShaderVanillaParallax::getFactory());
+        }
+        if (params.ShaderPatcher.complexMaterial) {
+            Logger::debug("Adding Complex Material shader patcher");
+            meshPatchers.shaderPatchers.emplace(
+                PatcherMeshShaderComplexMaterial::getShaderType(), PatcherMeshShaderComplexMaterial::getFactory());
+            PatcherMeshShaderComplexMaterial::loadStatics(params.PrePatcher.disableMLP,
+                params.ShaderPatcher.ShaderPatcherComplexMaterial.listsDyncubemapBlocklist);
+        }
+        if (params.ShaderPatcher.truePBR) {
+            Logger::debug("Adding True PBR shader patcher");
+            meshPatchers.shaderPatchers.emplace(
+                PatcherMeshShaderTruePBR::getShaderType(), PatcherMeshShaderTruePBR::getFactory());
+            PatcherMeshShaderTruePBR::loadOptions(params.ShaderPatcher.ShaderPatcherTruePBR.checkPaths,
+                params.ShaderPatcher.ShaderPatcherTruePBR.printNonExistentPaths);
+            PatcherMeshShaderTruePBR::loadStatics(pgd.getPBRJSONs());
+        }
+        if (params.ShaderTransforms.parallaxToCM) {
+            Logger::debug("Adding Parallax to Complex Material shader transform patcher");
+            meshPatchers.shaderTransformPatchers[PatcherMeshShaderTransformParallaxToCM::getFromShader()].emplace(
+                PatcherMeshShaderTransformParallaxToCM::getToShader(),
+                PatcherMeshShaderTransformParallaxToCM::getFactory());
+        }
 
-    const PatcherUtil::PatcherTextureSet texPatchers;
-    pg.loadPatchers(meshPatchers, texPatchers);
+        const PatcherUtil::PatcherTextureSet texPatchers;
+        pg.loadPatchers(meshPatchers, texPatchers);
+    });
+
+    // conflicts need complex material maps and plugin matches, the mod order dialog has to run on the main thread
+    pipeline.addStage(
+        "modOrder", { "plugins", "cmMaps", "patchers" },
+        [&] {
+            if (params.ModManager.type != ModManagerDirectory::ModManagerType::NONE) {
+                // Check if MO2 is used and MO2 use order is checked
+                if (params.ModManager.type == ModManagerDirectory::ModManagerType::MODORGANIZER2
+                    && params.ModManager.mo2UseOrder) {
+                    // Get mod order from MO2
+                    const auto& modOrder = mmd.getInferredOrder();
+                    pgc.setModOrder(modOrder);
+                } else {
+                    // Find conflicts
+                    const auto modConflicts
+                        = pg.findModConflicts(params.Processing.multithread, params.Processing.pluginPatching);
+                    const auto existingOrder = pgc.getModOrder();
+
+                    if (!modConflicts.empty()) {
+                        // pause timer for UI
+                        const auto pauseTime = chrono::high_resolution_clock::now();
+                        timeTaken += chrono::duration_cast<chrono::seconds>(pauseTime - startTime).count();
+
+                        // Select mod order
+                        Logger::info("Mod conflicts found. Showing mod order dialog.");
+                        auto selectedOrder = ParallaxGenUI::selectModOrder(modConflicts, existingOrder);
+                        startTime = chrono::high_resolution_clock::now();
+
+                        pgc.setModOrder(selectedOrder);
+                    }
+                }
 
-    if (params.ModManager.type != ModManagerDirectory::ModManagerType::NONE) {
-        // Check if MO2 is used and MO2 use order is checked
-        if (params.ModManager.type == ModManagerDirectory::ModManagerType::MODORGANIZER2
-            && params.ModManager.mo2UseOrder) {
-            // Get mod order from MO2
-            const auto& modOrder = mmd.getInferredOrder();
-            pgc.setModOrder(modOrder);
-        } else {
-            // Find conflicts
-            const auto modConflicts
-                = pg.findModConflicts(params.Processing.multithread, params.Processing.pluginPatching);
-            const auto existingOrder = pgc.getModOrder();
-
-            if (!modConflicts.empty()) {
-                // pause timer for UI
-                timeTaken
-                    += chrono::duration_cast<chrono::seconds>(chrono::high_resolution_clock::now() - startTime).count();
-
-                // Select mod order
-                Logger::info("Mod conflicts found. Showing mod order dialog.");
-                auto selectedOrder = ParallaxGenUI::selectModOrder(modConflicts, existingOrder);
-                startTime = chrono::high_resolution_clock::now();
-
-                pgc.setModOrder(selectedOrder);
+                pgc.saveUserConfig();
             }
+        },
+        true);
+
+    pipeline.addStage("meshes", { "modOrder" }, [&] {
+        // Patch meshes if set
+        modPriorityMap = pgc.getModPriorityMap();
+        pg.loadModPriorityMap(&modPriorityMap);
+        ParallaxGenWarnings::init(&pgd, &modPriorityMap);
+        pg.patch(params.Processing.multithread, params.Processing.pluginPatching);
+
+        // Save caches for the next run
+        textureCache.logStats();
+        textureCache.save();
+        cmCache.evict();
+        cmCache.logStats();
+
+        // Release cached files, if any
+        pgd.clearCache();
+    });
+
+    pipeline.addStage("plugin", { "meshes" }, [&] {
+        // Write plugin
+        if (params.Processing.pluginPatching) {
+            Logger::info("Saving Plugins...");
+            ParallaxGenPlugin::savePlugin(params.Output.dir, params.Processing.pluginESMify);
         }
+    });
 
-        pgc.saveUserConfig();
-    }
-
-    // Patch meshes if set
-    auto modPriorityMap = pgc.getModPriorityMap();
-    pg.loadModPriorityMap(&modPriorityMap);
-    ParallaxGenWarnings::init(&pgd, &modPriorityMap);
-    pg.patch(params.Processing.multithread, params.Processing.pluginPatching);
-
-    // Release cached files, if any
-    pgd.clearCache();
-
-    // Write plugin
-    if (params.Processing.pluginPatching) {
-        Logger::info("Saving Plugins...");
-        ParallaxGenPlugin::savePlugin(params.Output.dir, params.Processing.pluginESMify);
-    }
+    pipeline.run(params.Processing.multithread);
 
     // Save diag JSON
     if (params.Processing.diagnostics) {
@@ -339,6 +418,23 @@ void mainRunner(ParallaxGenCLIArgs& args, const filesystem::path& exePath)
     Logger::info("PG Patcher took {} seconds to complete (does not include time in user interface)", timeTaken);
 }
 
+/**
+ * @brief Check if a file descriptor is open in this process
+ *
+ * @param fd file descriptor
+ * @return true if _get_osfhandle finds a handle for it
+ */
+auto isOpenFD(const int& fd) -> bool
+{
+    // _get_osfhandle calls the invalid parameter handler for closed descriptors, which terminates by default
+    const auto prevHandler = _set_thread_local_invalid_parameter_handler(
+        [](const wchar_t*, const wchar_t*, const wchar_t*, unsigned int, uintptr_t) { });
+    const bool isOpen = _get_osfhandle(fd) != -1;
+    _set_thread_local_invalid_parameter_handler(prevHandler);
+
+    return isOpen;
+}
+
 void addArguments(CLI::App& app, ParallaxGenCLIArgs& args)
 {
     // Logging
@@ -347,6 +443,21 @@ void addArguments(CLI::App& app, ParallaxGenCLIArgs& args)
         "(warning: TRACE data is very verbose)");
     app.add_flag("--autostart", args.autostart, "Start generation without user input");
     app.add_flag("--full-dump", args.fullDump, "Save all memory to crash dumps");
+    app.add_option("--progress-fd", args.progressFD,
+        "Write progress of every task as JSON lines to this already open file descriptor (e.g. 1 for stdout)")
+        ->check(CLI::Validator(
+            [](const string& value) -> string {
+                int fd = -1;
+                const auto* end = value.data() + value.size();
+                const auto [ptr, ec] = from_chars(value.data(), end, fd);
+                if (ec != errc() || ptr != end || fd < 0 || !isOpenFD(fd)) {
+                    return "File descriptor " + value + " is not open";
+                }
+                return {};
+            },
+            "FD"));
+    app.add_option("--trace", args.tracePath,
+        "Record a timeline of the run and save it to this file as Chrome trace JSON (open in ui.perfetto.dev)");
 }
 
 void initLogger(const filesystem::path& logpath, const ParallaxGenCLIArgs& args)
@@ -417,6 +528,14 @@ auto main(int ArgC, char** ArgV) -> int
     // Set dump type
     ParallaxGenHandlers::setDumpType(args.fullDump);
 
+    // Machine readable progress
+    ParallaxGenTask::setProgressFD(args.progressFD);
+
+    // Timeline profiling
+    if (!args.tracePath.empty()) {
+        ParallaxGenTrace::enable();
+    }
+
     // Initialize logger
     const filesystem::path logDir = exePath / "log";
     // delete old logs
@@ -438,12 +557,25 @@ auto main(int ArgC, char** ArgV) -> int
     const filesystem::path logPath = logDir / "ParallaxGen.log";
     initLogger(logPath, args);
 
+    // Save the timeline on exit, which also covers runs ending in Logger::critical. Registered after the logger so the
+    // logger is still alive when saveTrace runs
+    if (!args.tracePath.empty()) {
+        s_tracePath = args.tracePath;
+        if (atexit(saveTrace) != 0) {
+            cerr << "Failed to register saveTrace function\n";
+            return 1;
+        }
+    }
+
     // Main Runner (Catches all exceptions)
     CPPTRACE_TRY { mainRunner(args, exePath); }
     CPPTRACE_CATCH(const exception& e)
     {
         ParallaxGenRunner::processException(e, cpptrace::from_current_exception().to_string());
 
+        // abort skips exit handlers, save the timeline of the failed run here
+        saveTrace();
+
         cout << "Press ENTER to abort...";
         cin.get();
         abort();
@@ -120,6 +120,9 @@ void mainRunner(PGToolsCLIArgs& args)
         // Map files
         pgd.mapFiles({}, {}, {}, {}, args.Patch.mapTexturesFromMeshes, args.multithreading, args.Patch.highMem);
 
+        // Index DDS headers
+        pgd3D.buildDDSHeaderIndex(args.multithreading);
+
         // Split patchers into names and options
         unordered_map<string, unordered_map<string, string>> patcherDefs;
         for (const auto& patcher : args.Patch.patchers) {